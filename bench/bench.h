@@ -0,0 +1,40 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+// Roster generator constants
+#define GENERATOR_DEFAULT_SEED 1ULL                // Seed used without '--seed'
+#define GENERATOR_SURNAME_COUNT 4096               // Distinct surnames, drawn with a Zipf skew
+#define GENERATOR_GIVEN_NAME_COUNT 512             // Distinct given names, drawn uniformly
+#define GENERATOR_ZIPF_EXPONENT 0.8                // Skew of the surname frequencies
+#define GENERATOR_NAME_SIZE 32                     // Size of a generated name buffer
+#define GENERATOR_MEAN_SCORE 72.0                  // Mean ability of a student
+#define GENERATOR_ABILITY_SPREAD 14.0              // Spread of the ability between students
+#define GENERATOR_SCORE_SPREAD 9.0                 // Spread of the scores of one student
+#define GENERATOR_WRITE_BUFFER_SIZE (1L << 20)     // Output buffer of the generator
+#define GENERATOR_RANDOM_SCALE 9007199254740992.0  // 2^53, turns 53 random bits into [0, 1)
+
+// Benchmark driver constants
+#define BENCH_DEFAULT_REPEAT 3            // Runs per roster, the fastest is reported
+#define BENCH_MAXIMUM_REPEAT 1000         // Largest number of runs per roster
+#define BENCH_UNKNOWN_COMMIT "unknown"    // Commit name used without '--commit'
+#define BENCH_NULL_DEVICE "/dev/null"     // Sink of the formatted letter grades
+#define BENCH_READ_AHEAD_MODE_COUNT 3     // Read-ahead modes timed on a cold cache
+#define OPTION_SEED "--seed"              // Seed of the roster generator
+#define OPTION_MALFORMED "--malformed"    // Fraction of malformed rows
+#define OPTION_REPEAT "--repeat"          // Runs per roster
+#define OPTION_COMMIT "--commit"          // Commit the results belong to
+
+// Benchmark messages
+#define MSG_GENERATOR_USAGE                                                            \
+    "Usage: generate_roster [--seed <n>] [--malformed <fraction>] <rows> <file|->\n" \
+    "Writes <rows> synthetic student rows; the same seed always gives the same file.\n"
+#define MSG_BENCH_USAGE                                                                                   \
+    "Usage: benchmark [--repeat <n>] [--commit <id>] [--output <file>] <roster>...\n"                  \
+    "Grades each roster with the real pipeline and writes the phase times of the fastest run as JSON.\n"
+#define ERR_BENCH_ROSTER_FAILED "\n\nERROR! Roster '%s' could not be graded"
+
+#endif // BENCH_H
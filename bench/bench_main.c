@@ -0,0 +1,420 @@
+/**
+ * @file bench_main.c
+ * @brief Benchmark driver that times each stage of the grading pipeline.
+ *
+ * Every roster named on the command line is graded with the real 'src/' code: read, tokenize
+ * and parse through 'process_student_data', grade, sort and format the letter grades, write
+ * them, compute the class statistics and free the records. Stage times come from the phase
+ * profiler of the grading context, so they measure exactly what '--timing' reports. The
+ * structural scanner is also timed alone over the roster in memory, finding every line end
+ * and counting the fields of every line, which gives its indexing throughput. Reading and
+ * parsing are timed once more per read-ahead mode after the roster is dropped from the page
+ * cache, which compares asynchronous read-ahead with blocking reads on cold storage. Each
+ * roster runs several times and the fastest run is kept. The results are written as one JSON
+ * object, which can be stored per commit and compared to find regressions.
+ */
+
+// Library includes
+#include <ctype.h> // for tolower
+#include <fcntl.h> // for posix_fadvise
+#include <stdio.h>
+#include <stdlib.h> // for strtol
+#include <string.h>
+
+// Code includes
+#include "bench.h"
+#include "context.h"
+#include "file.h"
+#include "memory.h"
+#include "profiler.h"
+#include "scan.h"
+#include "student.h"
+
+// Define the measurements of one run over a roster
+typedef struct
+{
+    long long phaseTime[NUMBER_OF_PHASES];               // Nanoseconds per phase, parse includes tokenize
+    long long statisticsTime;                            // Nanoseconds spent on the class statistics
+    long long scanTime;                                  // Nanoseconds to index the roster in memory
+    long long coldReadTime[BENCH_READ_AHEAD_MODE_COUNT]; // Nanoseconds to read and parse the roster from a cold cache
+    long long wallTime;                                  // Nanoseconds of the whole run
+    long nBytes;                                         // Size of the roster
+    long nLines;                                         // Line ends found by the structural scan
+    long nFields;                                        // Fields found by the structural scan
+    int nRows;                                           // Student records graded
+} BenchRun;
+
+// Read-ahead modes timed on a cold cache, and their names in the results
+const ReadAheadMode BENCH_READ_AHEAD_MODES[BENCH_READ_AHEAD_MODE_COUNT] = {READ_AHEAD_OFF, READ_AHEAD_THREAD,
+                                                                          READ_AHEAD_AUTO};
+const char *const BENCH_READ_AHEAD_NAMES[BENCH_READ_AHEAD_MODE_COUNT] = {READ_AHEAD_NAME_OFF, READ_AHEAD_NAME_THREAD,
+                                                                        READ_AHEAD_NAME_AUTO};
+
+// Function declaration
+ReturnStatus parse_bench_args(int, char **, int *, const char **, const char **, int *);
+ReturnStatus run_roster(const char *, BenchRun *);
+ReturnStatus scan_roster(GradingContext *, const char *, long, BenchRun *);
+ReturnStatus read_cold_roster(const char *, BenchRun *);
+ReturnStatus write_bench_run(FILE *, const char *, const BenchRun *, Boolean);
+
+/**
+ * @brief Benchmarks every roster named on the command line.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line argument strings.
+ * @return EXIT_CODE_SUCCESS if every roster is graded, EXIT_CODE_USAGE for invalid arguments,
+ *         EXIT_CODE_OUTPUT if the results cannot be written, otherwise EXIT_CODE_FAILURE.
+ */
+int main(int argc, char *argv[])
+{
+    int nRepeat = BENCH_DEFAULT_REPEAT;
+    const char *pCommit = BENCH_UNKNOWN_COMMIT;
+    const char *pOutputName = NULL;
+    int firstRoster = 0;
+
+    if (parse_bench_args(argc, argv, &nRepeat, &pCommit, &pOutputName, &firstRoster) != SUCCESS)
+    {
+        fprintf(stderr, MSG_BENCH_USAGE);
+        return EXIT_CODE_USAGE;
+    }
+
+    FILE *pFile = (pOutputName == NULL) ? stdout : fopen(pOutputName, "w");
+    if (pFile == NULL)
+    {
+        fprintf(stderr, ERR_FILE_OPEN_WRITE, pOutputName);
+        fputc(END_OF_LINE_CHAR, stderr);
+        return EXIT_CODE_OUTPUT;
+    }
+
+    int exitCode = EXIT_CODE_SUCCESS;
+    fprintf(pFile, "{\"commit\":\"%s\",\"repeat\":%d,\"results\":[", pCommit, nRepeat);
+
+    for (int n = firstRoster; n < argc; n++)
+    {
+        BenchRun fastest = {0};
+
+        // Keep the fastest run, the others only differ by noise from the system
+        for (int run = 0; run < nRepeat; run++)
+        {
+            BenchRun current = {0};
+            if (run_roster(argv[n], &current) != SUCCESS)
+            {
+                fprintf(stderr, ERR_BENCH_ROSTER_FAILED, argv[n]);
+                fputc(END_OF_LINE_CHAR, stderr);
+                exitCode = EXIT_CODE_FAILURE;
+                break;
+            }
+            if (run == 0 || current.wallTime < fastest.wallTime)
+            {
+                fastest = current;
+            }
+        }
+
+        // Cold reads are slow and vary little, one run per roster is enough
+        if (exitCode == EXIT_CODE_SUCCESS && read_cold_roster(argv[n], &fastest) != SUCCESS)
+        {
+            fprintf(stderr, ERR_BENCH_ROSTER_FAILED, argv[n]);
+            fputc(END_OF_LINE_CHAR, stderr);
+            exitCode = EXIT_CODE_FAILURE;
+        }
+
+        if (exitCode == EXIT_CODE_SUCCESS)
+        {
+            write_bench_run(pFile, argv[n], &fastest, (n == firstRoster) ? TRUE : FALSE);
+        }
+    }
+
+    fprintf(pFile, "]}\n");
+
+    if (((pFile == stdout) ? fflush(pFile) : fclose(pFile)) != 0)
+    {
+        fprintf(stderr, ERR_FILE_WRITE, (pOutputName != NULL) ? pOutputName : STANDARD_OUTPUT_NAME);
+        fputc(END_OF_LINE_CHAR, stderr);
+        return EXIT_CODE_OUTPUT;
+    }
+
+    return exitCode;
+}
+
+/**
+ * @brief Processes the command-line arguments of the benchmark driver.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line argument strings.
+ * @param pRepeat Receives the number of runs per roster.
+ * @param ppCommit Receives the commit the results belong to.
+ * @param ppOutputName Receives the results file name, or NULL for standard output.
+ * @param pFirstRoster Receives the index of the first roster argument.
+ * @return SUCCESS if the arguments are valid and name at least one roster, otherwise FAILURE.
+ */
+ReturnStatus parse_bench_args(int argc, char **argv, int *pRepeat, const char **ppCommit, const char **ppOutputName,
+                              int *pFirstRoster)
+{
+    int n = ARG_INDEX_PROGRAM_NAME + 1;
+
+    for (; n + 1 < argc && strncmp(argv[n], OPTION_PREFIX, strlen(OPTION_PREFIX)) == 0; n += 2)
+    {
+        if (strcmp(argv[n], OPTION_REPEAT) == 0)
+        {
+            char *pEnd = NULL;
+            long nRepeat = strtol(argv[n + 1], &pEnd, 10);
+            if (pEnd == argv[n + 1] || *pEnd != STRING_TERMINATION || nRepeat < 1 || nRepeat > BENCH_MAXIMUM_REPEAT)
+            {
+                return FAILURE;
+            }
+            *pRepeat = (int)nRepeat;
+        }
+        else if (strcmp(argv[n], OPTION_COMMIT) == 0)
+        {
+            *ppCommit = argv[n + 1];
+        }
+        else if (strcmp(argv[n], OPTION_OUTPUT) == 0)
+        {
+            *ppOutputName = argv[n + 1];
+        }
+        else
+        {
+            return FAILURE;
+        }
+    }
+
+    *pFirstRoster = n;
+
+    return (n < argc && strncmp(argv[n], OPTION_PREFIX, strlen(OPTION_PREFIX)) != 0) ? SUCCESS : FAILURE;
+}
+
+/**
+ * @brief Grades one roster and measures every stage.
+ *
+ * The formatted letter grades go to the null device, so the write stage measures the
+ * formatting and stream overhead without disk speed.
+ *
+ * @param pFileName The roster to grade.
+ * @param pRun Receives the measurements.
+ * @return SUCCESS if the roster is graded, otherwise FAILURE.
+ */
+ReturnStatus run_roster(const char *pFileName, BenchRun *pRun)
+{
+    ReturnStatus status = FAILURE;
+    GradingContext context;
+    FILE *pFile = NULL;
+
+    init_grading_context(&context, NULL);
+    set_message_stream(&context, stderr);
+    start_profiler(&context.profiler);
+
+    do
+    {
+        // Read, tokenize and parse
+        if (get_file_size(&context, pFileName, &pRun->nBytes) != SUCCESS ||
+            open_file_in_read_mode(&context, &pFile, pFileName) != SUCCESS)
+        {
+            break;
+        }
+        ReturnStatus readStatus = process_student_data(&context, pFile, pFileName);
+        close_file(&context, &pFile);
+        if (readStatus != SUCCESS)
+        {
+            break;
+        }
+        pRun->nRows = context.table.nStudents;
+
+        // Grade
+        PROFILE_START(&context, gradeStart);
+        ReturnStatus gradeStatus = calculate_student_grade(&context);
+        PROFILE_STOP(&context, PHASE_GRADE, gradeStart);
+        if (gradeStatus != SUCCESS)
+        {
+            break;
+        }
+
+        // Sort and format, then write
+        if (open_file_in_write_mode(&context, &pFile, BENCH_NULL_DEVICE) != SUCCESS)
+        {
+            break;
+        }
+        ReturnStatus writeStatus = write_names_and_grades_to_file(&context, pFile);
+        PROFILE_START(&context, writeStart);
+        if (close_file(&context, &pFile) != SUCCESS)
+        {
+            writeStatus = FAILURE;
+        }
+        PROFILE_STOP(&context, PHASE_WRITE, writeStart);
+        if (writeStatus != SUCCESS)
+        {
+            break;
+        }
+
+        // Class statistics
+        long long statisticsStart = get_monotonic_time();
+        for (int n = 0; n < context.schema->nTests; n++)
+        {
+            double average, minimum, maximum;
+            calculate_average(&context, n, &average);
+            calculate_minimum(&context, n, &minimum);
+            calculate_maximum(&context, n, &maximum);
+        }
+        pRun->statisticsTime = get_monotonic_time() - statisticsStart;
+
+        // Structural scan
+        if (scan_roster(&context, pFileName, pRun->nBytes, pRun) != SUCCESS)
+        {
+            break;
+        }
+
+        status = SUCCESS;
+    } while (FALSE); // This loop runs only once, allowing for an easy break if any step fails
+
+    // Free
+    PROFILE_START(&context, freeStart);
+    clear_grading_context(&context);
+    PROFILE_STOP(&context, PHASE_FREE, freeStart);
+
+    pRun->wallTime = get_monotonic_time() - context.profiler.startTime;
+    for (int n = 0; n < NUMBER_OF_PHASES; n++)
+    {
+        pRun->phaseTime[n] = context.profiler.phaseTime[n];
+    }
+
+    return status;
+}
+
+/**
+ * @brief Times the structural scanner alone over a roster in memory.
+ *
+ * The roster is read whole first, so only the scan is timed: every line end is found, as
+ * the line reader does, and the fields of all lines are counted in one pass over the
+ * comma and newline masks, as the tokenizer counts them per line.
+ *
+ * @param pContext The grading context that owns the roster buffer.
+ * @param pFileName The roster to scan.
+ * @param nBytes Size of the roster.
+ * @param pRun Receives the scan time.
+ * @return SUCCESS if the roster is read and scanned, otherwise FAILURE.
+ */
+ReturnStatus scan_roster(GradingContext *pContext, const char *pFileName, long nBytes, BenchRun *pRun)
+{
+    char *pBuffer = NULL;
+    long nSize = 0;
+    CharacterScan newLines;
+
+    if (read_file_range(pContext, pFileName, 0, nBytes, &pBuffer, &nSize) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    long long scanStart = get_monotonic_time();
+    start_character_scan(&newLines, pBuffer, nSize, END_OF_LINE_CHAR);
+    while (find_next_character(&newLines) != NULL)
+    {
+        pRun->nLines++;
+    }
+    pRun->nFields = count_fields(pBuffer, nSize);
+    pRun->scanTime = get_monotonic_time() - scanStart;
+
+    clear_buffer_memory(pContext, pBuffer);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads and parses a roster from a cold page cache with every read-ahead mode.
+ *
+ * The roster is dropped from the page cache before each run, so the reads go to the
+ * storage. Where the system keeps the pages anyway, the runs measure a warm cache.
+ *
+ * @param pFileName The roster to read.
+ * @param pRun Receives the read and parse time of each mode.
+ * @return SUCCESS if the roster is read with every mode, otherwise FAILURE.
+ */
+ReturnStatus read_cold_roster(const char *pFileName, BenchRun *pRun)
+{
+    // The first pass is not timed, it only warms the heap so every mode starts alike
+    for (int pass = 0; pass <= BENCH_READ_AHEAD_MODE_COUNT; pass++)
+    {
+        int n = (pass > 0) ? pass - 1 : 0;
+        GradingContext context;
+        FILE *pFile = NULL;
+
+        init_grading_context(&context, NULL);
+        set_message_stream(&context, stderr);
+        context.readAheadMode = BENCH_READ_AHEAD_MODES[n];
+        if (open_file_in_read_mode(&context, &pFile, pFileName) != SUCCESS)
+        {
+            return FAILURE;
+        }
+
+        // Drop the cached pages of the roster, then time the blocking or asynchronous reads
+        posix_fadvise(fileno(pFile), 0, 0, POSIX_FADV_DONTNEED);
+        long long readStart = get_monotonic_time();
+        ReturnStatus status = process_student_data(&context, pFile, pFileName);
+        if (pass > 0)
+        {
+            pRun->coldReadTime[n] = get_monotonic_time() - readStart;
+        }
+
+        close_file(&context, &pFile);
+        clear_grading_context(&context);
+        if (status != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the measurements of one roster as a JSON object.
+ *
+ * The roster name is written without escaping. Phase keys are the lower case phase names
+ * of the timing report, and parse is reported without tokenize as in that report.
+ *
+ * @param pFile The stream that receives the object.
+ * @param pFileName The roster name.
+ * @param pRun The measurements.
+ * @param isFirst TRUE for the first object of the results array.
+ * @return SUCCESS after the object is written.
+ */
+ReturnStatus write_bench_run(FILE *pFile, const char *pFileName, const BenchRun *pRun, Boolean isFirst)
+{
+    double wallSeconds = (double)pRun->wallTime / NANOSECONDS_PER_SECOND;
+    double rowsPerSecond = (wallSeconds > 0) ? pRun->nRows / wallSeconds : 0;
+    double megabytesPerSecond = (wallSeconds > 0) ? pRun->nBytes / BYTES_PER_MEGABYTE / wallSeconds : 0;
+    double scanSeconds = (double)pRun->scanTime / NANOSECONDS_PER_SECOND;
+    double scanMegabytesPerSecond = (scanSeconds > 0) ? pRun->nBytes / BYTES_PER_MEGABYTE / scanSeconds : 0;
+
+    fprintf(pFile, "%s\n{\"roster\":\"%s\",\"rows\":%d,\"bytes\":%ld,\"wall_ms\":%.*f,", (isFirst == TRUE) ? "" : ",",
+            pFileName, pRun->nRows, pRun->nBytes, PROFILE_PRECISION, pRun->wallTime / NANOSECONDS_PER_MILLISECOND);
+    fprintf(pFile, "\"rows_per_second\":%.0f,\"megabytes_per_second\":%.*f,", rowsPerSecond, PROFILE_PRECISION,
+            megabytesPerSecond);
+    fprintf(pFile, "\"scan_lines\":%ld,\"scan_fields\":%ld,\"scan_megabytes_per_second\":%.*f,\"phases_ms\":{",
+            pRun->nLines, pRun->nFields, PROFILE_PRECISION, scanMegabytesPerSecond);
+
+    for (int n = 0; n < NUMBER_OF_PHASES; n++)
+    {
+        long long phaseTime = pRun->phaseTime[n];
+        if (n == PHASE_PARSE)
+        {
+            phaseTime -= pRun->phaseTime[PHASE_TOKENIZE];
+        }
+
+        fputc('"', pFile);
+        for (const char *pChar = PHASE_NAMES[n]; *pChar != STRING_TERMINATION; pChar++)
+        {
+            fputc(tolower((unsigned char)*pChar), pFile);
+        }
+        fprintf(pFile, "\":%.*f,", PROFILE_PRECISION, phaseTime / NANOSECONDS_PER_MILLISECOND);
+    }
+    fprintf(pFile, "\"statistics\":%.*f},\"cold_read_ms\":{", PROFILE_PRECISION,
+            pRun->statisticsTime / NANOSECONDS_PER_MILLISECOND);
+
+    for (int n = 0; n < BENCH_READ_AHEAD_MODE_COUNT; n++)
+    {
+        fprintf(pFile, "%s\"%s\":%.*f", (n == 0) ? "" : ",", BENCH_READ_AHEAD_NAMES[n], PROFILE_PRECISION,
+                pRun->coldReadTime[n] / NANOSECONDS_PER_MILLISECOND);
+    }
+    fprintf(pFile, "}}");
+
+    return SUCCESS;
+}
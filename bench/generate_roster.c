@@ -0,0 +1,372 @@
+/**
+ * @file generate_roster.c
+ * @brief Deterministic generator of synthetic student rosters for benchmarks.
+ *
+ * Writes '<name>,<score>,...' rows with one score per test of the default grading schema.
+ * Names are '<surname> <given name>' built from syllables, so their lengths vary like real
+ * names. Surnames are drawn with a Zipf skew, which gives a few very common surnames and a
+ * long tail of rare ones, as in real class lists. Scores follow a per-student ability with
+ * noise per test. An optional fraction of rows is malformed: a score out of range, a missing
+ * score or an empty name.
+ *
+ * The generator uses its own splitmix64 random numbers, so a seed gives the same file on
+ * every platform. Rows are streamed, so memory use does not depend on the row count.
+ */
+
+// Library includes
+#include <math.h> // for pow
+#include <stdio.h>
+#include <stdlib.h> // for strtoull and strtod
+#include <string.h>
+
+// Code includes
+#include "bench.h"
+#include "student.h"
+
+// Syllables that names are built from
+const char *const NAME_SYLLABLES[] = {"an", "bel", "car", "da", "el",  "fen", "gar", "ha",  "is", "jo",
+                                      "ka", "lin", "mar", "no", "ol",  "per", "qui", "ro",  "sa", "tor",
+                                      "u",  "ven", "wil", "xa", "yo",  "zen", "ber", "chi", "de", "fa",
+                                      "gu", "hel", "ri",  "mo", "son", "ta",  "ve",  "ly",  "ne", "ston"};
+
+// Cumulative share of names with 1, 2, 3 and 4 syllables
+const double SYLLABLE_COUNT_SHARE[] = {0.15, 0.65, 0.93, 1.0};
+
+// Define the kinds of malformed rows
+typedef enum
+{
+    MALFORMED_SCORE_RANGE,   // One score above the maximum score
+    MALFORMED_MISSING_SCORE, // The last score is left out
+    MALFORMED_EMPTY_NAME,    // The name field is empty
+    NUMBER_OF_MALFORMED_KINDS
+} MalformedKind;
+
+// Define the name tables of the generator
+typedef struct
+{
+    char surnames[GENERATOR_SURNAME_COUNT][GENERATOR_NAME_SIZE];      // Surnames by frequency rank
+    double surnameWeights[GENERATOR_SURNAME_COUNT];                   // Cumulative Zipf weights
+    char givenNames[GENERATOR_GIVEN_NAME_COUNT][GENERATOR_NAME_SIZE]; // Given names
+} NameTables;
+
+// Function declaration
+ReturnStatus parse_generator_args(int, char **, unsigned long long *, double *, long long *, const char **);
+ReturnStatus build_name_tables(NameTables *, unsigned long long);
+ReturnStatus build_name(char *, int, unsigned long long *);
+ReturnStatus write_roster(FILE *, const NameTables *, long long, double, unsigned long long);
+const char *draw_surname(const NameTables *, unsigned long long *);
+int draw_score(double, unsigned long long *);
+unsigned long long next_random(unsigned long long *);
+double next_uniform(unsigned long long *);
+
+/**
+ * @brief Writes a synthetic roster.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line argument strings.
+ * @return EXIT_CODE_SUCCESS if the roster is written, otherwise EXIT_CODE_USAGE or
+ *         EXIT_CODE_OUTPUT.
+ */
+int main(int argc, char *argv[])
+{
+    unsigned long long seed = GENERATOR_DEFAULT_SEED;
+    double malformedShare = 0;
+    long long nRows = 0;
+    const char *pFileName = NULL;
+
+    if (parse_generator_args(argc, argv, &seed, &malformedShare, &nRows, &pFileName) != SUCCESS)
+    {
+        fprintf(stderr, MSG_GENERATOR_USAGE);
+        return EXIT_CODE_USAGE;
+    }
+
+    // The tables hold 160 KiB of names, too much for the stack
+    static NameTables tables;
+    build_name_tables(&tables, seed);
+
+    Boolean isStandardOutput = (strcmp(pFileName, STANDARD_STREAM_NAME) == 0) ? TRUE : FALSE;
+    FILE *pFile = (isStandardOutput == TRUE) ? stdout : fopen(pFileName, "w");
+    if (pFile == NULL)
+    {
+        fprintf(stderr, ERR_FILE_OPEN_WRITE, pFileName);
+        fputc(END_OF_LINE_CHAR, stderr);
+        return EXIT_CODE_OUTPUT;
+    }
+    setvbuf(pFile, NULL, _IOFBF, GENERATOR_WRITE_BUFFER_SIZE);
+
+    ReturnStatus status = write_roster(pFile, &tables, nRows, malformedShare, seed);
+
+    if (((isStandardOutput == TRUE) ? fflush(pFile) : fclose(pFile)) != 0 || status != SUCCESS)
+    {
+        fprintf(stderr, ERR_FILE_WRITE, pFileName);
+        fputc(END_OF_LINE_CHAR, stderr);
+        return EXIT_CODE_OUTPUT;
+    }
+
+    return EXIT_CODE_SUCCESS;
+}
+
+/**
+ * @brief Processes the command-line arguments of the generator.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line argument strings.
+ * @param pSeed Receives the seed.
+ * @param pMalformedShare Receives the fraction of malformed rows, from 0 to 1.
+ * @param pRows Receives the number of rows.
+ * @param ppFileName Receives the output file name, '-' for standard output.
+ * @return SUCCESS if the arguments are valid, otherwise FAILURE.
+ */
+ReturnStatus parse_generator_args(int argc, char **argv, unsigned long long *pSeed, double *pMalformedShare,
+                                  long long *pRows, const char **ppFileName)
+{
+    const char *ppPlain[ARG_COUNT_REQUIRED - 1]; // Row count and file name
+    int nPlain = 0;
+
+    for (int n = ARG_INDEX_PROGRAM_NAME + 1; n < argc; n++)
+    {
+        char *pEnd = NULL;
+
+        if (strcmp(argv[n], OPTION_SEED) == 0 && n + 1 < argc)
+        {
+            *pSeed = strtoull(argv[++n], &pEnd, 10);
+        }
+        else if (strcmp(argv[n], OPTION_MALFORMED) == 0 && n + 1 < argc)
+        {
+            *pMalformedShare = strtod(argv[++n], &pEnd);
+            if (*pMalformedShare < 0 || *pMalformedShare > 1)
+            {
+                return FAILURE;
+            }
+        }
+        else if (strncmp(argv[n], OPTION_PREFIX, strlen(OPTION_PREFIX)) != 0 && nPlain < ARG_COUNT_REQUIRED - 1)
+        {
+            ppPlain[nPlain++] = argv[n];
+            continue;
+        }
+        else
+        {
+            return FAILURE;
+        }
+
+        // The option value must be a complete number
+        if (pEnd == argv[n] || *pEnd != STRING_TERMINATION)
+        {
+            return FAILURE;
+        }
+    }
+
+    if (nPlain != ARG_COUNT_REQUIRED - 1)
+    {
+        return FAILURE;
+    }
+
+    char *pEnd = NULL;
+    *pRows = strtoll(ppPlain[0], &pEnd, 10);
+    *ppFileName = ppPlain[1];
+
+    return (pEnd != ppPlain[0] && *pEnd == STRING_TERMINATION && *pRows > 0) ? SUCCESS : FAILURE;
+}
+
+/**
+ * @brief Builds the surname and given name tables for a seed.
+ *
+ * Surname 'k' of the frequency ranking gets the Zipf weight 1 / (k + 1)^s. The weights are
+ * stored cumulatively so a surname can be drawn with a binary search.
+ *
+ * @param pTables The tables to fill.
+ * @param seed The seed of the roster.
+ * @return SUCCESS after the tables are built.
+ */
+ReturnStatus build_name_tables(NameTables *pTables, unsigned long long seed)
+{
+    unsigned long long state = seed;
+    double totalWeight = 0;
+
+    for (int n = 0; n < GENERATOR_SURNAME_COUNT; n++)
+    {
+        build_name(pTables->surnames[n], GENERATOR_NAME_SIZE, &state);
+        totalWeight += 1.0 / pow(n + 1, GENERATOR_ZIPF_EXPONENT);
+        pTables->surnameWeights[n] = totalWeight;
+    }
+
+    for (int n = 0; n < GENERATOR_GIVEN_NAME_COUNT; n++)
+    {
+        build_name(pTables->givenNames[n], GENERATOR_NAME_SIZE, &state);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Builds a capitalized name from one to four syllables.
+ *
+ * @param pName The buffer that receives the name.
+ * @param nameSize The size of the buffer.
+ * @param pState The random number state.
+ * @return SUCCESS after the name is built.
+ */
+ReturnStatus build_name(char *pName, int nameSize, unsigned long long *pState)
+{
+    int nSyllableKinds = sizeof(NAME_SYLLABLES) / sizeof(NAME_SYLLABLES[0]);
+    double draw = next_uniform(pState);
+    int nSyllables = 1;
+
+    while (draw >= SYLLABLE_COUNT_SHARE[nSyllables - 1])
+    {
+        nSyllables++;
+    }
+
+    pName[0] = STRING_TERMINATION;
+    for (int n = 0; n < nSyllables; n++)
+    {
+        strncat(pName, NAME_SYLLABLES[next_random(pState) % nSyllableKinds], nameSize - strlen(pName) - 1);
+    }
+    pName[0] = (char)(pName[0] - 'a' + 'A');
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the rows of a roster.
+ *
+ * @param pFile The stream that receives the rows.
+ * @param pTables The name tables.
+ * @param nRows The number of rows.
+ * @param malformedShare The fraction of malformed rows.
+ * @param seed The seed of the roster.
+ * @return SUCCESS if every row is written, otherwise FAILURE.
+ */
+ReturnStatus write_roster(FILE *pFile, const NameTables *pTables, long long nRows, double malformedShare,
+                          unsigned long long seed)
+{
+    // Rows use a state of their own so the tables do not shift the rows of a seed
+    unsigned long long state = ~seed;
+    int nTests = DEFAULT_GRADING_SCHEMA.nTests;
+
+    for (long long row = 0; row < nRows; row++)
+    {
+        int nScores = nTests;
+        int badScore = -1; // Index of a score out of range
+        Boolean isNameEmpty = FALSE;
+
+        if (malformedShare > 0 && next_uniform(&state) < malformedShare)
+        {
+            switch ((MalformedKind)(next_random(&state) % NUMBER_OF_MALFORMED_KINDS))
+            {
+            case MALFORMED_SCORE_RANGE:
+                badScore = (int)(next_random(&state) % nTests);
+                break;
+            case MALFORMED_MISSING_SCORE:
+                nScores--;
+                break;
+            default:
+                isNameEmpty = TRUE;
+                break;
+            }
+        }
+
+        const char *pSurname = draw_surname(pTables, &state);
+        const char *pGivenName = pTables->givenNames[next_random(&state) % GENERATOR_GIVEN_NAME_COUNT];
+        if (isNameEmpty == FALSE)
+        {
+            fprintf(pFile, "%s %s", pSurname, pGivenName);
+        }
+
+        // Sum of four uniform numbers, close enough to a normal distribution
+        double ability = GENERATOR_MEAN_SCORE + GENERATOR_ABILITY_SPREAD * (next_uniform(&state) + next_uniform(&state) +
+                                                                            next_uniform(&state) + next_uniform(&state) - 2);
+        for (int n = 0; n < nScores; n++)
+        {
+            int score = (n == badScore) ? MAXIMUM_SCORE + 1 + (int)(next_random(&state) % MAXIMUM_SCORE)
+                                        : draw_score(ability, &state);
+            fprintf(pFile, ",%d", score);
+        }
+
+        if (fputc(END_OF_LINE_CHAR, pFile) == EOF)
+        {
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Draws a surname with the Zipf skew of the table.
+ *
+ * @param pTables The name tables.
+ * @param pState The random number state.
+ * @return The surname.
+ */
+const char *draw_surname(const NameTables *pTables, unsigned long long *pState)
+{
+    double target = next_uniform(pState) * pTables->surnameWeights[GENERATOR_SURNAME_COUNT - 1];
+    int low = 0;
+    int high = GENERATOR_SURNAME_COUNT - 1;
+
+    // First surname whose cumulative weight exceeds the target
+    while (low < high)
+    {
+        int middle = (low + high) / 2;
+        if (pTables->surnameWeights[middle] > target)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+
+    return pTables->surnames[low];
+}
+
+/**
+ * @brief Draws one test score around the ability of a student.
+ *
+ * @param ability The ability of the student.
+ * @param pState The random number state.
+ * @return A score from MINIMUM_SCORE to MAXIMUM_SCORE.
+ */
+int draw_score(double ability, unsigned long long *pState)
+{
+    double score = ability + GENERATOR_SCORE_SPREAD * (next_uniform(pState) + next_uniform(pState) - 1) * 2;
+
+    if (score < MINIMUM_SCORE)
+    {
+        return MINIMUM_SCORE;
+    }
+    if (score > MAXIMUM_SCORE)
+    {
+        return MAXIMUM_SCORE;
+    }
+    return (int)(score + 0.5);
+}
+
+/**
+ * @brief Returns the next number of a splitmix64 random sequence.
+ *
+ * @param pState The random number state.
+ * @return A 64-bit random number.
+ */
+unsigned long long next_random(unsigned long long *pState)
+{
+    unsigned long long z = (*pState += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Returns a random number from 0 to 1, excluding 1.
+ *
+ * @param pState The random number state.
+ * @return A uniform random number in [0, 1).
+ */
+double next_uniform(unsigned long long *pState)
+{
+    return (double)(next_random(pState) >> 11) / GENERATOR_RANDOM_SCALE;
+}
@@ -0,0 +1,952 @@
+/**
+ * @file batch.c
+ * @brief Batch driver that grades many rosters in parallel.
+ *
+ * The batch reads its input files from a directory or from a manifest with one file name
+ * per line. Each roster is a section with its own grading context. Rosters are scheduled
+ * on the work-stealing thread pool largest first: small rosters are packed several to a
+ * task, so a worker is not woken for every tiny file, and large rosters are split into line
+ * aligned byte ranges that are parsed and graded on different workers and then merged.
+ * Every section writes its own output file, and a summary with statistics across all
+ * sections is written to the output directory.
+ */
+
+// Library includes
+#include <dirent.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h> // for qsort
+#include <string.h>
+#include <sys/stat.h>
+
+// Code includes
+#include "batch.h"
+#include "context.h"
+#include "decompress.h"
+#include "file.h"
+#include "memory.h"
+#include "student.h"
+#include "threadpool.h"
+#include "trace.h"
+
+// Define statistics of one graded section
+typedef struct
+{
+    int nStudents;                           // Number of students in the section
+    double testSum[MAXIMUM_TEST_COUNT];      // Sum of the scores of each test
+    double testMinimum[MAXIMUM_TEST_COUNT];  // Minimum score of each test
+    double testMaximum[MAXIMUM_TEST_COUNT];  // Maximum score of each test
+    GradeDistribution distribution;          // Letter grade distribution
+} SectionSummary;
+
+// Define one roster of a batch
+typedef struct
+{
+    char inputName[FILE_NAME_SIZE];    // Roster file
+    char outputName[FILE_NAME_SIZE];   // Output file for the letter grades
+    long nBytes;                       // Size of the roster file
+    Boolean isCompressed;              // TRUE if the roster is compressed, which is never split
+    int nChunks;                       // Number of byte ranges the roster is split into
+    GradingContext *chunks;            // Grading context of each range when split
+    ReturnStatus *chunkStatus;         // Result of each range when split
+    Boolean *chunkStopped;             // TRUE for each range whose empty line ends the roster
+    Boolean *chunkParsed;              // TRUE for each range read and parsed, so a failure is in grading
+    atomic_int nChunksLeft;            // Ranges still being graded
+    ReturnStatus status;               // Result of the section
+    char message[MESSAGE_BUFFER_SIZE]; // Error message when the section failed
+    SectionSummary summary;            // Statistics of the section
+    Tracer *pTracer;                   // Trace event recorder, NULL to record nothing
+} BatchSection;
+
+// Define task that grades one byte range of a split roster
+typedef struct
+{
+    BatchSection *section; // Section the range belongs to
+    int index;             // Index of the range
+} ChunkTask;
+
+// Define task that grades several small rosters in turn
+typedef struct
+{
+    BatchSection **sections; // First section of the pack
+    int nSections;           // Number of sections in the pack
+} PackTask;
+
+// Function declaration
+ReturnStatus collect_input_files(GradingContext *, const char *, char ***, int *);
+ReturnStatus add_input_file(GradingContext *, char ***, int *, int *, const char *);
+ReturnStatus set_output_name(GradingContext *, BatchSection *, const char *);
+ReturnStatus check_output_names(GradingContext *, BatchSection **, int);
+ReturnStatus schedule_sections(GradingContext *, ThreadPool *, BatchSection **, int, int, ChunkTask **, PackTask **);
+void grade_pack_task(void *);
+void grade_chunk_task(void *);
+ReturnStatus grade_section(BatchSection *);
+ReturnStatus finish_section(BatchSection *, GradingContext *);
+ReturnStatus summarize_section(GradingContext *, SectionSummary *);
+ReturnStatus write_batch_summary(GradingContext *, BatchSection *, int, const char *, const char *, FILE *);
+int compare_names(const void *, const void *);
+int compare_section_size(const void *, const void *);
+int compare_output_names(const void *, const void *);
+
+/**
+ * @brief Grades every roster of a directory or manifest in parallel.
+ *
+ * @param pSource A directory of roster files, or a manifest file listing one roster per line.
+ * @param pOutputDirectory Existing directory that receives the outputs and the summary.
+ * @param nThreads Number of worker threads, or zero to use one per processor.
+ * @param pProgressStream Stream for progress messages, or NULL to print none.
+ * @param pTracer Trace event recorder for the workers, or NULL to record nothing.
+ * @param pErrorClass Pointer that receives the class of the failure, 'ERROR_CLASS_SECTION'
+ *                    when the batch ran but some sections failed.
+ *
+ * @return SUCCESS if every section is graded.
+ *         FAILURE if the inputs cannot be listed or any section fails.
+ */
+ReturnStatus run_batch(const char *pSource, const char *pOutputDirectory, int nThreads, FILE *pProgressStream,
+                       Tracer *pTracer, ErrorClass *pErrorClass)
+{
+    GradingContext batchContext; // Tracks the driver's own allocations and messages
+    char **ppNames = NULL;
+    int nNames = 0;
+    ReturnStatus status = SUCCESS;
+
+    BatchSection *sections = NULL;
+    BatchSection **ppOrder = NULL;
+    ChunkTask *chunkTasks = NULL;
+    PackTask *packTasks = NULL;
+    ThreadPool *pool = NULL;
+
+    init_grading_context(&batchContext, NULL);
+    set_message_stream(&batchContext, stderr);
+    nThreads = (nThreads > 0) ? nThreads : get_processor_count();
+
+    do
+    {
+        if (collect_input_files(&batchContext, pSource, &ppNames, &nNames) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        if (allocate_buffer_memory(&batchContext, (void **)&sections, nNames * sizeof(BatchSection)) != SUCCESS ||
+            allocate_buffer_memory(&batchContext, (void **)&ppOrder, nNames * sizeof(BatchSection *)) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        // Describe each section
+        for (int n = 0; n < nNames; n++)
+        {
+            BatchSection *section = &sections[n];
+            *section = (BatchSection){0};
+            strcpy(section->inputName, ppNames[n]);
+            section->status = SUCCESS;
+            section->nChunks = 1;
+            section->pTracer = pTracer;
+            ppOrder[n] = section;
+
+            if (set_output_name(&batchContext, section, pOutputDirectory) != SUCCESS ||
+                get_file_size(&batchContext, section->inputName, &section->nBytes) != SUCCESS)
+            {
+                section->status = FAILURE;
+                strcpy(section->message, batchContext.lastMessage);
+            }
+            section->isCompressed = (get_file_compression(section->inputName) != COMPRESSION_NONE) ? TRUE : FALSE;
+        }
+
+        // Two rosters of the same base name would overwrite each other's output
+        if (check_output_names(&batchContext, ppOrder, nNames) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        if (pProgressStream != NULL)
+        {
+            fprintf(pProgressStream, MSG_BATCH_START, nNames, (nNames == 1) ? "" : MSG_PLURAL_SUFFIX, pSource, nThreads,
+                    (nThreads == 1) ? "" : MSG_PLURAL_SUFFIX);
+        }
+
+        if (create_thread_pool(&pool, nThreads) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        // Schedule the largest rosters first so the small ones fill the gaps at the end
+        qsort(ppOrder, nNames, sizeof(BatchSection *), compare_section_size);
+        if (schedule_sections(&batchContext, pool, ppOrder, nNames, nThreads, &chunkTasks, &packTasks) != SUCCESS)
+        {
+            status = FAILURE;
+        }
+
+        wait_thread_pool(pool);
+        destroy_thread_pool(&pool);
+
+        if (write_batch_summary(&batchContext, sections, nNames, pSource, pOutputDirectory, pProgressStream) != SUCCESS)
+        {
+            status = FAILURE;
+        }
+
+        for (int n = 0; n < nNames; n++)
+        {
+            if (sections[n].status != SUCCESS && status == SUCCESS)
+            {
+                status = FAILURE;
+                batchContext.errorClass = ERROR_CLASS_SECTION;
+            }
+            clear_buffer_memory(&batchContext, sections[n].chunks);
+            clear_buffer_memory(&batchContext, sections[n].chunkStatus);
+            clear_buffer_memory(&batchContext, sections[n].chunkStopped);
+            clear_buffer_memory(&batchContext, sections[n].chunkParsed);
+        }
+    } while (FALSE);
+
+    clear_buffer_memory(&batchContext, chunkTasks);
+    clear_buffer_memory(&batchContext, packTasks);
+    clear_buffer_memory(&batchContext, ppOrder);
+    clear_buffer_memory(&batchContext, sections);
+    for (int n = 0; n < nNames; n++)
+    {
+        clear_string_memory(&batchContext, ppNames[n]);
+    }
+    clear_buffer_memory(&batchContext, ppNames);
+
+    *pErrorClass = batchContext.errorClass;
+
+    return status;
+}
+
+/**
+ * @brief Lists the roster files of a directory or manifest.
+ *
+ * Directory entries are sorted by name, and outputs from an earlier batch in the same
+ * directory are skipped. Manifest lines that are empty or start with '#' are ignored.
+ *
+ * @param pContext The batch context that owns the list.
+ * @param pSource The directory or manifest.
+ * @param pppNames Pointer that receives the array of file names.
+ * @param pCount Pointer that receives the number of file names.
+ *
+ * @return SUCCESS if at least one roster is found, otherwise FAILURE.
+ */
+ReturnStatus collect_input_files(GradingContext *pContext, const char *pSource, char ***pppNames, int *pCount)
+{
+    struct stat info;
+    int nCapacity = 0;
+
+    if (stat(pSource, &info) != 0)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pSource);
+        return FAILURE;
+    }
+
+    if (S_ISDIR(info.st_mode))
+    {
+        DIR *pDirectory = opendir(pSource);
+        if (pDirectory == NULL)
+        {
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pSource);
+            return FAILURE;
+        }
+
+        struct dirent *pEntry = NULL;
+        while ((pEntry = readdir(pDirectory)) != NULL)
+        {
+            char path[FILE_NAME_SIZE];
+            size_t nLength = strlen(pEntry->d_name);
+            size_t nSuffix = strlen(BATCH_OUTPUT_SUFFIX);
+
+            // Skip hidden entries, earlier outputs and the summary
+            if (pEntry->d_name[0] == '.' || strcmp(pEntry->d_name, BATCH_SUMMARY_FILE_NAME) == 0 ||
+                (nLength >= nSuffix && strcmp(pEntry->d_name + nLength - nSuffix, BATCH_OUTPUT_SUFFIX) == 0))
+            {
+                continue;
+            }
+
+            if (snprintf(path, FILE_NAME_SIZE, "%s%c%s", pSource, PATH_SEPARATOR_CHAR, pEntry->d_name) >= FILE_NAME_SIZE)
+            {
+                report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_NAME_TOO_LONG, pEntry->d_name);
+                continue;
+            }
+
+            // Only regular files are rosters
+            if (stat(path, &info) == 0 && S_ISREG(info.st_mode))
+            {
+                if (add_input_file(pContext, pppNames, pCount, &nCapacity, path) != SUCCESS)
+                {
+                    closedir(pDirectory);
+                    return FAILURE;
+                }
+            }
+        }
+        closedir(pDirectory);
+
+        qsort(*pppNames, *pCount, sizeof(char *), compare_names);
+    }
+    else
+    {
+        FILE *pFile = fopen(pSource, "r");
+        if (pFile == NULL)
+        {
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pSource);
+            return FAILURE;
+        }
+
+        char line[FILE_NAME_SIZE];
+        while (fgets(line, FILE_NAME_SIZE, pFile) != NULL)
+        {
+            // Trim the line ending
+            line[strcspn(line, "\r\n")] = STRING_TERMINATION;
+
+            if (line[0] == STRING_TERMINATION || line[0] == MANIFEST_COMMENT_CHAR)
+            {
+                continue;
+            }
+
+            if (add_input_file(pContext, pppNames, pCount, &nCapacity, line) != SUCCESS)
+            {
+                fclose(pFile);
+                return FAILURE;
+            }
+        }
+        fclose(pFile);
+    }
+
+    if (*pCount == 0)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_BATCH_EMPTY, pSource);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends a copy of a file name to the list of rosters.
+ *
+ * @param pContext The batch context that owns the list.
+ * @param pppNames The array of file names, grown when full.
+ * @param pCount The number of file names in the array.
+ * @param pCapacity The number of slots in the array.
+ * @param pName The file name to add.
+ *
+ * @return SUCCESS if the name is added, otherwise FAILURE.
+ */
+ReturnStatus add_input_file(GradingContext *pContext, char ***pppNames, int *pCount, int *pCapacity, const char *pName)
+{
+    if (strlen(pName) >= FILE_NAME_SIZE)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_NAME_TOO_LONG, pName);
+        return FAILURE;
+    }
+
+    if (*pCount == *pCapacity)
+    {
+        int nCapacity = (*pCapacity > 0) ? *pCapacity * 2 : BATCH_PACK_FILES;
+        char **ppLarger = NULL;
+        if (allocate_buffer_memory(pContext, (void **)&ppLarger, nCapacity * sizeof(char *)) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        if (*pCount > 0)
+        {
+            memcpy(ppLarger, *pppNames, *pCount * sizeof(char *));
+        }
+        clear_buffer_memory(pContext, *pppNames);
+        *pppNames = ppLarger;
+        *pCapacity = nCapacity;
+    }
+
+    if (allocate_string_memory(pContext, &(*pppNames)[*pCount], strlen(pName)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    strcpy((*pppNames)[*pCount], pName);
+    (*pCount)++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Builds the output file name of a section.
+ *
+ * The output is the roster's base name with 'BATCH_OUTPUT_SUFFIX' in the output directory.
+ *
+ * @param pContext The batch context that reports errors.
+ * @param section The section.
+ * @param pOutputDirectory The output directory.
+ *
+ * @return SUCCESS if the name fits, otherwise FAILURE.
+ */
+ReturnStatus set_output_name(GradingContext *pContext, BatchSection *section, const char *pOutputDirectory)
+{
+    const char *pBaseName = section->inputName;
+
+    for (const char *pChar = section->inputName; *pChar != STRING_TERMINATION; pChar++)
+    {
+        if (*pChar == PATH_SEPARATOR_CHAR || *pChar == PATH_SEPARATOR_WINDOWS_CHAR)
+        {
+            pBaseName = pChar + 1;
+        }
+    }
+
+    if (snprintf(section->outputName, FILE_NAME_SIZE, "%s%c%s%s", pOutputDirectory, PATH_SEPARATOR_CHAR, pBaseName,
+                 BATCH_OUTPUT_SUFFIX) >= FILE_NAME_SIZE)
+    {
+        // Leave no truncated name that could match the name of another section
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_NAME_TOO_LONG, pBaseName);
+        section->outputName[0] = STRING_TERMINATION;
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Checks that no two sections are written to the same output file.
+ *
+ * Outputs are named after the base names of the rosters, so rosters of the same name in
+ * different directories of a manifest would share one output and race on it. The sections
+ * are sorted by output name, which leaves equal names next to each other. Sections that
+ * already failed write nothing and are skipped.
+ *
+ * @param pContext The batch context that reports errors.
+ * @param ppOrder The sections, reordered by output name.
+ * @param nSections Number of sections.
+ *
+ * @return SUCCESS if every output name is unique, otherwise FAILURE.
+ */
+ReturnStatus check_output_names(GradingContext *pContext, BatchSection **ppOrder, int nSections)
+{
+    qsort(ppOrder, nSections, sizeof(BatchSection *), compare_output_names);
+
+    const BatchSection *previous = NULL; // Last section before 'n' that writes an output
+    for (int n = 0; n < nSections; n++)
+    {
+        // Sections that already failed write nothing
+        if (ppOrder[n]->status != SUCCESS)
+        {
+            continue;
+        }
+        if (previous != NULL && strcmp(previous->outputName, ppOrder[n]->outputName) == 0)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_BATCH_OUTPUT_DUPLICATE, previous->inputName,
+                         ppOrder[n]->inputName, ppOrder[n]->outputName);
+            return FAILURE;
+        }
+        previous = ppOrder[n];
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Submits the sections to the pool.
+ *
+ * Sections arrive sorted by size, largest first. Rosters of at least 'BATCH_SPLIT_BYTES'
+ * are split into one byte range per worker (fewer for rosters just over the limit), unless
+ * they are compressed and can only be read from the start. The remaining rosters are
+ * packed into tasks of about 'BATCH_PACK_BYTES'.
+ *
+ * @param pContext The batch context that owns the task arrays.
+ * @param pool The thread pool.
+ * @param ppOrder The sections sorted by size.
+ * @param nSections The number of sections.
+ * @param nThreads The number of workers.
+ * @param pChunkTasks Pointer that receives the chunk task array.
+ * @param pPackTasks Pointer that receives the pack task array.
+ *
+ * @return SUCCESS if every task is submitted, otherwise FAILURE.
+ */
+ReturnStatus schedule_sections(GradingContext *pContext, ThreadPool *pool, BatchSection **ppOrder, int nSections,
+                               int nThreads, ChunkTask **pChunkTasks, PackTask **pPackTasks)
+{
+    // Decide how many ranges each roster is split into
+    int nChunkTasks = 0;
+    for (int n = 0; n < nSections; n++)
+    {
+        BatchSection *section = ppOrder[n];
+        if (section->status == SUCCESS && nThreads > 1 && section->nBytes >= BATCH_SPLIT_BYTES &&
+            section->isCompressed == FALSE)
+        {
+            long nChunks = section->nBytes / (BATCH_SPLIT_BYTES / 2);
+            section->nChunks = (nChunks < nThreads) ? (int)nChunks : nThreads;
+            nChunkTasks += section->nChunks;
+        }
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)pChunkTasks, nChunkTasks * sizeof(ChunkTask)) != SUCCESS ||
+        allocate_buffer_memory(pContext, (void **)pPackTasks, nSections * sizeof(PackTask)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    int nChunkTask = 0;
+    int nPackTask = 0;
+    int nFirstPacked = -1;
+    long nPackedBytes = 0;
+
+    for (int n = 0; n < nSections; n++)
+    {
+        BatchSection *section = ppOrder[n];
+
+        if (section->status != SUCCESS)
+        {
+            continue;
+        }
+
+        if (section->nChunks > 1)
+        {
+            // Give every range its own context so workers share nothing while parsing
+            if (allocate_buffer_memory(pContext, (void **)&section->chunks, section->nChunks * sizeof(GradingContext)) != SUCCESS ||
+                allocate_buffer_memory(pContext, (void **)&section->chunkStatus, section->nChunks * sizeof(ReturnStatus)) != SUCCESS ||
+                allocate_buffer_memory(pContext, (void **)&section->chunkStopped, section->nChunks * sizeof(Boolean)) != SUCCESS ||
+                allocate_buffer_memory(pContext, (void **)&section->chunkParsed, section->nChunks * sizeof(Boolean)) != SUCCESS)
+            {
+                return FAILURE;
+            }
+            atomic_init(&section->nChunksLeft, section->nChunks);
+
+            for (int i = 0; i < section->nChunks; i++)
+            {
+                init_grading_context(&section->chunks[i], NULL);
+                set_message_stream(&section->chunks[i], NULL);
+                set_tracer(&section->chunks[i], section->pTracer);
+                section->chunkStatus[i] = SUCCESS;
+                section->chunkStopped[i] = FALSE;
+                section->chunkParsed[i] = FALSE;
+                (*pChunkTasks)[nChunkTask] = (ChunkTask){section, i};
+                if (submit_task(pool, grade_chunk_task, &(*pChunkTasks)[nChunkTask]) != SUCCESS)
+                {
+                    return FAILURE;
+                }
+                nChunkTask++;
+            }
+            continue;
+        }
+
+        // Pack small rosters that are next to each other in the size order
+        if (nFirstPacked < 0)
+        {
+            nFirstPacked = n;
+            nPackedBytes = 0;
+        }
+        nPackedBytes += section->nBytes;
+
+        Boolean isLast = (n == nSections - 1) ? TRUE : FALSE;
+        if (isLast == TRUE || nPackedBytes >= BATCH_PACK_BYTES || n - nFirstPacked + 1 >= BATCH_PACK_FILES)
+        {
+            (*pPackTasks)[nPackTask] = (PackTask){&ppOrder[nFirstPacked], n - nFirstPacked + 1};
+            if (submit_task(pool, grade_pack_task, &(*pPackTasks)[nPackTask]) != SUCCESS)
+            {
+                return FAILURE;
+            }
+            nPackTask++;
+            nFirstPacked = -1;
+        }
+    }
+
+    // Sections that failed earlier may have left a pack open at the end
+    if (nFirstPacked >= 0)
+    {
+        (*pPackTasks)[nPackTask] = (PackTask){&ppOrder[nFirstPacked], nSections - nFirstPacked};
+        if (submit_task(pool, grade_pack_task, &(*pPackTasks)[nPackTask]) != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Pool task that grades a pack of small rosters one after another.
+ *
+ * @param pArgument The 'PackTask'.
+ */
+void grade_pack_task(void *pArgument)
+{
+    PackTask *task = (PackTask *)pArgument;
+
+    for (int n = 0; n < task->nSections; n++)
+    {
+        if (task->sections[n]->status == SUCCESS && task->sections[n]->nChunks == 1)
+        {
+            grade_section(task->sections[n]);
+        }
+    }
+}
+
+/**
+ * @brief Pool task that parses and grades one byte range of a split roster.
+ *
+ * The worker that finishes the last range merges the ranges in file order, so the
+ * section is written exactly as if it had been graded on one thread. Ranges after the
+ * one holding the first empty line are dropped, since the roster ends at that line.
+ *
+ * @param pArgument The 'ChunkTask'.
+ */
+void grade_chunk_task(void *pArgument)
+{
+    ChunkTask *task = (ChunkTask *)pArgument;
+    BatchSection *section = task->section;
+    GradingContext *pContext = &section->chunks[task->index];
+    ReturnStatus status = SUCCESS;
+
+    long nChunkSize = section->nBytes / section->nChunks;
+    long nStart = nChunkSize * task->index;
+    long nEnd = (task->index == section->nChunks - 1) ? section->nBytes : nStart + nChunkSize;
+    char *pBuffer = NULL;
+    long nSize = 0;
+    long nLines = 0;
+
+    TRACE_START(pContext, loadStart);
+    status = read_file_range(pContext, section->inputName, nStart, nEnd, &pBuffer, &nSize);
+    TRACE_STOP(pContext, TRACE_STAGE_LOAD, section->inputName, task->index, loadStart);
+    if (status == SUCCESS)
+    {
+        // Grading each range fills that range's own grade distribution
+        TRACE_START(pContext, parseStart);
+        status = process_student_range(pContext, pBuffer, nSize, &nLines, &section->chunkStopped[task->index]);
+        TRACE_STOP(pContext, TRACE_STAGE_PARSE, section->inputName, task->index, parseStart);
+        clear_buffer_memory(pContext, pBuffer);
+    }
+    if (status == SUCCESS)
+    {
+        section->chunkParsed[task->index] = TRUE;
+        TRACE_START(pContext, gradeStart);
+        status = calculate_student_grade(pContext);
+        TRACE_STOP(pContext, TRACE_STAGE_GRADE, section->inputName, task->index, gradeStart);
+    }
+    section->chunkStatus[task->index] = status;
+
+    // The last range to finish merges and writes the section
+    if (atomic_fetch_sub(&section->nChunksLeft, 1) != 1)
+    {
+        return;
+    }
+
+    GradingContext *pMerged = &section->chunks[0];
+    TRACE_START(pMerged, mergeStart);
+
+    // A serial run parses the whole roster before grading it, so the first range that fails
+    // to parse is reported before the first range that fails to grade
+    int nFailed = -1;
+    for (int n = 0; n < section->nChunks; n++)
+    {
+        if (section->chunkStatus[n] != SUCCESS && section->chunkParsed[n] == FALSE)
+        {
+            nFailed = n;
+            break;
+        }
+        if (section->chunkStatus[n] != SUCCESS && nFailed < 0)
+        {
+            nFailed = n;
+        }
+        if (section->chunkStopped[n] == TRUE)
+        {
+            break;
+        }
+    }
+    if (nFailed >= 0)
+    {
+        section->status = FAILURE;
+        strcpy(section->message, section->chunks[nFailed].lastMessage);
+    }
+
+    Boolean isStopped = FALSE; // TRUE once a range ends the roster, as a serial parse stops there
+    for (int n = 0; n < section->nChunks; n++)
+    {
+        if (n > 0)
+        {
+            if (isStopped == FALSE)
+            {
+                merge_grading_context(pMerged, &section->chunks[n]);
+            }
+            clear_grading_context(&section->chunks[n]);
+        }
+        if (section->chunkStopped[n] == TRUE)
+        {
+            isStopped = TRUE;
+        }
+    }
+    TRACE_STOP(pMerged, TRACE_STAGE_MERGE, section->inputName, TRACE_WHOLE_FILE, mergeStart);
+
+    if (section->status == SUCCESS)
+    {
+        finish_section(section, pMerged);
+    }
+    clear_grading_context(pMerged);
+}
+
+/**
+ * @brief Parses, grades and writes one roster on the current worker.
+ *
+ * @param section The section to grade.
+ *
+ * @return SUCCESS if the section is graded and written, otherwise FAILURE.
+ */
+ReturnStatus grade_section(BatchSection *section)
+{
+    GradingContext context;
+    FILE *pFile = NULL;
+
+    init_grading_context(&context, NULL);
+    set_message_stream(&context, NULL);
+    set_tracer(&context, section->pTracer);
+
+    do
+    {
+        if (open_file_in_read_mode(&context, &pFile, section->inputName) != SUCCESS)
+        {
+            section->status = FAILURE;
+            break;
+        }
+
+        // Loading happens while parsing, the reader records its own load events
+        TRACE_START(&context, parseStart);
+        section->status = process_student_data(&context, pFile, section->inputName);
+        TRACE_STOP(&context, TRACE_STAGE_PARSE, section->inputName, TRACE_WHOLE_FILE, parseStart);
+        close_file(&context, &pFile);
+
+        if (section->status == SUCCESS)
+        {
+            TRACE_START(&context, gradeStart);
+            section->status = calculate_student_grade(&context);
+            TRACE_STOP(&context, TRACE_STAGE_GRADE, section->inputName, TRACE_WHOLE_FILE, gradeStart);
+        }
+
+        if (section->status == SUCCESS)
+        {
+            finish_section(section, &context);
+        }
+    } while (FALSE);
+
+    if (section->status != SUCCESS)
+    {
+        strcpy(section->message, context.lastMessage);
+    }
+    clear_grading_context(&context);
+
+    return section->status;
+}
+
+/**
+ * @brief Writes the output file of a graded section and keeps its statistics.
+ *
+ * @param section The section.
+ * @param pContext The context holding all graded students of the section.
+ *
+ * @return SUCCESS if the output is written, otherwise FAILURE.
+ */
+ReturnStatus finish_section(BatchSection *section, GradingContext *pContext)
+{
+    FILE *pFile = NULL;
+    TRACE_START(pContext, writeStart);
+
+    if (open_file_in_write_mode(pContext, &pFile, section->outputName) != SUCCESS ||
+        write_file_header(pContext, pFile, section->inputName) != SUCCESS ||
+        write_file_data(pContext, pFile) != SUCCESS)
+    {
+        if (pFile != NULL)
+        {
+            close_file(pContext, &pFile);
+        }
+        section->status = FAILURE;
+        strcpy(section->message, pContext->lastMessage);
+        return FAILURE;
+    }
+    close_file(pContext, &pFile);
+    TRACE_STOP(pContext, TRACE_STAGE_WRITE, section->inputName, TRACE_WHOLE_FILE, writeStart);
+
+    return summarize_section(pContext, &section->summary);
+}
+
+/**
+ * @brief Keeps the statistics of a graded section for the cross-section summary.
+ *
+ * Test sums are kept instead of averages so the summary can weigh each section by its
+ * number of students.
+ *
+ * @param pContext The context holding the graded students.
+ * @param pSummary The summary that receives the statistics.
+ *
+ * @return SUCCESS after the statistics are kept.
+ */
+ReturnStatus summarize_section(GradingContext *pContext, SectionSummary *pSummary)
+{
+    int nTests = pContext->schema->nTests;
+
+    set_number_of_students(pContext, &pSummary->nStudents);
+    pSummary->distribution = pContext->distribution;
+
+    for (int n = 0; n < nTests && n < MAXIMUM_TEST_COUNT && pSummary->nStudents > 0; n++)
+    {
+        double average = 0;
+        calculate_average(pContext, n, &average);
+        calculate_minimum(pContext, n, &pSummary->testMinimum[n]);
+        calculate_maximum(pContext, n, &pSummary->testMaximum[n]);
+        pSummary->testSum[n] = average * pSummary->nStudents;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the statistics across all sections to the summary file.
+ *
+ * The summary holds the per-test average, minimum and maximum over every student of every
+ * section, the combined letter grade distribution, and one line per section with its
+ * letter counts or its error.
+ *
+ * @param pContext The batch context.
+ * @param sections The sections in roster name order.
+ * @param nSections The number of sections.
+ * @param pSource The directory or manifest the rosters came from.
+ * @param pOutputDirectory The output directory.
+ * @param pProgressStream Stream for the completion message, or NULL to print none.
+ *
+ * @return SUCCESS if the summary is written, otherwise FAILURE.
+ */
+ReturnStatus write_batch_summary(GradingContext *pContext, BatchSection *sections, int nSections, const char *pSource,
+                                 const char *pOutputDirectory, FILE *pProgressStream)
+{
+    const GradingSchema *pSchema = pContext->schema;
+    int nTests = (pSchema->nTests < MAXIMUM_TEST_COUNT) ? pSchema->nTests : MAXIMUM_TEST_COUNT;
+    SectionSummary total = {0};
+    int nFailed = 0;
+
+    for (int n = 0; n < nTests; n++)
+    {
+        total.testMinimum[n] = MAXIMUM_SCORE;
+        total.testMaximum[n] = MINIMUM_SCORE;
+    }
+
+    // Combine the sections
+    for (int i = 0; i < nSections; i++)
+    {
+        SectionSummary *pSummary = &sections[i].summary;
+
+        if (sections[i].status != SUCCESS)
+        {
+            nFailed++;
+            continue;
+        }
+
+        total.nStudents += pSummary->nStudents;
+        merge_grade_distribution(&total.distribution, &pSummary->distribution);
+
+        for (int n = 0; n < nTests && pSummary->nStudents > 0; n++)
+        {
+            total.testSum[n] += pSummary->testSum[n];
+            total.testMinimum[n] = (pSummary->testMinimum[n] < total.testMinimum[n]) ? pSummary->testMinimum[n] : total.testMinimum[n];
+            total.testMaximum[n] = (pSummary->testMaximum[n] > total.testMaximum[n]) ? pSummary->testMaximum[n] : total.testMaximum[n];
+        }
+    }
+
+    char summaryName[FILE_NAME_SIZE];
+    snprintf(summaryName, FILE_NAME_SIZE, "%s%c%s", pOutputDirectory, PATH_SEPARATOR_CHAR, BATCH_SUMMARY_FILE_NAME);
+
+    FILE *pFile = NULL;
+    if (open_file_in_write_mode(pContext, &pFile, summaryName) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    fprintf(pFile, MSG_BATCH_SUMMARY_HEADER, total.nStudents, nSections - nFailed, pSource);
+
+    // Per-test statistics over all students
+    fprintf(pFile, "\n%*s", STATS_COLUMN_WIDTH, "");
+    for (int n = 0; n < nTests; n++)
+    {
+        fprintf(pFile, "%-*s", STATS_COLUMN_WIDTH, pSchema->testNames[n]);
+    }
+    for (int row = ROW_AVERAGE; row <= ROW_MAXIMUM && total.nStudents > 0; row++)
+    {
+        fprintf(pFile, "\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[row]);
+        for (int n = 0; n < nTests; n++)
+        {
+            double value = (row == ROW_AVERAGE) ? total.testSum[n] / total.nStudents
+                         : (row == ROW_MINIMUM) ? total.testMinimum[n]
+                                                : total.testMaximum[n];
+            fprintf(pFile, "%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, value);
+        }
+    }
+
+    // Combined letter grade distribution
+    fprintf(pFile, "\n\n%-*s", STATS_COLUMN_WIDTH, "");
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        fprintf(pFile, "%-*c", STATS_COLUMN_WIDTH, pSchema->gradeLetter[n]);
+    }
+    fprintf(pFile, "\n%-*s", STATS_COLUMN_WIDTH, "Count");
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        fprintf(pFile, "%-*d", STATS_COLUMN_WIDTH, total.distribution.letterCount[n]);
+    }
+    fprintf(pFile, "\n%-*s", STATS_COLUMN_WIDTH, "Percent");
+    for (int n = 0; n < NUMBER_OF_GRADES && total.distribution.nGraded > 0; n++)
+    {
+        double percent = PERCENT_SCALE * total.distribution.letterCount[n] / total.distribution.nGraded;
+        fprintf(pFile, "%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, percent);
+    }
+
+    // One line per section
+    fprintf(pFile, MSG_BATCH_SECTION_HEADER);
+    for (int i = 0; i < nSections; i++)
+    {
+        if (sections[i].status != SUCCESS)
+        {
+            fprintf(pFile, MSG_BATCH_SECTION_FAILED, sections[i].inputName, sections[i].message);
+            continue;
+        }
+
+        fprintf(pFile, MSG_BATCH_SECTION_STUDENTS, sections[i].inputName, sections[i].summary.nStudents);
+        for (int n = 0; n < NUMBER_OF_GRADES; n++)
+        {
+            fprintf(pFile, MSG_BATCH_SECTION_GRADE, pSchema->gradeLetter[n], sections[i].summary.distribution.letterCount[n]);
+        }
+        fprintf(pFile, "\n");
+    }
+
+    close_file(pContext, &pFile);
+
+    if (pProgressStream != NULL)
+    {
+        fprintf(pProgressStream, MSG_BATCH_DONE, nSections, total.nStudents, nFailed, summaryName);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Compares two file names for 'qsort'.
+ */
+int compare_names(const void *pLeft, const void *pRight)
+{
+    return strcmp(*(const char *const *)pLeft, *(const char *const *)pRight);
+}
+
+/**
+ * @brief Compares two sections by output name for 'qsort'.
+ */
+int compare_output_names(const void *pLeft, const void *pRight)
+{
+    const BatchSection *left = *(const BatchSection *const *)pLeft;
+    const BatchSection *right = *(const BatchSection *const *)pRight;
+
+    return strcmp(left->outputName, right->outputName);
+}
+
+/**
+ * @brief Compares two sections by size, largest first, for 'qsort'.
+ */
+int compare_section_size(const void *pLeft, const void *pRight)
+{
+    const BatchSection *left = *(const BatchSection *const *)pLeft;
+    const BatchSection *right = *(const BatchSection *const *)pRight;
+
+    return (left->nBytes < right->nBytes) - (left->nBytes > right->nBytes);
+}
@@ -0,0 +1,10 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus run_batch(const char *, const char *, int, FILE *, Tracer *, ErrorClass *);
+
+#endif // BATCH_H
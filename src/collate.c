@@ -0,0 +1,290 @@
+/**
+ * @file collate.c
+ * @brief Name ordering by folded or locale collation keys.
+ *
+ * Byte order puts 'de la Cruz' after 'Zhang' and 'Émile' after every name in ASCII. A
+ * collation orders names as people read them, but comparing names with 'strcoll' or with
+ * folding on the fly repeats the expensive part on every comparison. Instead each name is
+ * turned into a binary collation key once, so that comparing two keys with 'memcmp' gives
+ * the order of the names:
+ *
+ * - 'fold' lowercases ASCII letters and folds the Latin-1 and Latin Extended-A letters of
+ *   UTF-8 names to their base letters, such as 'É' to 'e' and 'ß' to 'ss'. Other bytes are
+ *   kept, so names in other scripts keep their byte order.
+ * - 'locale' takes the key from 'strxfrm' in the 'LC_COLLATE' locale.
+ *
+ * The first 'COLLATION_PREFIX_SIZE' bytes of each key are packed into an integer, so most
+ * comparisons of the sort are one integer comparison on a flat array, and 'memcmp' runs on
+ * the rest of the keys only when the prefixes are equal. Names with equal keys are ordered
+ * by their bytes, then by their place in the table, which keeps the sort stable.
+ */
+
+// Library includes
+#include <stdlib.h> // for qsort
+#include <string.h>
+
+// Code includes
+#include "collate.h"
+#include "context.h"
+#include "memory.h"
+
+// Define a student and the collation key of its name
+typedef struct
+{
+    uint64_t prefix;           // First key bytes in big endian order, zero padded
+    const unsigned char *pKey; // Collation key of the name
+    long nKey;                 // Bytes of the collation key
+    long position;             // Position of the student in the table
+    Record *record;            // The student
+} CollationEntry;
+
+// Function declaration
+long fold_name(const char *, char *, long);
+uint64_t get_key_prefix(const unsigned char *, long);
+int compare_collation_entries(const void *, const void *);
+
+// Base letters of the code points from 'COLLATION_FOLD_FIRST' to 'COLLATION_FOLD_LAST'.
+// Digits from 'COLLATION_FOLD_EXPANSION' on select a pair of letters of 'FOLD_EXPANSIONS'.
+const char FOLD_LETTERS[] = "aaaaaa1ceeeeiiiidnooooo.ouuuuy23" // U+00C0 to U+00DF
+                            "aaaaaa1ceeeeiiiidnooooo.ouuuuy2y" // U+00E0 to U+00FF
+                            "aaaaaaccccccccddddeeeeeeeeee"     // U+0100 to U+011B
+                            "gggggggghhhhiiiiiiiiii44jjkkk"    // U+011C to U+0138
+                            "llllllllllnnnnnnnnnoooooo55"      // U+0139 to U+0153
+                            "rrrrrrsssssssstttttt"             // U+0154 to U+0167
+                            "uuuuuuuuuuuuwwyyyzzzzzzs";        // U+0168 to U+017F
+
+// Letters of the code points folded to two letters: 'Æ', 'Þ', 'ß', 'Ĳ' and 'Œ'
+const char *const FOLD_EXPANSIONS[] = {"ae", "th", "ss", "ij", "oe"};
+
+/**
+ * @brief Writes the collation key of a name.
+ *
+ * Like 'strxfrm', the key is written only if it fits, with a terminator, and its length is
+ * returned either way, so a first call with no buffer sizes the key.
+ *
+ * @param pName The name.
+ * @param collation The collation, 'NAME_COLLATION_FOLD' or 'NAME_COLLATION_LOCALE'.
+ * @param pKey Buffer that receives the key, or NULL to only size it.
+ * @param nCapacity Bytes of the buffer, zero to only size the key.
+ *
+ * @return Bytes of the key without its terminator.
+ */
+long get_collation_key(const char *pName, NameCollation collation, char *pKey, long nCapacity)
+{
+    if (collation == NAME_COLLATION_LOCALE)
+    {
+        return (long)strxfrm(pKey, pName, (size_t)nCapacity);
+    }
+
+    return fold_name(pName, pKey, nCapacity);
+}
+
+/**
+ * @brief Sorts the student table by the collation keys of the names.
+ *
+ * The keys of all names are written once into one block, the students are sorted as a flat
+ * array of keys and the list is linked again in the sorted order.
+ *
+ * @param pContext The grading context that owns the student table.
+ * @param collation The collation, 'NAME_COLLATION_FOLD' or 'NAME_COLLATION_LOCALE'.
+ *
+ * @return SUCCESS if the list is sorted.
+ *         FAILURE if the list is empty or memory is exhausted.
+ */
+ReturnStatus sort_list_by_collation(GradingContext *pContext, NameCollation collation)
+{
+    long nStudents = pContext->table.nStudents;
+    CollationEntry *entries = NULL;
+    char *pKeys = NULL;
+
+    // Don't attempt to sort an empty list
+    if (pContext->table.head == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_RECORD_EMPTY);
+        return FAILURE;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&entries, nStudents * sizeof(CollationEntry)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    // Size the keys, each followed by its terminator
+    long nEntries = 0;
+    size_t nKeyBytes = 0;
+    for (Record *current = pContext->table.head; current != NULL && nEntries < nStudents; current = current->next)
+    {
+        entries[nEntries].nKey = get_collation_key(current->name, collation, NULL, 0);
+        entries[nEntries].position = nEntries;
+        entries[nEntries].record = current;
+        nKeyBytes += (size_t)entries[nEntries].nKey + 1;
+        nEntries++;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&pKeys, nKeyBytes) != SUCCESS)
+    {
+        clear_buffer_memory(pContext, entries);
+        return FAILURE;
+    }
+
+    // Write the keys one after another
+    char *pNextKey = pKeys;
+    for (long n = 0; n < nEntries; n++)
+    {
+        CollationEntry *pEntry = &entries[n];
+        get_collation_key(pEntry->record->name, collation, pNextKey, pEntry->nKey + 1);
+        pEntry->pKey = (const unsigned char *)pNextKey;
+        pEntry->prefix = get_key_prefix(pEntry->pKey, pEntry->nKey);
+        pNextKey += pEntry->nKey + 1;
+    }
+
+    qsort(entries, (size_t)nEntries, sizeof(CollationEntry), compare_collation_entries);
+
+    // Link the records again in key order
+    for (long n = 0; n + 1 < nEntries; n++)
+    {
+        entries[n].record->next = entries[n + 1].record;
+    }
+    entries[nEntries - 1].record->next = NULL;
+    pContext->table.head = entries[0].record;
+    pContext->table.tail = entries[nEntries - 1].record;
+
+    clear_buffer_memory(pContext, pKeys);
+    clear_buffer_memory(pContext, entries);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the folded collation key of a name.
+ *
+ * ASCII letters are lowercased, and the two-byte UTF-8 sequences of the Latin-1 and Latin
+ * Extended-A letters are replaced by their base letters. A folded letter never takes more
+ * bytes than its sequence, so the key is at most as long as the name.
+ *
+ * @param pName The name.
+ * @param pKey Buffer that receives the key, or NULL to only size it.
+ * @param nCapacity Bytes of the buffer, zero to only size the key.
+ *
+ * @return Bytes of the key without its terminator.
+ */
+long fold_name(const char *pName, char *pKey, long nCapacity)
+{
+    const unsigned char *pByte = (const unsigned char *)pName;
+    char folded[2];
+    long nKey = 0;
+
+    while (*pByte != STRING_TERMINATION)
+    {
+        const char *pFolded = folded;
+        long nFolded = 1;
+        long nRead = 1;
+        long codePoint = -1;
+
+        // Two-byte sequences hold the code points up to U+07FF
+        if ((pByte[0] & 0xE0) == 0xC0 && (pByte[1] & 0xC0) == 0x80)
+        {
+            codePoint = ((long)(pByte[0] & 0x1F) << 6) | (pByte[1] & 0x3F);
+        }
+
+        if (codePoint >= COLLATION_FOLD_FIRST && codePoint <= COLLATION_FOLD_LAST &&
+            FOLD_LETTERS[codePoint - COLLATION_FOLD_FIRST] != COLLATION_FOLD_KEEP)
+        {
+            char letter = FOLD_LETTERS[codePoint - COLLATION_FOLD_FIRST];
+            nRead = 2;
+            if (letter >= COLLATION_FOLD_EXPANSION && letter <= '9')
+            {
+                pFolded = FOLD_EXPANSIONS[letter - COLLATION_FOLD_EXPANSION];
+                nFolded = 2;
+            }
+            else
+            {
+                folded[0] = letter;
+            }
+        }
+        else
+        {
+            folded[0] = (*pByte >= 'A' && *pByte <= 'Z') ? (char)(*pByte - 'A' + 'a') : (char)*pByte;
+        }
+
+        if (pKey != NULL && nKey + nFolded < nCapacity)
+        {
+            memcpy(pKey + nKey, pFolded, (size_t)nFolded);
+        }
+        nKey += nFolded;
+        pByte += nRead;
+    }
+
+    if (pKey != NULL && nKey < nCapacity)
+    {
+        pKey[nKey] = STRING_TERMINATION;
+    }
+
+    return nKey;
+}
+
+/**
+ * @brief Packs the first bytes of a key into an integer that compares like the bytes.
+ *
+ * @param pKey The key.
+ * @param nKey Bytes of the key.
+ *
+ * @return The first 'COLLATION_PREFIX_SIZE' bytes in big endian order, zero padded.
+ */
+uint64_t get_key_prefix(const unsigned char *pKey, long nKey)
+{
+    uint64_t prefix = 0;
+
+    for (long n = 0; n < COLLATION_PREFIX_SIZE; n++)
+    {
+        prefix = (prefix << 8) | ((n < nKey) ? pKey[n] : 0);
+    }
+
+    return prefix;
+}
+
+/**
+ * @brief Compares two students by collation key for 'qsort'.
+ *
+ * Keys are compared by their prefixes first and with 'memcmp' only when the prefixes are
+ * equal. Equal keys are ordered by the bytes of the names, then by table position.
+ *
+ * @param a The first entry.
+ * @param b The second entry.
+ *
+ * @return A negative value, zero or a positive value if 'a' sorts before, with or after 'b'.
+ */
+int compare_collation_entries(const void *a, const void *b)
+{
+    const CollationEntry *pEntryA = a;
+    const CollationEntry *pEntryB = b;
+
+    if (pEntryA->prefix != pEntryB->prefix)
+    {
+        return (pEntryA->prefix < pEntryB->prefix) ? -1 : 1;
+    }
+
+    // Keys with equal prefixes differ after them, or in length
+    long nShorter = (pEntryA->nKey < pEntryB->nKey) ? pEntryA->nKey : pEntryB->nKey;
+    if (nShorter > COLLATION_PREFIX_SIZE)
+    {
+        int order = memcmp(pEntryA->pKey + COLLATION_PREFIX_SIZE, pEntryB->pKey + COLLATION_PREFIX_SIZE,
+                           (size_t)(nShorter - COLLATION_PREFIX_SIZE));
+        if (order != 0)
+        {
+            return order;
+        }
+    }
+    if (pEntryA->nKey != pEntryB->nKey)
+    {
+        return (pEntryA->nKey < pEntryB->nKey) ? -1 : 1;
+    }
+
+    int order = strcmp(pEntryA->record->name, pEntryB->record->name);
+    if (order != 0)
+    {
+        return order;
+    }
+
+    return (pEntryA->position < pEntryB->position) ? -1 : 1;
+}
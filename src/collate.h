@@ -0,0 +1,11 @@
+#ifndef COLLATE_H
+#define COLLATE_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+long get_collation_key(const char *, NameCollation, char *, long);
+ReturnStatus sort_list_by_collation(GradingContext *, NameCollation);
+
+#endif // COLLATE_H
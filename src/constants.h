@@ -20,6 +20,82 @@
 #define ARG_INDEX_INPUT_FILE 1   // Input file name
 #define ARG_INDEX_OUTPUT_FILE 2  // Output file output
 
+// Command-line options
+#define OPTION_PREFIX "--"                     // Prefix of every option
+#define OPTION_INPUT "--input"                 // Input file, '-' for standard input
+#define OPTION_OUTPUT "--output"               // Output file, '-' for standard output, or batch output directory
+#define OPTION_BATCH "--batch"                 // Grades a directory or manifest of rosters
+#define OPTION_THREADS "--threads"             // Number of worker threads
+#define OPTION_QUIET "--quiet"                 // Prints no progress messages
+#define OPTION_NO_WAIT "--no-wait"             // Exits without waiting for Enter
+#define OPTION_STATS_FORMAT "--stats-format"   // Format of the class statistics
+#define OPTION_OUTPUT_FORMAT "--output-format" // Format of the letter grade output
+#define OPTION_TIMING "--timing"               // Prints phase timing and throughput
+#define OPTION_TRACE "--trace"                 // Writes a Chrome trace of the pipeline stages
+#define OPTION_MEMORY_REPORT "--memory-report" // Writes the allocation profile as JSON
+#define OPTION_DAEMON "--daemon"               // Serves grading requests on a Unix domain socket
+#define OPTION_WATCH "--watch"                 // Re-grades the input whenever it changes
+#define OPTION_INDEX "--index"                 // Grade index written after grading, or read by a query
+#define OPTION_LOOKUP "--lookup"               // Prints the grade of one student from the grade index
+#define OPTION_NAME_PREFIX "--prefix"          // Prints the students whose name starts with a prefix
+#define OPTION_FROM "--from"                   // Prints the students from a name on
+#define OPTION_TO "--to"                       // Prints the students up to a name or name prefix
+#define OPTION_SKIP_INVALID "--skip-invalid"   // Skips invalid rows into a rejects file instead of failing
+#define OPTION_READ_AHEAD "--read-ahead"       // Selects how input files are read ahead of the parser
+#define OPTION_TOP "--top"                     // Reports the students with the highest weighted scores
+#define OPTION_BOTTOM "--bottom"               // Reports the students with the lowest weighted scores
+#define OPTION_RANK_OUTPUT "--rank-output"     // Writes the top and bottom students as CSV
+#define OPTION_SORT "--sort"                   // Order of the students in the letter grade output
+#define OPTION_COLLATION "--collation"         // How names are compared when students are sorted by name
+#define OPTION_DUPLICATES "--duplicates"       // What is done with students listed more than once
+#define OPTION_HELP "--help"                   // Prints the usage
+#define STANDARD_STREAM_NAME "-"               // File name selecting standard input or output
+#define STANDARD_INPUT_NAME "stdin"            // Input name written to the output header
+#define STANDARD_OUTPUT_NAME "stdout"          // Output name shown in progress messages
+#define STATS_FORMAT_NAME_TEXT "text"          // Console tables and histogram
+#define STATS_FORMAT_NAME_CSV "csv"            // Comma separated values
+#define STATS_FORMAT_NAME_JSON "json"          // JSON object
+#define STATS_FORMAT_NAME_NONE "none"          // No statistics
+#define OUTPUT_FORMAT_NAME_TEXT "text"         // Padded names and letters
+#define OUTPUT_FORMAT_NAME_CSV "csv"           // Comma separated values
+#define OUTPUT_FORMAT_NAME_JSONL "jsonl"       // JSON Lines
+#define OUTPUT_FORMAT_NAME_BINARY "binary"     // Packed binary records
+#define READ_AHEAD_NAME_AUTO "auto"            // io_uring where available, otherwise a thread
+#define READ_AHEAD_NAME_THREAD "thread"        // Read-ahead thread
+#define READ_AHEAD_NAME_OFF "off"              // Blocking reads
+#define SORT_ORDER_NAME_NAME "name"            // By name
+#define SORT_ORDER_NAME_SCORE "score"          // By weighted score, highest first, then by name
+#define SORT_ORDER_NAME_GRADE "grade"          // By letter grade, then by name
+#define COLLATION_NAME_BYTE "byte"             // Bytes of the names
+#define COLLATION_NAME_FOLD "fold"             // Case and accents folded
+#define COLLATION_NAME_LOCALE "locale"         // Collation of the LC_COLLATE locale
+#define DUPLICATE_POLICY_NAME_FIRST "first"    // Keep the first row of a student
+#define DUPLICATE_POLICY_NAME_LAST "last"      // Keep the last row of a student
+#define DUPLICATE_POLICY_NAME_ERROR "error"    // Fail on a second row of a student
+#define DUPLICATE_POLICY_NAME_MERGE "merge"    // Merge the rows of a student
+#define COMPRESSION_NAME_GZIP "gzip"           // Name of gzip compression in messages
+#define COMPRESSION_NAME_ZSTD "zstd"           // Name of Zstandard compression in messages
+
+// Exit codes, one per class of failure
+#define EXIT_CODE_SUCCESS 0                  // Every step succeeded
+#define EXIT_CODE_FAILURE 1                  // Failure without a more specific class
+#define EXIT_CODE_USAGE 2                    // Invalid command-line options
+#define EXIT_CODE_INPUT 3                    // Input cannot be opened or read
+#define EXIT_CODE_DATA 4                     // Input holds invalid student data
+#define EXIT_CODE_OUTPUT 5                   // Output cannot be written
+#define EXIT_CODE_MEMORY 6                   // Memory allocation failed
+#define EXIT_CODE_SECTION 7                  // One or more batch sections failed
+
+// Stream constants
+#define SCAN_BLOCK_SIZE 64                   // Bytes classified at a time by the structural scanner
+#define STREAM_READ_BLOCK_SIZE (1L << 20)    // Initial read buffer of an input stream, grown for longer lines
+#define STREAM_WRITE_BUFFER_SIZE (1L << 16)  // Buffer of standard output when results are written to it
+#define READ_AHEAD_BLOCK_SIZE (1L << 20)     // Bytes of one read kept in flight ahead of the parser
+#define READ_AHEAD_BLOCK_COUNT 4             // Reads in flight, or blocks read and not yet parsed
+#define DECOMPRESS_INPUT_SIZE (1L << 17)     // Compressed bytes read at a time by the decompressing thread
+#define DECOMPRESS_RING_SIZE (1L << 22)      // Decompressed bytes buffered ahead of the parser
+#define COMPRESSION_MAGIC_SIZE 4             // Bytes of the longest magic number of a compressed stream
+
 // Default file names
 #define DEFAULT_INPUT_FILE_NAME "input.txt"   // Default input file name
 #define DEFAULT_OUTPUT_FILE_NAME "output.txt" // Default output file name
@@ -33,18 +109,146 @@
 // Class statistics constants
 #define MINIMUM_SCORE 0
 #define MAXIMUM_SCORE 100
+#define SCORE_VALUE_COUNT (MAXIMUM_SCORE - MINIMUM_SCORE + 1)
 #define ROW_AVERAGE 0
 #define ROW_MINIMUM 1
 #define ROW_MAXIMUM 2
 #define STATS_COLUMN_WIDTH 8
 #define STATS_PRECISION 2
 #define DEFAULT_GRADE 'F'
+#define STATS_CSV_HEADER "statistic,name,value\n"
+#define STAT_NAME_STUDENTS "Students"
+#define STAT_NAME_COUNT "Count"
+#define STAT_NAME_PERCENT "Percent"
+#define STAT_NAME_HISTOGRAM "Histogram"
+#define STAT_NAME_TOP "Top"
+#define STAT_NAME_BOTTOM "Bottom"
+
+// Grade distribution constants
+#define NUMBER_OF_GRADES 5         // Number of letter grades (A to F)
+#define HISTOGRAM_BUCKET_WIDTH 10  // Width of a weighted score histogram bucket
+#define HISTOGRAM_BUCKET_COUNT 10  // Number of buckets (a perfect score is counted in the last bucket)
+#define HISTOGRAM_BAR_WIDTH 40     // Maximum number of characters for a histogram bar
+#define HISTOGRAM_BAR_CHAR '*'     // Character used to draw histogram bars
+#define PERCENT_SCALE 100.0        // Scale a fraction to a percentage
+
+// Ranking constants
+#define RANK_PERCENT_CHAR '%'                              // Ends a top or bottom size given as a percent of the class
+#define RANK_WIDTH 6                                       // Width of the rank column of the ranking report
+#define RANK_STUDENT_FORMAT "\n%-*d%-*s%*.*f%*c"           // Rank, name, weighted score and letter of the ranking report
+#define RANK_CSV_HEADER "list,rank,name,score,grade\n"     // Header of the ranking output
+#define RANK_LIST_NAME_TOP "top"                           // List column of the highest weighted scores
+#define RANK_LIST_NAME_BOTTOM "bottom"                     // List column of the lowest weighted scores
+
+// Batch constants
+#define FILE_NAME_SIZE 1024                          // Size of a file name buffer
+#define MAXIMUM_TEST_COUNT 32                        // Largest number of tests in a grading schema
+#define MAXIMUM_THREAD_COUNT 1024                    // Largest number of worker threads
+#define THREAD_POOL_QUEUE_SIZE 16                    // Initial number of tasks per worker queue
+#define BATCH_PACK_BYTES (1L << 20)                  // Small rosters are packed into tasks of about this size
+#define BATCH_PACK_FILES 64                          // Most rosters packed into one task
+#define BATCH_SPLIT_BYTES (8L << 20)                 // Rosters of at least this size are split across workers
+#define BATCH_READ_BLOCK_SIZE 4096                   // Bytes read at a time when looking for a line boundary
+#define BATCH_OUTPUT_SUFFIX ".grades.txt"            // Suffix of each section's output file
+#define BATCH_SUMMARY_FILE_NAME "batch_summary.txt"  // Cross-section statistics file in the output directory
+#define MANIFEST_COMMENT_CHAR '#'                    // Manifest lines starting with this are ignored
+#define PATH_SEPARATOR_CHAR '/'                      // Separator between directory and file names
+#define PATH_SEPARATOR_WINDOWS_CHAR '\\'           // Separator used by Windows paths
+
+// Profiler constants
+#define NANOSECONDS_PER_SECOND 1000000000LL     // Nanoseconds in a second
+#define NANOSECONDS_PER_MILLISECOND 1.0e6       // Nanoseconds in a millisecond
+#define NANOSECONDS_PER_MICROSECOND 1.0e3       // Nanoseconds in a microsecond
+#define BYTES_PER_MEGABYTE (1024.0 * 1024.0)    // Bytes in a megabyte for throughput
+#define PROFILE_NAME_WIDTH 10                   // Width of the name column of the timing report
+#define PROFILE_COLUMN_WIDTH 10                 // Width of the value columns of the timing report
+#define PROFILE_PRECISION 3                     // Decimals of the millisecond column
+
+// Trace constants
+#define TRACE_RING_SIZE 8192                    // Events kept per thread, older ones are overwritten
+#define TRACE_LABEL_SIZE 64                     // Size of the roster name kept per event
+#define TRACE_WHOLE_FILE -1                     // Chunk index of an event that covers a whole roster
+#define TRACE_PROCESS_ID 1                      // Process id written to every event
+#define TRACE_THREAD_NAME "thread"              // Timeline row name, followed by the thread number
+#define TRACE_CATEGORY "grader"                 // Category of every event
+#define TRACE_STAGE_LOAD "load"                 // Reading input bytes
+#define TRACE_STAGE_PARSE "parse"               // Building records from lines
+#define TRACE_STAGE_GRADE "grade"               // Calculating letter grades
+#define TRACE_STAGE_MERGE "merge"               // Joining the byte ranges of a split roster
+#define TRACE_STAGE_SORT "sort"                 // Sorting records by name
+#define TRACE_STAGE_WRITE "write"               // Writing the letter grades
+
+// Daemon constants
+#define DAEMON_REQUEST_BUFFER_SIZE 16384        // Longest request line of a connection, in bytes
+#define DAEMON_REPLY_BUFFER_SIZE 4096           // Initial size of the reply buffer of a connection
+#define DAEMON_ROSTER_NAME_SIZE 64              // Size of a resident roster name, including '\0'
+#define DAEMON_LISTEN_BACKLOG 512               // Connections waiting to be accepted
+#define DAEMON_EVENT_COUNT 256                  // Events handled per wait of the event loop
+#define DAEMON_REQUEST_LOAD "LOAD"              // Parses, grades and keeps a roster: LOAD <roster> <file>
+#define DAEMON_REQUEST_UNLOAD "UNLOAD"          // Releases a roster: UNLOAD <roster>
+#define DAEMON_REQUEST_GRADE "GRADE"            // Letter grade of a student: GRADE <roster> <name>
+#define DAEMON_REQUEST_LOOKUP "LOOKUP"          // Scores and grade of a student: LOOKUP <roster> <name>
+#define DAEMON_REQUEST_STATS "STATS"            // Class statistics as JSON: STATS <roster>
+#define DAEMON_REQUEST_LIST "LIST"              // Resident rosters and their sizes
+#define DAEMON_REQUEST_PING "PING"              // Liveness check
+
+// Watch constants
+#define WATCH_DEBOUNCE_MS 300                    // Quiet time after the last change before the input is re-graded
+#define WATCH_EVENT_BUFFER_SIZE 4096             // Bytes of file change events read at a time
+#define WATCH_INDEX_INITIAL_CAPACITY 1024        // Initial number of slots of the line index, a power of two
+#define WATCH_TEMPORARY_SUFFIX ".XXXXXX"         // Suffix of the temporary output, replaced before the rename
+#define LINE_HASH_OFFSET 14695981039346656037ULL // FNV-1a 64 bit offset basis
+#define LINE_HASH_PRIME 1099511628211ULL         // FNV-1a 64 bit prime
+
+// Output writer constants
+#define OUTPUT_BUFFER_SIZE (1L << 18)           // Bytes formatted before they are handed to the stream
+#define OUTPUT_RECORD_RESERVE 64                // Bytes reserved for the fields of a record besides the name
+#define OUTPUT_CSV_HEADER "name,weighted_score,grade\n"
+#define OUTPUT_BINARY_MAGIC "LGRADES"           // Start of every packed binary output, with its terminator
+#define OUTPUT_BINARY_MAGIC_SIZE 8              // Bytes of 'OUTPUT_BINARY_MAGIC' including the terminator
+#define OUTPUT_BINARY_VERSION 1                 // Layout version of the packed binary output
+#define SCORE_HUNDREDTHS 100                    // Weighted scores are written with two decimals
+
+// Sort key constants
+#define SORT_KEY_DIGIT_BITS 8                            // Bits of the sort key ordered by one radix pass
+#define SORT_KEY_BUCKET_COUNT (1 << SORT_KEY_DIGIT_BITS) // Buckets of one radix pass
+#define SORT_KEY_BITS 64                                 // Bits of a packed sort key
+
+// Collation constants
+#define COLLATION_FOLD_FIRST 0xC0     // First code point folded by its table, 'À'
+#define COLLATION_FOLD_LAST 0x17F     // Last code point folded by its table, 'ſ'
+#define COLLATION_FOLD_KEEP '.'       // Table entry of a code point that is not a letter and is kept
+#define COLLATION_FOLD_EXPANSION '1'  // Table entry of the first code point folded to two letters
+#define COLLATION_PREFIX_SIZE 8       // Key bytes compared as one integer before the rest of the key
+
+// Duplicate detection constants
+#define DUPLICATE_DIAGNOSTIC_COUNT 16 // Duplicate students named on the console, later ones are only counted
+#define DUPLICATE_SLOTS_PER_STUDENT 2 // Slots of the name set per student, keeps it at most half full
+
+// Rejected row constants
+#define REJECT_DIAGNOSTIC_COUNT 16              // Diagnostics kept for the console, later rejects are only counted
+#define REJECT_MESSAGE_SIZE 128                 // Size of the reason text of one rejected row
+#define REJECT_FILE_HEADER "line,reason,detail,row\n"
+#define REJECT_COPY_BUFFER_SIZE 4096            // Bytes copied at a time when the parts of a parallel parse are merged
+
+// Grade index constants
+#define INDEX_MAGIC "LGINDEX"                   // Start of every grade index file, with its terminator
+#define INDEX_MAGIC_SIZE 8                      // Bytes of 'INDEX_MAGIC' including the terminator
+#define INDEX_VERSION 1                         // Layout version of the grade index file
+
+// Allocation telemetry constants
+#define ALLOCATION_HISTOGRAM_BUCKET_COUNT 20    // Size classes of the allocation histogram, the last one is open
+#define ALLOCATION_HISTOGRAM_SMALLEST_SIZE 16   // Largest requested size counted in the first size class
+#define BYTES_PER_KILOBYTE 1024.0               // Bytes in a kilobyte for the timing report
+
+// Message constants
+#define MESSAGE_BUFFER_SIZE 256 // Size of the last message kept by a grading context
 
 // String and character constants
 #define COMMA ","               // String comma for parser
+#define COMMA_CHAR ','          // Char comma for parser
 #define STRING_TERMINATION '\0' // Char for string termination
 #define END_OF_LINE_CHAR '\n'   // Char for end of line
-#define SIZE_OF_NEW_LINE 2      // "\n\r" for Windows
-#define END_OF_FILE_CHAR EOF    // Char for end of file
+#define CARRIAGE_RETURN_CHAR '\r' // Char for carriage return in Windows line endings
 
 #endif // CONSTANTS_H
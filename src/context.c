@@ -0,0 +1,258 @@
+/**
+ * @file context.c
+ * @brief Creation and release of the grading context.
+ *
+ * A grading context owns everything one grading job needs: the student table, the grading
+ * schema, the allocation counters, the tokenizer state and the grade distribution. Nothing
+ * is kept in file scope variables, so independent jobs can run at the same time in one
+ * process as long as each job uses its own context. Error and warning messages are also
+ * routed through the context, so an embedding application can keep the console silent.
+ */
+
+// Library includes
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "memory.h"
+#include "profiler.h"
+#include "rank.h"
+#include "student.h"
+
+// Function declaration
+ReturnStatus write_message(GradingContext *, const char *, va_list);
+
+/**
+ * @brief Initializes a grading context.
+ *
+ * Clears the student table, counters and distribution and selects the grading schema.
+ * The default schema is used when 'pSchema' is NULL. Messages go to 'stdout' until
+ * another stream is selected with 'set_message_stream'.
+ *
+ * @param pContext The context to initialize.
+ * @param pSchema The grading schema, or NULL for the default schema.
+ *
+ * @return SUCCESS if the context is initialized.
+ *         FAILURE if the context is NULL.
+ */
+ReturnStatus init_grading_context(GradingContext *pContext, const GradingSchema *pSchema)
+{
+    if (pContext == NULL)
+    {
+        return FAILURE;
+    }
+
+    *pContext = (GradingContext){0};
+    pContext->schema = (pSchema != NULL) ? pSchema : &DEFAULT_GRADING_SCHEMA;
+    pContext->pMessageStream = stdout;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Releases all memory owned by a grading context.
+ *
+ * Deletes the student records and any tokenizer buffer left over from a failed parse.
+ * The context can be initialized again and reused afterwards.
+ *
+ * @param pContext The context to clear.
+ *
+ * @return SUCCESS if the context is cleared.
+ *         FAILURE if the student records could not be deleted.
+ */
+ReturnStatus clear_grading_context(GradingContext *pContext)
+{
+    if (pContext == NULL)
+    {
+        return FAILURE;
+    }
+
+    // Delete student records from memory
+    if (delete_students(pContext) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    // The ranking points at the records just deleted
+    clear_student_ranking(pContext);
+
+    // Release a tokenizer buffer left by a line that failed to parse
+    clear_string_memory(pContext, pContext->tokenizer.buffer);
+    pContext->tokenizer.buffer = NULL;
+    pContext->tokenizer.cursor = NULL;
+    pContext->tokenizer.block = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Moves the students of one context to the end of another.
+ *
+ * The source table is spliced onto the target table in constant time, and the grade
+ * distribution and allocation counters move with the records, so the target can release
+ * them later. Phase times measured in the source are added to the target. The source is
+ * left empty. Both contexts must use the same grading schema.
+ *
+ * @param pTarget The context that receives the students.
+ * @param pSource The context whose students are moved.
+ *
+ * @return SUCCESS if the students are moved.
+ *         FAILURE if either context is NULL.
+ */
+ReturnStatus merge_grading_context(GradingContext *pTarget, GradingContext *pSource)
+{
+    if (pTarget == NULL || pSource == NULL)
+    {
+        return FAILURE;
+    }
+
+    // Splice the source list after the target list
+    if (pSource->table.head != NULL)
+    {
+        if (pTarget->table.head == NULL)
+        {
+            pTarget->table.head = pSource->table.head;
+        }
+        else
+        {
+            pTarget->table.tail->next = pSource->table.head;
+        }
+        pTarget->table.tail = pSource->table.tail;
+        pTarget->table.nStudents += pSource->table.nStudents;
+    }
+
+    merge_grade_distribution(&pTarget->distribution, &pSource->distribution);
+
+    // The target now owns the source allocations
+    merge_allocator(&pTarget->allocator, &pSource->allocator);
+    merge_profiler(&pTarget->profiler, &pSource->profiler);
+
+    pSource->table = (StudentTable){0};
+    pSource->distribution = (GradeDistribution){0};
+    pSource->allocator = (Allocator){0};
+    pSource->profiler = (Profiler){0};
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Selects the tracer that records the stages of this job.
+ *
+ * @param pContext The grading context.
+ * @param pTracer The tracer, or NULL to record nothing.
+ *
+ * @return SUCCESS if the tracer is selected.
+ *         FAILURE if the context is NULL.
+ */
+ReturnStatus set_tracer(GradingContext *pContext, Tracer *pTracer)
+{
+    if (pContext == NULL)
+    {
+        return FAILURE;
+    }
+
+    pContext->pTracer = pTracer;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Selects the stream that receives error and warning messages.
+ *
+ * @param pContext The grading context.
+ * @param pStream The stream for messages, or NULL to only keep the last message.
+ *
+ * @return SUCCESS if the stream is selected.
+ *         FAILURE if the context is NULL.
+ */
+ReturnStatus set_message_stream(GradingContext *pContext, FILE *pStream)
+{
+    if (pContext == NULL)
+    {
+        return FAILURE;
+    }
+
+    pContext->pMessageStream = pStream;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reports a warning message for a grading context.
+ *
+ * The formatted message is kept as the context's last message, without the leading
+ * line breaks used for console layout, and written to the message stream if one is set.
+ *
+ * @param pContext The grading context reporting the message.
+ * @param pFormat The 'printf' style message format from 'messages.h'.
+ *
+ * @return SUCCESS after the message is reported.
+ */
+ReturnStatus report_message(GradingContext *pContext, const char *pFormat, ...)
+{
+    va_list args;
+
+    va_start(args, pFormat);
+    write_message(pContext, pFormat, args);
+    va_end(args);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reports an error message and records its class for a grading context.
+ *
+ * The message is handled like 'report_message'. The class lets the application pick
+ * the exit code of a failed run.
+ *
+ * @param pContext The grading context reporting the error.
+ * @param errorClass The class of the failure.
+ * @param pFormat The 'printf' style message format from 'messages.h'.
+ *
+ * @return SUCCESS after the error is reported.
+ */
+ReturnStatus report_error(GradingContext *pContext, ErrorClass errorClass, const char *pFormat, ...)
+{
+    va_list args;
+
+    pContext->errorClass = errorClass;
+
+    va_start(args, pFormat);
+    write_message(pContext, pFormat, args);
+    va_end(args);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Keeps and prints a formatted message.
+ *
+ * @param pContext The grading context reporting the message.
+ * @param pFormat The 'printf' style message format.
+ * @param args The message arguments.
+ *
+ * @return SUCCESS after the message is written.
+ */
+ReturnStatus write_message(GradingContext *pContext, const char *pFormat, va_list args)
+{
+    // Keep the message for callers that do not print to the console
+    vsnprintf(pContext->lastMessage, MESSAGE_BUFFER_SIZE, pFormat, args);
+
+    // Print the message with its original layout
+    if (pContext->pMessageStream != NULL)
+    {
+        fputs(pContext->lastMessage, pContext->pMessageStream);
+    }
+
+    // Drop the leading line breaks from the kept message
+    int nSkip = 0;
+    while (pContext->lastMessage[nSkip] == END_OF_LINE_CHAR)
+    {
+        nSkip++;
+    }
+    memmove(pContext->lastMessage, pContext->lastMessage + nSkip, strlen(pContext->lastMessage + nSkip) + 1);
+
+    return SUCCESS;
+}
@@ -0,0 +1,16 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus init_grading_context(GradingContext *, const GradingSchema *);
+ReturnStatus clear_grading_context(GradingContext *);
+ReturnStatus merge_grading_context(GradingContext *, GradingContext *);
+ReturnStatus set_message_stream(GradingContext *, FILE *);
+ReturnStatus set_tracer(GradingContext *, Tracer *);
+ReturnStatus report_message(GradingContext *, const char *, ...);
+ReturnStatus report_error(GradingContext *, ErrorClass, const char *, ...);
+
+#endif // CONTEXT_H
@@ -0,0 +1,1228 @@
+/**
+ * @file daemon.c
+ * @brief Grading daemon that keeps rosters in memory and answers requests on a Unix socket.
+ *
+ * Starting the application for every request costs process start-up, opening the roster
+ * and a full parse. The daemon parses and grades a roster once, on a LOAD request, and keeps
+ * the graded students, an index sorted by name and the class statistics in memory, so later
+ * requests are answered without touching the file.
+ *
+ * The protocol is line based. Each request is one line, a command followed by space
+ * separated arguments, and gets exactly one reply line that starts with 'OK' or 'ERR':
+ *
+ *     LOAD <roster> <file>     OK <students>          Parses and grades a file, replacing a roster of that name
+ *     UNLOAD <roster>          OK
+ *     GRADE <roster> <name>    OK <letter> <score>
+ *     LOOKUP <roster> <name>   OK <name>,<scores...>,<letter>,<score>
+ *     STATS <roster>           OK <statistics JSON>
+ *     LIST                     OK <roster>:<students> ...
+ *     PING                     OK
+ *
+ * One thread runs an epoll event loop that accepts connections and moves bytes. Complete
+ * request lines of a connection are answered by a thread pool worker, all lines received
+ * so far in one task, and the worker hands the connection back through an eventfd. A
+ * connection has at most one task at a time, so replies keep the order of the requests,
+ * and new requests wait until the previous replies are sent. Rosters are shared by all
+ * workers behind a reader-writer lock; only LOAD and UNLOAD take it for writing, and LOAD
+ * parses the file before taking it.
+ *
+ * SIGINT and SIGTERM stop the daemon. They are blocked everywhere except while the event
+ * loop waits, so no worker is interrupted.
+ */
+
+// Library includes
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "daemon.h"
+
+#ifdef __linux__
+
+// Library includes
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Code includes
+#include "file.h"
+#include "helper.h"
+#include "memory.h"
+#include "student.h"
+#include "threadpool.h"
+
+// Define a roster kept in memory between requests
+typedef struct
+{
+    char name[DAEMON_ROSTER_NAME_SIZE]; // Name the requests use
+    GradingContext context;             // Graded students, sorted by name
+    Record **index;                     // Students sorted by name, for binary search
+    int nStudents;                      // Number of entries in 'index'
+    char *statistics;                   // Class statistics as one JSON line
+    size_t nStatistics;                 // Length of 'statistics'
+} ResidentRoster;
+
+typedef struct grading_daemon GradingDaemon;
+
+// Define one client connection
+typedef struct daemon_connection
+{
+    int descriptor;                           // Socket of the client
+    GradingDaemon *daemon;                    // Daemon that serves the client
+    char request[DAEMON_REQUEST_BUFFER_SIZE]; // Received bytes not yet answered
+    long nBuffered;                           // Bytes in 'request'
+    long nRequested;                          // Bytes of complete lines handed to a worker
+    char *reply;                              // Replies not yet sent
+    long nReply;                              // Bytes in 'reply'
+    long nSent;                               // Bytes of 'reply' already sent
+    long capacity;                            // Size of 'reply'
+    unsigned int events;                      // Events the event loop waits for, 0 if none
+    Boolean isBusy;                           // TRUE while a worker answers the requested lines
+    Boolean isClosing;                        // TRUE once the client stops sending
+    Boolean isBroken;                         // TRUE if nothing more can be sent to the client
+    Boolean isOutOfMemory;                    // Set by the worker when a reply could not be stored
+    struct daemon_connection *previous;       // Previous open connection
+    struct daemon_connection *next;           // Next open connection
+    struct daemon_connection *nextDone;       // Next connection handed back by the workers
+} DaemonConnection;
+
+// Define daemon state
+struct grading_daemon
+{
+    GradingContext context;        // Roster registry allocations and console messages
+    pthread_rwlock_t rosterLock;   // Shared to answer requests, exclusive to change the registry
+    ResidentRoster **rosters;      // Resident rosters
+    int nRosters;                  // Number of resident rosters
+    int capacity;                  // Number of entries 'rosters' can hold
+    ThreadPool *pool;              // Workers that answer requests
+    int epoll;                     // Event loop descriptor
+    int listener;                  // Listening socket
+    int wake;                      // Event descriptor the workers signal when a connection is done
+    pthread_mutex_t doneLock;      // Protects 'done'
+    DaemonConnection *done;        // Connections whose requests are answered
+    DaemonConnection *connections; // Open connections
+    DaemonConnection *closed;      // Connections closed during the current event batch
+    atomic_long nRequests;         // Requests answered
+};
+
+// Set by the signal handler, the only state of the daemon outside 'GradingDaemon'
+static volatile sig_atomic_t isStopRequested = 0;
+
+// Function declaration
+void request_daemon_stop(int);
+ReturnStatus open_daemon_socket(GradingDaemon *, const char *);
+ReturnStatus run_event_loop(GradingDaemon *, const sigset_t *);
+ReturnStatus accept_connections(GradingDaemon *);
+ReturnStatus read_connection(DaemonConnection *);
+ReturnStatus flush_reply(DaemonConnection *);
+ReturnStatus finish_requests(GradingDaemon *);
+ReturnStatus update_connection(GradingDaemon *, DaemonConnection *);
+Boolean dispatch_requests(GradingDaemon *, DaemonConnection *);
+ReturnStatus set_connection_events(GradingDaemon *, DaemonConnection *, unsigned int);
+ReturnStatus close_connection(GradingDaemon *, DaemonConnection *);
+void answer_requests_task(void *);
+ReturnStatus answer_request(GradingDaemon *, DaemonConnection *, char *);
+ReturnStatus append_reply(DaemonConnection *, const char *, ...);
+ReturnStatus load_roster(GradingDaemon *, DaemonConnection *, const char *, const char *);
+ReturnStatus unload_roster(GradingDaemon *, DaemonConnection *, const char *);
+ReturnStatus build_roster_index(ResidentRoster *);
+ReturnStatus destroy_roster(ResidentRoster *);
+int find_roster(const GradingDaemon *, const char *);
+Record *find_student(const ResidentRoster *, const char *);
+const char *get_reply_message(const char *);
+
+/**
+ * @brief Serves grading requests on a Unix domain socket until SIGINT or SIGTERM.
+ *
+ * The socket file is created on start and removed on exit. A socket file left behind by a
+ * daemon that no longer runs is replaced; a socket another daemon still listens on is not.
+ *
+ * @param pSocketName Path of the Unix domain socket.
+ * @param nThreads Number of worker threads, zero for one per processor.
+ * @param pProgressStream Stream for the start and stop messages, or NULL for none.
+ * @param pErrorClass Pointer that receives the class of the failure.
+ *
+ * @return SUCCESS if the daemon stopped on a signal.
+ *         FAILURE if the socket, the thread pool or the event loop failed.
+ */
+ReturnStatus run_daemon(const char *pSocketName, int nThreads, FILE *pProgressStream, ErrorClass *pErrorClass)
+{
+    GradingDaemon daemon = {0};
+    ReturnStatus status = SUCCESS;
+    sigset_t stopSignals, originalSignals;
+
+    init_grading_context(&daemon.context, NULL);
+    set_message_stream(&daemon.context, stderr);
+    pthread_rwlock_init(&daemon.rosterLock, NULL);
+    pthread_mutex_init(&daemon.doneLock, NULL);
+    atomic_init(&daemon.nRequests, 0);
+    daemon.epoll = daemon.listener = daemon.wake = -1;
+    nThreads = (nThreads > 0) ? nThreads : get_processor_count();
+
+    // Workers inherit the blocked signals, only the event loop wait lets them through
+    struct sigaction action = {0};
+    action.sa_handler = request_daemon_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &originalSignals);
+
+    do
+    {
+        if (open_daemon_socket(&daemon, pSocketName) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        if (create_thread_pool(&daemon.pool, nThreads) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        if (pProgressStream != NULL)
+        {
+            fprintf(pProgressStream, MSG_DAEMON_START, pSocketName, nThreads, (nThreads == 1) ? "" : MSG_PLURAL_SUFFIX);
+            fflush(pProgressStream);
+        }
+
+        status = run_event_loop(&daemon, &originalSignals);
+    } while (FALSE); // This loop runs only once, allowing for an easy break if any step fails
+
+    // Let running workers finish before their connections are released
+    if (daemon.pool != NULL)
+    {
+        wait_thread_pool(daemon.pool);
+        destroy_thread_pool(&daemon.pool);
+    }
+    while (daemon.connections != NULL)
+    {
+        close_connection(&daemon, daemon.connections);
+    }
+    finish_requests(&daemon);
+
+    for (int n = 0; n < daemon.nRosters; n++)
+    {
+        destroy_roster(daemon.rosters[n]);
+    }
+    clear_buffer_memory(&daemon.context, daemon.rosters);
+
+    if (daemon.listener >= 0)
+    {
+        close(daemon.listener);
+        unlink(pSocketName);
+    }
+    if (daemon.wake >= 0)
+    {
+        close(daemon.wake);
+    }
+    if (daemon.epoll >= 0)
+    {
+        close(daemon.epoll);
+    }
+    pthread_rwlock_destroy(&daemon.rosterLock);
+    pthread_mutex_destroy(&daemon.doneLock);
+    pthread_sigmask(SIG_SETMASK, &originalSignals, NULL);
+
+    if (pProgressStream != NULL && status == SUCCESS)
+    {
+        fprintf(pProgressStream, MSG_DAEMON_STOP, atomic_load(&daemon.nRequests));
+    }
+
+    *pErrorClass = daemon.context.errorClass;
+
+    return status;
+}
+
+/**
+ * @brief Signal handler that asks the event loop to stop.
+ *
+ * @param signalNumber The signal received.
+ */
+void request_daemon_stop(int signalNumber)
+{
+    (void)signalNumber;
+    isStopRequested = 1;
+}
+
+/**
+ * @brief Creates the listening socket, the wake descriptor and the event loop descriptor.
+ *
+ * @param daemon The daemon.
+ * @param pSocketName Path of the Unix domain socket.
+ *
+ * @return SUCCESS if the daemon listens on the socket, otherwise FAILURE.
+ */
+ReturnStatus open_daemon_socket(GradingDaemon *daemon, const char *pSocketName)
+{
+    struct sockaddr_un address = {0};
+    struct stat information;
+
+    address.sun_family = AF_UNIX;
+    if (strlen(pSocketName) >= sizeof(address.sun_path))
+    {
+        report_error(&daemon->context, ERROR_CLASS_USAGE, ERR_DAEMON_SOCKET, pSocketName);
+        return FAILURE;
+    }
+    strcpy(address.sun_path, pSocketName);
+
+    daemon->listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (daemon->listener < 0)
+    {
+        report_error(&daemon->context, ERROR_CLASS_OUTPUT, ERR_DAEMON_SOCKET, pSocketName);
+        return FAILURE;
+    }
+
+    // Replace a socket file only if no daemon answers on it any more
+    if (stat(pSocketName, &information) == 0)
+    {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        Boolean isStale = (S_ISSOCK(information.st_mode) && probe >= 0 &&
+                           connect(probe, (struct sockaddr *)&address, sizeof(address)) != 0) ? TRUE : FALSE;
+        if (probe >= 0)
+        {
+            close(probe);
+        }
+        if (isStale == FALSE)
+        {
+            report_error(&daemon->context, ERROR_CLASS_OUTPUT, ERR_DAEMON_SOCKET, pSocketName);
+            close(daemon->listener);
+            daemon->listener = -1;
+            return FAILURE;
+        }
+        unlink(pSocketName);
+    }
+
+    if (bind(daemon->listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(daemon->listener, DAEMON_LISTEN_BACKLOG) != 0 ||
+        fcntl(daemon->listener, F_SETFL, fcntl(daemon->listener, F_GETFL) | O_NONBLOCK) != 0)
+    {
+        report_error(&daemon->context, ERROR_CLASS_OUTPUT, ERR_DAEMON_SOCKET, pSocketName);
+        close(daemon->listener);
+        daemon->listener = -1;
+        return FAILURE;
+    }
+
+    daemon->wake = eventfd(0, EFD_NONBLOCK);
+    daemon->epoll = epoll_create1(0);
+    if (daemon->wake < 0 || daemon->epoll < 0)
+    {
+        report_error(&daemon->context, ERROR_CLASS_MEMORY, ERR_DAEMON_SOCKET, pSocketName);
+        return FAILURE;
+    }
+
+    // The listener and the wake descriptor are told apart from connections by their address
+    struct epoll_event event = {0};
+    event.events = EPOLLIN;
+    event.data.ptr = &daemon->listener;
+    epoll_ctl(daemon->epoll, EPOLL_CTL_ADD, daemon->listener, &event);
+    event.data.ptr = &daemon->wake;
+    epoll_ctl(daemon->epoll, EPOLL_CTL_ADD, daemon->wake, &event);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Waits for socket events and moves request and reply bytes until a stop is requested.
+ *
+ * Connections closed while handling a batch of events are freed after the batch, because a
+ * later event of the same batch may still point to them.
+ *
+ * @param daemon The daemon.
+ * @param pWaitSignals Signal mask while waiting, with the stop signals unblocked.
+ *
+ * @return SUCCESS if the loop stopped on a signal, otherwise FAILURE.
+ */
+ReturnStatus run_event_loop(GradingDaemon *daemon, const sigset_t *pWaitSignals)
+{
+    struct epoll_event events[DAEMON_EVENT_COUNT];
+
+    while (isStopRequested == 0)
+    {
+        int nEvents = epoll_pwait(daemon->epoll, events, DAEMON_EVENT_COUNT, -1, pWaitSignals);
+        if (nEvents < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            report_error(&daemon->context, ERROR_CLASS_NONE, ERR_DAEMON_EVENT_LOOP);
+            return FAILURE;
+        }
+
+        for (int n = 0; n < nEvents; n++)
+        {
+            void *pSource = events[n].data.ptr;
+
+            if (pSource == &daemon->listener)
+            {
+                accept_connections(daemon);
+            }
+            else if (pSource == &daemon->wake)
+            {
+                finish_requests(daemon);
+            }
+            else
+            {
+                DaemonConnection *connection = (DaemonConnection *)pSource;
+                if (connection->descriptor < 0)
+                {
+                    continue; // Closed earlier in this batch
+                }
+                if ((events[n].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0)
+                {
+                    read_connection(connection);
+                }
+                if ((events[n].events & EPOLLOUT) != 0 && connection->isBusy == FALSE)
+                {
+                    flush_reply(connection);
+                }
+                update_connection(daemon, connection);
+            }
+        }
+
+        while (daemon->closed != NULL)
+        {
+            DaemonConnection *next = daemon->closed->next;
+            free(daemon->closed->reply);
+            free(daemon->closed);
+            daemon->closed = next;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Accepts every waiting connection.
+ *
+ * Connections are allocated with 'malloc' because workers grow their reply buffers, and the
+ * allocation counters of the daemon context are not shared between threads.
+ *
+ * @param daemon The daemon.
+ *
+ * @return SUCCESS after the waiting connections are accepted.
+ */
+ReturnStatus accept_connections(GradingDaemon *daemon)
+{
+    int descriptor;
+
+    while ((descriptor = accept(daemon->listener, NULL, NULL)) >= 0)
+    {
+        DaemonConnection *connection = (DaemonConnection *)malloc(sizeof(DaemonConnection));
+        if (connection == NULL || fcntl(descriptor, F_SETFL, fcntl(descriptor, F_GETFL) | O_NONBLOCK) != 0)
+        {
+            free(connection);
+            close(descriptor);
+            continue;
+        }
+
+        connection->descriptor = descriptor;
+        connection->daemon = daemon;
+        connection->nBuffered = connection->nRequested = 0;
+        connection->reply = NULL;
+        connection->nReply = connection->nSent = connection->capacity = 0;
+        connection->events = 0;
+        connection->isBusy = connection->isClosing = connection->isBroken = connection->isOutOfMemory = FALSE;
+        connection->nextDone = NULL;
+
+        connection->previous = NULL;
+        connection->next = daemon->connections;
+        if (daemon->connections != NULL)
+        {
+            daemon->connections->previous = connection;
+        }
+        daemon->connections = connection;
+
+        set_connection_events(daemon, connection, EPOLLIN);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads the bytes a client has sent into its request buffer.
+ *
+ * Reading goes on while a worker answers earlier lines; the worker only uses the bytes
+ * before 'nRequested'.
+ *
+ * @param connection The connection.
+ *
+ * @return SUCCESS after the available bytes are read.
+ */
+ReturnStatus read_connection(DaemonConnection *connection)
+{
+    if (connection->isClosing == TRUE || connection->nBuffered == DAEMON_REQUEST_BUFFER_SIZE)
+    {
+        return SUCCESS;
+    }
+
+    ssize_t nRead = read(connection->descriptor, connection->request + connection->nBuffered,
+                         DAEMON_REQUEST_BUFFER_SIZE - connection->nBuffered);
+    if (nRead > 0)
+    {
+        connection->nBuffered += nRead;
+    }
+    else if (nRead == 0)
+    {
+        // The client sent its last request, the lines already received are still answered
+        connection->isClosing = TRUE;
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        connection->isClosing = TRUE;
+        connection->isBroken = TRUE;
+        connection->nBuffered = connection->nRequested;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Sends as much of the pending replies as the socket takes.
+ *
+ * Must not be called while a worker owns the connection.
+ *
+ * @param connection The connection.
+ *
+ * @return SUCCESS after the bytes are sent or the socket is full.
+ */
+ReturnStatus flush_reply(DaemonConnection *connection)
+{
+    while (connection->isBroken == FALSE && connection->nSent < connection->nReply)
+    {
+        ssize_t nWritten = send(connection->descriptor, connection->reply + connection->nSent,
+                                connection->nReply - connection->nSent, MSG_NOSIGNAL);
+        if (nWritten > 0)
+        {
+            connection->nSent += nWritten;
+        }
+        else if (nWritten < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            return SUCCESS;
+        }
+        else if (nWritten < 0 && errno != EINTR)
+        {
+            connection->isClosing = TRUE;
+            connection->isBroken = TRUE;
+        }
+    }
+
+    // Everything is sent, or can never be
+    connection->nReply = connection->nSent = 0;
+    if (connection->isBroken == TRUE)
+    {
+        connection->nBuffered = 0;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes back the connections whose requests the workers have answered.
+ *
+ * @param daemon The daemon.
+ *
+ * @return SUCCESS after the connections are taken back.
+ */
+ReturnStatus finish_requests(GradingDaemon *daemon)
+{
+    uint64_t nSignals;
+
+    if (daemon->wake >= 0 && read(daemon->wake, &nSignals, sizeof(nSignals)) < 0)
+    {
+        // Nothing signalled, the done list is still checked
+    }
+
+    pthread_mutex_lock(&daemon->doneLock);
+    DaemonConnection *connection = daemon->done;
+    daemon->done = NULL;
+    pthread_mutex_unlock(&daemon->doneLock);
+
+    while (connection != NULL)
+    {
+        DaemonConnection *next = connection->nextDone;
+
+        // Drop the answered lines and keep what arrived meanwhile
+        memmove(connection->request, connection->request + connection->nRequested,
+                connection->nBuffered - connection->nRequested);
+        connection->nBuffered -= connection->nRequested;
+        connection->nRequested = 0;
+        connection->isBusy = FALSE;
+        if (connection->isOutOfMemory == TRUE)
+        {
+            connection->isClosing = TRUE;
+            connection->isBroken = TRUE;
+        }
+
+        if (connection->descriptor >= 0)
+        {
+            flush_reply(connection);
+            update_connection(daemon, connection);
+        }
+        connection = next;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Hands new requests to a worker, closes a finished connection and updates the events
+ *        the event loop waits for.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection.
+ *
+ * @return SUCCESS after the connection is updated.
+ */
+ReturnStatus update_connection(GradingDaemon *daemon, DaemonConnection *connection)
+{
+    unsigned int events = 0;
+
+    if (connection->isBusy == FALSE && connection->nSent == connection->nReply)
+    {
+        if (dispatch_requests(daemon, connection) == FALSE && connection->isClosing == TRUE)
+        {
+            close_connection(daemon, connection);
+            return SUCCESS;
+        }
+    }
+
+    if (connection->isClosing == FALSE && connection->nBuffered < DAEMON_REQUEST_BUFFER_SIZE)
+    {
+        events |= EPOLLIN;
+    }
+    if (connection->isBusy == FALSE && connection->nSent < connection->nReply)
+    {
+        events |= EPOLLOUT;
+    }
+
+    return set_connection_events(daemon, connection, events);
+}
+
+/**
+ * @brief Hands the complete request lines of an idle connection to a worker.
+ *
+ * A buffer full of bytes without a line end cannot become a request; the client gets an
+ * error and the connection is closed once it is sent.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection, with no reply left to send.
+ *
+ * @return TRUE if a worker answers the connection now, otherwise FALSE.
+ */
+Boolean dispatch_requests(GradingDaemon *daemon, DaemonConnection *connection)
+{
+    long nComplete = connection->nBuffered;
+
+    while (nComplete > 0 && connection->request[nComplete - 1] != END_OF_LINE_CHAR)
+    {
+        nComplete--;
+    }
+
+    if (nComplete == 0)
+    {
+        if (connection->nBuffered == DAEMON_REQUEST_BUFFER_SIZE && connection->isClosing == FALSE)
+        {
+            append_reply(connection, DAEMON_REPLY_TOO_LONG, DAEMON_REQUEST_BUFFER_SIZE);
+            connection->isClosing = TRUE;
+            connection->nBuffered = 0;
+            flush_reply(connection);
+        }
+        return FALSE;
+    }
+
+    connection->nRequested = nComplete;
+    connection->isBusy = TRUE;
+    if (submit_task(daemon->pool, answer_requests_task, connection) != SUCCESS)
+    {
+        connection->nRequested = 0;
+        connection->isBusy = FALSE;
+        connection->isClosing = TRUE;
+        connection->isBroken = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Changes the events the event loop waits for on a connection.
+ *
+ * A connection that waits for nothing is removed from the event loop, otherwise a client
+ * that hung up would keep reporting its hang up while a worker answers it.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection.
+ * @param events The epoll events to wait for, 0 for none.
+ *
+ * @return SUCCESS if the events are changed, otherwise FAILURE.
+ */
+ReturnStatus set_connection_events(GradingDaemon *daemon, DaemonConnection *connection, unsigned int events)
+{
+    struct epoll_event event = {0};
+    int operation;
+
+    if (events == connection->events)
+    {
+        return SUCCESS;
+    }
+
+    operation = (events == 0) ? EPOLL_CTL_DEL : (connection->events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    event.events = events;
+    event.data.ptr = connection;
+    connection->events = events;
+
+    return (epoll_ctl(daemon->epoll, operation, connection->descriptor, &event) == 0) ? SUCCESS : FAILURE;
+}
+
+/**
+ * @brief Closes a connection and moves it to the list freed after the current event batch.
+ *
+ * A connection a worker still owns is freed when the worker hands it back.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection.
+ *
+ * @return SUCCESS after the connection is closed.
+ */
+ReturnStatus close_connection(GradingDaemon *daemon, DaemonConnection *connection)
+{
+    set_connection_events(daemon, connection, 0);
+    close(connection->descriptor);
+    connection->descriptor = -1;
+
+    if (connection->previous != NULL)
+    {
+        connection->previous->next = connection->next;
+    }
+    else
+    {
+        daemon->connections = connection->next;
+    }
+    if (connection->next != NULL)
+    {
+        connection->next->previous = connection->previous;
+    }
+
+    connection->next = daemon->closed;
+    daemon->closed = connection;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Answers the requested lines of a connection on a pool worker.
+ *
+ * Empty lines get no reply. The connection is handed back to the event loop when every
+ * line is answered.
+ *
+ * @param pArgument The connection.
+ */
+void answer_requests_task(void *pArgument)
+{
+    DaemonConnection *connection = (DaemonConnection *)pArgument;
+    GradingDaemon *daemon = connection->daemon;
+    char *pLine = connection->request;
+    char *pEnd = connection->request + connection->nRequested;
+    uint64_t signal = 1;
+
+    while (pLine < pEnd)
+    {
+        char *pLineEnd = (char *)memchr(pLine, END_OF_LINE_CHAR, pEnd - pLine);
+        *pLineEnd = STRING_TERMINATION;
+        if (pLineEnd > pLine && pLineEnd[-1] == CARRIAGE_RETURN_CHAR)
+        {
+            pLineEnd[-1] = STRING_TERMINATION;
+        }
+
+        if (*pLine != STRING_TERMINATION)
+        {
+            answer_request(daemon, connection, pLine);
+            atomic_fetch_add(&daemon->nRequests, 1);
+        }
+        pLine = pLineEnd + 1;
+    }
+
+    pthread_mutex_lock(&daemon->doneLock);
+    connection->nextDone = daemon->done;
+    daemon->done = connection;
+    pthread_mutex_unlock(&daemon->doneLock);
+
+    if (write(daemon->wake, &signal, sizeof(signal)) < 0)
+    {
+        // The counter is already signalled, the event loop will find the connection
+    }
+}
+
+/**
+ * @brief Answers one request line.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection that receives the reply.
+ * @param pLine The request, split in place.
+ *
+ * @return SUCCESS if the request is answered with 'OK', otherwise FAILURE.
+ */
+ReturnStatus answer_request(GradingDaemon *daemon, DaemonConnection *connection, char *pLine)
+{
+    // Split the command, the roster name and the rest of the line
+    char *pRoster = strchr(pLine, ' ');
+    pRoster = (pRoster != NULL) ? (*pRoster = STRING_TERMINATION, pRoster + 1) : pLine + strlen(pLine);
+    char *pArgument = strchr(pRoster, ' ');
+    pArgument = (pArgument != NULL) ? (*pArgument = STRING_TERMINATION, pArgument + 1) : pRoster + strlen(pRoster);
+
+    if (strcmp(pLine, DAEMON_REQUEST_PING) == 0)
+    {
+        return append_reply(connection, DAEMON_REPLY_OK);
+    }
+
+    if (strcmp(pLine, DAEMON_REQUEST_LIST) == 0)
+    {
+        pthread_rwlock_rdlock(&daemon->rosterLock);
+        append_reply(connection, "OK");
+        for (int n = 0; n < daemon->nRosters; n++)
+        {
+            append_reply(connection, " %s:%d", daemon->rosters[n]->name, daemon->rosters[n]->nStudents);
+        }
+        pthread_rwlock_unlock(&daemon->rosterLock);
+        return append_reply(connection, "\n");
+    }
+
+    Boolean isStats = (strcmp(pLine, DAEMON_REQUEST_STATS) == 0) ? TRUE : FALSE;
+    Boolean isUnload = (strcmp(pLine, DAEMON_REQUEST_UNLOAD) == 0) ? TRUE : FALSE;
+    Boolean isLoad = (strcmp(pLine, DAEMON_REQUEST_LOAD) == 0) ? TRUE : FALSE;
+    Boolean isGrade = (strcmp(pLine, DAEMON_REQUEST_GRADE) == 0) ? TRUE : FALSE;
+    Boolean isLookup = (strcmp(pLine, DAEMON_REQUEST_LOOKUP) == 0) ? TRUE : FALSE;
+
+    if (isStats == FALSE && isUnload == FALSE && isLoad == FALSE && isGrade == FALSE && isLookup == FALSE)
+    {
+        append_reply(connection, DAEMON_REPLY_UNKNOWN_REQUEST, pLine);
+        return FAILURE;
+    }
+
+    // Every remaining request names a roster, and all but STATS and UNLOAD one more argument
+    if (*pRoster == STRING_TERMINATION ||
+        (isStats == FALSE && isUnload == FALSE && *pArgument == STRING_TERMINATION))
+    {
+        append_reply(connection, DAEMON_REPLY_MISSING_ARGUMENT, pLine);
+        return FAILURE;
+    }
+    if (strlen(pRoster) >= DAEMON_ROSTER_NAME_SIZE)
+    {
+        append_reply(connection, DAEMON_REPLY_ROSTER_NAME, pRoster);
+        return FAILURE;
+    }
+
+    if (isLoad == TRUE)
+    {
+        return load_roster(daemon, connection, pRoster, pArgument);
+    }
+    if (isUnload == TRUE)
+    {
+        return unload_roster(daemon, connection, pRoster);
+    }
+
+    ReturnStatus status = SUCCESS;
+    pthread_rwlock_rdlock(&daemon->rosterLock);
+
+    int nRoster = find_roster(daemon, pRoster);
+    if (nRoster < 0)
+    {
+        append_reply(connection, DAEMON_REPLY_UNKNOWN_ROSTER, pRoster);
+        status = FAILURE;
+    }
+    else if (isStats == TRUE)
+    {
+        const ResidentRoster *roster = daemon->rosters[nRoster];
+        append_reply(connection, "OK %.*s\n", (int)roster->nStatistics, roster->statistics);
+    }
+    else
+    {
+        const Record *student = find_student(daemon->rosters[nRoster], pArgument);
+        if (student == NULL)
+        {
+            append_reply(connection, DAEMON_REPLY_UNKNOWN_STUDENT, pArgument);
+            status = FAILURE;
+        }
+        else if (isGrade == TRUE)
+        {
+            append_reply(connection, DAEMON_REPLY_GRADE, student->grade, STATS_PRECISION, student->weightedScore);
+        }
+        else
+        {
+            append_reply(connection, "OK %s", student->name);
+            for (int n = 0; n < student->numberOfScores; n++)
+            {
+                append_reply(connection, ",%d", student->scores[n]);
+            }
+            append_reply(connection, ",%c,%.*f\n", student->grade, STATS_PRECISION, student->weightedScore);
+        }
+    }
+
+    pthread_rwlock_unlock(&daemon->rosterLock);
+
+    return status;
+}
+
+/**
+ * @brief Appends formatted text to the replies of a connection, growing the buffer as needed.
+ *
+ * @param connection The connection, owned by the calling worker.
+ * @param pFormat The 'printf' style format.
+ *
+ * @return SUCCESS if the text is stored.
+ *         FAILURE if the buffer cannot grow; the connection is then closed by the event loop.
+ */
+ReturnStatus append_reply(DaemonConnection *connection, const char *pFormat, ...)
+{
+    va_list args;
+
+    va_start(args, pFormat);
+    int nLength = vsnprintf(NULL, 0, pFormat, args);
+    va_end(args);
+
+    if (nLength < 0 || connection->isOutOfMemory == TRUE)
+    {
+        return FAILURE;
+    }
+
+    if (connection->nReply + nLength + 1 > connection->capacity)
+    {
+        long capacity = (connection->capacity > 0) ? connection->capacity : DAEMON_REPLY_BUFFER_SIZE;
+        while (connection->nReply + nLength + 1 > capacity)
+        {
+            capacity *= 2;
+        }
+
+        char *pReply = (char *)realloc(connection->reply, capacity);
+        if (pReply == NULL)
+        {
+            connection->isOutOfMemory = TRUE;
+            return FAILURE;
+        }
+        connection->reply = pReply;
+        connection->capacity = capacity;
+    }
+
+    va_start(args, pFormat);
+    vsnprintf(connection->reply + connection->nReply, nLength + 1, pFormat, args);
+    va_end(args);
+    connection->nReply += nLength;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Parses and grades a roster file and makes it resident under a name.
+ *
+ * The file is parsed before the registry is locked, so other requests are answered in the
+ * meantime. A roster of the same name is replaced and released.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection that receives the reply.
+ * @param pName The roster name.
+ * @param pFileName The roster file.
+ *
+ * @return SUCCESS if the roster is resident, otherwise FAILURE.
+ */
+ReturnStatus load_roster(GradingDaemon *daemon, DaemonConnection *connection, const char *pName, const char *pFileName)
+{
+    FILE *pFile = NULL;
+
+    // The roster owns the context that tracks its memory, so it is allocated with 'malloc'
+    ResidentRoster *roster = (ResidentRoster *)malloc(sizeof(ResidentRoster));
+    if (roster == NULL)
+    {
+        append_reply(connection, DAEMON_REPLY_ERROR, get_reply_message(ERR_MEMORY_ALLOCATION_BUFFER));
+        return FAILURE;
+    }
+    *roster = (ResidentRoster){0};
+    strcpy(roster->name, pName);
+    init_grading_context(&roster->context, NULL);
+    set_message_stream(&roster->context, NULL);
+
+    ReturnStatus status = open_file_in_read_mode(&roster->context, &pFile, pFileName);
+    if (status == SUCCESS)
+    {
+        status = process_student_data(&roster->context, pFile, pFileName);
+        close_file(&roster->context, &pFile);
+    }
+    if (status == SUCCESS)
+    {
+        status = calculate_student_grade(&roster->context);
+    }
+    if (status == SUCCESS)
+    {
+        status = build_roster_index(roster);
+    }
+    if (status != SUCCESS)
+    {
+        append_reply(connection, DAEMON_REPLY_ERROR, get_reply_message(roster->context.lastMessage));
+        destroy_roster(roster);
+        return FAILURE;
+    }
+
+    // Once published the roster may be unloaded by another request at any time
+    int nStudents = roster->nStudents;
+    ResidentRoster *replaced = NULL;
+    pthread_rwlock_wrlock(&daemon->rosterLock);
+
+    int nRoster = find_roster(daemon, pName);
+    if (nRoster >= 0)
+    {
+        replaced = daemon->rosters[nRoster];
+        daemon->rosters[nRoster] = roster;
+    }
+    else
+    {
+        if (daemon->nRosters == daemon->capacity)
+        {
+            int capacity = (daemon->capacity > 0) ? daemon->capacity * 2 : THREAD_POOL_QUEUE_SIZE;
+            ResidentRoster **rosters = NULL;
+            if (allocate_buffer_memory(&daemon->context, (void **)&rosters, capacity * sizeof(ResidentRoster *)) != SUCCESS)
+            {
+                status = FAILURE;
+            }
+            else
+            {
+                if (daemon->nRosters > 0)
+                {
+                    memcpy(rosters, daemon->rosters, daemon->nRosters * sizeof(ResidentRoster *));
+                }
+                clear_buffer_memory(&daemon->context, daemon->rosters);
+                daemon->rosters = rosters;
+                daemon->capacity = capacity;
+            }
+        }
+        if (status == SUCCESS)
+        {
+            daemon->rosters[daemon->nRosters++] = roster;
+        }
+    }
+
+    pthread_rwlock_unlock(&daemon->rosterLock);
+
+    if (status != SUCCESS)
+    {
+        append_reply(connection, DAEMON_REPLY_ERROR, get_reply_message(ERR_MEMORY_ALLOCATION_BUFFER));
+        destroy_roster(roster);
+        return FAILURE;
+    }
+
+    // No request can still read the replaced roster once the write lock was held
+    destroy_roster(replaced);
+
+    return append_reply(connection, DAEMON_REPLY_COUNT, nStudents);
+}
+
+/**
+ * @brief Releases a resident roster.
+ *
+ * @param daemon The daemon.
+ * @param connection The connection that receives the reply.
+ * @param pName The roster name.
+ *
+ * @return SUCCESS if the roster is released, otherwise FAILURE.
+ */
+ReturnStatus unload_roster(GradingDaemon *daemon, DaemonConnection *connection, const char *pName)
+{
+    ResidentRoster *roster = NULL;
+
+    pthread_rwlock_wrlock(&daemon->rosterLock);
+    int nRoster = find_roster(daemon, pName);
+    if (nRoster >= 0)
+    {
+        roster = daemon->rosters[nRoster];
+        daemon->rosters[nRoster] = daemon->rosters[--daemon->nRosters];
+    }
+    pthread_rwlock_unlock(&daemon->rosterLock);
+
+    if (roster == NULL)
+    {
+        append_reply(connection, DAEMON_REPLY_UNKNOWN_ROSTER, pName);
+        return FAILURE;
+    }
+
+    destroy_roster(roster);
+
+    return append_reply(connection, DAEMON_REPLY_OK);
+}
+
+/**
+ * @brief Sorts a graded roster by name, indexes it and keeps its statistics.
+ *
+ * @param roster The roster.
+ *
+ * @return SUCCESS if the roster is ready for requests, otherwise FAILURE.
+ */
+ReturnStatus build_roster_index(ResidentRoster *roster)
+{
+    GradingContext *pContext = &roster->context;
+
+    set_number_of_students(pContext, &roster->nStudents);
+    if (roster->nStudents > 0 && sort_list_by_name(pContext) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&roster->index, roster->nStudents * sizeof(Record *)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    int n = 0;
+    for (Record *current = pContext->table.head; current != NULL; current = current->next)
+    {
+        roster->index[n++] = current;
+    }
+
+    // The statistics never change while the roster is resident
+    FILE *pStream = open_memstream(&roster->statistics, &roster->nStatistics);
+    if (pStream == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    ReturnStatus status = write_statistics_json(pContext, pStream);
+    fclose(pStream);
+
+    // One reply line per request
+    while (roster->nStatistics > 0 && roster->statistics[roster->nStatistics - 1] == END_OF_LINE_CHAR)
+    {
+        roster->nStatistics--;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Releases a roster and everything it owns.
+ *
+ * @param roster The roster, or NULL.
+ *
+ * @return SUCCESS after the roster is released.
+ */
+ReturnStatus destroy_roster(ResidentRoster *roster)
+{
+    if (roster == NULL)
+    {
+        return SUCCESS;
+    }
+
+    clear_buffer_memory(&roster->context, roster->index);
+    clear_grading_context(&roster->context);
+    free(roster->statistics); // Allocated by 'open_memstream'
+    free(roster);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the registry index of a roster. The caller holds the roster lock.
+ *
+ * @param daemon The daemon.
+ * @param pName The roster name.
+ *
+ * @return The index, or -1 if no roster has the name.
+ */
+int find_roster(const GradingDaemon *daemon, const char *pName)
+{
+    for (int n = 0; n < daemon->nRosters; n++)
+    {
+        if (strcmp(daemon->rosters[n]->name, pName) == 0)
+        {
+            return n;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Finds a student by name with a binary search of the roster index.
+ *
+ * With several students of the same name the first one in the sorted roster is returned.
+ *
+ * @param roster The roster.
+ * @param pName The student name.
+ *
+ * @return The student, or NULL if the roster has no student of that name.
+ */
+Record *find_student(const ResidentRoster *roster, const char *pName)
+{
+    int lower = 0;
+    int upper = roster->nStudents;
+
+    while (lower < upper)
+    {
+        int middle = lower + (upper - lower) / 2;
+        if (strcmp(roster->index[middle]->name, pName) < 0)
+        {
+            lower = middle + 1;
+        }
+        else
+        {
+            upper = middle;
+        }
+    }
+
+    return (lower < roster->nStudents && strcmp(roster->index[lower]->name, pName) == 0) ? roster->index[lower] : NULL;
+}
+
+/**
+ * @brief Returns an error message without its leading line ends and 'ERROR!' tag.
+ *
+ * @param pMessage A message from 'messages.h'.
+ *
+ * @return The text of the message for an 'ERR' reply.
+ */
+const char *get_reply_message(const char *pMessage)
+{
+    while (*pMessage == END_OF_LINE_CHAR)
+    {
+        pMessage++;
+    }
+
+    const char *pTag = strstr(pMessage, MESSAGE_TAG_END);
+    return (pTag != NULL) ? pTag + strlen(MESSAGE_TAG_END) : pMessage;
+}
+
+#else
+
+/**
+ * @brief Reports that daemon mode is not available without epoll.
+ *
+ * @return FAILURE.
+ */
+ReturnStatus run_daemon(const char *pSocketName, int nThreads, FILE *pProgressStream, ErrorClass *pErrorClass)
+{
+    GradingContext context;
+
+    (void)pSocketName;
+    (void)nThreads;
+    (void)pProgressStream;
+
+    init_grading_context(&context, NULL);
+    set_message_stream(&context, stderr);
+    report_error(&context, ERROR_CLASS_USAGE, ERR_DAEMON_UNSUPPORTED);
+    *pErrorClass = context.errorClass;
+
+    return FAILURE;
+}
+
+#endif // __linux__
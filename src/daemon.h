@@ -0,0 +1,10 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus run_daemon(const char *, int, FILE *, ErrorClass *);
+
+#endif // DAEMON_H
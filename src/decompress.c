@@ -0,0 +1,611 @@
+/**
+ * @file decompress.c
+ * @brief Streaming decompression of gzip and Zstandard rosters for the line reader.
+ *
+ * Rosters are highly repetitive text and often arrive compressed, from a few times to more
+ * than ten times smaller. The line reader finds a compressed stream from the magic number
+ * of its first bytes, so files, pipes and standard input are all handled the same way, and
+ * nothing has to be decompressed to disk first.
+ *
+ * A decompressor thread reads the compressed bytes in blocks of 'DECOMPRESS_INPUT_SIZE'
+ * and inflates them into a ring of 'DECOMPRESS_RING_SIZE' bytes, which the parser empties
+ * through 'read_decompressed' as it would read a plain stream. Reading and inflating the
+ * next blocks so overlaps with parsing the current ones, and the parser waits only when it
+ * has caught up with the thread. Concatenated gzip members and Zstandard frames are read
+ * one after the other, as 'zcat' and 'zstdcat' do.
+ *
+ * gzip needs zlib and Zstandard needs libzstd; the Makefile defines 'HAVE_ZLIB' and
+ * 'HAVE_ZSTD' for each library it finds. A stream in a format the build cannot read is
+ * rejected with a message naming the format instead of being parsed as text.
+ */
+
+// Library includes
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h> // for read, pread and lseek
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Code includes
+#include "context.h"
+#include "decompress.h"
+#include "memory.h"
+
+// Define magic number of one compression format
+typedef struct
+{
+    CompressionFormat format;                    // Format the magic number belongs to
+    unsigned char magic[COMPRESSION_MAGIC_SIZE]; // First bytes of a stream in the format
+    int nMagic;                                  // Bytes of the magic number
+} CompressionMagic;
+
+// Define decompressor state
+struct decompressor
+{
+    int descriptor;                      // Compressed stream
+    CompressionFormat format;            // Format of the stream
+    char prefix[COMPRESSION_MAGIC_SIZE]; // Bytes already read from a stream that cannot be peeked
+    long nPrefix;                        // Bytes in 'prefix'
+    char *input;                         // Compressed bytes read and not yet inflated
+    char *ring;                          // Ring of decompressed bytes
+    long long nWritten;                  // Decompressed bytes put into the ring
+    long long nTaken;                    // Decompressed bytes taken by the parser
+    Boolean isFinished;                  // TRUE once the thread has put its last bytes into the ring
+    int error;                           // Error number of a failed read of the stream
+    char reason[MESSAGE_BUFFER_SIZE];    // Why the stream could not be decompressed, empty if it could
+    pthread_t thread;                    // Decompressor thread
+    pthread_mutex_t lock;                // Protects the ring positions and the result
+    pthread_cond_t dataReady;            // Signaled when decompressed bytes are put into the ring
+    pthread_cond_t spaceFree;            // Signaled when the parser takes bytes from the ring
+    Boolean isStopping;                  // TRUE to stop the decompressor thread
+#ifdef HAVE_ZLIB
+    z_stream inflater;                   // zlib state of the current gzip member
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *pZstd;                 // libzstd state of the current frame
+#endif
+};
+
+// Function declaration
+void *decompress_thread(void *);
+ReturnStatus inflate_block(Decompressor *, const char *, long, char *, long, long *, long *, Boolean *);
+void finish_decompression(Decompressor *, int, const char *);
+
+// Magic numbers of the formats that are read
+const CompressionMagic COMPRESSION_MAGICS[] = {
+    {COMPRESSION_GZIP, {0x1f, 0x8b}, 2},
+    {COMPRESSION_ZSTD, {0x28, 0xb5, 0x2f, 0xfd}, 4},
+};
+
+/**
+ * @brief Finds the compression of a stream from its first bytes.
+ *
+ * @param pBytes The first bytes of the stream.
+ * @param nBytes Number of bytes available.
+ * @return The format whose magic number the bytes start with, or COMPRESSION_NONE.
+ */
+CompressionFormat get_compression_format(const char *pBytes, long nBytes)
+{
+    for (size_t n = 0; n < sizeof(COMPRESSION_MAGICS) / sizeof(COMPRESSION_MAGICS[0]); n++)
+    {
+        const CompressionMagic *pMagic = &COMPRESSION_MAGICS[n];
+        if (nBytes >= pMagic->nMagic && memcmp(pBytes, pMagic->magic, pMagic->nMagic) == 0)
+        {
+            return pMagic->format;
+        }
+    }
+
+    return COMPRESSION_NONE;
+}
+
+/**
+ * @brief Tells whether more bytes could still complete a magic number.
+ *
+ * @param pBytes The first bytes of the stream.
+ * @param nBytes Number of bytes available.
+ * @return TRUE if the bytes are the start of a magic number but shorter than it.
+ */
+Boolean is_compression_magic_prefix(const char *pBytes, long nBytes)
+{
+    for (size_t n = 0; n < sizeof(COMPRESSION_MAGICS) / sizeof(COMPRESSION_MAGICS[0]); n++)
+    {
+        const CompressionMagic *pMagic = &COMPRESSION_MAGICS[n];
+        if (nBytes < pMagic->nMagic && memcmp(pBytes, pMagic->magic, nBytes) == 0)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Returns the name of a compression format for messages.
+ *
+ * @param format The format.
+ * @return Name of the format.
+ */
+const char *get_compression_name(CompressionFormat format)
+{
+    return (format == COMPRESSION_ZSTD) ? COMPRESSION_NAME_ZSTD : COMPRESSION_NAME_GZIP;
+}
+
+/**
+ * @brief Finds the compression of a stream before its first line is read.
+ *
+ * A regular file is peeked with 'pread', which leaves its offset alone. Any other stream
+ * cannot be peeked: its first bytes are read into the buffer and belong to the caller.
+ * Plain text is read once, so a terminal is not kept waiting; only bytes that start a
+ * magic number are followed by further reads until the magic number is complete.
+ *
+ * @param descriptor The stream.
+ * @param pBuffer Buffer of at least 'COMPRESSION_MAGIC_SIZE' bytes for the bytes read.
+ * @param pnBuffered Pointer that receives the number of bytes read into the buffer.
+ * @param pIsEnd Pointer that receives TRUE if the stream ended while it was peeked.
+ * @param pFormat Pointer that receives the format of the stream.
+ * @return SUCCESS if the format is found, FAILURE with 'errno' set if a read failed.
+ */
+ReturnStatus peek_compression_format(int descriptor, char *pBuffer, long *pnBuffered, Boolean *pIsEnd,
+                                     CompressionFormat *pFormat)
+{
+    struct stat status;
+    long long nOffset = lseek(descriptor, 0, SEEK_CUR);
+
+    *pnBuffered = 0;
+    *pIsEnd = FALSE;
+    *pFormat = COMPRESSION_NONE;
+
+    if (fstat(descriptor, &status) == 0 && S_ISREG(status.st_mode) && nOffset >= 0)
+    {
+        char magic[COMPRESSION_MAGIC_SIZE];
+        ssize_t nRead;
+        do
+        {
+            nRead = pread(descriptor, magic, COMPRESSION_MAGIC_SIZE, nOffset);
+        } while (nRead < 0 && errno == EINTR);
+        if (nRead < 0)
+        {
+            return FAILURE;
+        }
+
+        *pFormat = get_compression_format(magic, nRead);
+        return SUCCESS;
+    }
+
+    while (*pnBuffered < COMPRESSION_MAGIC_SIZE && is_compression_magic_prefix(pBuffer, *pnBuffered) == TRUE)
+    {
+        ssize_t nRead = read(descriptor, pBuffer + *pnBuffered, COMPRESSION_MAGIC_SIZE - *pnBuffered);
+        if (nRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nRead < 0)
+        {
+            return FAILURE;
+        }
+        if (nRead == 0)
+        {
+            *pIsEnd = TRUE;
+            break;
+        }
+        *pnBuffered += nRead;
+    }
+
+    *pFormat = get_compression_format(pBuffer, *pnBuffered);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Finds the compression of a file without reading it for the parser.
+ *
+ * Used to keep compressed rosters out of the parsers that split a file into byte ranges.
+ *
+ * @param pFileName Name of the file.
+ * @return The format of the file, or COMPRESSION_NONE if it is plain or cannot be read.
+ */
+CompressionFormat get_file_compression(const char *pFileName)
+{
+    char magic[COMPRESSION_MAGIC_SIZE];
+    FILE *pFile = fopen(pFileName, "rb");
+
+    if (pFile == NULL)
+    {
+        return COMPRESSION_NONE;
+    }
+
+    long nRead = (long)fread(magic, 1, COMPRESSION_MAGIC_SIZE, pFile);
+    fclose(pFile);
+
+    return get_compression_format(magic, nRead);
+}
+
+/**
+ * @brief Starts decompressing a stream on a thread of its own.
+ *
+ * @param pContext The grading context that owns the buffers and reports errors.
+ * @param ppDecompressor Pointer that receives the decompressor.
+ * @param descriptor The compressed stream, read from its current offset on.
+ * @param format Compression of the stream.
+ * @param pPrefix Bytes of the stream already read by 'peek_compression_format'.
+ * @param nPrefix Number of bytes in 'pPrefix'.
+ * @return SUCCESS if the decompressor runs, FAILURE if the build cannot read the format or
+ *         the decompressor cannot be started.
+ */
+ReturnStatus open_decompressor(GradingContext *pContext, Decompressor **ppDecompressor, int descriptor,
+                               CompressionFormat format, const char *pPrefix, long nPrefix)
+{
+    *ppDecompressor = NULL;
+
+#ifndef HAVE_ZLIB
+    if (format == COMPRESSION_GZIP)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_COMPRESSION_UNSUPPORTED, COMPRESSION_NAME_GZIP);
+        return FAILURE;
+    }
+#endif
+#ifndef HAVE_ZSTD
+    if (format == COMPRESSION_ZSTD)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_COMPRESSION_UNSUPPORTED, COMPRESSION_NAME_ZSTD);
+        return FAILURE;
+    }
+#endif
+
+    Decompressor *pDecompressor = malloc(sizeof(Decompressor));
+    if (pDecompressor == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *pDecompressor = (Decompressor){0};
+    pDecompressor->descriptor = descriptor;
+    pDecompressor->format = format;
+    memcpy(pDecompressor->prefix, pPrefix, nPrefix);
+    pDecompressor->nPrefix = nPrefix;
+
+    if (allocate_buffer_memory(pContext, (void **)&pDecompressor->input, DECOMPRESS_INPUT_SIZE) != SUCCESS ||
+        allocate_buffer_memory(pContext, (void **)&pDecompressor->ring, DECOMPRESS_RING_SIZE) != SUCCESS)
+    {
+        clear_buffer_memory(pContext, pDecompressor->input);
+        free(pDecompressor);
+        return FAILURE;
+    }
+
+    Boolean isReady = FALSE;
+#ifdef HAVE_ZLIB
+    if (format == COMPRESSION_GZIP)
+    {
+        // A window of 15 bits plus 32 reads the gzip header and checks its trailer
+        isReady = (inflateInit2(&pDecompressor->inflater, MAX_WBITS + 32) == Z_OK) ? TRUE : FALSE;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (format == COMPRESSION_ZSTD)
+    {
+        pDecompressor->pZstd = ZSTD_createDStream();
+        isReady = (pDecompressor->pZstd != NULL && !ZSTD_isError(ZSTD_initDStream(pDecompressor->pZstd))) ? TRUE
+                                                                                                          : FALSE;
+    }
+#endif
+
+    pthread_mutex_init(&pDecompressor->lock, NULL);
+    pthread_cond_init(&pDecompressor->dataReady, NULL);
+    pthread_cond_init(&pDecompressor->spaceFree, NULL);
+    if (isReady == FALSE || pthread_create(&pDecompressor->thread, NULL, decompress_thread, pDecompressor) != 0)
+    {
+        // Nothing runs yet, so the thread is not joined
+        pDecompressor->isStopping = TRUE;
+        pDecompressor->isFinished = TRUE;
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_DECOMPRESSOR_START, get_compression_name(format));
+        close_decompressor(pContext, &pDecompressor);
+        return FAILURE;
+    }
+
+    *ppDecompressor = pDecompressor;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes the next decompressed bytes of the stream, like 'read'.
+ *
+ * Waits only when the ring is empty and the thread is still decompressing. Bytes are copied
+ * out of the ring without the lock: the thread writes only the part the parser has freed.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pDecompressor The decompressor.
+ * @param pStreamName Name of the stream for error messages.
+ * @param pBuffer Buffer that receives the bytes.
+ * @param nCapacity Most bytes to take.
+ * @param pnRead Pointer that receives the number of bytes taken, zero at the end of the stream.
+ * @return SUCCESS if bytes or the end of the stream are returned, FAILURE if the stream
+ *         cannot be read or is damaged.
+ */
+ReturnStatus read_decompressed(GradingContext *pContext, Decompressor *pDecompressor, const char *pStreamName,
+                               char *pBuffer, long nCapacity, long *pnRead)
+{
+    *pnRead = 0;
+
+    pthread_mutex_lock(&pDecompressor->lock);
+    while (pDecompressor->nWritten == pDecompressor->nTaken && pDecompressor->isFinished == FALSE)
+    {
+        pthread_cond_wait(&pDecompressor->dataReady, &pDecompressor->lock);
+    }
+    long long nAvailable = pDecompressor->nWritten - pDecompressor->nTaken;
+    pthread_mutex_unlock(&pDecompressor->lock);
+
+    // An empty ring of a finished thread is the end of the stream, or the point it failed
+    if (nAvailable == 0)
+    {
+        if (pDecompressor->error != 0)
+        {
+            errno = pDecompressor->error;
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_READ, pStreamName);
+            return FAILURE;
+        }
+        if (pDecompressor->reason[0] != STRING_TERMINATION)
+        {
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_DECOMPRESS, pStreamName, pDecompressor->reason);
+            return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+    long nCopy = (nAvailable < nCapacity) ? (long)nAvailable : nCapacity;
+    long nPosition = (long)(pDecompressor->nTaken % DECOMPRESS_RING_SIZE);
+    long nFirst = (nCopy < DECOMPRESS_RING_SIZE - nPosition) ? nCopy : DECOMPRESS_RING_SIZE - nPosition;
+    memcpy(pBuffer, pDecompressor->ring + nPosition, nFirst);
+    memcpy(pBuffer + nFirst, pDecompressor->ring, nCopy - nFirst);
+    *pnRead = nCopy;
+
+    pthread_mutex_lock(&pDecompressor->lock);
+    pDecompressor->nTaken += nCopy;
+    pthread_cond_signal(&pDecompressor->spaceFree);
+    pthread_mutex_unlock(&pDecompressor->lock);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Stops the decompressor thread and releases the decompressor.
+ *
+ * The stream itself stays open. A thread blocked reading a pipe is joined once that read
+ * returns.
+ *
+ * @param pContext The grading context that owns the buffers.
+ * @param ppDecompressor Pointer to the decompressor, set to NULL.
+ * @return SUCCESS after the decompressor is released.
+ */
+ReturnStatus close_decompressor(GradingContext *pContext, Decompressor **ppDecompressor)
+{
+    Decompressor *pDecompressor = *ppDecompressor;
+
+    if (pDecompressor == NULL)
+    {
+        return SUCCESS;
+    }
+
+    if (pDecompressor->isStopping == FALSE)
+    {
+        pthread_mutex_lock(&pDecompressor->lock);
+        pDecompressor->isStopping = TRUE;
+        pthread_cond_signal(&pDecompressor->spaceFree);
+        pthread_mutex_unlock(&pDecompressor->lock);
+        pthread_join(pDecompressor->thread, NULL);
+    }
+    pthread_cond_destroy(&pDecompressor->spaceFree);
+    pthread_cond_destroy(&pDecompressor->dataReady);
+    pthread_mutex_destroy(&pDecompressor->lock);
+
+#ifdef HAVE_ZLIB
+    if (pDecompressor->format == COMPRESSION_GZIP)
+    {
+        inflateEnd(&pDecompressor->inflater);
+    }
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_freeDStream(pDecompressor->pZstd);
+#endif
+
+    clear_buffer_memory(pContext, pDecompressor->ring);
+    clear_buffer_memory(pContext, pDecompressor->input);
+    free(pDecompressor);
+    *ppDecompressor = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Thread that reads the compressed stream and fills the ring.
+ *
+ * At the end of the input the decoder is still called while it returns bytes it held
+ * back, and a member or frame that is still open then is a truncated stream.
+ *
+ * @param pArgument The 'Decompressor'.
+ * @return NULL once the stream is decompressed, fails or the decompressor stops.
+ */
+void *decompress_thread(void *pArgument)
+{
+    Decompressor *pDecompressor = (Decompressor *)pArgument;
+    const char *pInput = pDecompressor->prefix; // Next compressed byte to inflate
+    long nInput = pDecompressor->nPrefix;       // Compressed bytes left at 'pInput'
+    Boolean isInputEnd = FALSE;                 // TRUE once the stream reported its end
+    Boolean isFrameOpen = FALSE;                // TRUE inside a gzip member or Zstandard frame
+
+    for (;;)
+    {
+        if (nInput == 0 && isInputEnd == FALSE)
+        {
+            ssize_t nRead = read(pDecompressor->descriptor, pDecompressor->input, DECOMPRESS_INPUT_SIZE);
+            if (nRead < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (nRead < 0)
+            {
+                finish_decompression(pDecompressor, errno, NULL);
+                break;
+            }
+            isInputEnd = (nRead == 0) ? TRUE : FALSE;
+            pInput = pDecompressor->input;
+            nInput = nRead;
+        }
+        if (isInputEnd == TRUE && isFrameOpen == FALSE)
+        {
+            finish_decompression(pDecompressor, 0, NULL);
+            break;
+        }
+
+        // Wait until the parser has freed part of the ring
+        pthread_mutex_lock(&pDecompressor->lock);
+        while (pDecompressor->isStopping == FALSE &&
+               pDecompressor->nWritten - pDecompressor->nTaken == DECOMPRESS_RING_SIZE)
+        {
+            pthread_cond_wait(&pDecompressor->spaceFree, &pDecompressor->lock);
+        }
+        Boolean isStopping = pDecompressor->isStopping;
+        long long nFree = DECOMPRESS_RING_SIZE - (pDecompressor->nWritten - pDecompressor->nTaken);
+        pthread_mutex_unlock(&pDecompressor->lock);
+        if (isStopping == TRUE)
+        {
+            break;
+        }
+
+        // Inflate into the free bytes up to the end of the ring
+        long nPosition = (long)(pDecompressor->nWritten % DECOMPRESS_RING_SIZE);
+        long nOutput = (nFree < DECOMPRESS_RING_SIZE - nPosition) ? (long)nFree : DECOMPRESS_RING_SIZE - nPosition;
+        long nConsumed = 0;
+        long nProduced = 0;
+        if (inflate_block(pDecompressor, pInput, nInput, pDecompressor->ring + nPosition, nOutput, &nConsumed,
+                          &nProduced, &isFrameOpen) != SUCCESS)
+        {
+            break;
+        }
+        pInput += nConsumed;
+        nInput -= nConsumed;
+
+        if (isInputEnd == TRUE && isFrameOpen == TRUE && nProduced == 0)
+        {
+            finish_decompression(pDecompressor, 0, "unexpected end of the compressed stream");
+            break;
+        }
+
+        pthread_mutex_lock(&pDecompressor->lock);
+        pDecompressor->nWritten += nProduced;
+        pthread_cond_signal(&pDecompressor->dataReady);
+        pthread_mutex_unlock(&pDecompressor->lock);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Inflates compressed bytes into the ring with the decoder of the stream's format.
+ *
+ * A gzip member or Zstandard frame that ends is followed by a new one when more input
+ * comes, as concatenated files decompress to the concatenation of their contents.
+ *
+ * @param pDecompressor The decompressor.
+ * @param pInput Compressed bytes.
+ * @param nInput Number of compressed bytes, zero to take bytes the decoder held back.
+ * @param pOutput Free bytes of the ring.
+ * @param nOutput Number of free bytes.
+ * @param pnConsumed Pointer that receives the number of compressed bytes used.
+ * @param pnProduced Pointer that receives the number of decompressed bytes written.
+ * @param pIsFrameOpen Pointer to TRUE inside a member or frame, updated after the call.
+ * @return SUCCESS if the bytes are inflated, FAILURE after the thread is finished with the
+ *         reason the stream is damaged.
+ */
+ReturnStatus inflate_block(Decompressor *pDecompressor, const char *pInput, long nInput, char *pOutput,
+                           long nOutput, long *pnConsumed, long *pnProduced, Boolean *pIsFrameOpen)
+{
+    *pnConsumed = 0;
+    *pnProduced = 0;
+
+#ifdef HAVE_ZLIB
+    if (pDecompressor->format == COMPRESSION_GZIP)
+    {
+        z_stream *pInflater = &pDecompressor->inflater;
+        if (*pIsFrameOpen == FALSE)
+        {
+            inflateReset(pInflater);
+        }
+
+        pInflater->next_in = (Bytef *)pInput;
+        pInflater->avail_in = (uInt)nInput;
+        pInflater->next_out = (Bytef *)pOutput;
+        pInflater->avail_out = (uInt)nOutput;
+        int result = inflate(pInflater, Z_NO_FLUSH);
+        *pnConsumed = nInput - pInflater->avail_in;
+        *pnProduced = nOutput - pInflater->avail_out;
+
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+        {
+            finish_decompression(pDecompressor, 0, (pInflater->msg != NULL) ? pInflater->msg : "invalid gzip data");
+            return FAILURE;
+        }
+        *pIsFrameOpen = (result == Z_STREAM_END) ? FALSE : TRUE;
+
+        return SUCCESS;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if (pDecompressor->format == COMPRESSION_ZSTD)
+    {
+        ZSTD_inBuffer input = {pInput, (size_t)nInput, 0};
+        ZSTD_outBuffer output = {pOutput, (size_t)nOutput, 0};
+        size_t result = ZSTD_decompressStream(pDecompressor->pZstd, &output, &input);
+        *pnConsumed = (long)input.pos;
+        *pnProduced = (long)output.pos;
+
+        if (ZSTD_isError(result))
+        {
+            finish_decompression(pDecompressor, 0, ZSTD_getErrorName(result));
+            return FAILURE;
+        }
+        // Zero means the frame is complete and all of it was written out
+        *pIsFrameOpen = (result != 0) ? TRUE : FALSE;
+
+        return SUCCESS;
+    }
+#endif
+
+    (void)pInput;
+    (void)nInput;
+    (void)pOutput;
+    (void)nOutput;
+    (void)pIsFrameOpen;
+    finish_decompression(pDecompressor, 0, "unsupported format");
+
+    return FAILURE;
+}
+
+/**
+ * @brief Records the end of the stream, or why it failed, and wakes the parser.
+ *
+ * @param pDecompressor The decompressor.
+ * @param error Error number of a failed read, or zero.
+ * @param pReason Why the stream is damaged, or NULL.
+ */
+void finish_decompression(Decompressor *pDecompressor, int error, const char *pReason)
+{
+    pthread_mutex_lock(&pDecompressor->lock);
+    pDecompressor->error = error;
+    if (pReason != NULL)
+    {
+        snprintf(pDecompressor->reason, sizeof(pDecompressor->reason), "%s", pReason);
+    }
+    pDecompressor->isFinished = TRUE;
+    pthread_cond_signal(&pDecompressor->dataReady);
+    pthread_mutex_unlock(&pDecompressor->lock);
+}
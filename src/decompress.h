@@ -0,0 +1,17 @@
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+CompressionFormat get_compression_format(const char *, long);
+Boolean is_compression_magic_prefix(const char *, long);
+const char *get_compression_name(CompressionFormat);
+ReturnStatus peek_compression_format(int, char *, long *, Boolean *, CompressionFormat *);
+CompressionFormat get_file_compression(const char *);
+ReturnStatus open_decompressor(GradingContext *, Decompressor **, int, CompressionFormat, const char *, long);
+ReturnStatus read_decompressed(GradingContext *, Decompressor *, const char *, char *, long, long *);
+ReturnStatus close_decompressor(GradingContext *, Decompressor **);
+
+#endif // DECOMPRESS_H
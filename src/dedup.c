@@ -0,0 +1,252 @@
+/**
+ * @file dedup.c
+ * @brief Detection of students listed more than once in a roster.
+ *
+ * Merged rosters can list the same student twice, and both rows would be graded and
+ * counted in the class statistics. After loading, the student table is checked in one pass
+ * against a set of the names seen so far: an open addressing hash table of 64-bit FNV-1a
+ * hashes and records, sized once to at least twice the number of students so probe runs
+ * stay short. A name is compared with 'strcmp' only when its hash matches. Each later row of
+ * a student is handled by the selected policy:
+ *
+ * - first: the later row is dropped.
+ * - last: the later row replaces the scores of the earlier one.
+ * - error: the run fails on the first student listed twice.
+ * - merge: the rows become one with the highest score of every test.
+ *
+ * Names are compared by their bytes, as the default name order compares them. The whole
+ * check is O(n) in the number of rows.
+ */
+
+// Library includes
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "dedup.h"
+#include "memory.h"
+
+// Define one name of the duplicate set
+typedef struct
+{
+    unsigned long long hash; // Hash of the name, 0 for an empty slot
+    Record *record;          // The record kept for the name
+    long nRows;              // Number of rows of the name seen so far
+} NameSlot;
+
+// Function declaration
+unsigned long long hash_name(const char *);
+NameSlot *find_name_slot(NameSlot *, unsigned long long, unsigned long long, const char *);
+ReturnStatus keep_duplicate_row(Record *, Record *, DuplicatePolicy);
+ReturnStatus delete_duplicate_row(GradingContext *, Record *);
+
+/**
+ * @brief Removes the students listed more than once from the student table.
+ *
+ * The table must not be graded yet. The kept record of a student stays at the place of its
+ * first row. A warning names the first 'DUPLICATE_DIAGNOSTIC_COUNT' students listed twice.
+ *
+ * @param pContext The grading context that owns the student table.
+ * @param policy What is done with the later rows of a student.
+ *
+ * @return SUCCESS if the table holds each student once, or nothing is checked for
+ *         'DUPLICATE_POLICY_NONE'.
+ *         FAILURE if a student is listed twice with 'DUPLICATE_POLICY_ERROR', or memory is
+ *         exhausted.
+ */
+ReturnStatus remove_duplicate_students(GradingContext *pContext, DuplicatePolicy policy)
+{
+    StudentTable *pTable = &pContext->table;
+    NameSlot *slots = NULL;
+    unsigned long long capacity = 1;
+    const char *ppDuplicates[DUPLICATE_DIAGNOSTIC_COUNT]; // Names of the first students listed twice
+    long nDuplicateStudents = 0;
+    long nDuplicateRows = 0;
+
+    if (policy == DUPLICATE_POLICY_NONE || pTable->nStudents < 2)
+    {
+        return SUCCESS;
+    }
+
+    while (capacity < (unsigned long long)pTable->nStudents * DUPLICATE_SLOTS_PER_STUDENT)
+    {
+        capacity *= 2;
+    }
+    if (allocate_buffer_memory(pContext, (void **)&slots, capacity * sizeof(NameSlot)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    memset(slots, 0, capacity * sizeof(NameSlot));
+
+    ReturnStatus status = SUCCESS;
+    Record *previous = NULL;
+    Record *current = pTable->head;
+    while (current != NULL)
+    {
+        Record *next = current->next;
+        NameSlot *pSlot = find_name_slot(slots, capacity - 1, hash_name(current->name), current->name);
+
+        pSlot->nRows++;
+
+        // First row of the student
+        if (pSlot->record == NULL)
+        {
+            pSlot->record = current;
+            previous = current;
+            current = next;
+            continue;
+        }
+
+        if (policy == DUPLICATE_POLICY_ERROR)
+        {
+            report_error(pContext, ERROR_CLASS_DATA, ERR_STUDENT_DUPLICATE, current->name);
+            status = FAILURE;
+            break;
+        }
+
+        // Name the student on its second row
+        if (pSlot->nRows == 2)
+        {
+            if (nDuplicateStudents < DUPLICATE_DIAGNOSTIC_COUNT)
+            {
+                ppDuplicates[nDuplicateStudents] = pSlot->record->name;
+            }
+            nDuplicateStudents++;
+        }
+        nDuplicateRows++;
+
+        // The kept record takes what the policy keeps, then the later row is unlinked
+        keep_duplicate_row(pSlot->record, current, policy);
+        previous->next = next;
+        if (pTable->tail == current)
+        {
+            pTable->tail = previous;
+        }
+        pTable->nStudents--;
+        if (delete_duplicate_row(pContext, current) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+        current = next;
+    }
+
+    if (status == SUCCESS && nDuplicateRows > 0)
+    {
+        const char *pAction = (policy == DUPLICATE_POLICY_FIRST)  ? MSG_DUPLICATES_KEPT_FIRST
+                              : (policy == DUPLICATE_POLICY_LAST) ? MSG_DUPLICATES_KEPT_LAST
+                                                                  : MSG_DUPLICATES_MERGED;
+        report_message(pContext, WARNING_DUPLICATES_FOUND, nDuplicateRows, nDuplicateStudents, pAction);
+        for (long n = 0; n < nDuplicateStudents && n < DUPLICATE_DIAGNOSTIC_COUNT; n++)
+        {
+            report_message(pContext, WARNING_DUPLICATE_STUDENT, ppDuplicates[n]);
+        }
+        if (nDuplicateStudents > DUPLICATE_DIAGNOSTIC_COUNT)
+        {
+            report_message(pContext, WARNING_MORE_DUPLICATES, nDuplicateStudents - DUPLICATE_DIAGNOSTIC_COUNT);
+        }
+    }
+
+    clear_buffer_memory(pContext, slots);
+
+    return status;
+}
+
+/**
+ * @brief Hashes a name with 64 bit FNV-1a.
+ *
+ * @param pName The name.
+ *
+ * @return The hash, never 0 so it can mark an empty slot.
+ */
+unsigned long long hash_name(const char *pName)
+{
+    unsigned long long hash = LINE_HASH_OFFSET;
+
+    for (const unsigned char *pByte = (const unsigned char *)pName; *pByte != STRING_TERMINATION; pByte++)
+    {
+        hash = (hash ^ *pByte) * LINE_HASH_PRIME;
+    }
+
+    return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief Finds the slot of a name in the duplicate set, or the empty slot for it.
+ *
+ * Slots are probed one after another from the hash, and a name is compared only in slots
+ * of the same hash. The set is never more than half full, so an empty slot is always found.
+ *
+ * @param slots The slots of the set.
+ * @param mask Number of slots minus one, the number of slots is a power of two.
+ * @param hash Hash of the name.
+ * @param pName The name.
+ *
+ * @return The slot that holds the name, or the empty slot where it belongs.
+ */
+NameSlot *find_name_slot(NameSlot *slots, unsigned long long mask, unsigned long long hash, const char *pName)
+{
+    unsigned long long n = hash & mask;
+
+    while (slots[n].hash != 0 && (slots[n].hash != hash || strcmp(slots[n].record->name, pName) != 0))
+    {
+        n = (n + 1) & mask;
+    }
+    slots[n].hash = hash;
+
+    return &slots[n];
+}
+
+/**
+ * @brief Applies the policy to the kept record of a student and a later row of it.
+ *
+ * @param kept The record kept for the student.
+ * @param duplicate The later row, deleted afterwards.
+ * @param policy What is done with the later row.
+ *
+ * @return SUCCESS after the kept record is updated.
+ */
+ReturnStatus keep_duplicate_row(Record *kept, Record *duplicate, DuplicatePolicy policy)
+{
+    if (policy == DUPLICATE_POLICY_LAST)
+    {
+        // Swap the scores, so the later ones stay and the earlier ones are deleted
+        int *scores = kept->scores;
+        int numberOfScores = kept->numberOfScores;
+        kept->scores = duplicate->scores;
+        kept->numberOfScores = duplicate->numberOfScores;
+        duplicate->scores = scores;
+        duplicate->numberOfScores = numberOfScores;
+    }
+    else if (policy == DUPLICATE_POLICY_MERGE)
+    {
+        int nScores = (kept->numberOfScores < duplicate->numberOfScores) ? kept->numberOfScores
+                                                                          : duplicate->numberOfScores;
+        for (int n = 0; n < nScores; n++)
+        {
+            kept->scores[n] = (duplicate->scores[n] > kept->scores[n]) ? duplicate->scores[n] : kept->scores[n];
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Deletes a row that was unlinked from the student table.
+ *
+ * @param pContext The grading context that owns the row.
+ * @param record The row.
+ *
+ * @return SUCCESS if the row is deleted, otherwise FAILURE.
+ */
+ReturnStatus delete_duplicate_row(GradingContext *pContext, Record *record)
+{
+    if (clear_string_memory(pContext, record->name) != SUCCESS ||
+        clear_int_array_memory(pContext, record->scores) != SUCCESS ||
+        clear_record_memory(pContext, record) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,10 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus remove_duplicate_students(GradingContext *, DuplicatePolicy);
+
+#endif // DEDUP_H
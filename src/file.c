@@ -4,33 +4,50 @@
  *
  * This file contains utility functions to manage file input and output operations
  * for student records. The functions include opening and closing files, reading student
- * data, checking if a complete line is available for reading, and writing processed data
- * to an output file.
+ * data line by line with a forward-only reader that also works on pipes, and writing
+ * processed data to an output file. An output can also be replaced atomically through a
+ * temporary file. Student data can also be processed from a buffer already in memory.
  */
 
 // Library includes
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>   // for mkstemp
+#include <string.h>
+#include <sys/stat.h> // for fchmod
+#include <unistd.h>   // for read
 
 // Code includes
+#include "context.h"
+#include "decompress.h"
 #include "file.h"
+#include "memory.h"
+#include "profiler.h"
+#include "readahead.h"
+#include "reject.h"
+#include "scan.h"
+#include "trace.h"
 #include "student.h"
 
 /**
  * @brief Opens a file in read mode.
  *
  * This function attempts to open a specified file in read mode. If the file cannot be opened,
- * it prints an error message and returns 'FAILURE'. If the file is empty, it also returns 'FAILURE'.
+ * it prints an error message and returns 'FAILURE'. The file is not sized or rewound, so
+ * pipes and other streams that cannot seek open the same way; an empty file is reported
+ * by 'process_student_data' once the end of the file is reached.
  *
+ * @param pContext The grading context that reports errors.
  * @param pFile Pointer to a 'FILE*' that will hold the file pointer upon success.
  * @param pFileName Name of the file to be opened.
  * @return SUCCESS if the file is successfully opened, otherwise FAILURE.
  */
-ReturnStatus open_file_in_read_mode(FILE **pFile, const char *pFileName)
+ReturnStatus open_file_in_read_mode(GradingContext *pContext, FILE **pFile, const char *pFileName)
 {
     // Check if the file pointer is valid
     if (*pFile != NULL)
     {
-        printf(WARNING_FILE_POINTER_NOT_NULL);
+        report_message(pContext, WARNING_FILE_POINTER_NOT_NULL);
     }
 
     // Open the file in read mode
@@ -39,17 +56,7 @@ ReturnStatus open_file_in_read_mode(FILE **pFile, const char *pFileName)
     *pFile = fopen(pFileName, "r");
     if (*pFile == NULL)
     {
-        printf(ERR_FILE_OPEN_READ, pFileName);
-        return FAILURE;
-    }
-
-    // Check if the file is empty by moving to the end and checking the size
-    fseek(*pFile, 0, SEEK_END); // Move the file pointer to the end
-    long size = ftell(*pFile);  // Get the current position of the file pointer (which is the file size)
-    fseek(*pFile, 0, SEEK_SET); // Move the file pointer back to the beginning
-    if (size == 0)
-    {
-        printf(ERR_FILE_EMPTY, pFileName);
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
         return FAILURE;
     }
 
@@ -62,21 +69,23 @@ ReturnStatus open_file_in_read_mode(FILE **pFile, const char *pFileName)
  * This function closes the given file and sets its pointer to NULL to prevent
  * dangling pointers.
  *
+ * @param pContext The grading context that reports errors.
  * @param pFile Pointer to the 'FILE*' to be closed.
  * @return SUCCESS if the file is closed successfully, otherwise FAILURE.
  */
-ReturnStatus close_file(FILE **pFile)
+ReturnStatus close_file(GradingContext *pContext, FILE **pFile)
 {
     // Check if the file pointer is NULL
     if (*pFile == NULL)
     {
-        printf(WARNING_FILE_POINTER_NULL);
+        report_message(pContext, WARNING_FILE_POINTER_NULL);
+        return FAILURE;
     }
 
     // Attempt to close the file
     if (fclose(*pFile) != 0)
     {
-        printf("\n\nERROR! Failed to close file");
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_CLOSE_UNNAMED);
         return FAILURE;
     }
 
@@ -87,78 +96,217 @@ ReturnStatus close_file(FILE **pFile)
 }
 
 /**
- * @brief Reads a single line from a file into memory.
+ * @brief Prepares a forward-only line reader for a stream.
  *
- * Reads a line of student data from the file and stores it in a dynamically allocated
- * memory buffer.
+ * The reader reads the stream's descriptor directly in blocks of 'STREAM_READ_BLOCK_SIZE'
+ * and never seeks, so it works the same on files, pipes and terminals. Nothing must have
+ * been read from the stream through 'stdio' before. A stream that starts with the magic
+ * number of gzip or Zstandard is decompressed on a thread of its own; a plain regular file
+ * is read ahead of the parser as the read-ahead mode of the context selects.
  *
- * @param pFile Pointer to an open file.
- * @param pLineOfData Pointer to store the dynamically allocated string.
- * @param nSize Size of the line to be read.
- * @return SUCCESS if the line is read successfully, otherwise FAILURE.
+ * @param pContext The grading context that owns the read buffer.
+ * @param pReader The reader to prepare.
+ * @param pStream The open stream to read.
+ * @return SUCCESS if the reader is ready, otherwise FAILURE, also for a compressed stream the
+ *         build cannot read.
  */
-ReturnStatus read_one_line_from_file(FILE *pFile, char **pLineOfData, long nSize)
+ReturnStatus open_line_reader(GradingContext *pContext, LineReader *pReader, FILE *pStream)
 {
-    // Read the specified number of characters from the file
-    fread(*pLineOfData, sizeof(char), nSize, pFile);
+    *pReader = (LineReader){0};
+    pReader->descriptor = fileno(pStream);
+    pReader->capacity = STREAM_READ_BLOCK_SIZE;
 
-    // Null-terminate the string to avoid buffer overflows
-    (*pLineOfData)[nSize] = STRING_TERMINATION;
+    // One spare byte terminates a last line that has no newline
+    if (allocate_buffer_memory(pContext, (void **)&pReader->buffer, pReader->capacity + 1) != SUCCESS)
+    {
+        return FAILURE;
+    }
 
-    // Move to the next line by skipping the newline character
-    fseek(pFile, SIZE_OF_NEW_LINE, SEEK_CUR);
+    // A stream that cannot be peeked keeps the bytes read while its magic number is looked for
+    CompressionFormat format = COMPRESSION_NONE;
+    long nBuffered = 0;
+    Boolean isEnd = FALSE;
+    if (peek_compression_format(pReader->descriptor, pReader->buffer, &nBuffered, &isEnd, &format) != SUCCESS)
+    {
+        // The next read reports the error with the name of the stream
+        format = COMPRESSION_NONE;
+    }
+
+    // The decompressor thread reads the compressed stream ahead of the parser itself
+    if (format != COMPRESSION_NONE)
+    {
+        if (open_decompressor(pContext, &pReader->pDecompressor, pReader->descriptor, format, pReader->buffer,
+                              nBuffered) != SUCCESS)
+        {
+            close_line_reader(pContext, pReader);
+            return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+    pReader->end = nBuffered;
+    pReader->nBytesRead = nBuffered;
+    pReader->isEndOfStream = isEnd;
+    PROFILE_ADD(pContext, nBytesRead, nBuffered);
+    start_character_scan(&pReader->newLines, pReader->buffer, nBuffered, END_OF_LINE_CHAR);
+
+    if (nBuffered == 0 &&
+        open_read_ahead(pContext, &pReader->pReadAhead, pReader->descriptor, pContext->readAheadMode) != SUCCESS)
+    {
+        close_line_reader(pContext, pReader);
+        return FAILURE;
+    }
 
     return SUCCESS;
 }
 
 /**
- * @brief Checks if a complete line is available for reading.
+ * @brief Returns the next line of a stream.
  *
- * This function reads the file character by character to check if a full line
- * (terminated by a newline or EOF) is available.
+ * Lines end with a newline, with or without a carriage return, or at the end of the
+ * stream. The line is terminated in place in the reader's buffer and stays valid until the
+ * next call. More input is read only when no complete line is buffered: the unread part is
+ * moved to the front of the buffer, which doubles when a single line fills it. The bytes of
+ * each read are scanned for newlines once, a block at a time.
  *
- * @param pFile Pointer to the file.
- * @param pIsData Pointer to a boolean indicating if data is available.
- * @param pDataSize Pointer to store the size of the available data.
- * @return SUCCESS if the operation completes successfully.
+ * @param pContext The grading context that reports errors.
+ * @param pReader The line reader.
+ * @param pStreamName Name of the stream for error messages and trace events.
+ * @param pLine Pointer that receives the line, or NULL at the end of the stream.
+ * @param pLength Pointer that receives the number of characters in the line.
+ * @return SUCCESS if a line or the end of the stream is returned, otherwise FAILURE.
  */
-ReturnStatus is_line_available_for_read(FILE *pFile, Boolean *pIsData, int *pDataSize)
+ReturnStatus read_next_line(GradingContext *pContext, LineReader *pReader, const char *pStreamName, char **pLine,
+                            int *pLength)
 {
-    int ch;                        // Stores the character read from file
-    long readSize = 0;             // Size of data read
-    long readStart = ftell(pFile); // Store current file position
+    char *pLineStart = NULL;
+    long nLength = 0;
 
-    // Read until newline or EOF
-    while (TRUE)
+    while (pLineStart == NULL)
     {
-        // Read the next character from the file
-        ch = getc(pFile);
-
-        // If we encounter the end of a line
-        if (ch == END_OF_LINE_CHAR)
+        const char *pNewLine = find_next_character(&pReader->newLines);
+        if (pNewLine != NULL)
         {
-            // Calculate the size of the line (excluding the newline character)
-            readSize = ftell(pFile) - SIZE_OF_NEW_LINE - readStart;
-            // Exit the loop as we've found the end of the line
+            pLineStart = pReader->buffer + pReader->start;
+            nLength = pNewLine - pLineStart;
+            pReader->start = (pNewLine - pReader->buffer) + 1;
             break;
         }
 
-        // If we encounter the end of file (EOF)
-        if (ch == END_OF_FILE_CHAR)
+        if (pReader->isEndOfStream == TRUE)
         {
-            // Calculate the size of the line (excluding the newline character)
-            readSize = ftell(pFile) - readStart;
-            // Exit the loop
+            if (pReader->start == pReader->end)
+            {
+                *pLine = NULL;
+                *pLength = 0;
+                return SUCCESS;
+            }
+
+            // Last line without a newline
+            pLineStart = pReader->buffer + pReader->start;
+            nLength = pReader->end - pReader->start;
+            pReader->start = pReader->end;
             break;
         }
+
+        // Move the partial line to the front of the buffer
+        if (pReader->start > 0)
+        {
+            memmove(pReader->buffer, pReader->buffer + pReader->start, pReader->end - pReader->start);
+            pReader->end -= pReader->start;
+            pReader->start = 0;
+        }
+        long nSearch = pReader->end; // Buffered bytes before this have no newline
+
+        // Grow the buffer when one line fills it
+        if (pReader->end == pReader->capacity)
+        {
+            char *pLarger = NULL;
+            if (allocate_buffer_memory(pContext, (void **)&pLarger, pReader->capacity * 2 + 1) != SUCCESS)
+            {
+                return FAILURE;
+            }
+            memcpy(pLarger, pReader->buffer, pReader->end);
+            clear_buffer_memory(pContext, pReader->buffer);
+            pReader->buffer = pLarger;
+            pReader->capacity *= 2;
+        }
+
+        // Take whatever the stream or the read-ahead has ready, up to the free space
+        long nRead;
+        PROFILE_START(pContext, readStart);
+        TRACE_START(pContext, loadStart);
+        if (pReader->pDecompressor != NULL)
+        {
+            if (read_decompressed(pContext, pReader->pDecompressor, pStreamName, pReader->buffer + pReader->end,
+                                  pReader->capacity - pReader->end, &nRead) != SUCCESS)
+            {
+                TRACE_STOP(pContext, TRACE_STAGE_LOAD, pStreamName, TRACE_WHOLE_FILE, loadStart);
+                PROFILE_STOP(pContext, PHASE_READ, readStart);
+                return FAILURE;
+            }
+        }
+        else if (pReader->pReadAhead != NULL)
+        {
+            if (read_ahead(pReader->pReadAhead, pReader->buffer + pReader->end, pReader->capacity - pReader->end,
+                           &nRead) != SUCCESS)
+            {
+                nRead = -1;
+            }
+        }
+        else
+        {
+            do
+            {
+                nRead = read(pReader->descriptor, pReader->buffer + pReader->end, pReader->capacity - pReader->end);
+            } while (nRead < 0 && errno == EINTR);
+        }
+        TRACE_STOP(pContext, TRACE_STAGE_LOAD, pStreamName, TRACE_WHOLE_FILE, loadStart);
+        PROFILE_STOP(pContext, PHASE_READ, readStart);
+
+        if (nRead < 0)
+        {
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_READ, pStreamName);
+            return FAILURE;
+        }
+
+        pReader->isEndOfStream = (nRead == 0) ? TRUE : FALSE;
+        pReader->end += nRead;
+        pReader->nBytesRead += nRead;
+        PROFILE_ADD(pContext, nBytesRead, nRead);
+
+        // Find the newlines of the bytes just read
+        start_character_scan(&pReader->newLines, pReader->buffer + nSearch, nRead, END_OF_LINE_CHAR);
     }
 
-    // Reset file pointer to initial position
-    fseek(pFile, readStart, SEEK_SET);
+    // Drop the carriage return of a Windows line ending
+    if (nLength > 0 && pLineStart[nLength - 1] == CARRIAGE_RETURN_CHAR)
+    {
+        nLength--;
+    }
+    pLineStart[nLength] = STRING_TERMINATION;
+
+    *pLine = pLineStart;
+    *pLength = (int)nLength;
+
+    return SUCCESS;
+}
 
-    // Assign size and availability status
-    *pDataSize = readSize;                    // Set the size of the available data (in bytes)
-    *pIsData = (readSize > 0) ? TRUE : FALSE; // If data is available, set to TRUE, else FALSE
+/**
+ * @brief Releases the buffer and stops the read-ahead or decompressor of a line reader.
+ *
+ * The stream itself stays open.
+ *
+ * @param pContext The grading context that owns the read buffer.
+ * @param pReader The line reader.
+ * @return SUCCESS after the buffer is released.
+ */
+ReturnStatus close_line_reader(GradingContext *pContext, LineReader *pReader)
+{
+    close_decompressor(pContext, &pReader->pDecompressor);
+    close_read_ahead(pContext, &pReader->pReadAhead);
+    clear_buffer_memory(pContext, pReader->buffer);
+    *pReader = (LineReader){0};
 
     return SUCCESS;
 }
@@ -168,16 +316,17 @@ ReturnStatus is_line_available_for_read(FILE *pFile, Boolean *pIsData, int *pDat
  *
  * Attempts to open the file for writing. If unsuccessful, returns 'FAILURE'.
  *
+ * @param pContext The grading context that reports errors.
  * @param pFile Pointer to a 'FILE*' that will hold the file pointer upon success.
  * @param pFileName Name of the file to be opened.
  * @return SUCCESS if the file is successfully opened, otherwise FAILURE.
  */
-ReturnStatus open_file_in_write_mode(FILE **pFile, const char *pFileName)
+ReturnStatus open_file_in_write_mode(GradingContext *pContext, FILE **pFile, const char *pFileName)
 {
     // Check if the file pointer is valid
     if (*pFile != NULL)
     {
-        printf(WARNING_FILE_POINTER_NOT_NULL);
+        report_message(pContext, WARNING_FILE_POINTER_NOT_NULL);
     }
 
     // Open the file in write mode
@@ -186,7 +335,103 @@ ReturnStatus open_file_in_write_mode(FILE **pFile, const char *pFileName)
     // If file failed to open, return failure
     if (*pFile == NULL)
     {
-        printf(ERR_FILE_OPEN_WRITE, pFileName);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_OPEN_WRITE, pFileName);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Opens a temporary file next to a file that will be replaced.
+ *
+ * The temporary file is created in the directory of 'pFileName', so 'replace_file' can
+ * rename it over the file. It gets the permissions of the file it replaces, or those a
+ * new file would get.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pFile Pointer to a 'FILE*' that will hold the file pointer upon success.
+ * @param pFileName Name of the file that will be replaced.
+ * @param pTemporaryName Buffer of 'FILE_NAME_SIZE' bytes that receives the temporary file name.
+ * @return SUCCESS if the temporary file is open for writing, otherwise FAILURE.
+ */
+ReturnStatus open_temporary_file(GradingContext *pContext, FILE **pFile, const char *pFileName, char *pTemporaryName)
+{
+    struct stat fileStatus;
+    mode_t mode = 0;
+
+    if (snprintf(pTemporaryName, FILE_NAME_SIZE, "%s%s", pFileName, WATCH_TEMPORARY_SUFFIX) >= FILE_NAME_SIZE)
+    {
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_OPEN_WRITE, pFileName);
+        return FAILURE;
+    }
+
+    int descriptor = mkstemp(pTemporaryName);
+    if (descriptor < 0)
+    {
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_OPEN_WRITE, pTemporaryName);
+        return FAILURE;
+    }
+
+    // 'mkstemp' creates the file for its owner only
+    if (stat(pFileName, &fileStatus) == 0)
+    {
+        mode = fileStatus.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+    }
+    else
+    {
+        mode_t mask = umask(0);
+        umask(mask);
+        mode = (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH) & ~mask;
+    }
+    fchmod(descriptor, mode);
+
+    *pFile = fdopen(descriptor, "w");
+    if (*pFile == NULL)
+    {
+        close(descriptor);
+        unlink(pTemporaryName);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_OPEN_WRITE, pTemporaryName);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Closes a temporary file and renames it over the file it replaces.
+ *
+ * The data is flushed to the disk before the rename, so readers of 'pFileName' see either
+ * the old or the new contents, never a partly written file. On failure the temporary
+ * file is removed and 'pFileName' is left as it was.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pFile Pointer to the temporary file opened by 'open_temporary_file'.
+ * @param pTemporaryName Name of the temporary file.
+ * @param pFileName Name of the file to replace.
+ * @return SUCCESS if the file is replaced, otherwise FAILURE.
+ */
+ReturnStatus replace_file(GradingContext *pContext, FILE **pFile, const char *pTemporaryName, const char *pFileName)
+{
+    Boolean isWritten = (fflush(*pFile) == 0 && ferror(*pFile) == 0 && fsync(fileno(*pFile)) == 0) ? TRUE : FALSE;
+
+    if (fclose(*pFile) != 0)
+    {
+        isWritten = FALSE;
+    }
+    *pFile = NULL;
+
+    if (isWritten == FALSE)
+    {
+        unlink(pTemporaryName);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, pFileName);
+        return FAILURE;
+    }
+
+    if (rename(pTemporaryName, pFileName) != 0)
+    {
+        unlink(pTemporaryName);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_REPLACE, pFileName);
         return FAILURE;
     }
 
@@ -198,17 +443,18 @@ ReturnStatus open_file_in_write_mode(FILE **pFile, const char *pFileName)
  *
  * This function writes the number of students and the input filename as metadata in the output file.
  *
+ * @param pContext The grading context that owns the student table.
  * @param pFile Pointer to the open output file.
  * @param pReadFileName Name of the original input file.
  * @return SUCCESS if the header is written successfully, otherwise FAILURE.
  */
-ReturnStatus write_file_header(FILE *pFile, const char *pReadFileName)
+ReturnStatus write_file_header(GradingContext *pContext, FILE *pFile, const char *pReadFileName)
 {
     int numberOfStudents;
     int *pNumberoFStudents = &numberOfStudents;
 
     // Get the total number of students
-    if (set_number_of_students(pNumberoFStudents) != SUCCESS)
+    if (set_number_of_students(pContext, pNumberoFStudents) != SUCCESS)
     {
         return FAILURE;
     }
@@ -222,16 +468,382 @@ ReturnStatus write_file_header(FILE *pFile, const char *pReadFileName)
 /**
  * @brief Writes student data (names and grades) to the output file.
  *
+ * @param pContext The grading context that owns the student table.
  * @param pFile Pointer to the open output file.
  * @return SUCCESS if the data is written successfully, otherwise FAILURE.
  */
-ReturnStatus write_file_data(FILE *pFile)
+ReturnStatus write_file_data(GradingContext *pContext, FILE *pFile)
 {
     // Delegate writing operation to another function
-    if (write_names_and_grades_to_file(pFile) != SUCCESS)
+    if (write_names_and_grades_to_file(pContext, pFile) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+/**
+ * @brief Processes student data from an open file or stream.
+ *
+ * Reads each line of the stream, extracts student information, and stores it in the
+ * student table of the grading context. Processing stops at the first empty line. Lines
+ * are graded as they arrive, so a producer on the other end of a pipe keeps running while
+ * earlier lines are parsed. A stream that ends before any byte is read is reported as empty.
+ * When the context has a reject log, invalid lines are logged and skipped instead of failing
+ * the run.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param pFile Pointer to an open file or stream in read mode.
+ * @param pFileName Name of the file or stream for error messages.
+ * @return SUCCESS if the student data is processed correctly, otherwise FAILURE.
+ */
+ReturnStatus process_student_data(GradingContext *pContext, FILE *pFile, const char *pFileName)
+{
+    LineReader reader;
+    ReturnStatus status = SUCCESS;
+    char *DataString = NULL; // Line returned by the reader
+    int DataSize = 0;        // Number of characters in the line
+    long lineNumber = 0;     // Line of 'DataString' in the stream, counted from one
+
+    if (open_line_reader(pContext, &reader, pFile) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    while (TRUE)
+    {
+        // Read the next line from the stream
+        if (read_next_line(pContext, &reader, pFileName, &DataString, &DataSize) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        // Stop at the end of the stream or the first empty line
+        if (DataString == NULL || DataSize == 0)
+        {
+            break;
+        }
+
+        // Create the student record from the line
+        lineNumber++;
+        if (process_student_line(pContext, DataString, lineNumber) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+    }
+
+    // Emptiness is only known once the end of the stream is reached
+    if (status == SUCCESS && reader.nBytesRead == 0)
     {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_EMPTY, pFileName);
+        status = FAILURE;
+    }
+
+    close_line_reader(pContext, &reader);
+
+    return status;
+}
+
+/**
+ * @brief Processes one line of student data.
+ *
+ * Creates the student record of the line. When the context has a reject log, an invalid
+ * line is logged and skipped instead of failing.
+ *
+ * @param pContext The grading context that receives the student record.
+ * @param pLine The null terminated line.
+ * @param lineNumber Line number of the line for the reject log.
+ * @return SUCCESS if the line is processed or skipped, otherwise FAILURE.
+ */
+ReturnStatus process_student_line(GradingContext *pContext, const char *pLine, long lineNumber)
+{
+    PROFILE_START(pContext, parseStart);
+    Boolean isValid = TRUE;
+    if (pContext->pRejectLog != NULL)
+    {
+        RejectDiagnostic diagnostic = {.lineNumber = lineNumber};
+        check_student_data(pContext, pLine, &isValid, &diagnostic);
+        if (isValid == FALSE)
+        {
+            add_rejected_row(pContext->pRejectLog, &diagnostic, pLine);
+        }
+    }
+    ReturnStatus status = (isValid == TRUE) ? create_student(pContext, pLine) : SUCCESS;
+    PROFILE_STOP(pContext, PHASE_PARSE, parseStart);
+
+    return status;
+}
+
+/**
+ * @brief Processes the lines of a byte range read with 'read_file_range'.
+ *
+ * Works like 'process_student_data' on a buffer the caller owns: each line is terminated
+ * in place, so no line is copied. Line numbers in the reject log count from one at the
+ * start of the buffer. Processing stops at the first empty line, which ends the roster.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param pBuffer The complete lines of the range, changed in place.
+ * @param nSize Number of bytes in the buffer.
+ * @param pnLines Pointer that receives the number of lines processed.
+ * @param pIsStopped Pointer that receives TRUE if an empty line was found.
+ * @return SUCCESS if the lines are processed, otherwise FAILURE.
+ */
+ReturnStatus process_student_range(GradingContext *pContext, char *pBuffer, long nSize, long *pnLines,
+                                   Boolean *pIsStopped)
+{
+    char *pLine = pBuffer;
+    char *pEnd = pBuffer + nSize;
+    CharacterScan newLines;
+
+    *pnLines = 0;
+    *pIsStopped = FALSE;
+    start_character_scan(&newLines, pBuffer, nSize, END_OF_LINE_CHAR);
+
+    while (pLine < pEnd)
+    {
+        // Find the end of the line
+        char *pNewLine = (char *)find_next_character(&newLines);
+        char *pLineEnd = (pNewLine != NULL) ? pNewLine : pEnd;
+        char *pNext = (pNewLine != NULL) ? pNewLine + 1 : pEnd;
+
+        // Drop the carriage return of a Windows line ending
+        if (pLineEnd > pLine && *(pLineEnd - 1) == CARRIAGE_RETURN_CHAR)
+        {
+            pLineEnd--;
+        }
+
+        if (pLineEnd == pLine)
+        {
+            *pIsStopped = TRUE;
+            break;
+        }
+
+        // A last line without a newline ends in the free byte 'read_file_range' leaves after the lines
+        *pLineEnd = STRING_TERMINATION;
+
+        (*pnLines)++;
+        if (process_student_line(pContext, pLine, *pnLines) != SUCCESS)
+        {
+            return FAILURE;
+        }
+
+        pLine = pNext;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Processes student data from a buffer in memory.
+ *
+ * Splits the buffer into lines ending with a newline, with or without a carriage return,
+ * and creates a student record for each line. As with file input, processing stops at
+ * the first empty line. The buffer does not need to be null terminated.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param pBuffer The buffer holding comma separated student data.
+ * @param nSize Number of bytes in the buffer.
+ * @return SUCCESS if the student data is processed correctly, otherwise FAILURE.
+ */
+ReturnStatus process_student_buffer(GradingContext *pContext, const char *pBuffer, long nSize)
+{
+    const char *pLine = pBuffer;
+    const char *pEnd = pBuffer + nSize;
+    char *DataString = NULL;
+    CharacterScan newLines;
+
+    start_character_scan(&newLines, pBuffer, nSize, END_OF_LINE_CHAR);
+
+    while (pLine < pEnd)
+    {
+        // Find the end of the line
+        const char *pNewLine = find_next_character(&newLines);
+        const char *pLineEnd = (pNewLine != NULL) ? pNewLine : pEnd;
+        const char *pNext = (pNewLine != NULL) ? pNewLine + 1 : pEnd;
+
+        // Drop the carriage return of a Windows line ending
+        if (pLineEnd > pLine && *(pLineEnd - 1) == CARRIAGE_RETURN_CHAR)
+        {
+            pLineEnd--;
+        }
+
+        int DataSize = (int)(pLineEnd - pLine);
+        if (DataSize <= 0)
+        {
+            break;
+        }
+
+        // Copy the line into a null terminated string
+        if (allocate_string_memory(pContext, &DataString, DataSize) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        memcpy(DataString, pLine, DataSize);
+        DataString[DataSize] = STRING_TERMINATION;
+
+        // Create the student record from the line
+        if (create_student(pContext, DataString) != SUCCESS)
+        {
+            clear_string_memory(pContext, DataString);
+            return FAILURE;
+        }
+
+        // Clear the allocated memory after use
+        clear_string_memory(pContext, DataString);
+
+        pLine = pNext;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Gets the size of a file in bytes.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pFileName Name of the file.
+ * @param pSize Pointer that receives the size of the file.
+ * @return SUCCESS if the size is read, otherwise FAILURE.
+ */
+ReturnStatus get_file_size(GradingContext *pContext, const char *pFileName, long *pSize)
+{
+    FILE *pFile = fopen(pFileName, "rb");
+    if (pFile == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
+        return FAILURE;
+    }
+
+    fseek(pFile, 0, SEEK_END);
+    *pSize = ftell(pFile);
+    fclose(pFile);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Gets the size of an open regular file.
+ *
+ * Pipes, terminals and other streams have no size known in advance.
+ *
+ * @param pFile The open file or stream.
+ * @param pSize Pointer that receives the size in bytes, or -1 if the stream is not a regular file.
+ * @return SUCCESS after the size is stored.
+ */
+ReturnStatus get_stream_size(FILE *pFile, long *pSize)
+{
+    struct stat status;
+
+    *pSize = (fstat(fileno(pFile), &status) == 0 && S_ISREG(status.st_mode)) ? (long)status.st_size : -1;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads the lines of a file that start inside a byte range.
+ *
+ * A line belongs to the range in which its first byte lies, so consecutive ranges of one
+ * file read every line exactly once. The read starts one byte early to see whether the
+ * range begins at a line start, and continues past the end of the range until the last
+ * line is complete. The buffer is allocated from the grading context and must be released
+ * with 'clear_buffer_memory'. At least one byte after the lines is free, so the last line
+ * can be terminated in place.
+ *
+ * @param pContext The grading context that owns the buffer.
+ * @param pFileName Name of the file.
+ * @param nStart First byte of the range.
+ * @param nEnd Byte after the range.
+ * @param pBuffer Pointer that receives the buffer with the complete lines.
+ * @param pSize Pointer that receives the number of bytes in the buffer.
+ * @return SUCCESS if the lines are read, otherwise FAILURE.
+ */
+ReturnStatus read_file_range(GradingContext *pContext, const char *pFileName, long nStart, long nEnd,
+                             char **pBuffer, long *pSize)
+{
+    FILE *pFile = fopen(pFileName, "rb");
+    if (pFile == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
+        return FAILURE;
+    }
+
+    // Read one byte before the range to find the first line start
+    long nFrom = (nStart > 0) ? nStart - 1 : 0;
+    long nCapacity = nEnd - nFrom + BATCH_READ_BLOCK_SIZE;
+    char *pData = NULL;
+    if (allocate_buffer_memory(pContext, (void **)&pData, nCapacity) != SUCCESS)
+    {
+        fclose(pFile);
+        return FAILURE;
+    }
+
+    fseek(pFile, nFrom, SEEK_SET);
+    long nRead = (long)fread(pData, sizeof(char), nEnd - nFrom, pFile);
+
+    // Keep reading until the line holding the last byte of the range is complete
+    long nSearch = (nEnd - 1 > nFrom) ? nEnd - 1 - nFrom : 0;
+    while (nSearch < nRead && memchr(pData + nSearch, END_OF_LINE_CHAR, nRead - nSearch) == NULL)
+    {
+        nSearch = nRead;
+        if (nRead + BATCH_READ_BLOCK_SIZE > nCapacity)
+        {
+            // Grow the buffer for long lines
+            char *pLarger = NULL;
+            if (allocate_buffer_memory(pContext, (void **)&pLarger, nCapacity * 2) != SUCCESS)
+            {
+                clear_buffer_memory(pContext, pData);
+                fclose(pFile);
+                return FAILURE;
+            }
+            memcpy(pLarger, pData, nRead);
+            clear_buffer_memory(pContext, pData);
+            pData = pLarger;
+            nCapacity *= 2;
+        }
+
+        long nBlock = (long)fread(pData + nRead, sizeof(char), BATCH_READ_BLOCK_SIZE, pFile);
+        if (nBlock <= 0)
+        {
+            break;
+        }
+        nRead += nBlock;
+    }
+
+    if (ferror(pFile))
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_READ, pFileName);
+        clear_buffer_memory(pContext, pData);
+        fclose(pFile);
         return FAILURE;
     }
+    fclose(pFile);
+
+    // Skip the partial line owned by the previous range
+    long nFirst = 0;
+    if (nStart > 0)
+    {
+        char *pNewLine = memchr(pData, END_OF_LINE_CHAR, nRead);
+        nFirst = (pNewLine != NULL) ? (pNewLine - pData) + 1 : nRead;
+        // A line that starts after the range belongs to the next range
+        nFirst = (nFrom + nFirst >= nEnd) ? nRead : nFirst;
+    }
+
+    // End after the newline that completes the last line starting inside the range
+    long nLast = nRead;
+    if (nSearch < nRead)
+    {
+        char *pNewLine = memchr(pData + nSearch, END_OF_LINE_CHAR, nRead - nSearch);
+        nLast = (pNewLine != NULL) ? (pNewLine - pData) + 1 : nRead;
+    }
+
+    // Move the owned lines to the start of the buffer
+    long nSize = (nLast > nFirst) ? nLast - nFirst : 0;
+    memmove(pData, pData + nFirst, nSize);
+
+    *pBuffer = pData;
+    *pSize = nSize;
 
     return SUCCESS;
-}
\ No newline at end of file
+}
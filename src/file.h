@@ -5,15 +5,27 @@
 #include "messages.h" 
 #include "types.h"
 
-ReturnStatus open_file_in_read_mode(FILE **, const char *);
-ReturnStatus open_file_in_write_mode(FILE **, const char *);
+ReturnStatus open_file_in_read_mode(GradingContext *, FILE **, const char *);
+ReturnStatus open_file_in_write_mode(GradingContext *, FILE **, const char *);
+ReturnStatus open_temporary_file(GradingContext *, FILE **, const char *, char *);
+ReturnStatus replace_file(GradingContext *, FILE **, const char *, const char *);
 
-ReturnStatus write_file_header(FILE *pFile, const char *pReadFileName);
-ReturnStatus write_file_data(FILE *pFile);
+ReturnStatus write_file_header(GradingContext *, FILE *pFile, const char *pReadFileName);
+ReturnStatus write_file_data(GradingContext *, FILE *pFile);
 
-ReturnStatus is_line_available_for_read(FILE *, Boolean *, int *);
-ReturnStatus read_one_line_from_file(FILE *, char **, long);
+ReturnStatus open_line_reader(GradingContext *, LineReader *, FILE *);
+ReturnStatus read_next_line(GradingContext *, LineReader *, const char *, char **, int *);
+ReturnStatus close_line_reader(GradingContext *, LineReader *);
 
-ReturnStatus close_file(FILE **pFile);
+ReturnStatus process_student_data(GradingContext *, FILE *, const char *);
+ReturnStatus process_student_buffer(GradingContext *, const char *, long);
+ReturnStatus process_student_line(GradingContext *, const char *, long);
+ReturnStatus process_student_range(GradingContext *, char *, long, long *, Boolean *);
+
+ReturnStatus get_file_size(GradingContext *, const char *, long *);
+ReturnStatus get_stream_size(FILE *, long *);
+ReturnStatus read_file_range(GradingContext *, const char *, long, long, char **, long *);
+
+ReturnStatus close_file(GradingContext *, FILE **pFile);
 
 #endif // FILE_H
\ No newline at end of file
@@ -0,0 +1,374 @@
+/**
+ * @file grader.c
+ * @brief Batch API of the embeddable grading library (libgrader).
+ *
+ * Wraps a grading context in an opaque handle so other programs can load, grade and read
+ * back rosters without spawning the application. Every grader owns its own context and
+ * reports errors only through 'grader_last_error'; see 'grader.h' for the allocation and
+ * thread safety contract.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "grader.h"
+#include "helper.h"
+#include "memory.h"
+#include "student.h"
+
+// Define grader handle
+struct grader
+{
+    GradingContext context; // Grading state of this grader
+    GraderResult *results;  // Results sorted by name, NULL until requested
+    int nResults;           // Number of entries in 'results'
+    Boolean isGraded;       // TRUE once the loaded students are graded
+};
+
+// Function declaration
+ReturnStatus clear_grader_results(Grader *);
+
+/**
+ * @brief Creates a grader with an empty roster.
+ *
+ * The grader itself is allocated with 'malloc' because it owns the context whose
+ * allocation counters track everything else.
+ *
+ * @param pGrader Pointer that receives the new grader.
+ *
+ * @return SUCCESS if the grader is created.
+ *         FAILURE if memory allocation fails.
+ */
+ReturnStatus grader_create(Grader **pGrader)
+{
+    if (pGrader == NULL)
+    {
+        return FAILURE;
+    }
+
+    *pGrader = (Grader *)malloc(sizeof(Grader));
+    if (*pGrader == NULL)
+    {
+        return FAILURE;
+    }
+
+    // Library callers never get console output
+    init_grading_context(&(*pGrader)->context, NULL);
+    set_message_stream(&(*pGrader)->context, NULL);
+
+    (*pGrader)->results = NULL;
+    (*pGrader)->nResults = 0;
+    (*pGrader)->isGraded = FALSE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Destroys a grader and releases all memory it owns.
+ *
+ * @param pGrader Pointer to the grader, set to NULL afterwards.
+ *
+ * @return SUCCESS if the grader is destroyed.
+ *         FAILURE if the roster memory could not be released.
+ */
+ReturnStatus grader_destroy(Grader **pGrader)
+{
+    if (pGrader == NULL || *pGrader == NULL)
+    {
+        return SUCCESS;
+    }
+
+    ReturnStatus status = grader_reset(*pGrader);
+
+    free(*pGrader);
+    *pGrader = NULL;
+
+    return status;
+}
+
+/**
+ * @brief Removes all students and results so the grader can load a new roster.
+ *
+ * @param pGrader The grader to reset.
+ *
+ * @return SUCCESS if the grader is reset.
+ *         FAILURE if the roster memory could not be released.
+ */
+ReturnStatus grader_reset(Grader *pGrader)
+{
+    clear_grader_results(pGrader);
+    pGrader->isGraded = FALSE;
+
+    if (clear_grading_context(&pGrader->context) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    pGrader->context.distribution = (GradeDistribution){0};
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Loads student data from a buffer in memory.
+ *
+ * Lines are added to the students already loaded. The buffer is not kept after the call.
+ *
+ * @param pGrader The grader that receives the students.
+ * @param pBuffer Comma separated student data, one student per line.
+ * @param nSize Number of bytes in the buffer.
+ *
+ * @return SUCCESS if every line is loaded.
+ *         FAILURE if a line is invalid or memory allocation fails.
+ */
+ReturnStatus grader_load_buffer(Grader *pGrader, const char *pBuffer, long nSize)
+{
+    clear_grader_results(pGrader);
+    pGrader->isGraded = FALSE;
+
+    return process_student_buffer(&pGrader->context, pBuffer, nSize);
+}
+
+/**
+ * @brief Loads student data from a file.
+ *
+ * Lines are added to the students already loaded.
+ *
+ * @param pGrader The grader that receives the students.
+ * @param pFileName Name of the file with comma separated student data.
+ *
+ * @return SUCCESS if the file is loaded.
+ *         FAILURE if the file cannot be read or a line is invalid.
+ */
+ReturnStatus grader_load_file(Grader *pGrader, const char *pFileName)
+{
+    FILE *pFile = NULL;
+
+    clear_grader_results(pGrader);
+    pGrader->isGraded = FALSE;
+
+    if (open_file_in_read_mode(&pGrader->context, &pFile, pFileName) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    ReturnStatus status = process_student_data(&pGrader->context, pFile, pFileName);
+
+    close_file(&pGrader->context, &pFile);
+
+    return status;
+}
+
+/**
+ * @brief Grades all loaded students and updates the grade distribution.
+ *
+ * @param pGrader The grader whose students are graded.
+ *
+ * @return SUCCESS if every student is graded.
+ *         FAILURE if a student has the wrong number of scores.
+ */
+ReturnStatus grader_grade(Grader *pGrader)
+{
+    clear_grader_results(pGrader);
+
+    if (calculate_student_grade(&pGrader->context) != SUCCESS)
+    {
+        pGrader->isGraded = FALSE;
+        return FAILURE;
+    }
+
+    pGrader->isGraded = TRUE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the graded students sorted by name.
+ *
+ * The array is built on the first call after grading and reused by later calls.
+ *
+ * @param pGrader The grader with graded students.
+ * @param pResults Pointer that receives the result array owned by the grader.
+ * @param pCount Pointer that receives the number of results.
+ *
+ * @return SUCCESS if the results are available.
+ *         FAILURE if the students are not graded or memory allocation fails.
+ */
+ReturnStatus grader_get_results(Grader *pGrader, const GraderResult **pResults, int *pCount)
+{
+    GradingContext *pContext = &pGrader->context;
+
+    if (pGrader->isGraded == FALSE)
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_GRADER_NOT_GRADED);
+        return FAILURE;
+    }
+
+    if (pGrader->results == NULL)
+    {
+        int nStudents = 0;
+        set_number_of_students(pContext, &nStudents);
+
+        // Sort the roster once, an empty roster has nothing to sort
+        if (nStudents > 0 && sort_list_by_name(pContext) != SUCCESS)
+        {
+            return FAILURE;
+        }
+
+        if (allocate_buffer_memory(pContext, (void **)&pGrader->results, nStudents * sizeof(GraderResult)) != SUCCESS)
+        {
+            return FAILURE;
+        }
+
+        int n = 0;
+        for (Record *current = pContext->table.head; current != NULL; current = current->next)
+        {
+            pGrader->results[n].name = current->name;
+            pGrader->results[n].weightedScore = current->weightedScore;
+            pGrader->results[n].grade = current->grade;
+            n++;
+        }
+        pGrader->nResults = n;
+    }
+
+    *pResults = pGrader->results;
+    *pCount = pGrader->nResults;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the number of tests in the grading schema.
+ *
+ * Use this count to size the arrays passed to 'grader_get_statistics'.
+ *
+ * @param pGrader The grader.
+ * @param pCount Pointer that receives the number of tests.
+ *
+ * @return SUCCESS after the count is set.
+ */
+ReturnStatus grader_get_test_count(const Grader *pGrader, int *pCount)
+{
+    *pCount = pGrader->context.schema->nTests;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Copies the per-test average, minimum and maximum into caller arrays.
+ *
+ * Any of the arrays may be NULL when that statistic is not needed.
+ *
+ * @param pGrader The grader with graded students.
+ * @param pAverage Array that receives the average of each test.
+ * @param pMinimum Array that receives the minimum of each test.
+ * @param pMaximum Array that receives the maximum of each test.
+ * @param nSize Number of entries in each array.
+ *
+ * @return SUCCESS if the statistics are copied.
+ *         FAILURE if the students are not graded or the arrays are too small.
+ */
+ReturnStatus grader_get_statistics(Grader *pGrader, double *pAverage, double *pMinimum, double *pMaximum, int nSize)
+{
+    GradingContext *pContext = &pGrader->context;
+    int nTests = pContext->schema->nTests;
+
+    // Grading checks every student has a score for each test
+    if (pGrader->isGraded == FALSE)
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_GRADER_NOT_GRADED);
+        return FAILURE;
+    }
+
+    if (nSize < nTests)
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_BUFFER_SIZE, nSize, nTests);
+        return FAILURE;
+    }
+
+    for (int n = 0; n < nTests; n++)
+    {
+        if (pAverage != NULL && calculate_average(pContext, n, &pAverage[n]) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        if (pMinimum != NULL && calculate_minimum(pContext, n, &pMinimum[n]) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        if (pMaximum != NULL && calculate_maximum(pContext, n, &pMaximum[n]) != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Copies the letter grade counts and weighted score histogram into caller arrays.
+ *
+ * 'pLetterCount' holds 'NUMBER_OF_GRADES' entries ordered A to F and 'pHistogram' holds
+ * 'HISTOGRAM_BUCKET_COUNT' entries of 'HISTOGRAM_BUCKET_WIDTH' points each. Either array
+ * may be NULL.
+ *
+ * @param pGrader The grader with graded students.
+ * @param pLetterCount Array that receives the number of students per letter grade.
+ * @param pHistogram Array that receives the number of students per score bucket.
+ *
+ * @return SUCCESS if the distribution is copied.
+ *         FAILURE if the students are not graded.
+ */
+ReturnStatus grader_get_distribution(const Grader *pGrader, int *pLetterCount, int *pHistogram)
+{
+    const GradeDistribution *pDistribution = &pGrader->context.distribution;
+
+    if (pGrader->isGraded == FALSE)
+    {
+        return FAILURE;
+    }
+
+    for (int n = 0; pLetterCount != NULL && n < NUMBER_OF_GRADES; n++)
+    {
+        pLetterCount[n] = pDistribution->letterCount[n];
+    }
+
+    for (int n = 0; pHistogram != NULL && n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        pHistogram[n] = pDistribution->scoreHistogram[n];
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the last error or warning reported by a grader.
+ *
+ * @param pGrader The grader.
+ *
+ * @return The message, or an empty string if nothing has been reported.
+ */
+const char *grader_last_error(const Grader *pGrader)
+{
+    return pGrader->context.lastMessage;
+}
+
+/**
+ * @brief Releases the cached result array of a grader.
+ *
+ * @param pGrader The grader whose results are released.
+ *
+ * @return SUCCESS after the results are released.
+ */
+ReturnStatus clear_grader_results(Grader *pGrader)
+{
+    clear_buffer_memory(&pGrader->context, pGrader->results);
+    pGrader->results = NULL;
+    pGrader->nResults = 0;
+
+    return SUCCESS;
+}
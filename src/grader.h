@@ -0,0 +1,55 @@
+/**
+ * @file grader.h
+ * @brief Batch API of the embeddable grading library (libgrader).
+ *
+ * The library grades rosters in-process: load student data from a buffer or a file, grade it,
+ * then fetch the results sorted by name and the class statistics as arrays. The library never
+ * prints to the console and never reads from stdin; the last error message is available
+ * from 'grader_last_error'.
+ *
+ * Allocation contract:
+ * - 'grader_create' allocates a grader that owns all memory it hands out.
+ * - Result arrays and the names they point to stay valid until the next call to
+ *   'grader_load_buffer', 'grader_load_file', 'grader_grade', 'grader_reset' or
+ *   'grader_destroy' on the same grader. Callers must not free them.
+ * - Statistics and distributions are copied into arrays supplied by the caller.
+ * - 'grader_destroy' releases everything and sets the caller's pointer to NULL.
+ *
+ * Thread safety contract:
+ * - Graders share no state, so different graders can be used on different threads at the
+ *   same time.
+ * - A single grader must not be used by more than one thread at a time.
+ */
+
+#ifndef GRADER_H
+#define GRADER_H
+
+#include "types.h"
+
+// Opaque grader handle
+typedef struct grader Grader;
+
+// Define graded result of one student
+typedef struct
+{
+    const char *name;     // Student name, owned by the grader
+    double weightedScore; // Weighted score of the student
+    char grade;           // Letter grade of the student
+} GraderResult;
+
+ReturnStatus grader_create(Grader **);
+ReturnStatus grader_destroy(Grader **);
+ReturnStatus grader_reset(Grader *);
+
+ReturnStatus grader_load_buffer(Grader *, const char *, long);
+ReturnStatus grader_load_file(Grader *, const char *);
+ReturnStatus grader_grade(Grader *);
+
+ReturnStatus grader_get_results(Grader *, const GraderResult **, int *);
+ReturnStatus grader_get_test_count(const Grader *, int *);
+ReturnStatus grader_get_statistics(Grader *, double *, double *, double *, int);
+ReturnStatus grader_get_distribution(const Grader *, int *, int *);
+
+const char *grader_last_error(const Grader *);
+
+#endif // GRADER_H
@@ -5,6 +5,7 @@
  * This file contains helper functions for managing linked lists, adding and sorting records, and
  * handling tokenization of strings. The functions provide utility for creating and manipulating
  * linked lists of records, as well as parsing and processing comma-separated tokenized data.
+ * All state is kept in the grading context passed to each function.
  */
 
 // Library includes
@@ -12,150 +13,398 @@
 #include <string.h>
 
 // Code includes
+#include "context.h"
 #include "helper.h"
 #include "memory.h"
+#include "profiler.h"
+#include "scan.h"
+#include "writer.h"
 
 // Function declaration
-ReturnStatus new_record_list(Record **, Record *);
-ReturnStatus append_record_list(Record *, Record *);
+ReturnStatus new_record_list(StudentTable *, Record *);
+ReturnStatus append_record_list(StudentTable *, Record *, long *);
+Record *split_record_run(Record *, long);
+ReturnStatus merge_record_runs(Record *, Record *, Record **, Record **, long *);
+long get_sort_key_value(const Record *, SortOrder);
+int get_key_bit_count(uint64_t);
+uint64_t *radix_sort_keys(uint64_t *, uint64_t *, long, int);
+char *split_next_token(Tokenizer *);
 
 /**
- * @brief Adds a record to the linked list.
+ * @brief Adds a record to the student table.
  *
  * This function checks if the list is empty and either creates a new list or appends
- * the record to the end of the list. It handles the insertion of the record appropriately
- * based on the current state of the linked list.
+ * the record to the end of the list. The table keeps a pointer to the last record, so
+ * appending does not need to traverse the list. The records visited to find the end are
+ * counted in the profiler.
  *
- * @param head Pointer to the head of the linked list.
+ * @param pContext The grading context that owns the student table.
  * @param record Pointer to the record to be added.
  *
  * @return SUCCESS if the record is successfully added.
  *         FAILURE if an error occurs during the process.
  */
-ReturnStatus add_record_to_list(Record **head, Record *record)
+ReturnStatus add_record_to_list(GradingContext *pContext, Record *record)
 {
     // Record must not be NULL
     if (record == NULL)
     {
-        printf(ERR_RECORD_EMPTY);
+        report_error(pContext, ERROR_CLASS_DATA, ERR_RECORD_EMPTY);
         return FAILURE;
     }
 
     // If the list is empty, create a new record list
-    if (*head == NULL)
+    if (pContext->table.head == NULL)
     {
-        if (new_record_list(head, record) != SUCCESS)
+        if (new_record_list(&pContext->table, record) != SUCCESS)
         {
             return FAILURE;
         }
     }
     else
     {
-        Record *last = *head;
-        // Traverse to the last node
-        while (last->next != NULL)
-        {
-            last = last->next;
-        }
         // Append the record to the end of the list
-        if (append_record_list(last, record) != SUCCESS)
+        long nSteps = 0;
+        if (append_record_list(&pContext->table, record, &nSteps) != SUCCESS)
         {
             return FAILURE;
         };
+        PROFILE_ADD(pContext, nRecordSteps, nSteps);
     }
     return SUCCESS;
 }
 
 /**
- * @brief Sorts the linked list by the name field.
+ * @brief Sorts the student table by the name field.
  *
- * This function performs a bubble sort on the linked list, comparing the 'name' fields
- * of the records. If the names are out of order, the nodes are swapped to sort the list.
+ * This function performs a bottom-up merge sort on the linked list, comparing the 'name'
+ * fields of the records. Sorted runs of 1, 2, 4, ... records are merged pairwise until a
+ * single run is left, which takes O(n log n) comparisons and no extra memory. Records with
+ * equal names keep their input order.
  *
- * @param head Pointer to the head of the linked list.
+ * @param pContext The grading context that owns the student table.
  *
  * @return SUCCESS if the list is successfully sorted.
  *         FAILURE if an error occurs during sorting.
  */
-ReturnStatus sort_list_by_name(Record **head)
+ReturnStatus sort_list_by_name(GradingContext *pContext)
 {
+    Record *head = pContext->table.head;
+
     // Don't attempt to sort an empty list
-    if (*head == NULL)
+    if (head == NULL)
     {
-        printf(ERR_RECORD_EMPTY);
+        report_error(pContext, ERROR_CLASS_DATA, ERR_RECORD_EMPTY);
         return FAILURE;
     }
 
     // No sort needed if there is only one node
-    if ((*head)->next == NULL)
+    if (head->next == NULL)
     {
         return SUCCESS;
     }
 
-    Boolean isSwap = TRUE;
-    Record *previous = NULL;
-    Record *current = NULL;
-    Record *next = NULL;
-    //Record *temp = NULL;
+    Record *tail = NULL;
+    int nMerges = 0;
+    long nComparisons = 0;
 
-    // Continue sorting as long as a swap was made in the previous pass
-    while (isSwap)
+    // Merge runs of doubling length until one pass merges the whole list at once
+    for (long runLength = 1; nMerges != 1; runLength *= 2)
     {
-        isSwap = FALSE;
-        current = *head; // Reset current to head at the start of each pass
-        previous = NULL;
+        Record *pending = head; // Records not merged in this pass yet
+        head = NULL;
+        tail = NULL;
+        nMerges = 0;
 
-        // Traverse the list and perform swaps if needed
-        while (current->next != NULL)
+        while (pending != NULL)
         {
-            next = current->next;
+            Record *left = pending;
+            Record *right = split_record_run(left, runLength);
+            pending = split_record_run(right, runLength);
 
-            // Compare names and swap nodes if needed
-            if (strcmp(current->name, next->name) > 0)
+            // Append the merged pair of runs to the list built by this pass
+            Record *mergedHead = NULL;
+            Record *mergedTail = NULL;
+            merge_record_runs(left, right, &mergedHead, &mergedTail, &nComparisons);
+            if (tail == NULL)
             {
-                // Perform swap of nodes
-                isSwap = TRUE; // Mark that we swapped
-                // Redirect previos nodes
-                if (previous == NULL) // If current is the head node
-                {
-                    // Update head to the next node
-                    *head = next;
-                }
-                else
-                {
-                    previous->next = next;
-                }
-                // Perform the node swap
-                current->next = next->next;
-                next->next = current;
-                previous = next;
+                head = mergedHead;
             }
             else
             {
-                // Move to the next node in the list if no swap occurred
-                previous = current;
-                current = current->next;
+                tail->next = mergedHead;
             }
+            tail = mergedTail;
+            nMerges++;
+        }
+    }
+
+    pContext->table.head = head;
+    pContext->table.tail = tail;
+    PROFILE_ADD(pContext, nNameComparisons, nComparisons);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Cuts a run of records off the front of a list.
+ *
+ * @param run The first record of the run, or NULL.
+ * @param runLength The largest number of records in the run.
+ *
+ * @return The first record after the run, or NULL if the list ends within the run.
+ */
+Record *split_record_run(Record *run, long runLength)
+{
+    for (long n = 1; run != NULL && n < runLength; n++)
+    {
+        run = run->next;
+    }
+
+    if (run == NULL)
+    {
+        return NULL;
+    }
+
+    Record *rest = run->next;
+    run->next = NULL;
+
+    return rest;
+}
+
+/**
+ * @brief Merges two runs sorted by name into one sorted run.
+ *
+ * On equal names the record of the left run comes first, which keeps the sort stable.
+ *
+ * @param left The first record of the left run.
+ * @param right The first record of the right run, or NULL.
+ * @param pHead Receives the first record of the merged run.
+ * @param pTail Receives the last record of the merged run.
+ * @param pnComparisons Pointer to the count of name comparisons, increased by this merge.
+ *
+ * @return SUCCESS after the runs are merged.
+ */
+ReturnStatus merge_record_runs(Record *left, Record *right, Record **pHead, Record **pTail, long *pnComparisons)
+{
+    Record merged = {0}; // Placeholder in front of the merged run
+    Record *tail = &merged;
+
+    while (left != NULL && right != NULL)
+    {
+        (*pnComparisons)++;
+        if (strcmp(left->name, right->name) <= 0)
+        {
+            tail->next = left;
+            left = left->next;
+        }
+        else
+        {
+            tail->next = right;
+            right = right->next;
         }
+        tail = tail->next;
+    }
+
+    // Link the rest of the run that is left over
+    tail->next = (left != NULL) ? left : right;
+    while (tail->next != NULL)
+    {
+        tail = tail->next;
+    }
+
+    *pHead = merged.next;
+    *pTail = tail;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Orders a student table sorted by name by weighted score or by letter grade.
+ *
+ * The table must be sorted by name, as 'sort_list_by_name' leaves it. Each record gets a
+ * packed 64-bit key with the score or letter in the high bits and the position of the
+ * record in name order in the low bits, so the keys are unique and equal scores or letters
+ * keep the name order. The keys are ordered with a radix sort instead of a comparator over
+ * the records, then the list is linked again in key order.
+ *
+ * @param pContext The grading context that owns the student table.
+ * @param order The order of the students, 'SORT_ORDER_SCORE' or 'SORT_ORDER_GRADE'.
+ *
+ * @return SUCCESS if the list is sorted, FAILURE if memory is exhausted.
+ */
+ReturnStatus sort_list_by_key(GradingContext *pContext, SortOrder order)
+{
+    long nStudents = pContext->table.nStudents;
+    uint64_t *keys = NULL;
+    uint64_t *spare = NULL;
+    Record **records = NULL;
+
+    if (order == SORT_ORDER_NAME || nStudents < 2)
+    {
+        return SUCCESS;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&keys, nStudents * sizeof(uint64_t)) != SUCCESS ||
+        allocate_buffer_memory(pContext, (void **)&spare, nStudents * sizeof(uint64_t)) != SUCCESS ||
+        allocate_buffer_memory(pContext, (void **)&records, nStudents * sizeof(Record *)) != SUCCESS)
+    {
+        clear_buffer_memory(pContext, keys);
+        clear_buffer_memory(pContext, spare);
+        return FAILURE;
+    }
+
+    // Take the sort values in name order and find their range
+    long nRecords = 0;
+    long lowest = 0;
+    long highest = 0;
+    for (Record *current = pContext->table.head; current != NULL && nRecords < nStudents; current = current->next)
+    {
+        long value = get_sort_key_value(current, order);
+        lowest = (nRecords == 0 || value < lowest) ? value : lowest;
+        highest = (nRecords == 0 || value > highest) ? value : highest;
+        keys[nRecords] = (uint64_t)value;
+        records[nRecords++] = current;
     }
+
+    // Pack the value above the position in name order, in as few bits as the roster needs
+    int nPositionBits = get_key_bit_count((uint64_t)(nRecords - 1));
+    int nKeyBits = nPositionBits + get_key_bit_count((uint64_t)(highest - lowest));
+    for (long n = 0; n < nRecords; n++)
+    {
+        keys[n] = (((uint64_t)((long)keys[n] - lowest)) << nPositionBits) | (uint64_t)n;
+    }
+
+    uint64_t *sorted = radix_sort_keys(keys, spare, nRecords, nKeyBits);
+
+    // Link the records again in key order
+    uint64_t positionMask = (nPositionBits < SORT_KEY_BITS) ? ((1ULL << nPositionBits) - 1) : ~0ULL;
+    Record *head = records[sorted[0] & positionMask];
+    Record *tail = head;
+    for (long n = 1; n < nRecords; n++)
+    {
+        tail->next = records[sorted[n] & positionMask];
+        tail = tail->next;
+    }
+    tail->next = NULL;
+    pContext->table.head = head;
+    pContext->table.tail = tail;
+
+    clear_buffer_memory(pContext, records);
+    clear_buffer_memory(pContext, spare);
+    clear_buffer_memory(pContext, keys);
+
     return SUCCESS;
 }
 
+/**
+ * @brief Returns the value a record is ordered by, smaller values first.
+ *
+ * @param record The record.
+ * @param order The order of the students.
+ *
+ * @return The negated weighted score in hundredths, so the highest score comes first, or
+ *         the letter grade.
+ */
+long get_sort_key_value(const Record *record, SortOrder order)
+{
+    if (order == SORT_ORDER_SCORE)
+    {
+        return -get_score_hundredths(record->weightedScore);
+    }
+
+    return (unsigned char)record->grade;
+}
+
+/**
+ * @brief Returns the number of bits needed to hold a value.
+ *
+ * @param value The value.
+ *
+ * @return The position of the highest set bit plus one, or zero for zero.
+ */
+int get_key_bit_count(uint64_t value)
+{
+    int nBits = 0;
+
+    while (nBits < SORT_KEY_BITS && (value >> nBits) != 0)
+    {
+        nBits++;
+    }
+
+    return nBits;
+}
+
+/**
+ * @brief Sorts packed keys with a least significant digit first radix sort.
+ *
+ * Each pass counts the keys per digit of 'SORT_KEY_DIGIT_BITS' bits and moves them stably
+ * into the other buffer. Only the digits within 'nKeyBits' are sorted, and a pass whose
+ * digit is the same for every key is skipped.
+ *
+ * @param keys The keys to sort.
+ * @param spare A buffer of the same size, overwritten.
+ * @param nKeys Number of keys.
+ * @param nKeyBits Number of low bits of the keys that can be set.
+ *
+ * @return The buffer that holds the sorted keys, 'keys' or 'spare'.
+ */
+uint64_t *radix_sort_keys(uint64_t *keys, uint64_t *spare, long nKeys, int nKeyBits)
+{
+    for (int shift = 0; shift < nKeyBits; shift += SORT_KEY_DIGIT_BITS)
+    {
+        long counts[SORT_KEY_BUCKET_COUNT] = {0};
+
+        for (long n = 0; n < nKeys; n++)
+        {
+            counts[(keys[n] >> shift) & (SORT_KEY_BUCKET_COUNT - 1)]++;
+        }
+
+        // Every key has the same digit, the pass would not move any key
+        if (counts[(keys[0] >> shift) & (SORT_KEY_BUCKET_COUNT - 1)] == nKeys)
+        {
+            continue;
+        }
+
+        // Turn the counts into the first position of each digit
+        long nPosition = 0;
+        for (int digit = 0; digit < SORT_KEY_BUCKET_COUNT; digit++)
+        {
+            long nCount = counts[digit];
+            counts[digit] = nPosition;
+            nPosition += nCount;
+        }
+
+        for (long n = 0; n < nKeys; n++)
+        {
+            spare[counts[(keys[n] >> shift) & (SORT_KEY_BUCKET_COUNT - 1)]++] = keys[n];
+        }
+
+        uint64_t *swap = keys;
+        keys = spare;
+        spare = swap;
+    }
+
+    return keys;
+}
+
 /**
  * @brief Initializes a new linked list with a single record.
  *
- * This function sets the head of the linked list to point to the provided record
+ * This function sets the head and tail of the table to point to the provided record
  * and sets the record's next pointer to NULL, indicating it is the only node in the list.
  *
- * @param head Pointer to the head of the linked list.
+ * @param pTable The student table to initialize.
  * @param record The record to initialize the list with.
  *
  * @return SUCCESS if the list is successfully initialized.
  */
-ReturnStatus new_record_list(Record **head, Record *record)
+ReturnStatus new_record_list(StudentTable *pTable, Record *record)
 {
     record->next = NULL;
-    *head = record;
+    pTable->head = record;
+    pTable->tail = record;
+    pTable->nStudents = 1;
     return SUCCESS;
 }
 
@@ -163,59 +412,49 @@ ReturnStatus new_record_list(Record **head, Record *record)
  * @brief Appends a record to the end of the linked list.
  *
  * This function appends the provided record to the end of the existing list by
- * setting the next pointer of the last node to the new record.
+ * setting the next pointer of the last node to the new record. The search for the last
+ * node starts at the tail pointer, so it visits one record.
  *
- * @param last Pointer to the last record in the list.
+ * @param pTable The student table to append to.
  * @param record The record to append.
+ * @param pnSteps Pointer that receives the number of records visited to find the end.
  *
  * @return SUCCESS if the record is successfully appended.
  */
-ReturnStatus append_record_list(Record *last, Record *record)
+ReturnStatus append_record_list(StudentTable *pTable, Record *record, long *pnSteps)
 {
+    Record *last = pTable->tail;
+
+    *pnSteps = 1;
+    while (last->next != NULL)
+    {
+        last = last->next;
+        (*pnSteps)++;
+    }
+
     record->next = NULL;
     last->next = record;
+    pTable->tail = record;
+    pTable->nStudents++;
     return SUCCESS;
 }
 
 /**
  * @brief Counts the number of tokens in a CSV string.
  *
- * This function uses 'strtok' to tokenize the input string by commas and counts
- * the number of resulting tokens. It creates a copy of the input string to prevent
- * modification of the original string.
+ * This function counts the runs of characters between commas. Empty fields are skipped
+ * the same way the tokenizer skips them, so the count matches the number of tokens
+ * returned by 'get_next_token'. The commas are found by the structural scanner, a block at
+ * a time. The input string is not modified or copied.
  *
  * @param pString The input CSV string.
  * @param ntokens Pointer to an integer that will store the number of tokens.
  *
  * @return SUCCESS if the token count is successfully calculated.
- *         FAILURE if memory allocation fails for copying the string.
  */
 ReturnStatus get_token_count(const char *pString, int *ntokens)
 {
-    char *pTemp = NULL; // To create a copy of string as strtok will modify the string
-
-    // Allocate memory for a copy of input string becasue strtok will modify the string
-    if (allocate_string_memory(&pTemp, strlen(pString)) != SUCCESS)
-    {
-        return FAILURE;
-    }
-
-    // Copy the string into the allocated memory
-    strcpy(pTemp, pString);
-
-    // Tokenize the string by commas
-    char *token = strtok(pTemp, COMMA);
-
-    *ntokens = 0;
-
-    while (token != NULL)
-    {
-        (*ntokens)++;                // Increment the token counter
-        token = strtok(NULL, COMMA); // Get the next token
-    }
-
-    // Free the allocated memory
-    clear_string_memory(pTemp);
+    *ntokens = (int)count_fields(pString, (long)strlen(pString));
 
     return SUCCESS;
 }
@@ -223,39 +462,115 @@ ReturnStatus get_token_count(const char *pString, int *ntokens)
 /**
  * @brief Retrieves the next token in a CSV string.
  *
- * This function retrieves the next token from a CSV string using 'strtok'.
- * It uses a static pointer to remember the position in the string for subsequent calls.
+ * Pass a NULL token to start on a new string; the string is copied into the context's
+ * tokenizer buffer, padded with a zero filled block so the scanner can read whole blocks.
+ * Each following call returns the next token, and the buffer is released when there are
+ * no tokens left. The tokenizer state lives in the grading context, so several contexts
+ * can tokenize at the same time.
  *
+ * @param pContext The grading context that owns the tokenizer state.
  * @param string The input CSV string.
  * @param token Pointer to a string where the next token will be stored.
  *
  * @return SUCCESS if the next token is successfully retrieved.
  *         FAILURE if memory allocation fails for copying the string.
  */
-ReturnStatus get_next_token(const char *string, char **token)
+ReturnStatus get_next_token(GradingContext *pContext, const char *string, char **token)
 {
-    static char *temp = NULL;
+    Tokenizer *pTokenizer = &pContext->tokenizer;
+    PROFILE_START(pContext, tokenizeStart);
+
     if (*token == NULL)
     {
-        // Allocate memory for a copy of input string becasue strtok will modify the string
-        if (allocate_string_memory(&temp, strlen(string)) != SUCCESS)
+        // Release a buffer left by a string that was not fully tokenized
+        clear_string_memory(pContext, pTokenizer->buffer);
+
+        // Allocate memory for a copy of input string because tokenizing modifies the string
+        size_t nLength = strlen(string);
+        if (allocate_string_memory(pContext, &pTokenizer->buffer, (int)nLength + SCAN_BLOCK_SIZE) != SUCCESS)
         {
+            pTokenizer->buffer = NULL;
+            PROFILE_STOP(pContext, PHASE_TOKENIZE, tokenizeStart);
             return FAILURE;
         }
-        // Copy the string into the allocated memory
-        strcpy(temp, string);
-        // Tokenize the string by commas
-        *token = strtok(temp, COMMA);
-        return SUCCESS;
+        // Copy the string into the allocated memory and zero the padding after it
+        memcpy(pTokenizer->buffer, string, nLength);
+        memset(pTokenizer->buffer + nLength, 0, SCAN_BLOCK_SIZE + 1);
+        pTokenizer->cursor = pTokenizer->buffer;
+        pTokenizer->block = pTokenizer->buffer;
+        pTokenizer->fieldEndMask = get_field_end_mask(pTokenizer->block);
     }
-    *token = strtok(NULL, COMMA); // Get the next token
+
+    *token = split_next_token(pTokenizer); // Get the next token
 
     if (*token == NULL)
     {
         // Free the allocated memory
-        clear_string_memory(temp);
-        temp = NULL;
+        clear_string_memory(pContext, pTokenizer->buffer);
+        pTokenizer->buffer = NULL;
+        pTokenizer->cursor = NULL;
+        pTokenizer->block = NULL;
     }
 
+    PROFILE_STOP(pContext, PHASE_TOKENIZE, tokenizeStart);
     return SUCCESS;
 }
+
+/**
+ * @brief Splits the next comma separated token from the tokenizer buffer.
+ *
+ * Leading commas are skipped, and the comma that ends the token is replaced by a string
+ * terminator, which matches the behavior of 'strtok' without its hidden static state.
+ * The end of the token is the lowest bit of the field end mask at or after the token
+ * start, so the characters of a token are not tested one at a time; a new block is
+ * scanned only when the token runs past the current one.
+ *
+ * @param pTokenizer The tokenizer whose buffer is split.
+ *
+ * @return Pointer to the token inside the buffer, or NULL if there are no tokens left.
+ */
+char *split_next_token(Tokenizer *pTokenizer)
+{
+    char *pCursor = pTokenizer->cursor;
+
+    // Skip empty fields
+    while (*pCursor == COMMA_CHAR)
+    {
+        pCursor++;
+    }
+
+    if (*pCursor == STRING_TERMINATION)
+    {
+        pTokenizer->cursor = pCursor;
+        return NULL;
+    }
+
+    char *pToken = pCursor;
+
+    // Move to the block that holds the token start
+    while (pCursor - pTokenizer->block >= SCAN_BLOCK_SIZE)
+    {
+        pTokenizer->block += SCAN_BLOCK_SIZE;
+        pTokenizer->fieldEndMask = get_field_end_mask(pTokenizer->block);
+    }
+
+    // Find the end of the token in the field end masks
+    uint64_t mask = pTokenizer->fieldEndMask & (~0ULL << (pCursor - pTokenizer->block));
+    while (mask == 0)
+    {
+        pTokenizer->block += SCAN_BLOCK_SIZE;
+        pTokenizer->fieldEndMask = get_field_end_mask(pTokenizer->block);
+        mask = pTokenizer->fieldEndMask;
+    }
+    pCursor = pTokenizer->block + get_lowest_bit(mask);
+
+    // Terminate the token and continue after the comma
+    if (*pCursor == COMMA_CHAR)
+    {
+        *pCursor = STRING_TERMINATION;
+        pCursor++;
+    }
+    pTokenizer->cursor = pCursor;
+
+    return pToken;
+}
@@ -5,10 +5,11 @@
 #include "messages.h" 
 #include "types.h"
 
-ReturnStatus add_record_to_list(Record **, Record *);
-ReturnStatus sort_list_by_name(Record **);
+ReturnStatus add_record_to_list(GradingContext *, Record *);
+ReturnStatus sort_list_by_name(GradingContext *);
+ReturnStatus sort_list_by_key(GradingContext *, SortOrder);
 
 ReturnStatus get_token_count(const char *, int *);
-ReturnStatus get_next_token(const char *, char **);
+ReturnStatus get_next_token(GradingContext *, const char *, char **);
 
 #endif // HELPER_H
\ No newline at end of file
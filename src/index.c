@@ -0,0 +1,445 @@
+/**
+ * @file index.c
+ * @brief Persistent grade index for looking up students without reading the whole output.
+ *
+ * The index is written next to the letter grades after the table has been sorted by name.
+ * It is a flat file that other processes map into memory and search in place:
+ *
+ *     GradeIndexHeader                    magic, version, entry size, counts and offsets
+ *     GradeIndexEntry[nStudents]          fixed size entries in name order
+ *     name block                          null terminated names the entries point to
+ *
+ * Numbers are stored in the byte order of the machine that wrote the index. Because the
+ * entries have a fixed size and follow the order of 'sort_list_by_name', a student is
+ * found by binary search in O(log n) with only the touched pages read from disk, and the
+ * students with a name prefix or in a range of names are one contiguous run of entries
+ * that is read in place. The index is replaced atomically, so a process that has the old
+ * index mapped keeps a consistent view.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+#endif
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "index.h"
+
+// Define grade index opened for queries
+struct grade_index
+{
+    const char *pData;              // Contents of the index file
+    size_t nSize;                   // Bytes in 'pData'
+    const GradeIndexHeader *header; // Header at the start of 'pData'
+    const GradeIndexEntry *entries; // Entries in name order
+    const char *names;              // Name block
+    long nStudents;                 // Number of entries
+    Boolean isMapped;               // TRUE if 'pData' is mapped, FALSE if it was read into memory
+    const char *pFileName;          // Name of the index for error messages
+};
+
+// Function declaration
+ReturnStatus read_index_file(GradingContext *, GradeIndex *, const char *);
+ReturnStatus search_index(GradingContext *, const GradeIndex *, const char *, Boolean, long *);
+const char *get_index_name(const GradeIndex *, long);
+
+/**
+ * @brief Writes the grade index of the student table.
+ *
+ * The table must be sorted by name, as 'write_file_data' leaves it. The index is written
+ * to a temporary file and renamed over 'pFileName'.
+ *
+ * @param pContext The grading context that owns the sorted student table.
+ * @param pFileName Name of the index file.
+ *
+ * @return SUCCESS if the index is written.
+ *         FAILURE if the index file cannot be written.
+ */
+ReturnStatus write_grade_index(GradingContext *pContext, const char *pFileName)
+{
+    char temporaryName[FILE_NAME_SIZE];
+    GradeIndexHeader header = {0};
+    FILE *pFile = NULL;
+
+    // The name block holds every name with its terminator
+    uint64_t namesSize = 0;
+    for (const Record *current = pContext->table.head; current != NULL; current = current->next)
+    {
+        namesSize += strlen(current->name) + 1;
+    }
+
+    memcpy(header.magic, INDEX_MAGIC, INDEX_MAGIC_SIZE);
+    header.version = INDEX_VERSION;
+    header.entrySize = sizeof(GradeIndexEntry);
+    header.nStudents = pContext->table.nStudents;
+    header.namesOffset = sizeof(GradeIndexHeader) + header.nStudents * sizeof(GradeIndexEntry);
+    header.namesSize = namesSize;
+
+    if (open_temporary_file(pContext, &pFile, pFileName, temporaryName) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    Boolean isWritten = (fwrite(&header, sizeof(header), 1, pFile) == 1) ? TRUE : FALSE;
+
+    // Entries in table order, each pointing at its name in the block
+    uint64_t nameOffset = 0;
+    for (const Record *current = pContext->table.head; current != NULL && isWritten == TRUE; current = current->next)
+    {
+        GradeIndexEntry entry = {0};
+        entry.nameLength = (uint32_t)strlen(current->name);
+        entry.nameOffset = nameOffset;
+        entry.weightedScore = current->weightedScore;
+        entry.grade = current->grade;
+        nameOffset += entry.nameLength + 1;
+        isWritten = (fwrite(&entry, sizeof(entry), 1, pFile) == 1) ? TRUE : FALSE;
+    }
+
+    for (const Record *current = pContext->table.head; current != NULL && isWritten == TRUE; current = current->next)
+    {
+        isWritten = (fputs(current->name, pFile) >= 0 && fputc(STRING_TERMINATION, pFile) != EOF) ? TRUE : FALSE;
+    }
+
+    if (isWritten == FALSE)
+    {
+        fclose(pFile);
+        remove(temporaryName);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, pFileName);
+        return FAILURE;
+    }
+
+    return replace_file(pContext, &pFile, temporaryName, pFileName);
+}
+
+/**
+ * @brief Opens a grade index for queries.
+ *
+ * The file is mapped into memory, so opening costs the same for any size and only the
+ * pages a query touches are read. Only the header is checked here; every entry is checked
+ * when it is read.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param ppIndex Pointer that receives the index.
+ * @param pFileName Name of the index file.
+ *
+ * @return SUCCESS if the index is open.
+ *         FAILURE if the file cannot be read or is not a grade index.
+ */
+ReturnStatus open_grade_index(GradingContext *pContext, GradeIndex **ppIndex, const char *pFileName)
+{
+    GradeIndex *index = malloc(sizeof(GradeIndex));
+    if (index == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *index = (GradeIndex){0};
+    index->pFileName = pFileName;
+
+    if (read_index_file(pContext, index, pFileName) != SUCCESS)
+    {
+        close_grade_index(&index);
+        return FAILURE;
+    }
+
+    // The header must describe entries and a name block inside the file
+    const GradeIndexHeader *header = (const GradeIndexHeader *)index->pData;
+    if (index->nSize < sizeof(GradeIndexHeader) || memcmp(header->magic, INDEX_MAGIC, INDEX_MAGIC_SIZE) != 0 ||
+        header->version != INDEX_VERSION || header->entrySize != sizeof(GradeIndexEntry) ||
+        header->nStudents > (index->nSize - sizeof(GradeIndexHeader)) / sizeof(GradeIndexEntry) ||
+        header->namesOffset != sizeof(GradeIndexHeader) + header->nStudents * sizeof(GradeIndexEntry) ||
+        header->namesSize > index->nSize - header->namesOffset)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_INDEX_INVALID, pFileName);
+        close_grade_index(&index);
+        return FAILURE;
+    }
+
+    index->header = header;
+    index->entries = (const GradeIndexEntry *)(index->pData + sizeof(GradeIndexHeader));
+    index->names = index->pData + header->namesOffset;
+    index->nStudents = (long)header->nStudents;
+    *ppIndex = index;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Closes a grade index.
+ *
+ * Names returned by the index are no longer valid afterwards.
+ *
+ * @param ppIndex Pointer to the index, set to NULL.
+ *
+ * @return SUCCESS once the index is closed.
+ */
+ReturnStatus close_grade_index(GradeIndex **ppIndex)
+{
+    GradeIndex *index = *ppIndex;
+    if (index == NULL)
+    {
+        return SUCCESS;
+    }
+
+#ifndef _WIN32
+    if (index->isMapped == TRUE)
+    {
+        munmap((void *)index->pData, index->nSize);
+    }
+    else
+#endif
+    {
+        free((void *)index->pData);
+    }
+
+    free(index);
+    *ppIndex = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Gets the number of students in a grade index.
+ *
+ * @param index The grade index.
+ *
+ * @return The number of students.
+ */
+long get_index_student_count(const GradeIndex *index)
+{
+    return index->nStudents;
+}
+
+/**
+ * @brief Finds the first position whose name is not less than a key.
+ *
+ * The names compare the way 'sort_list_by_name' orders them. The position is the
+ * number of students if every name is less than the key.
+ *
+ * @param pContext The grading context that reports a damaged index.
+ * @param index The grade index.
+ * @param pKey The name to search for.
+ * @param pPosition Pointer that receives the position.
+ *
+ * @return SUCCESS if the position is found.
+ *         FAILURE if an entry on the search path is damaged.
+ */
+ReturnStatus find_index_position(GradingContext *pContext, const GradeIndex *index, const char *pKey,
+                                 long *pPosition)
+{
+    return search_index(pContext, index, pKey, FALSE, pPosition);
+}
+
+/**
+ * @brief Finds the positions of the students in a range of names.
+ *
+ * The range starts at the first name not less than 'pFrom' and ends after the last name
+ * that is less than 'pTo' or starts with it, so a range from "Kim" to "Lee" includes
+ * "Lee Smith" and a range from a prefix to itself holds exactly the names with that
+ * prefix. Only two binary searches are made; the students are read afterwards one by
+ * one with 'get_index_student', so nothing is copied.
+ *
+ * @param pContext The grading context that reports a damaged index.
+ * @param index The grade index.
+ * @param pFrom Lowest name of the range, or NULL to start at the first student.
+ * @param pTo Highest name or name prefix of the range, or NULL to end after the last student.
+ * @param pFirst Pointer that receives the position of the first student in the range.
+ * @param pEnd Pointer that receives the position after the last student in the range.
+ *
+ * @return SUCCESS if the range is found, it is empty if '*pFirst' is not less than '*pEnd'.
+ *         FAILURE if an entry on the search path is damaged.
+ */
+ReturnStatus find_index_range(GradingContext *pContext, const GradeIndex *index, const char *pFrom,
+                              const char *pTo, long *pFirst, long *pEnd)
+{
+    *pFirst = 0;
+    *pEnd = index->nStudents;
+
+    if (pFrom != NULL && search_index(pContext, index, pFrom, FALSE, pFirst) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    if (pTo != NULL && search_index(pContext, index, pTo, TRUE, pEnd) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Binary searches the names of a grade index.
+ *
+ * @param pContext The grading context that reports a damaged index.
+ * @param index The grade index.
+ * @param pKey The name or name prefix to search for.
+ * @param isPastPrefix FALSE for the first name not less than the key, TRUE for the first
+ *        name greater than the key that does not start with it.
+ * @param pPosition Pointer that receives the position.
+ *
+ * @return SUCCESS if the position is found.
+ *         FAILURE if an entry on the search path is damaged.
+ */
+ReturnStatus search_index(GradingContext *pContext, const GradeIndex *index, const char *pKey,
+                          Boolean isPastPrefix, long *pPosition)
+{
+    size_t nKeyLength = strlen(pKey);
+    long lower = 0;
+    long upper = index->nStudents;
+
+    while (lower < upper)
+    {
+        long middle = lower + (upper - lower) / 2;
+        const char *pName = get_index_name(index, middle);
+        if (pName == NULL)
+        {
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_INDEX_INVALID, index->pFileName);
+            return FAILURE;
+        }
+
+        Boolean isBefore = (isPastPrefix == TRUE) ? (strncmp(pName, pKey, nKeyLength) <= 0 ? TRUE : FALSE)
+                                                  : (strcmp(pName, pKey) < 0 ? TRUE : FALSE);
+        if (isBefore == TRUE)
+        {
+            lower = middle + 1;
+        }
+        else
+        {
+            upper = middle;
+        }
+    }
+
+    *pPosition = lower;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads the student at a position of a grade index.
+ *
+ * @param pContext The grading context that reports a damaged index.
+ * @param index The grade index.
+ * @param position Position of the student, from 0 to the number of students - 1.
+ * @param pStudent Pointer that receives the student.
+ *
+ * @return SUCCESS if the student is read.
+ *         FAILURE if the position is outside the index or the entry is damaged.
+ */
+ReturnStatus get_index_student(GradingContext *pContext, const GradeIndex *index, long position,
+                               IndexedStudent *pStudent)
+{
+    const char *pName = (position >= 0 && position < index->nStudents) ? get_index_name(index, position) : NULL;
+    if (pName == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_INDEX_INVALID, index->pFileName);
+        return FAILURE;
+    }
+
+    pStudent->name = pName;
+    pStudent->grade = index->entries[position].grade;
+    pStudent->weightedScore = index->entries[position].weightedScore;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Gets the name of an entry after checking that it lies inside the name block.
+ *
+ * @param index The grade index.
+ * @param position Position of the entry.
+ *
+ * @return The name, or NULL if the entry is damaged.
+ */
+const char *get_index_name(const GradeIndex *index, long position)
+{
+    const GradeIndexEntry *entry = &index->entries[position];
+
+    if (entry->nameOffset >= index->header->namesSize ||
+        entry->nameLength >= index->header->namesSize - entry->nameOffset ||
+        index->names[entry->nameOffset + entry->nameLength] != STRING_TERMINATION)
+    {
+        return NULL;
+    }
+
+    return index->names + entry->nameOffset;
+}
+
+/**
+ * @brief Maps an index file into memory, or reads it where mapping is not available.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param index The index that receives the contents.
+ * @param pFileName Name of the index file.
+ *
+ * @return SUCCESS if the contents are available, otherwise FAILURE.
+ */
+ReturnStatus read_index_file(GradingContext *pContext, GradeIndex *index, const char *pFileName)
+{
+#ifndef _WIN32
+    struct stat fileStatus;
+
+    int descriptor = open(pFileName, O_RDONLY);
+    if (descriptor < 0)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
+        return FAILURE;
+    }
+
+    if (fstat(descriptor, &fileStatus) != 0 || fileStatus.st_size < (off_t)sizeof(GradeIndexHeader))
+    {
+        close(descriptor);
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_INDEX_INVALID, pFileName);
+        return FAILURE;
+    }
+
+    void *pData = mmap(NULL, (size_t)fileStatus.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor); // The mapping stays valid without the descriptor
+    if (pData == MAP_FAILED)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
+        return FAILURE;
+    }
+
+    index->pData = pData;
+    index->nSize = (size_t)fileStatus.st_size;
+    index->isMapped = TRUE;
+#else
+    long nSize = 0;
+    char *pData = NULL;
+
+    if (get_file_size(pContext, pFileName, &nSize) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    pData = malloc(nSize > 0 ? nSize : 1);
+    FILE *pFile = fopen(pFileName, "rb");
+    if (pData == NULL || pFile == NULL || fread(pData, 1, nSize, pFile) != (size_t)nSize)
+    {
+        free(pData);
+        if (pFile != NULL)
+        {
+            fclose(pFile);
+        }
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_OPEN_READ, pFileName);
+        return FAILURE;
+    }
+    fclose(pFile);
+
+    index->pData = pData;
+    index->nSize = (size_t)nSize;
+    index->isMapped = FALSE;
+#endif
+
+    return SUCCESS;
+}
@@ -0,0 +1,17 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus write_grade_index(GradingContext *, const char *);
+
+ReturnStatus open_grade_index(GradingContext *, GradeIndex **, const char *);
+ReturnStatus close_grade_index(GradeIndex **);
+long get_index_student_count(const GradeIndex *);
+ReturnStatus find_index_position(GradingContext *, const GradeIndex *, const char *, long *);
+ReturnStatus find_index_range(GradingContext *, const GradeIndex *, const char *, const char *, long *, long *);
+ReturnStatus get_index_student(GradingContext *, const GradeIndex *, long, IndexedStudent *);
+
+#endif // INDEX_H
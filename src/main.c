@@ -7,41 +7,82 @@
  * and displays statistical insights such as average, minimum, and maximum scores.
  *
  * Features:
- * - Reads student data from a specified input file.
+ * - Reads student data from a specified input file or standard input.
  * - Parses and processes student records.
  * - Computes student grades based on provided scores.
- * - Writes processed student data to an output file.
+ * - Writes processed student data to an output file or standard output.
  * - Displays class statistics including average, minimum, and maximum scores.
+ * - Displays the letter grade distribution and a weighted score histogram.
+ * - Reports the class statistics as text, CSV or JSON.
  * - Implements dynamic memory management for handling student records.
  *
  * Usage:
- * - The program expects command-line arguments specifying the input and output file names.
- * - If incorrect arguments are provided, default file names are used.
+ * - The program expects command-line arguments specifying the input and output file names,
+ *   either as two plain arguments or with '--input' and '--output'. '-' selects standard
+ *   input or output so the program can sit in a shell pipeline.
+ * - '--batch <directory|manifest> <output directory>' grades many rosters in parallel.
+ * - '--quiet' and '--no-wait' remove all console output and the final Enter prompt.
+ * - '--timing' reports the time spent in each phase of the run on standard error.
+ * - '--trace <file>' writes a Chrome trace of the pipeline stages of every thread.
+ * - '--memory-report <file>' writes the peak memory and allocation sizes of the run as JSON.
+ * - '--daemon <socket>' keeps rosters in memory and answers requests on a Unix domain socket.
+ * - '--watch' grades the input again whenever it changes and replaces the output atomically.
+ * - '--index <file>' also writes a grade index; with '--lookup <name>', '--prefix <text>' or
+ *   '--from <name>' and '--to <name>' the index is queried instead.
+ * - If no file names are provided, default file names are used.
  * - The program follows a structured approach using modular functions.
  *
  * Return Codes:
- * - SUCCESS (0): The program executed successfully.
- * - FAILURE (-1): An error occurred during execution.
+ * - EXIT_CODE_SUCCESS (0): The program executed successfully.
+ * - Otherwise one exit code per class of failure, see 'constants.h'.
  */
 
 // Library includes
+#include <locale.h> // for setlocale
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h> // for strtol
+#include <string.h>
 
 // Code includes
+#include "batch.h"
 #include "constants.h"
+#include "context.h"
+#include "decompress.h"
+#include "daemon.h"
+#include "dedup.h"
 #include "file.h"
+#include "helper.h"
+#include "index.h"
 #include "memory.h"
 #include "messages.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "rank.h"
+#include "reject.h"
 #include "student.h"
+#include "trace.h"
 #include "types.h"
+#include "watch.h"
+#include "writer.h"
 
 // Function declaration
-ReturnStatus process_args(int, char **, char **, char **);
-ReturnStatus read_student_data(const char *);
-ReturnStatus process_student_data(FILE *);
-ReturnStatus write_student_data(const char *, const char *);
-ReturnStatus show_class_statistics(void);
-ReturnStatus clear_dynamic_memmory(void);
+ReturnStatus process_args(GradingContext *, int, char **, CommandLineOptions *);
+ReturnStatus parse_option_value(GradingContext *, const char *, const char *, CommandLineOptions *);
+ReturnStatus read_student_data(GradingContext *, const CommandLineOptions *);
+ReturnStatus write_student_data(GradingContext *, const CommandLineOptions *);
+ReturnStatus show_class_statistics(GradingContext *, const CommandLineOptions *);
+ReturnStatus rank_student_data(GradingContext *, const CommandLineOptions *);
+ReturnStatus sort_grade_index_order(GradingContext *);
+ReturnStatus clear_dynamic_memmory(GradingContext *);
+ReturnStatus run_batch_mode(const CommandLineOptions *, Tracer *, ErrorClass *);
+ReturnStatus run_watch_mode(GradingContext *, const CommandLineOptions *);
+ReturnStatus regrade_watched_file(GradingContext *, const CommandLineOptions *, FileWatch *);
+ReturnStatus run_index_query(GradingContext *, const CommandLineOptions *);
+ReturnStatus write_trace_file(GradingContext *, const CommandLineOptions *, const Tracer *);
+ReturnStatus write_memory_report_file(GradingContext *, const CommandLineOptions *);
+ReturnStatus show_progress(const CommandLineOptions *, const char *, ...);
+int get_exit_code(ErrorClass);
 
 /**
  * @brief Main function to execute the student data processing program.
@@ -52,287 +93,1445 @@ ReturnStatus clear_dynamic_memmory(void);
  *
  * @param argc The number of command-line arguments.
  * @param argv The array of command-line argument strings.
- * @return SUCCESS if the program executes successfully, otherwise FAILURE.
+ * @return EXIT_CODE_SUCCESS if the program executes successfully, otherwise the exit code
+ *         of the class of failure.
  */
 int main(int argc, char *argv[])
 {
     ReturnStatus status = SUCCESS;
-    char *pReadFileName = NULL;
-    char *pWriteFileName = NULL;
+    CommandLineOptions options;
+    GradingContext context; // State of this grading job
+    Tracer *tracer = NULL;  // Records the pipeline stages when a trace is requested
+
+    // Errors go to standard error so they never mix with results on standard output
+    init_grading_context(&context, NULL);
+    set_message_stream(&context, stderr);
+
+    // Process the command line arguments
+    if (process_args(&context, argc, argv, &options) != SUCCESS)
+    {
+        fprintf(stderr, "\n\n%s", MSG_USAGE);
+        return get_exit_code(context.errorClass);
+    }
+
+    if (options.isHelp == TRUE)
+    {
+        printf("%s", MSG_USAGE);
+        return EXIT_CODE_SUCCESS;
+    }
+
+    // Queries are answered from an index written by an earlier run
+    if (options.pLookupName != NULL || options.pQueryPrefix != NULL || options.pQueryFrom != NULL ||
+        options.pQueryTo != NULL)
+    {
+        setvbuf(stdout, NULL, _IOFBF, STREAM_WRITE_BUFFER_SIZE);
+        status = run_index_query(&context, &options);
+        if (status != SUCCESS)
+        {
+            fputc(END_OF_LINE_CHAR, stderr);
+        }
+        return (status == SUCCESS) ? EXIT_CODE_SUCCESS : get_exit_code(context.errorClass);
+    }
+
+    // Daemon mode serves requests until it is stopped and does not wait for the user
+    if (options.pDaemonSocketName != NULL)
+    {
+        ErrorClass errorClass = ERROR_CLASS_NONE;
+        FILE *pProgressStream = (options.isQuiet == TRUE) ? NULL : options.pReportStream;
+        status = run_daemon(options.pDaemonSocketName, options.nThreads, pProgressStream, &errorClass);
+        fputc(END_OF_LINE_CHAR, (status == SUCCESS && pProgressStream != NULL) ? pProgressStream : stderr);
+        return (status == SUCCESS) ? EXIT_CODE_SUCCESS : get_exit_code(errorClass);
+    }
+
+    // Time the run from here so the report covers everything after argument handling
+    if (options.isTiming == TRUE)
+    {
+        start_profiler(&context.profiler);
+    }
+
+    // Input files are read ahead of the parser as selected
+    context.readAheadMode = options.readAheadMode;
+
+    // The letter grades are written in the selected order, names compared as selected
+    context.sortOrder = options.sortOrder;
+    context.collation = options.collation;
+    if (options.collation == NAME_COLLATION_LOCALE && setlocale(LC_COLLATE, "") == NULL)
+    {
+        report_error(&context, ERROR_CLASS_USAGE, ERR_COLLATION_LOCALE);
+        fputc(END_OF_LINE_CHAR, stderr);
+        return get_exit_code(context.errorClass);
+    }
+
+    // Record the stages of every thread from here on
+    if (options.pTraceFileName != NULL)
+    {
+        if (create_tracer(&tracer) != SUCCESS)
+        {
+            return EXIT_CODE_MEMORY;
+        }
+        set_tracer(&context, tracer);
+    }
+
+    // Letter grades on standard output are written in large blocks instead of per line
+    if (options.pReportStream == stderr)
+    {
+        setvbuf(stdout, NULL, _IOFBF, STREAM_WRITE_BUFFER_SIZE);
+    }
 
     // Display the welcome message
-    printf(MSG_WELCOME);
+    show_progress(&options, MSG_WELCOME);
+
+    // Batch mode grades many rosters and does not wait for the user
+    if (options.pBatchSource != NULL)
+    {
+        ErrorClass errorClass = ERROR_CLASS_NONE;
+        status = run_batch_mode(&options, tracer, &errorClass);
+        if (tracer != NULL && write_trace_file(&context, &options, tracer) != SUCCESS && status == SUCCESS)
+        {
+            status = FAILURE;
+            errorClass = context.errorClass;
+        }
+        destroy_tracer(&tracer);
+        // End the last message before the shell prompt returns, failed sections are only
+        // reported in the summary
+        if (options.isQuiet == FALSE)
+        {
+            fputc(END_OF_LINE_CHAR, options.pReportStream);
+        }
+        else if (status != SUCCESS && errorClass != ERROR_CLASS_SECTION)
+        {
+            fputc(END_OF_LINE_CHAR, stderr);
+        }
+        return (status == SUCCESS) ? EXIT_CODE_SUCCESS : get_exit_code(errorClass);
+    }
+
+    if (options.isDefaultFileName == TRUE)
+    {
+        show_progress(&options, WARNING_INVALID_ARGUMENT_COUNT);
+        show_progress(&options, MSG_INVALID_ARGUMENT_COUNT);
+    }
+    else
+    {
+        show_progress(&options, MSG_VALID_ARGUMENT_COUNT);
+    }
 
     do
     {
-        // Process the command line arguments
-        if (process_args(argc, argv, &pReadFileName, &pWriteFileName) != SUCCESS)
+        // Watch mode grades the input again after every change until it is stopped
+        if (options.isWatch == TRUE)
+        {
+            if (run_watch_mode(&context, &options) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+        }
+        else
+        {
+            // Read and process student data from input file
+            if (read_student_data(&context, &options) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+
+            // Write processed student data to output file
+            if (write_student_data(&context, &options) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+
+            // Select the top and bottom students for the statistics and the ranking file
+            if (rank_student_data(&context, &options) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+
+            // Show class statistics
+            if (show_class_statistics(&context, &options) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+        }
+
+        // Clear dynamically allocated memeory
+        PROFILE_START(&context, freeStart);
+        ReturnStatus freeStatus = clear_dynamic_memmory(&context);
+        PROFILE_STOP(&context, PHASE_FREE, freeStart);
+        context.profiler.freedAllocations = context.allocator;
+        if (freeStatus != SUCCESS)
         {
             status = FAILURE;
             break;
         }
+    } while (FALSE); // This loop runs only once, allowing for an easy break if any step fails
 
-        // Read and process student data from input file
-        if (read_student_data(pReadFileName) != SUCCESS)
+    if (tracer != NULL)
+    {
+        if (write_trace_file(&context, &options, tracer) != SUCCESS && status == SUCCESS)
         {
             status = FAILURE;
-            break;
         }
+        destroy_tracer(&tracer);
+    }
 
-        // Write processed student data to output file
-        if (write_student_data(pReadFileName, pWriteFileName) != SUCCESS)
+    // The allocation report is written after the free step so it shows any leak
+    if (options.pMemoryReportFileName != NULL)
+    {
+        if (write_memory_report_file(&context, &options) != SUCCESS && status == SUCCESS)
         {
             status = FAILURE;
-            break;
         }
+    }
+
+    // The timing report goes to standard error so it never mixes with grades or statistics
+    if (options.isTiming == TRUE)
+    {
+        fflush(options.pReportStream);
+        write_profile_report(&context.profiler, stderr);
+        fputc(END_OF_LINE_CHAR, stderr);
+    }
+
+    if (options.isNoWait == FALSE)
+    {
+        // Wait for the user to press Enter before exiting the program
+        show_progress(&options, PROMPT_FOR_ENTER_TO_EXIT);
+        getchar(); // Ensures the user acknowledges the program before it terminates
+    }
+    else if (status != SUCCESS)
+    {
+        // End the error message before the shell prompt returns
+        fputc(END_OF_LINE_CHAR, stderr);
+    }
+    else if (options.isQuiet == FALSE || options.statsFormat == STATS_FORMAT_TEXT)
+    {
+        // End the last console line before the shell prompt returns
+        fputc(END_OF_LINE_CHAR, options.pReportStream);
+    }
+
+    return (status == SUCCESS) ? EXIT_CODE_SUCCESS : get_exit_code(context.errorClass);
+}
+
+/**
+ * @brief Processes command-line arguments into program options.
+ *
+ * Options start with '--' and may appear in any order. Plain arguments name the input
+ * and output files, or the output directory in batch mode, unless the matching option is
+ * given. Missing file names are replaced by the default file names. Progress messages and
+ * statistics go to standard output, or to standard error when the letter grades are
+ * written to standard output.
+ *
+ * @param pContext The grading context that reports invalid arguments.
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line argument strings.
+ * @param pOptions Pointer that receives the selected options.
+ * @return SUCCESS if arguments are processed successfully, otherwise FAILURE.
+ */
+ReturnStatus process_args(GradingContext *pContext, int argc, char **argv, CommandLineOptions *pOptions)
+{
+    const char *ppPlain[ARG_COUNT_REQUIRED - 1]; // Plain arguments in order
+    int nPlain = 0;
+
+    *pOptions = (CommandLineOptions){0};
+    pOptions->statsFormat = STATS_FORMAT_TEXT;
+    pOptions->outputFormat = OUTPUT_FORMAT_TEXT;
+    pOptions->readAheadMode = READ_AHEAD_AUTO;
+    pOptions->sortOrder = SORT_ORDER_NAME;
+    pOptions->collation = NAME_COLLATION_BYTE;
+    pOptions->duplicatePolicy = DUPLICATE_POLICY_NONE;
+
+    for (int n = ARG_INDEX_PROGRAM_NAME + 1; n < argc; n++)
+    {
+        const char *pArgument = argv[n];
+
+        // Plain argument, including '-' for a standard stream
+        if (strncmp(pArgument, OPTION_PREFIX, strlen(OPTION_PREFIX)) != 0)
+        {
+            if (nPlain == ARG_COUNT_REQUIRED - 1)
+            {
+                report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, pArgument);
+                return FAILURE;
+            }
+            ppPlain[nPlain++] = pArgument;
+            continue;
+        }
+
+        // Switches without a value
+        if (strcmp(pArgument, OPTION_QUIET) == 0)
+        {
+            pOptions->isQuiet = TRUE;
+            continue;
+        }
+        if (strcmp(pArgument, OPTION_NO_WAIT) == 0)
+        {
+            pOptions->isNoWait = TRUE;
+            continue;
+        }
+        if (strcmp(pArgument, OPTION_WATCH) == 0)
+        {
+            pOptions->isWatch = TRUE;
+            continue;
+        }
+#ifndef PROFILING_DISABLED
+        if (strcmp(pArgument, OPTION_TIMING) == 0)
+        {
+            pOptions->isTiming = TRUE;
+            continue;
+        }
+#endif
+        if (strcmp(pArgument, OPTION_HELP) == 0)
+        {
+            pOptions->isHelp = TRUE;
+            return SUCCESS;
+        }
+
+        // Options with a value
+        if (n + 1 >= argc)
+        {
+            // Validate the option name with an empty value to tell unknown from incomplete
+            if (parse_option_value(pContext, pArgument, NULL, pOptions) == SUCCESS)
+            {
+                report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_MISSING, pArgument);
+            }
+            return FAILURE;
+        }
+        if (parse_option_value(pContext, pArgument, argv[n + 1], pOptions) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        n++;
+    }
+
+    // Daemon mode loads its rosters on request
+    if (pOptions->pDaemonSocketName != NULL && pOptions->pBatchSource != NULL)
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_BATCH);
+        return FAILURE;
+    }
+
+    // A query reads the index only, and only one kind of query is answered
+    const char *pQuery = (pOptions->pLookupName != NULL)    ? OPTION_LOOKUP
+                         : (pOptions->pQueryPrefix != NULL) ? OPTION_NAME_PREFIX
+                         : (pOptions->pQueryFrom != NULL)   ? OPTION_FROM
+                         : (pOptions->pQueryTo != NULL)     ? OPTION_TO
+                                                            : NULL;
+    if (pQuery != NULL)
+    {
+        if (pOptions->pIndexFileName == NULL)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_INDEX_MISSING, pQuery);
+            return FAILURE;
+        }
+        const char *pUnexpected = (nPlain > 0)                            ? ppPlain[0]
+                                  : (pOptions->pReadFileName != NULL)     ? OPTION_INPUT
+                                  : (pOptions->pWriteFileName != NULL)    ? OPTION_OUTPUT
+                                  : (pOptions->pBatchSource != NULL)      ? OPTION_BATCH
+                                  : (pOptions->pDaemonSocketName != NULL) ? OPTION_DAEMON
+                                  : (pOptions->isWatch == TRUE)           ? OPTION_WATCH
+                                                                          : NULL;
+        // A lookup, a prefix and a range cannot be combined, a range may have both ends
+        if (pUnexpected == NULL && pOptions->pLookupName != NULL && pOptions->pQueryPrefix != NULL)
+        {
+            pUnexpected = OPTION_NAME_PREFIX;
+        }
+        if (pUnexpected == NULL && (pOptions->pLookupName != NULL || pOptions->pQueryPrefix != NULL) &&
+            (pOptions->pQueryFrom != NULL || pOptions->pQueryTo != NULL))
+        {
+            pUnexpected = (pOptions->pQueryFrom != NULL) ? OPTION_FROM : OPTION_TO;
+        }
+        if (pUnexpected != NULL)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, pUnexpected);
+            return FAILURE;
+        }
+        pOptions->pReportStream = stdout;
+        return SUCCESS;
+    }
+
+    // The grade index belongs to one output file
+    if (pOptions->pIndexFileName != NULL && (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_INDEX);
+        return FAILURE;
+    }
+
+    // Watch mode grades one input file
+    if (pOptions->isWatch == TRUE && (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_WATCH);
+        return FAILURE;
+    }
+
+    // Rejected rows are logged by the single-file reader only
+    if (pOptions->pRejectsFileName != NULL &&
+        (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL || pOptions->isWatch == TRUE))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_SKIP_INVALID);
+        return FAILURE;
+    }
+
+    // Duplicates are removed from the table of one roster as it is loaded
+    if (pOptions->duplicatePolicy != DUPLICATE_POLICY_NONE &&
+        (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL || pOptions->isWatch == TRUE))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_DUPLICATES);
+        return FAILURE;
+    }
+
+    // Batch sections and daemon rosters are written sorted by the bytes of the names
+    if ((pOptions->sortOrder != SORT_ORDER_NAME || pOptions->collation != NAME_COLLATION_BYTE) &&
+        (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED,
+                     (pOptions->sortOrder != SORT_ORDER_NAME) ? OPTION_SORT : OPTION_COLLATION);
+        return FAILURE;
+    }
+
+    // Students are ranked for one roster, and the ranking file holds the ranked lists
+    Boolean isRanked = (pOptions->topSize.nCount > 0 || pOptions->topSize.percent > 0 ||
+                        pOptions->bottomSize.nCount > 0 || pOptions->bottomSize.percent > 0) ? TRUE : FALSE;
+    if (isRanked == TRUE && (pOptions->pDaemonSocketName != NULL || pOptions->pBatchSource != NULL))
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED,
+                     (pOptions->topSize.nCount > 0 || pOptions->topSize.percent > 0) ? OPTION_TOP : OPTION_BOTTOM);
+        return FAILURE;
+    }
+    if (pOptions->pRankFileName != NULL && isRanked == FALSE)
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_RANK_SIZE_MISSING, OPTION_RANK_OUTPUT);
+        return FAILURE;
+    }
+
+    if (pOptions->pBatchSource != NULL)
+    {
+        // Batch mode takes the output directory as its only plain argument
+        int nNext = 0;
+        if (pOptions->pWriteFileName == NULL && nNext < nPlain)
+        {
+            pOptions->pWriteFileName = ppPlain[nNext++];
+        }
+        if (pOptions->pReadFileName != NULL)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_INPUT);
+            return FAILURE;
+        }
+        // Sections are written as text, the batch output is scanned for their headers
+        if (pOptions->outputFormat != OUTPUT_FORMAT_TEXT)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_OUTPUT_FORMAT);
+            return FAILURE;
+        }
+        // Sections are graded in contexts of their own, their allocations are not collected
+        if (pOptions->pMemoryReportFileName != NULL)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, OPTION_MEMORY_REPORT);
+            return FAILURE;
+        }
+        if (nNext < nPlain)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, ppPlain[nNext]);
+            return FAILURE;
+        }
+        if (pOptions->pWriteFileName == NULL)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_BATCH_OUTPUT_MISSING);
+            return FAILURE;
+        }
+        if (strcmp(pOptions->pBatchSource, STANDARD_STREAM_NAME) == 0 ||
+            strcmp(pOptions->pWriteFileName, STANDARD_STREAM_NAME) == 0)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_BATCH_STANDARD_STREAM);
+            return FAILURE;
+        }
+    }
+    else
+    {
+        // Plain arguments fill the file names not given as options, in order
+        int nNext = 0;
+        if (pOptions->pReadFileName == NULL && nNext < nPlain)
+        {
+            pOptions->pReadFileName = ppPlain[nNext++];
+        }
+        if (pOptions->pWriteFileName == NULL && nNext < nPlain)
+        {
+            pOptions->pWriteFileName = ppPlain[nNext++];
+        }
+        if (nNext < nPlain)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_ARGUMENT_UNEXPECTED, ppPlain[nNext]);
+            return FAILURE;
+        }
+
+        // Assign default file names if arguments are missing
+        if (pOptions->pReadFileName == NULL || pOptions->pWriteFileName == NULL)
+        {
+            pOptions->isDefaultFileName = TRUE;
+            pOptions->pReadFileName = (pOptions->pReadFileName != NULL) ? pOptions->pReadFileName : DEFAULT_INPUT_FILE_NAME;
+            pOptions->pWriteFileName = (pOptions->pWriteFileName != NULL) ? pOptions->pWriteFileName : DEFAULT_OUTPUT_FILE_NAME;
+        }
+
+        // A watched input is read again and its output replaced, which streams cannot do. The
+        // watch ends on a signal, so there is nobody to press Enter.
+        if (pOptions->isWatch == TRUE)
+        {
+            if (strcmp(pOptions->pReadFileName, STANDARD_STREAM_NAME) == 0 ||
+                strcmp(pOptions->pWriteFileName, STANDARD_STREAM_NAME) == 0)
+            {
+                report_error(pContext, ERROR_CLASS_USAGE, ERR_WATCH_STANDARD_STREAM);
+                return FAILURE;
+            }
+            pOptions->isNoWait = TRUE;
+        }
+    }
+
+    // Keep standard output for the letter grades when they are written there
+    Boolean isStandardOutput = (pOptions->pBatchSource == NULL &&
+                                strcmp(pOptions->pWriteFileName, STANDARD_STREAM_NAME) == 0) ? TRUE : FALSE;
+    pOptions->pReportStream = (isStandardOutput == TRUE) ? stderr : stdout;
+
+    // A quiet run prints statistics only when asked for
+    if (pOptions->isQuiet == TRUE && pOptions->isStatsFormatSet == FALSE)
+    {
+        pOptions->statsFormat = STATS_FORMAT_NONE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Stores the value of one command-line option.
+ *
+ * With a NULL value only the option name is checked.
+ *
+ * @param pContext The grading context that reports invalid values.
+ * @param pOption The option name.
+ * @param pValue The value that follows the option, or NULL.
+ * @param pOptions The options being built.
+ * @return SUCCESS if the option and value are valid, otherwise FAILURE.
+ */
+ReturnStatus parse_option_value(GradingContext *pContext, const char *pOption, const char *pValue,
+                                CommandLineOptions *pOptions)
+{
+    const char *const ppValueOptions[] = {OPTION_INPUT, OPTION_OUTPUT, OPTION_BATCH, OPTION_THREADS, OPTION_STATS_FORMAT,
+                                          OPTION_MEMORY_REPORT, OPTION_DAEMON, OPTION_INDEX, OPTION_LOOKUP,
+                                          OPTION_NAME_PREFIX, OPTION_FROM, OPTION_TO, OPTION_OUTPUT_FORMAT,
+                                          OPTION_SKIP_INVALID, OPTION_READ_AHEAD, OPTION_TOP, OPTION_BOTTOM,
+                                          OPTION_RANK_OUTPUT, OPTION_SORT, OPTION_COLLATION, OPTION_DUPLICATES,
+#ifndef PROFILING_DISABLED
+                                          OPTION_TRACE
+#endif
+    };
+    int nValueOptions = sizeof(ppValueOptions) / sizeof(ppValueOptions[0]);
+
+    if (pValue == NULL)
+    {
+        for (int n = 0; n < nValueOptions; n++)
+        {
+            if (strcmp(pOption, ppValueOptions[n]) == 0)
+            {
+                return SUCCESS;
+            }
+        }
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_UNKNOWN, pOption);
+        return FAILURE;
+    }
+
+    if (strcmp(pOption, OPTION_INPUT) == 0)
+    {
+        pOptions->pReadFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_OUTPUT) == 0)
+    {
+        pOptions->pWriteFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_BATCH) == 0)
+    {
+        pOptions->pBatchSource = pValue;
+    }
+    else if (strcmp(pOption, OPTION_MEMORY_REPORT) == 0)
+    {
+        pOptions->pMemoryReportFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_DAEMON) == 0)
+    {
+        pOptions->pDaemonSocketName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_SKIP_INVALID) == 0)
+    {
+        pOptions->pRejectsFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_RANK_OUTPUT) == 0)
+    {
+        pOptions->pRankFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_TOP) == 0 || strcmp(pOption, OPTION_BOTTOM) == 0)
+    {
+        RankSize *pSize = (strcmp(pOption, OPTION_TOP) == 0) ? &pOptions->topSize : &pOptions->bottomSize;
+        if (parse_rank_size(pValue, pSize) != SUCCESS)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+    }
+    else if (strcmp(pOption, OPTION_INDEX) == 0)
+    {
+        pOptions->pIndexFileName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_LOOKUP) == 0)
+    {
+        pOptions->pLookupName = pValue;
+    }
+    else if (strcmp(pOption, OPTION_NAME_PREFIX) == 0)
+    {
+        pOptions->pQueryPrefix = pValue;
+    }
+    else if (strcmp(pOption, OPTION_FROM) == 0)
+    {
+        pOptions->pQueryFrom = pValue;
+    }
+    else if (strcmp(pOption, OPTION_TO) == 0)
+    {
+        pOptions->pQueryTo = pValue;
+    }
+#ifndef PROFILING_DISABLED
+    else if (strcmp(pOption, OPTION_TRACE) == 0)
+    {
+        pOptions->pTraceFileName = pValue;
+    }
+#endif
+    else if (strcmp(pOption, OPTION_THREADS) == 0)
+    {
+        char *pEnd = NULL;
+        long nThreads = strtol(pValue, &pEnd, 10);
+        if (pEnd == pValue || *pEnd != STRING_TERMINATION || nThreads < 0 || nThreads > MAXIMUM_THREAD_COUNT)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->nThreads = (int)nThreads;
+    }
+    else if (strcmp(pOption, OPTION_STATS_FORMAT) == 0)
+    {
+        const char *const ppNames[] = {STATS_FORMAT_NAME_TEXT, STATS_FORMAT_NAME_CSV, STATS_FORMAT_NAME_JSON,
+                                       STATS_FORMAT_NAME_NONE};
+        const StatsFormat formats[] = {STATS_FORMAT_TEXT, STATS_FORMAT_CSV, STATS_FORMAT_JSON, STATS_FORMAT_NONE};
+        int nFormats = sizeof(formats) / sizeof(formats[0]);
+        int n = 0;
+
+        while (n < nFormats && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nFormats)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->statsFormat = formats[n];
+        pOptions->isStatsFormatSet = TRUE;
+    }
+    else if (strcmp(pOption, OPTION_OUTPUT_FORMAT) == 0)
+    {
+        const char *const ppNames[] = {OUTPUT_FORMAT_NAME_TEXT, OUTPUT_FORMAT_NAME_CSV, OUTPUT_FORMAT_NAME_JSONL,
+                                       OUTPUT_FORMAT_NAME_BINARY};
+        const OutputFormat formats[] = {OUTPUT_FORMAT_TEXT, OUTPUT_FORMAT_CSV, OUTPUT_FORMAT_JSONL, OUTPUT_FORMAT_BINARY};
+        int nFormats = sizeof(formats) / sizeof(formats[0]);
+        int n = 0;
+
+        while (n < nFormats && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nFormats)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->outputFormat = formats[n];
+    }
+    else if (strcmp(pOption, OPTION_READ_AHEAD) == 0)
+    {
+        const char *const ppNames[] = {READ_AHEAD_NAME_AUTO, READ_AHEAD_NAME_THREAD, READ_AHEAD_NAME_OFF};
+        const ReadAheadMode modes[] = {READ_AHEAD_AUTO, READ_AHEAD_THREAD, READ_AHEAD_OFF};
+        int nModes = sizeof(modes) / sizeof(modes[0]);
+        int n = 0;
+
+        while (n < nModes && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nModes)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->readAheadMode = modes[n];
+    }
+    else if (strcmp(pOption, OPTION_SORT) == 0)
+    {
+        const char *const ppNames[] = {SORT_ORDER_NAME_NAME, SORT_ORDER_NAME_SCORE, SORT_ORDER_NAME_GRADE};
+        const SortOrder orders[] = {SORT_ORDER_NAME, SORT_ORDER_SCORE, SORT_ORDER_GRADE};
+        int nOrders = sizeof(orders) / sizeof(orders[0]);
+        int n = 0;
 
-        // Show class statistics
-        if (show_class_statistics() != SUCCESS)
+        while (n < nOrders && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nOrders)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->sortOrder = orders[n];
+    }
+    else if (strcmp(pOption, OPTION_COLLATION) == 0)
+    {
+        const char *const ppNames[] = {COLLATION_NAME_BYTE, COLLATION_NAME_FOLD, COLLATION_NAME_LOCALE};
+        const NameCollation collations[] = {NAME_COLLATION_BYTE, NAME_COLLATION_FOLD, NAME_COLLATION_LOCALE};
+        int nCollations = sizeof(collations) / sizeof(collations[0]);
+        int n = 0;
+
+        while (n < nCollations && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nCollations)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->collation = collations[n];
+    }
+    else if (strcmp(pOption, OPTION_DUPLICATES) == 0)
+    {
+        const char *const ppNames[] = {DUPLICATE_POLICY_NAME_FIRST, DUPLICATE_POLICY_NAME_LAST,
+                                       DUPLICATE_POLICY_NAME_ERROR, DUPLICATE_POLICY_NAME_MERGE};
+        const DuplicatePolicy policies[] = {DUPLICATE_POLICY_FIRST, DUPLICATE_POLICY_LAST, DUPLICATE_POLICY_ERROR,
+                                            DUPLICATE_POLICY_MERGE};
+        int nPolicies = sizeof(policies) / sizeof(policies[0]);
+        int n = 0;
+
+        while (n < nPolicies && strcmp(pValue, ppNames[n]) != 0)
+        {
+            n++;
+        }
+        if (n == nPolicies)
+        {
+            report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_VALUE_INVALID, pValue, pOption);
+            return FAILURE;
+        }
+        pOptions->duplicatePolicy = policies[n];
+    }
+    else
+    {
+        report_error(pContext, ERROR_CLASS_USAGE, ERR_OPTION_UNKNOWN, pOption);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads student data from a specified file and processes it.
+ *
+ * Opens the file in read mode, extracts student records, processes them, and calculates grades.
+ * Closes the file after processing. Standard input is streamed the same way as a file, so
+ * the input may come from a pipe.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param pOptions The command-line options naming the input.
+ * @return SUCCESS if data is read and processed successfully, otherwise FAILURE.
+ */
+ReturnStatus read_student_data(GradingContext *pContext, const CommandLineOptions *pOptions)
+{
+    Boolean isStandardInput = (strcmp(pOptions->pReadFileName, STANDARD_STREAM_NAME) == 0) ? TRUE : FALSE;
+    const char *pReadFileName = (isStandardInput == TRUE) ? STANDARD_INPUT_NAME : pOptions->pReadFileName;
+    FILE *pFile = NULL;
+
+    // Invalid rows go to the rejects file instead of failing the run
+    if (pOptions->pRejectsFileName != NULL)
+    {
+        if (open_reject_log(pContext, &pContext->pRejectLog, pOptions->pRejectsFileName) != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+
+    // Open the input file for reading
+    ReturnStatus status = SUCCESS;
+    if (isStandardInput == TRUE)
+    {
+        pFile = stdin;
+    }
+    else if (open_file_in_read_mode(pContext, &pFile, pReadFileName) != SUCCESS)
+    {
+        status = FAILURE;
+    }
+
+    if (status == SUCCESS)
+    {
+        // A large roster file is parsed in byte ranges on several workers, unless it is compressed
+        long nBytes = -1;
+        get_stream_size(pFile, &nBytes);
+        int nRanges = (isStandardInput == FALSE && get_file_compression(pReadFileName) == COMPRESSION_NONE)
+                          ? get_parse_range_count(nBytes, pOptions->nThreads)
+                          : 1;
+
+        // Process student data, the readers record their own load events
+        TRACE_START(pContext, parseStart);
+        if (nRanges > 1)
+        {
+            close_file(pContext, &pFile);
+            status = process_student_file(pContext, pReadFileName, nBytes, nRanges);
+        }
+        else
+        {
+            status = process_student_data(pContext, pFile, pReadFileName);
+        }
+        TRACE_STOP(pContext, TRACE_STAGE_PARSE, pReadFileName, TRACE_WHOLE_FILE, parseStart);
+
+        // Close the file after processing, standard input stays open
+        if (isStandardInput == FALSE && pFile != NULL)
+        {
+            close_file(pContext, &pFile);
+        }
+    }
+
+    if (pContext->pRejectLog != NULL)
+    {
+        long nRejected = pContext->pRejectLog->nRejected;
+        if (status == SUCCESS && nRejected > 0)
+        {
+            report_rejected_rows(pContext, pContext->pRejectLog);
+
+            // No progress message follows to end the warning in a quiet run
+            if (pOptions->isQuiet == TRUE)
+            {
+                fputc(END_OF_LINE_CHAR, stderr);
+            }
+        }
+        if (close_reject_log(pContext, &pContext->pRejectLog) != SUCCESS)
         {
-            status = FAILURE;
-            break;
+            return FAILURE;
         }
 
-        // Clear dynamically allocated memeory
-        if (clear_dynamic_memmory() != SUCCESS)
+        // Grading nothing would only fail later with a less helpful message
+        if (status == SUCCESS && nRejected > 0 && pContext->table.nStudents == 0)
         {
-            status = FAILURE;
-            break;
+            report_error(pContext, ERROR_CLASS_DATA, ERR_ROWS_ALL_REJECTED, pReadFileName, pOptions->pRejectsFileName);
+            return FAILURE;
         }
-    } while (FALSE); // This loop runs only once, allowing for an easy break if any step fails
+    }
+
+    if (status != SUCCESS)
+    {
+        return FAILURE;
+    }
 
-    // Wait for the user to press Enter before exiting the program
-    printf(PROMPT_FOR_ENTER_TO_EXIT);
-    getchar(); // Ensures the user acknowledges the program before it terminates
+    show_progress(pOptions, MSG_STUDENT_DATA_READ_DONE, pReadFileName);
+    pContext->profiler.nRows = pContext->table.nStudents;
+    pContext->profiler.parsedAllocations = pContext->allocator;
 
-    return status;
+    // Students listed more than once are dropped or merged before they are graded
+    int nRows = pContext->table.nStudents;
+    if (remove_duplicate_students(pContext, pOptions->duplicatePolicy) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    if (pContext->table.nStudents < nRows && pOptions->isQuiet == TRUE)
+    {
+        // No progress message follows to end the warning in a quiet run
+        fputc(END_OF_LINE_CHAR, stderr);
+    }
+
+    // Calculate grades after processing student data
+    PROFILE_START(pContext, gradeStart);
+    TRACE_START(pContext, traceStart);
+    status = calculate_student_grade(pContext);
+    TRACE_STOP(pContext, TRACE_STAGE_GRADE, pReadFileName, TRACE_WHOLE_FILE, traceStart);
+    PROFILE_STOP(pContext, PHASE_GRADE, gradeStart);
+    if (status != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    show_progress(pOptions, MSG_STUDENT_GRADING_DONE);
+
+    return SUCCESS;
 }
 
 /**
- * @brief Processes command-line arguments to extract input and output file names.
+ * @brief Writes processed student data to an output file.
  *
- * If the correct number of arguments is provided, it assigns the file names from the arguments.
- * Otherwise, it assigns default file names and displays a warning message.
+ * Opens the specified file in write mode, writes a header, and saves the student data.
+ * Closes the file after writing. Standard output is flushed instead of closed. The grade
+ * index is written afterwards when one is requested.
  *
- * @param argc The number of command-line arguments.
- * @param argv The array of command-line argument strings.
- * @param pReadFileName Pointer to store the extracted or default input file name.
- * @param pWriteFileName Pointer to store the extracted or default output file name.
- * @return SUCCESS if arguments are processed successfully, otherwise FAILURE.
+ * @param pContext The grading context that owns the student records.
+ * @param pOptions The command-line options naming the input and output.
+ * @return SUCCESS if data is written successfully, otherwise FAILURE.
  */
-ReturnStatus process_args(int argc, char **argv, char **pReadFileName, char **pWriteFileName)
+ReturnStatus write_student_data(GradingContext *pContext, const CommandLineOptions *pOptions)
 {
-    // Check if the argument count matches the expected value
-    if (argc != ARG_COUNT_REQUIRED)
+    FILE *pFile = NULL;
+    Boolean isStandardOutput = (strcmp(pOptions->pWriteFileName, STANDARD_STREAM_NAME) == 0) ? TRUE : FALSE;
+    const char *pReadFileName = (strcmp(pOptions->pReadFileName, STANDARD_STREAM_NAME) == 0) ? STANDARD_INPUT_NAME
+                                                                                            : pOptions->pReadFileName;
+    const char *pWriteFileName = (isStandardOutput == TRUE) ? STANDARD_OUTPUT_NAME : pOptions->pWriteFileName;
+
+    // Open the output file for writing
+    if (isStandardOutput == TRUE)
     {
-        printf(WARNING_INVALID_ARGUMENT_COUNT);
-        printf(MSG_INVALID_ARGUMENT_COUNT);
-        // Assign default file names if arguments are incorrect
-        *pReadFileName = DEFAULT_INPUT_FILE_NAME;
-        *pWriteFileName = DEFAULT_OUTPUT_FILE_NAME;
+        pFile = stdout;
     }
-    else
+    else if (open_file_in_write_mode(pContext, &pFile, pWriteFileName) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    // Write a header with file metadata and the student data
+    ReturnStatus status = SUCCESS;
+    TRACE_START(pContext, traceStart);
+    if (write_student_output(pContext, pFile, pReadFileName, pOptions->outputFormat) != SUCCESS)
+    {
+        status = FAILURE;
+    }
+
+    // Close the output file, or push the letter grades down the pipe
+    PROFILE_START(pContext, writeStart);
+    if (isStandardOutput == TRUE)
+    {
+        if (fflush(pFile) != 0 || ferror(pFile))
+        {
+            report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, pWriteFileName);
+            status = FAILURE;
+        }
+    }
+    else if (close_file(pContext, &pFile) != SUCCESS)
+    {
+        status = FAILURE;
+    }
+    PROFILE_STOP(pContext, PHASE_WRITE, writeStart);
+    TRACE_STOP(pContext, TRACE_STAGE_WRITE, pReadFileName, TRACE_WHOLE_FILE, traceStart);
+
+    if (status != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    show_progress(pOptions, MSG_STUDENT_GRADE_WRITE_DONE, pWriteFileName);
+
+    // The grade index is built from the table the letter grades left sorted
+    if (pOptions->pIndexFileName != NULL)
     {
-        // Assign file names from command-line arguments
-        printf(MSG_VALID_ARGUMENT_COUNT);
-        *pReadFileName = argv[ARG_INDEX_INPUT_FILE];
-        *pWriteFileName = argv[ARG_INDEX_OUTPUT_FILE];
+        if (sort_grade_index_order(pContext) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        if (write_grade_index(pContext, pOptions->pIndexFileName) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        show_progress(pOptions, MSG_INDEX_WRITE_DONE, pContext->table.nStudents, pOptions->pIndexFileName);
     }
-    // UI message with selected file names
-    // printf(MSG_READ_FROM_INPUT_FILE, *pReadFileName);
-    // printf(MSG_WRITE_TO_OUTPUT_FILE, *pWriteFileName);
+
     return SUCCESS;
 }
 
 /**
- * @brief Reads student data from a specified file and processes it.
+ * @brief Displays class statistics including averages, extremes and the grade distribution.
  *
- * Opens the file in read mode, extracts student records, processes them, and calculates grades.
- * Closes the file after processing.
+ * Computes and presents statistical insights from the processed student data in the format
+ * selected on the command line.
  *
- * @param pReadFileName The name of the file containing student data.
- * @return SUCCESS if data is read and processed successfully, otherwise FAILURE.
+ * @param pContext The grading context that owns the student records.
+ * @param pOptions The command-line options selecting the format and stream.
+ *
+ * @return SUCCESS if statistics are displayed correctly, otherwise FAILURE.
  */
-ReturnStatus read_student_data(const char *pReadFileName)
+ReturnStatus show_class_statistics(GradingContext *pContext, const CommandLineOptions *pOptions)
 {
-    FILE *pFile = NULL;
+    FILE *pStream = pOptions->pReportStream;
 
-    // Open the input file for reading
-    if (open_file_in_read_mode(&pFile, pReadFileName) != SUCCESS)
+    switch (pOptions->statsFormat)
+    {
+    case STATS_FORMAT_NONE:
+        return SUCCESS;
+    case STATS_FORMAT_CSV:
+        show_progress(pOptions, "\n\n"); // Start the table on its own line
+        return write_statistics_csv(pContext, pStream);
+    case STATS_FORMAT_JSON:
+        show_progress(pOptions, "\n\n");
+        return write_statistics_json(pContext, pStream);
+    default:
+        break;
+    }
+
+    // Display the class statistics header
+    if (show_header(pContext, pStream) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    // Show average score
+    if (show_average(pContext, pStream) != SUCCESS)
     {
         return FAILURE;
     }
 
-    printf(MSG_STUDENT_DATA_READ_DONE, pReadFileName);
+    // Show minimum score
+    if (show_minimum(pContext, pStream) != SUCCESS)
+    {
+        return FAILURE;
+    }
 
-    // Process student data
-    if (process_student_data(pFile) != SUCCESS)
+    // Show maximum score
+    if (show_maximum(pContext, pStream) != SUCCESS)
     {
-        close_file(&pFile);
         return FAILURE;
     }
 
-    // Calculate grades after processing student data
-    if (calculate_student_grade() != SUCCESS)
+    // Show letter grade distribution
+    if (show_grade_distribution(pContext, pStream) != SUCCESS)
     {
-        close_file(&pFile);
         return FAILURE;
     }
 
-    printf(MSG_STUDENT_GRADING_DONE);
+    // Show weighted score histogram
+    if (show_score_histogram(pContext, pStream) != SUCCESS)
+    {
+        return FAILURE;
+    }
 
-    // Close the file after processing
-    close_file(&pFile);
+    // Show the top and bottom students when they were ranked
+    if (show_student_ranking(pContext, pStream) != SUCCESS)
+    {
+        return FAILURE;
+    }
 
     return SUCCESS;
-}
+};
 
 /**
- * @brief Processes student data from an open file.
+ * @brief Selects the top and bottom students and writes them to the ranking file.
  *
- * Reads each line of the file, extracts student information, and stores it in a linked list.
- * Performs memory allocation for data storage.
+ * Nothing is done unless '--top' or '--bottom' is given. The lists are kept in the
+ * context for the class statistics.
  *
- * @param pFile Pointer to an open file in read mode.
- * @return SUCCESS if the student data is processed correctly, otherwise FAILURE.
+ * @param pContext The grading context that owns the graded student table.
+ * @param pOptions The command-line options selecting the lists and the ranking file.
+ * @return SUCCESS if the students are ranked and the file is written, otherwise FAILURE.
  */
-ReturnStatus process_student_data(FILE *pFile)
+ReturnStatus rank_student_data(GradingContext *pContext, const CommandLineOptions *pOptions)
 {
-    Boolean IsLine = FALSE;  // To track if a line of student data is available. Set to FALSE initially
-    int DataSize = 0;        // Size of data to be allocated
-    char *DataString = NULL; // Pointer to store the data string
+    int nStudents = pContext->table.nStudents;
+    int nTop = get_rank_count(&pOptions->topSize, nStudents);
+    int nBottom = get_rank_count(&pOptions->bottomSize, nStudents);
+
+    if (nTop == 0 && nBottom == 0)
+    {
+        return SUCCESS;
+    }
 
-    // Check if a line is available to read and set pIsData and pDataSize
-    if (is_line_available_for_read(pFile, &IsLine, &DataSize) != SUCCESS)
+    if (rank_students(pContext, nTop, nBottom) != SUCCESS)
     {
         return FAILURE;
     }
 
-    // Process while there is data to read
-    while (IsLine == TRUE)
+    if (pOptions->pRankFileName != NULL)
     {
-        // Allocate memory for the string based on pDataSize
-        if (allocate_string_memory(&DataString, DataSize) != SUCCESS)
+        if (write_ranking_file(pContext, pOptions->pRankFileName) != SUCCESS)
         {
             return FAILURE;
         }
+        show_progress(pOptions, MSG_RANK_WRITE_DONE, pContext->ranking.nTop, pContext->ranking.nBottom,
+                      pOptions->pRankFileName);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Sorts the student table by the bytes of the names for the grade index.
+ *
+ * The index is searched with 'strcmp', so it needs the order of 'sort_list_by_name'. The
+ * table is sorted again only when the letter grades were written in another order.
+ *
+ * @param pContext The grading context that owns the student table.
+ * @return SUCCESS if the table is in the order of the index, otherwise FAILURE.
+ */
+ReturnStatus sort_grade_index_order(GradingContext *pContext)
+{
+    if (pContext->sortOrder == SORT_ORDER_NAME && pContext->collation == NAME_COLLATION_BYTE)
+    {
+        return SUCCESS;
+    }
+
+    return sort_list_by_name(pContext);
+}
+
+/**
+ * @brief Frees dynamically allocated memory used for student data storage.
+ *
+ * Clears all allocated memory to prevent memory leaks.
+ *
+ * @param pContext The grading context whose memory is released.
+ *
+ * @return SUCCESS if memory is cleared successfully, otherwise FAILURE.
+ */
+ReturnStatus clear_dynamic_memmory(GradingContext *pContext)
+{
+    // Delete student records and context buffers from memory
+    if (clear_grading_context(pContext) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    return SUCCESS;
+};
+
+/**
+ * @brief Grades a directory or manifest of rosters in parallel.
+ *
+ * Without '--threads' one worker per processor is used.
+ *
+ * @param pOptions The command-line options naming the source and output directory.
+ * @param pTracer Trace event recorder for the workers, or NULL to record nothing.
+ * @param pErrorClass Pointer that receives the class of the failure.
+ * @return SUCCESS if every roster is graded, otherwise FAILURE.
+ */
+ReturnStatus run_batch_mode(const CommandLineOptions *pOptions, Tracer *pTracer, ErrorClass *pErrorClass)
+{
+    FILE *pProgressStream = (pOptions->isQuiet == TRUE) ? NULL : pOptions->pReportStream;
+
+    return run_batch(pOptions->pBatchSource, pOptions->pWriteFileName, pOptions->nThreads, pProgressStream, pTracer,
+                     pErrorClass);
+}
+
+/**
+ * @brief Grades the input file, then grades it again after every change until a stop signal.
+ *
+ * A pass that fails, for example on a line saved half way, is reported and leaves the
+ * last output in place; the next change is graded again. Only running out of memory
+ * ends the watch.
+ *
+ * @param pContext The grading context that keeps the students between passes.
+ * @param pOptions The command-line options naming the input and output.
+ * @return SUCCESS if the watch stopped on a signal, otherwise FAILURE.
+ */
+ReturnStatus run_watch_mode(GradingContext *pContext, const CommandLineOptions *pOptions)
+{
+    FileWatch *watch = NULL;
+    ReturnStatus status = SUCCESS;
+    Boolean isStopped = FALSE;
+    int nPasses = 0;
+
+    if (open_file_watch(pContext, &watch, pOptions->pReadFileName) != SUCCESS)
+    {
+        return FAILURE;
+    }
 
-        // Read the next line from the file into pDataString
-        if (read_one_line_from_file(pFile, &DataString, DataSize) != SUCCESS)
+    show_progress(pOptions, MSG_WATCH_START, pOptions->pReadFileName);
+
+    while (isStopped == FALSE)
+    {
+        pContext->errorClass = ERROR_CLASS_NONE;
+        nPasses++;
+        if (regrade_watched_file(pContext, pOptions, watch) != SUCCESS)
         {
-            return FAILURE;
+            if (pContext->errorClass == ERROR_CLASS_MEMORY)
+            {
+                status = FAILURE;
+                break;
+            }
+            // End the error message, the watch goes on
+            if (pContext->pMessageStream != NULL)
+            {
+                fputc(END_OF_LINE_CHAR, pContext->pMessageStream);
+            }
         }
 
-        // Optionally process the data here (e.g., storing student data)
-        if (create_student(DataString) != SUCCESS)
+        // Show the pass before waiting for the next change
+        fflush(pOptions->pReportStream);
+        if (wait_for_file_change(pContext, watch, &isStopped) != SUCCESS)
         {
-            return FAILURE;
+            status = FAILURE;
+            break;
         }
+    }
 
-        // Clear the allocated memory after use
-        clear_string_memory(DataString);
+    close_file_watch(pContext, &watch);
 
-        // Check if another line is available
-        if (is_line_available_for_read(pFile, &IsLine, &DataSize) != SUCCESS)
-        {
-            return FAILURE;
-        }
+    if (status == SUCCESS)
+    {
+        show_progress(pOptions, MSG_WATCH_STOP, nPasses);
     }
 
-    return SUCCESS;
+    return status;
 }
 
 /**
- * @brief Writes processed student data to an output file.
+ * @brief Reloads the watched input and replaces the output if the students changed.
  *
- * Opens the specified file in write mode, writes a header, and saves the student data.
- * Closes the file after writing.
+ * Only new and edited lines are parsed and graded. The output is written to a temporary
+ * file and renamed over the old output, so readers never see a partly written file. When
+ * a step after the reload fails, the next reload counts as a change even if the file is
+ * saved again unchanged, so the output is written then.
  *
- * @param pReadFileName The original input file name (for reference in output).
- * @param pWriteFileName The name of the file where processed student data is stored.
- * @return SUCCESS if data is written successfully, otherwise FAILURE.
+ * @param pContext The grading context that keeps the students between passes.
+ * @param pOptions The command-line options naming the input and output.
+ * @param watch The watch of the input file.
+ * @return SUCCESS if the input is graded and the output written, otherwise FAILURE.
  */
-ReturnStatus write_student_data(const char *pReadFileName, const char *pWriteFileName)
+ReturnStatus regrade_watched_file(GradingContext *pContext, const CommandLineOptions *pOptions, FileWatch *watch)
 {
+    const char *pReadFileName = pOptions->pReadFileName;
+    const char *pWriteFileName = pOptions->pWriteFileName;
+    char temporaryName[FILE_NAME_SIZE];
+    ReloadSummary reload;
     FILE *pFile = NULL;
+    long long startTime = get_monotonic_time();
 
-    // Open the output file for writing
-    if (open_file_in_write_mode(&pFile, pWriteFileName) != SUCCESS)
+    if (open_file_in_read_mode(pContext, &pFile, pReadFileName) != SUCCESS)
     {
         return FAILURE;
     }
 
-    // Write a header with file metadata
-    if (write_file_header(pFile, pReadFileName) != SUCCESS)
+    TRACE_START(pContext, parseStart);
+    ReturnStatus status = reload_watched_file(pContext, watch, pFile, pReadFileName, &reload);
+    TRACE_STOP(pContext, TRACE_STAGE_PARSE, pReadFileName, TRACE_WHOLE_FILE, parseStart);
+    close_file(pContext, &pFile);
+    if (status != SUCCESS)
     {
-        close_file(&pFile);
         return FAILURE;
     }
 
-    // Write student data to the file
-    if (write_file_data(pFile) != SUCCESS)
+    pContext->profiler.nRows = pContext->table.nStudents;
+    pContext->profiler.parsedAllocations = pContext->allocator;
+
+    // Saving a file without changing it writes nothing
+    if (reload.isChanged == FALSE)
     {
-        close_file(&pFile);
-        return FAILURE;
+        show_progress(pOptions, MSG_WATCH_UNCHANGED, pReadFileName);
+        return SUCCESS;
     }
 
-    // Close the output file
-    close_file(&pFile);
+    status = FAILURE;
+    do
+    {
+        if (open_temporary_file(pContext, &pFile, pWriteFileName, temporaryName) != SUCCESS)
+        {
+            break;
+        }
+
+        TRACE_START(pContext, writeStart);
+        if (write_student_output(pContext, pFile, pReadFileName, pOptions->outputFormat) != SUCCESS)
+        {
+            fclose(pFile);
+            remove(temporaryName);
+            break;
+        }
+        PROFILE_START(pContext, replaceStart);
+        ReturnStatus replaceStatus = replace_file(pContext, &pFile, temporaryName, pWriteFileName);
+        PROFILE_STOP(pContext, PHASE_WRITE, replaceStart);
+        TRACE_STOP(pContext, TRACE_STAGE_WRITE, pReadFileName, TRACE_WHOLE_FILE, writeStart);
+        if (replaceStatus != SUCCESS)
+        {
+            break;
+        }
+
+        // Processes that query the index see the new grades from here on
+        if (pOptions->pIndexFileName != NULL && (sort_grade_index_order(pContext) != SUCCESS ||
+                                                 write_grade_index(pContext, pOptions->pIndexFileName) != SUCCESS))
+        {
+            break;
+        }
 
-    printf(MSG_STUDENT_GRADE_WRITE_DONE, pWriteFileName);
+        show_progress(pOptions, MSG_WATCH_REGRADED, pContext->table.nStudents, pReadFileName, pWriteFileName,
+                      reload.nParsed, reload.nReused, reload.nRemoved,
+                      (get_monotonic_time() - startTime) / NANOSECONDS_PER_MILLISECOND);
 
-    return SUCCESS;
+        if (rank_student_data(pContext, pOptions) != SUCCESS)
+        {
+            break;
+        }
+
+        status = show_class_statistics(pContext, pOptions);
+    } while (FALSE);
+
+    // Saving the same content again must not be taken as unchanged while the output is stale
+    if (status != SUCCESS)
+    {
+        invalidate_file_watch(watch);
+    }
+
+    return status;
 }
 
 /**
- * @brief Displays class statistics including average, minimum, and maximum scores.
+ * @brief Answers a query from a grade index written by an earlier run.
  *
- * Computes and presents statistical insights from the processed student data.
+ * Prints every student of the index with the looked up name, the name prefix or a name
+ * in the range, as name, letter grade and weighted score in name order. The index is
+ * searched in place and each student is printed as it is read, so the roster is never
+ * read or copied.
  *
- * @return SUCCESS if statistics are displayed correctly, otherwise FAILURE.
+ * @param pContext The grading context that reports errors.
+ * @param pOptions The command-line options naming the index and the query.
+ * @return SUCCESS if the query is answered, otherwise FAILURE. A looked up student that
+ *         is not in the index is a failure, an empty prefix or range is not.
  */
-ReturnStatus show_class_statistics(void)
+ReturnStatus run_index_query(GradingContext *pContext, const CommandLineOptions *pOptions)
 {
-    // Display the class statistics header
-    if (show_header() != SUCCESS)
+    GradeIndex *index = NULL;
+    IndexedStudent student;
+    ReturnStatus status = SUCCESS;
+    long first = 0;
+    long end = 0;
+    int nFound = 0;
+
+    if (open_grade_index(pContext, &index, pOptions->pIndexFileName) != SUCCESS)
     {
         return FAILURE;
     }
 
-    // Show average score
-    if (show_average() != SUCCESS)
+    // Every query is one run of students in name order, students with the same name included
+    if (pOptions->pLookupName != NULL)
     {
-        return FAILURE;
+        status = find_index_position(pContext, index, pOptions->pLookupName, &first);
+        end = get_index_student_count(index);
+    }
+    else if (pOptions->pQueryPrefix != NULL)
+    {
+        status = find_index_range(pContext, index, pOptions->pQueryPrefix, pOptions->pQueryPrefix, &first, &end);
+    }
+    else
+    {
+        status = find_index_range(pContext, index, pOptions->pQueryFrom, pOptions->pQueryTo, &first, &end);
     }
 
-    // Show minimum score
-    if (show_minimum() != SUCCESS)
+    for (long n = first; status == SUCCESS && n < end; n++)
+    {
+        status = get_index_student(pContext, index, n, &student);
+        if (status != SUCCESS || (pOptions->pLookupName != NULL && strcmp(student.name, pOptions->pLookupName) != 0))
+        {
+            break;
+        }
+        printf(INDEX_STUDENT_FORMAT, student.name, student.grade, STATS_PRECISION, student.weightedScore);
+        nFound++;
+    }
+
+    if (status == SUCCESS && nFound == 0 && pOptions->pLookupName != NULL)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_INDEX_STUDENT_NOT_FOUND, pOptions->pLookupName);
+        status = FAILURE;
+    }
+
+    if (status == SUCCESS && (fflush(stdout) != 0 || ferror(stdout)))
+    {
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, STANDARD_OUTPUT_NAME);
+        status = FAILURE;
+    }
+
+    close_grade_index(&index);
+
+    return status;
+}
+
+/**
+ * @brief Writes the recorded trace events to the trace file.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pOptions The command-line options naming the trace file.
+ * @param pTracer The tracer of the run, after every worker has finished.
+ * @return SUCCESS if the trace is written, otherwise FAILURE.
+ */
+ReturnStatus write_trace_file(GradingContext *pContext, const CommandLineOptions *pOptions, const Tracer *pTracer)
+{
+    FILE *pFile = NULL;
+
+    if (open_file_in_write_mode(pContext, &pFile, pOptions->pTraceFileName) != SUCCESS)
     {
         return FAILURE;
     }
 
-    // Show maximum score
-    if (show_maximum() != SUCCESS)
+    write_trace(pTracer, pFile);
+
+    return close_file(pContext, &pFile);
+}
+
+/**
+ * @brief Writes the allocation profile of the run to the memory report file.
+ *
+ * @param pContext The grading context whose allocations are reported.
+ * @param pOptions The command-line options naming the report file.
+ * @return SUCCESS if the report is written, otherwise FAILURE.
+ */
+ReturnStatus write_memory_report_file(GradingContext *pContext, const CommandLineOptions *pOptions)
+{
+    FILE *pFile = NULL;
+
+    if (open_file_in_write_mode(pContext, &pFile, pOptions->pMemoryReportFileName) != SUCCESS)
     {
         return FAILURE;
     }
 
-    return SUCCESS;
-};
+    write_allocation_report(&pContext->allocator, pContext->profiler.nRows, pFile);
+
+    return close_file(pContext, &pFile);
+}
 
 /**
- * @brief Frees dynamically allocated memory used for student data storage.
+ * @brief Prints a progress message unless the run is quiet.
  *
- * Clears all allocated memory to prevent memory leaks.
+ * @param pOptions The command-line options selecting the report stream.
+ * @param pFormat The 'printf' style message format from 'messages.h'.
  *
- * @return SUCCESS if memory is cleared successfully, otherwise FAILURE.
+ * @return SUCCESS after the message is handled.
  */
-ReturnStatus clear_dynamic_memmory(void)
+ReturnStatus show_progress(const CommandLineOptions *pOptions, const char *pFormat, ...)
 {
-    // Delete student records from memory
-    if (delete_students() != SUCCESS)
+    va_list args;
+
+    if (pOptions->isQuiet == TRUE)
     {
-        return FAILURE;
+        return SUCCESS;
     }
+
+    va_start(args, pFormat);
+    vfprintf(pOptions->pReportStream, pFormat, args);
+    va_end(args);
+
     return SUCCESS;
-};
\ No newline at end of file
+}
+
+/**
+ * @brief Maps the class of a failure to the program's exit code.
+ *
+ * @param errorClass The class of the failure.
+ *
+ * @return The exit code for the class.
+ */
+int get_exit_code(ErrorClass errorClass)
+{
+    switch (errorClass)
+    {
+    case ERROR_CLASS_USAGE:
+        return EXIT_CODE_USAGE;
+    case ERROR_CLASS_INPUT:
+        return EXIT_CODE_INPUT;
+    case ERROR_CLASS_DATA:
+        return EXIT_CODE_DATA;
+    case ERROR_CLASS_OUTPUT:
+        return EXIT_CODE_OUTPUT;
+    case ERROR_CLASS_MEMORY:
+        return EXIT_CODE_MEMORY;
+    case ERROR_CLASS_SECTION:
+        return EXIT_CODE_SECTION;
+    default:
+        return EXIT_CODE_FAILURE;
+    }
+}
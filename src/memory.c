@@ -4,20 +4,42 @@
  *
  * This file contains functions for dynamically allocating and freeing memory for various structures,
  * such as 'Record' and arrays. These helper functions provide centralized memory management for the application
- * and track memory allocations for debugging or resource management purposes.
+ * and track memory allocations for debugging or resource management purposes. The allocation counters
+ * live in the grading context that owns the memory, so each grading job is tracked on its own.
+ *
+ * Besides the number of live allocations, every category keeps its live and peak bytes and a
+ * histogram of the requested sizes. Bytes are the block sizes the C library reports, which
+ * include its rounding, so the peak is close to the heap a roster really needs. On a C library
+ * that cannot report block sizes the byte counters stay zero and only the counts are kept.
  */
 
 // Library includes
 #include <stdio.h>
 #include <stdlib.h> // for malloc and free
+#if defined(__GLIBC__) || defined(_WIN32)
+#include <malloc.h> // for malloc_usable_size or _msize
+#elif defined(__APPLE__)
+#include <malloc/malloc.h> // for malloc_size
+#endif
 
 // Code includes
+#include "context.h"
 #include "memory.h"
 
-// File scope global variables
-static int nStringAllocationCount = 0;
-static int nArrayAllocationCount = 0;
-static int nRecordAllocationCount = 0;
+// Function declaration
+size_t get_block_size(void *);
+int get_size_class(size_t);
+ReturnStatus track_allocation(Allocator *, AllocationCategory, size_t, void *);
+ReturnStatus track_release(Allocator *, AllocationCategory, void *);
+ReturnStatus write_allocation_profile(const AllocationProfile *, const char *, int, FILE *);
+
+// Names of the allocation categories in the allocation report
+const char *const ALLOCATION_CATEGORY_NAMES[NUMBER_OF_ALLOCATION_CATEGORIES] = {
+    "strings",
+    "arrays",
+    "records",
+    "buffers",
+};
 
 /**
  * @brief Dynamically allocates memory for a 'Record' structure.
@@ -25,21 +47,23 @@ static int nRecordAllocationCount = 0;
  * This function allocates memory for a single 'Record' structure and initializes the pointer.
  * If memory allocation fails, an error message is printed and 'FAILURE' is returned.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param record Pointer to the 'Record' pointer that will be allocated and initialized.
  *
  * @return SUCCESS if the memory is allocated successfully.
  *         FAILURE if memory allocation fails.
  */
-ReturnStatus allocate_record_memory(Record **record)
+ReturnStatus allocate_record_memory(GradingContext *pContext, Record **record)
 {
     // Allocate memory for record
     *record = (Record *)malloc(sizeof(Record));
     if (*record == NULL)
     {
-        printf(ERR_MEMORY_ALLOCATION_RECORD);
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_RECORD);
         return FAILURE;
     }
-    nRecordAllocationCount++; // Track the number of record allocations
+    pContext->allocator.nRecordAllocationCount++; // Track the number of record allocations
+    track_allocation(&pContext->allocator, ALLOCATION_RECORD, sizeof(Record), *record);
     return SUCCESS;
 }
 
@@ -49,16 +73,18 @@ ReturnStatus allocate_record_memory(Record **record)
  * This function frees the memory associated with a 'Record' structure, including the structure itself.
  * The 'record' pointer is not set to NULL after freeing, as this could cause issues if used after freeing.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param record Pointer to the 'Record' structure that will be freed.
  *
  * @return SUCCESS after freeing the memory.
  */
-ReturnStatus clear_record_memory(Record *record)
+ReturnStatus clear_record_memory(GradingContext *pContext, Record *record)
 {
     if (record != NULL)
     {
+        track_release(&pContext->allocator, ALLOCATION_RECORD, record);
         free(record); // Free the memory allocated for the record
-        nRecordAllocationCount--; // Decrement the allocation count
+        pContext->allocator.nRecordAllocationCount--; // Decrement the allocation count
     }
     return SUCCESS;
 }
@@ -69,23 +95,25 @@ ReturnStatus clear_record_memory(Record *record)
  * This function allocates memory for a string of a given size, including space for the null terminator.
  * If memory allocation fails, an error message is printed, and 'FAILURE' is returned.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param pString Pointer to the string variable that will be allocated.
  * @param size The size of the string to be allocated (excluding the null terminator).
  *
  * @return SUCCESS if the memory allocation is successful.
  *         FAILURE if memory allocation fails.
  */
-ReturnStatus allocate_string_memory(char **pString, int size)
+ReturnStatus allocate_string_memory(GradingContext *pContext, char **pString, int size)
 {
     *pString = malloc(size + 1); // Allocate memory for string, including space for '\0'
 
     if (*pString == NULL)
     {
-        printf(ERR_MEMORY_ALLOCATION_STRING);
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_STRING);
         return FAILURE;
     }
 
-    nStringAllocationCount++; // Track the number of string allocations
+    pContext->allocator.nStringAllocationCount++; // Track the number of string allocations
+    track_allocation(&pContext->allocator, ALLOCATION_STRING, (size_t)size + 1, *pString);
 
     return SUCCESS;
 }
@@ -96,16 +124,18 @@ ReturnStatus allocate_string_memory(char **pString, int size)
  * This function frees the memory allocated for a string (character array). It checks if the string is
  * not NULL before freeing the memory to avoid errors. The pointer is not set to NULL after freeing.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param pString Pointer to the string whose memory needs to be freed.
  *
  * @return SUCCESS after freeing the memory.
  */
-ReturnStatus clear_string_memory(char *pString)
+ReturnStatus clear_string_memory(GradingContext *pContext, char *pString)
 {
     if (pString != NULL)
     {
+        track_release(&pContext->allocator, ALLOCATION_STRING, pString);
         free(pString); // Free the allocated memory for the string
-        nStringAllocationCount--; // Decrement the string allocation count
+        pContext->allocator.nStringAllocationCount--; // Decrement the string allocation count
     }
     return SUCCESS;
 }
@@ -116,23 +146,25 @@ ReturnStatus clear_string_memory(char *pString)
  * This function allocates memory for an array of integers based on the specified size.
  * If memory allocation fails, an error message is printed, and 'FAILURE' is returned.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param pArray Pointer to the integer array that will be allocated.
  * @param nSize The number of integers in the array.
  *
  * @return SUCCESS if the memory allocation is successful.
  *         FAILURE if memory allocation fails.
  */
-ReturnStatus allocate_int_array_memory(int **pArray, int nSize)
+ReturnStatus allocate_int_array_memory(GradingContext *pContext, int **pArray, int nSize)
 {
     *pArray = (int *)malloc(nSize * sizeof(int)); // Allocate memory for the integer array
 
     if (*pArray == NULL)
     {
-        printf(ERR_MEMORY_ALLOCATION_ARRAY);
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_ARRAY);
         return FAILURE;
     }
 
-    nArrayAllocationCount++; // Track the number of array allocations
+    pContext->allocator.nArrayAllocationCount++; // Track the number of array allocations
+    track_allocation(&pContext->allocator, ALLOCATION_ARRAY, nSize * sizeof(int), *pArray);
 
     return SUCCESS;
 }
@@ -143,17 +175,320 @@ ReturnStatus allocate_int_array_memory(int **pArray, int nSize)
  * This function frees the memory allocated for an integer array. It checks if the pointer is not NULL
  * before attempting to free the memory, thus avoiding errors.
  *
+ * @param pContext The grading context that tracks the allocation.
  * @param pArray Pointer to the integer array whose memory needs to be freed.
  *
  * @return SUCCESS after freeing the memory.
  */
-ReturnStatus clear_int_array_memory(int *pArray)
+ReturnStatus clear_int_array_memory(GradingContext *pContext, int *pArray)
 {
     if (pArray != NULL)
     {
+        track_release(&pContext->allocator, ALLOCATION_ARRAY, pArray);
         free(pArray); // Free the memory allocated for the integer array
-        nArrayAllocationCount--; // Decrement the array allocation count
+        pContext->allocator.nArrayAllocationCount--; // Decrement the array allocation count
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Allocates a general purpose buffer of the specified size in bytes.
+ *
+ * This function allocates memory for arrays and buffers that are not strings, integer arrays
+ * or records, such as result arrays handed to library callers.
+ * If memory allocation fails, an error message is printed, and 'FAILURE' is returned.
+ *
+ * @param pContext The grading context that tracks the allocation.
+ * @param pBuffer Pointer to the buffer that will be allocated.
+ * @param nBytes The number of bytes in the buffer.
+ *
+ * @return SUCCESS if the memory allocation is successful.
+ *         FAILURE if memory allocation fails.
+ */
+ReturnStatus allocate_buffer_memory(GradingContext *pContext, void **pBuffer, size_t nBytes)
+{
+    *pBuffer = malloc(nBytes > 0 ? nBytes : 1); // Allocate at least one byte so an empty buffer is valid
+
+    if (*pBuffer == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+
+    pContext->allocator.nBufferAllocationCount++; // Track the number of buffer allocations
+    track_allocation(&pContext->allocator, ALLOCATION_BUFFER, nBytes, *pBuffer);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Frees a dynamically allocated general purpose buffer.
+ *
+ * @param pContext The grading context that tracks the allocation.
+ * @param pBuffer Pointer to the buffer whose memory needs to be freed.
+ *
+ * @return SUCCESS after freeing the memory.
+ */
+ReturnStatus clear_buffer_memory(GradingContext *pContext, void *pBuffer)
+{
+    if (pBuffer != NULL)
+    {
+        track_release(&pContext->allocator, ALLOCATION_BUFFER, pBuffer);
+        free(pBuffer); // Free the memory allocated for the buffer
+        pContext->allocator.nBufferAllocationCount--; // Decrement the buffer allocation count
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Adds the allocations of one allocator to another.
+ *
+ * Used when a grading context takes over the memory of another one. The jobs of the two
+ * allocators may have run at the same time, so the peaks are added as an upper bound.
+ *
+ * @param pTarget The allocator that takes over the allocations.
+ * @param pSource The allocator whose allocations are added, left unchanged.
+ *
+ * @return SUCCESS after the counters are added.
+ */
+ReturnStatus merge_allocator(Allocator *pTarget, const Allocator *pSource)
+{
+    pTarget->nStringAllocationCount += pSource->nStringAllocationCount;
+    pTarget->nArrayAllocationCount += pSource->nArrayAllocationCount;
+    pTarget->nRecordAllocationCount += pSource->nRecordAllocationCount;
+    pTarget->nBufferAllocationCount += pSource->nBufferAllocationCount;
+
+    for (int n = 0; n < NUMBER_OF_ALLOCATION_CATEGORIES; n++)
+    {
+        AllocationProfile *pTargetProfile = &pTarget->profile[n];
+        const AllocationProfile *pSourceProfile = &pSource->profile[n];
+
+        pTargetProfile->nLiveBytes += pSourceProfile->nLiveBytes;
+        pTargetProfile->nPeakBytes += pSourceProfile->nPeakBytes;
+        pTargetProfile->nRequestedBytes += pSourceProfile->nRequestedBytes;
+        pTargetProfile->nAllocations += pSourceProfile->nAllocations;
+        for (int i = 0; i < ALLOCATION_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            pTargetProfile->sizeHistogram[i] += pSourceProfile->sizeHistogram[i];
+        }
+    }
+    pTarget->nLiveBytes += pSource->nLiveBytes;
+    pTarget->nPeakBytes += pSource->nPeakBytes;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reports student memory that is still allocated once the student table is empty.
+ *
+ * Records and score arrays belong only to students, and every string except a tokenizer
+ * line left by a failed parse belongs to a student name. Anything of these left over after
+ * 'delete_students' was never linked into the table or was freed through another context.
+ * General purpose buffers are owned by their callers and are not checked.
+ *
+ * @param pContext The grading context whose student table was deleted.
+ *
+ * @return SUCCESS if no student memory is left.
+ *         FAILURE if a leak is reported.
+ */
+ReturnStatus report_allocation_leaks(GradingContext *pContext)
+{
+    const Allocator *pAllocator = &pContext->allocator;
+    int nStrings = pAllocator->nStringAllocationCount;
+    long long nBytes = pAllocator->profile[ALLOCATION_STRING].nLiveBytes;
+
+    // The tokenizer line is released with the context, not with the students
+    if (pContext->tokenizer.buffer != NULL)
+    {
+        nStrings--;
+        nBytes -= (long long)get_block_size(pContext->tokenizer.buffer);
+    }
+
+    if (pAllocator->nRecordAllocationCount <= 0 && pAllocator->nArrayAllocationCount <= 0 && nStrings <= 0)
+    {
+        return SUCCESS;
+    }
+
+    nBytes += pAllocator->profile[ALLOCATION_RECORD].nLiveBytes + pAllocator->profile[ALLOCATION_ARRAY].nLiveBytes;
+    report_message(pContext, WARNING_ALLOCATION_LEAK, pAllocator->nRecordAllocationCount,
+                   pAllocator->nArrayAllocationCount, nStrings, nBytes);
+
+    return FAILURE;
+}
+
+/**
+ * @brief Writes the allocation profile of a run as one JSON object.
+ *
+ * The object holds the overall live and peak bytes, the peak bytes per student row and, per
+ * category, the live count, the byte counters and the non-empty size classes. A size class
+ * is named by the largest requested size it holds; the last class holds everything larger.
+ *
+ * @param pAllocator The allocator of the run.
+ * @param nRows The number of student rows of the run.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS after the report is written.
+ */
+ReturnStatus write_allocation_report(const Allocator *pAllocator, int nRows, FILE *pStream)
+{
+    const int nLive[NUMBER_OF_ALLOCATION_CATEGORIES] = {
+        pAllocator->nStringAllocationCount,
+        pAllocator->nArrayAllocationCount,
+        pAllocator->nRecordAllocationCount,
+        pAllocator->nBufferAllocationCount,
+    };
+
+    fprintf(pStream, "{\"rows\":%d,\"live_bytes\":%lld,\"peak_bytes\":%lld,\"peak_bytes_per_row\":%.1f,", nRows,
+            pAllocator->nLiveBytes, pAllocator->nPeakBytes, (nRows > 0) ? (double)pAllocator->nPeakBytes / nRows : 0.0);
+    fprintf(pStream, "\"categories\":{");
+
+    for (int n = 0; n < NUMBER_OF_ALLOCATION_CATEGORIES; n++)
+    {
+        write_allocation_profile(&pAllocator->profile[n], ALLOCATION_CATEGORY_NAMES[n], nLive[n], pStream);
+        fprintf(pStream, "%s", (n + 1 < NUMBER_OF_ALLOCATION_CATEGORIES) ? "," : "");
+    }
+    fprintf(pStream, "}}\n");
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the counters of one allocation category as a JSON member.
+ *
+ * @param pProfile The counters of the category.
+ * @param pName The category name.
+ * @param nLive The number of live allocations of the category.
+ * @param pStream The stream that receives the member.
+ *
+ * @return SUCCESS after the member is written.
+ */
+ReturnStatus write_allocation_profile(const AllocationProfile *pProfile, const char *pName, int nLive, FILE *pStream)
+{
+    Boolean isFirst = TRUE;
+
+    fprintf(pStream, "\"%s\":{\"live\":%d,\"live_bytes\":%lld,\"peak_bytes\":%lld,\"allocations\":%ld,", pName, nLive,
+            pProfile->nLiveBytes, pProfile->nPeakBytes, pProfile->nAllocations);
+    fprintf(pStream, "\"requested_bytes\":%lld,\"size_histogram\":{", pProfile->nRequestedBytes);
+
+    for (int n = 0; n < ALLOCATION_HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        if (pProfile->sizeHistogram[n] == 0)
+        {
+            continue;
+        }
+
+        if (n + 1 < ALLOCATION_HISTOGRAM_BUCKET_COUNT)
+        {
+            fprintf(pStream, "%s\"%ld\":%ld", (isFirst == TRUE) ? "" : ",", (long)ALLOCATION_HISTOGRAM_SMALLEST_SIZE << n,
+                    pProfile->sizeHistogram[n]);
+        }
+        else
+        {
+            fprintf(pStream, "%s\"larger\":%ld", (isFirst == TRUE) ? "" : ",", pProfile->sizeHistogram[n]);
+        }
+        isFirst = FALSE;
+    }
+    fprintf(pStream, "}}");
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the size of a heap block as reported by the C library.
+ *
+ * @param pBlock The block, returned by 'malloc'.
+ *
+ * @return The usable size of the block, or zero if the C library cannot report it.
+ */
+size_t get_block_size(void *pBlock)
+{
+#if defined(__GLIBC__)
+    return malloc_usable_size(pBlock);
+#elif defined(_WIN32)
+    return _msize(pBlock);
+#elif defined(__APPLE__)
+    return malloc_size(pBlock);
+#else
+    (void)pBlock;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Returns the size class of a requested allocation size.
+ *
+ * Class 0 holds sizes up to 'ALLOCATION_HISTOGRAM_SMALLEST_SIZE', each following class
+ * doubles the largest size, and the last class holds everything larger.
+ *
+ * @param nBytes The requested size.
+ *
+ * @return The index of the size class.
+ */
+int get_size_class(size_t nBytes)
+{
+    int sizeClass = 0;
+    size_t limit = ALLOCATION_HISTOGRAM_SMALLEST_SIZE;
+
+    while (nBytes > limit && sizeClass + 1 < ALLOCATION_HISTOGRAM_BUCKET_COUNT)
+    {
+        limit <<= 1;
+        sizeClass++;
+    }
+
+    return sizeClass;
+}
+
+/**
+ * @brief Counts a new allocation in the byte counters and size histogram of its category.
+ *
+ * @param pAllocator The allocator of the context that owns the allocation.
+ * @param category The category of the allocation.
+ * @param nRequested The number of bytes requested.
+ * @param pBlock The allocated block.
+ *
+ * @return SUCCESS after the allocation is counted.
+ */
+ReturnStatus track_allocation(Allocator *pAllocator, AllocationCategory category, size_t nRequested, void *pBlock)
+{
+    AllocationProfile *pProfile = &pAllocator->profile[category];
+    long long nBytes = (long long)get_block_size(pBlock);
+
+    pProfile->nAllocations++;
+    pProfile->nRequestedBytes += (long long)nRequested;
+    pProfile->sizeHistogram[get_size_class(nRequested)]++;
+
+    pProfile->nLiveBytes += nBytes;
+    if (pProfile->nLiveBytes > pProfile->nPeakBytes)
+    {
+        pProfile->nPeakBytes = pProfile->nLiveBytes;
+    }
+
+    pAllocator->nLiveBytes += nBytes;
+    if (pAllocator->nLiveBytes > pAllocator->nPeakBytes)
+    {
+        pAllocator->nPeakBytes = pAllocator->nLiveBytes;
     }
 
     return SUCCESS;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Removes a block that is about to be freed from the live bytes of its category.
+ *
+ * @param pAllocator The allocator of the context that owns the allocation.
+ * @param category The category of the allocation.
+ * @param pBlock The block, not yet freed.
+ *
+ * @return SUCCESS after the release is counted.
+ */
+ReturnStatus track_release(Allocator *pAllocator, AllocationCategory category, void *pBlock)
+{
+    long long nBytes = (long long)get_block_size(pBlock);
+
+    pAllocator->profile[category].nLiveBytes -= nBytes;
+    pAllocator->nLiveBytes -= nBytes;
+
+    return SUCCESS;
+}
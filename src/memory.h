@@ -1,17 +1,28 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include <stddef.h>
+
 #include "constants.h"
 #include "messages.h" 
 #include "types.h"
 
-ReturnStatus allocate_record_memory(Record **);
-ReturnStatus clear_record_memory(Record *);
+ReturnStatus allocate_record_memory(GradingContext *, Record **);
+ReturnStatus clear_record_memory(GradingContext *, Record *);
+
+ReturnStatus allocate_string_memory(GradingContext *, char **, int);
+ReturnStatus clear_string_memory(GradingContext *, char *);
+
+ReturnStatus allocate_int_array_memory(GradingContext *, int **, int);
+ReturnStatus clear_int_array_memory(GradingContext *, int *);
+
+ReturnStatus allocate_buffer_memory(GradingContext *, void **, size_t);
+ReturnStatus clear_buffer_memory(GradingContext *, void *);
 
-ReturnStatus allocate_string_memory(char **, int);
-ReturnStatus clear_string_memory(char *);
+extern const char *const ALLOCATION_CATEGORY_NAMES[];
 
-ReturnStatus allocate_int_array_memory(int **, int);
-ReturnStatus clear_int_array_memory(int *);
+ReturnStatus merge_allocator(Allocator *, const Allocator *);
+ReturnStatus report_allocation_leaks(GradingContext *);
+ReturnStatus write_allocation_report(const Allocator *, int, FILE *);
 
 #endif // MEMORY_H
\ No newline at end of file
@@ -14,6 +14,39 @@
 #define PROMPT_FOR_ENTER_TO_EXIT "\n\nPress enter to exit..."
 
 // Informational Messages
+#define MSG_USAGE                                                                                      \
+    "Usage: LetterGrader [options] [input output]\n"                                                   \
+    "       LetterGrader --batch <directory|manifest> [options] [output directory]\n\n"                \
+    "Options:\n"                                                                                       \
+    "  --input <file|->          Read student data from a file or '-' for standard input\n"            \
+    "  --output <file|->         Write letter grades to a file or '-' for standard output\n"           \
+    "  --batch <source>          Grade every roster of a directory or manifest\n"                      \
+    "  --threads <n>             Number of worker threads, 0 for one per processor\n"                  \
+    "  --stats-format <format>   Class statistics as text, csv, json or none\n"                        \
+    "  --output-format <format>  Letter grades as text, csv, jsonl or binary\n"                        \
+    "  --quiet                   Print no progress messages (statistics default to none)\n"            \
+    "  --no-wait                 Exit without waiting for Enter\n"                                     \
+    "  --timing                  Print phase timing, throughput and allocation counts\n"               \
+    "  --trace <file>            Write a Chrome trace of the pipeline stages of every thread\n"        \
+    "  --memory-report <file>    Write peak memory and allocation sizes as JSON\n"                     \
+    "  --daemon <socket>         Keep rosters in memory and serve requests on a Unix socket\n"         \
+    "  --watch                   Re-grade the input file whenever it changes, until Ctrl+C\n"          \
+    "  --index <file>            Write a grade index for lookups, or name the index to query\n"        \
+    "  --lookup <name>           Print the grade of a student from the index and exit\n"               \
+    "  --prefix <text>           Print the students of the index whose name starts with text\n"        \
+    "  --from <name>             Print the students of the index from this name on\n"                  \
+    "  --to <name>               Print the students of the index up to names starting with this\n"     \
+    "  --skip-invalid <file>     Skip invalid rows into a rejects file instead of failing\n"           \
+    "  --read-ahead <mode>       Read input files ahead of parsing: auto, thread or off\n"             \
+    "  --top <n|p%>              Report the n (or p percent) students with the highest scores\n"       \
+    "  --bottom <n|p%>           Report the n (or p percent) students with the lowest scores\n"        \
+    "  --rank-output <file>      Write the top and bottom students as CSV\n"                           \
+    "  --sort <key>              Order the letter grades by name, score or grade\n"                    \
+    "  --collation <mode>        Compare names as byte, fold (case and accents) or locale\n"           \
+    "  --duplicates <policy>     Drop or merge students listed twice: first, last, error, merge\n"     \
+    "  --help                    Print this help\n\n"                                                  \
+    "Exit codes: 0 success, 1 failure, 2 usage, 3 input, 4 data, 5 output, 6 memory,\n"                \
+    "            7 batch sections failed\n"
 #define MSG_WELCOME "Welcome to the Letter Grader application"
 #define MSG_INVALID_ARGUMENT_COUNT "\nApplication will use default read and write file names!"
 #define MSG_VALID_ARGUMENT_COUNT "\n\nApplication will use read and write files names provided in the command line arguments"
@@ -23,25 +56,108 @@
 #define MSG_STUDENT_GRADING_DONE "\nLetter grade has been calculated for all stuudents"
 #define MSG_STUDENT_GRADE_WRITE_DONE "\nStudent letter grades written to output file '%s'"
 #define MSG_SHOW_AVERAGE_HEADER "\n\nHere is the class averages:"
+#define MSG_SHOW_DISTRIBUTION_HEADER "\n\nHere is the letter grade distribution:"
+#define MSG_BATCH_START "\n\nGrading %d section%s from '%s' with %d thread%s"
+#define MSG_BATCH_DONE "\nGraded %d sections (%d students, %d failed), summary written to '%s'"
+#define MSG_BATCH_SUMMARY_HEADER "Statistics for %d students in %d sections given in %s:\n"
+#define MSG_BATCH_SECTION_HEADER "\n\nSection results:\n"
+#define MSG_BATCH_SECTION_FAILED "%s: FAILED! %s\n"
+#define MSG_BATCH_SECTION_STUDENTS "%s: %d students,"
+#define MSG_BATCH_SECTION_GRADE " %c=%d"
+#define MSG_SHOW_HISTOGRAM_HEADER "\n\nHere is the weighted score histogram:"
+#define MSG_PLURAL_SUFFIX "s"
+#define MSG_SHOW_TIMING_HEADER "\n\nHere is the phase timing:"
+#define MSG_DAEMON_START "\n\nServing grading requests on '%s' with %d thread%s"
+#define MSG_DAEMON_STOP "\nDaemon stopped after %ld requests"
+#define MSG_WATCH_START "\n\nWatching '%s' for changes, press Ctrl+C to stop"
+#define MSG_WATCH_REGRADED "\n\nRe-graded %d students of '%s' into '%s' (%d parsed, %d reused, %d removed) in %.1f ms"
+#define MSG_WATCH_UNCHANGED "\n\nInput file '%s' is unchanged"
+#define MSG_WATCH_STOP "\n\nWatch stopped after %d passes"
+#define MSG_INDEX_WRITE_DONE "\nGrade index of %d students written to '%s'"
+#define MSG_SHOW_TOP_HEADER "\n\nHere are the %d students with the highest weighted scores:"
+#define MSG_SHOW_BOTTOM_HEADER "\n\nHere are the %d students with the lowest weighted scores:"
+#define MSG_RANK_WRITE_DONE "\nTop %d and bottom %d students written to '%s'"
+#define INDEX_STUDENT_FORMAT "%s,%c,%.*f\n"
 
 // Warnings
 #define WARNING_INVALID_ARGUMENT_COUNT "\n\nWARNING! Command line argument format not suppoprted."
 #define WARNING_FILE_POINTER_NOT_NULL "\nWARNING! File pointer is not NULL"
 #define WARNING_FILE_POINTER_NULL "\nWARNING! File pointer is NULL"
 #define WARNING_PARSED_DATA_EMPTY "\nWARNING! Parsed data is empty"
+#define WARNING_ROWS_REJECTED "\n\nWARNING! Skipped %ld invalid rows (%ld without a name, %ld with a score out of range, %ld with a wrong score count), written to '%s'"
+#define WARNING_ROW_REJECTED "\n  line %ld: %s"
+#define WARNING_MORE_ROWS_REJECTED "\n  ... and %ld more"
+#define WARNING_DUPLICATES_FOUND "\n\nWARNING! Found %ld duplicate rows of %ld students, %s"
+#define WARNING_DUPLICATE_STUDENT "\n  %s"
+#define WARNING_MORE_DUPLICATES "\n  ... and %ld more"
+#define MSG_DUPLICATES_KEPT_FIRST "kept the first row of each"
+#define MSG_DUPLICATES_KEPT_LAST "kept the last row of each"
+#define MSG_DUPLICATES_MERGED "merged the rows of each by the highest score of every test"
+#define WARNING_ALLOCATION_LEAK "\nWARNING! %d records, %d score arrays and %d strings (%lld bytes) are still allocated after the students were deleted"
 
 // Errors
 #define ERR_FILE_OPEN_READ "\n\nERROR! Failed to open '%s' file for read operation"
 #define ERR_FILE_OPEN_WRITE "\n\nERROR! Failed to open '%s' file for write operation"
 #define ERR_FILE_EMPTY "\n\nERROR! File '%s' is empty"
 #define ERR_FILE_CLOSE "\n\nERROR! Failed to close '%s' file"
+#define ERR_FILE_CLOSE_UNNAMED "\n\nERROR! Failed to close file"
 #define ERR_MEMORY_ALLOCATION_STRING "\n\nERROR! Failed to allocate memory for string"
 #define ERR_MEMORY_ALLOCATION_ARRAY "\n\nERROR! Failed to allocate memory for array"
+#define ERR_MEMORY_ALLOCATION_BUFFER "\n\nERROR! Failed to allocate memory for buffer"
 #define ERR_MEMORY_ALLOCATION_RECORD "\n\nERROR! Failed to allocate memory for record data structure"
 #define ERR_PARSED_NAME_EMPTY "\n\nERROR! Parsed name is empty"
 #define ERR_PARSED_SCORE_INVALID "\n\nERROR! Parsed score '%d' is not within score range of '%d' to '%d'"
 #define ERR_INCORRECT_SCORE_COUNT "\n\nERROR! Student %s has %d scores, %d scores are required to calculate the grade"
 #define ERR_RECORD_EMPTY "\n\nERROR! Student record for link list operation is empty"
 #define ERR_DIVIDE_BY_ZERO "\n\nERROR! Divide by zero attempted"
+#define ERR_THREAD_CREATE "\n\nERROR! Failed to create worker thread"
+#define ERR_BATCH_EMPTY "\n\nERROR! No input files found in '%s'"
+#define ERR_FILE_NAME_TOO_LONG "\n\nERROR! File name '%s' is too long"
+#define ERR_FILE_READ "\n\nERROR! Failed to read '%s' file"
+#define ERR_FILE_DECOMPRESS "\n\nERROR! Failed to decompress '%s' file: %s"
+#define ERR_COMPRESSION_UNSUPPORTED "\n\nERROR! Input is compressed with %s, which this build cannot read"
+#define ERR_DECOMPRESSOR_START "\n\nERROR! Failed to start the %s decompressor"
+#define ERR_FILE_WRITE "\n\nERROR! Failed to write '%s' file"
+#define ERR_GRADER_NOT_GRADED "\n\nERROR! Students must be graded before results are requested"
+#define ERR_OPTION_UNKNOWN "\n\nERROR! Unknown option '%s'"
+#define ERR_OPTION_VALUE_MISSING "\n\nERROR! Option '%s' requires a value"
+#define ERR_OPTION_VALUE_INVALID "\n\nERROR! Value '%s' is not valid for option '%s'"
+#define ERR_ARGUMENT_UNEXPECTED "\n\nERROR! Unexpected argument '%s'"
+#define ERR_BATCH_OUTPUT_DUPLICATE "\n\nERROR! Rosters '%s' and '%s' would both be written to '%s'"
+#define ERR_BATCH_OUTPUT_MISSING "\n\nERROR! Batch mode requires an output directory"
+#define ERR_BATCH_STANDARD_STREAM "\n\nERROR! Batch mode cannot use standard input or output"
+#define ERR_DAEMON_SOCKET "\n\nERROR! Failed to listen on socket '%s'"
+#define ERR_DAEMON_UNSUPPORTED "\n\nERROR! Daemon mode needs Linux (epoll)"
+#define ERR_DAEMON_EVENT_LOOP "\n\nERROR! Daemon event loop failed"
+#define ERR_WATCH_OPEN "\n\nERROR! Failed to watch '%s' for changes"
+#define ERR_WATCH_UNSUPPORTED "\n\nERROR! Watch mode needs Linux (inotify)"
+#define ERR_WATCH_STANDARD_STREAM "\n\nERROR! Watch mode cannot use standard input or output"
+#define ERR_FILE_REPLACE "\n\nERROR! Failed to replace '%s' file"
+#define ERR_INDEX_INVALID "\n\nERROR! '%s' is not a grade index or is damaged"
+#define ERR_INDEX_MISSING "\n\nERROR! Option '%s' requires '--index <file>'"
+#define ERR_RANK_SIZE_MISSING "\n\nERROR! Option '%s' requires '--top' or '--bottom'"
+#define ERR_STUDENT_DUPLICATE "\n\nERROR! Student '%s' is listed more than once"
+#define ERR_COLLATION_LOCALE "\n\nERROR! The LC_COLLATE locale is not available, set LC_ALL, LC_COLLATE or LANG"
+#define ERR_INDEX_STUDENT_NOT_FOUND "\n\nERROR! Student '%s' is not in the grade index"
+#define ERR_ROWS_ALL_REJECTED "\n\nERROR! Every row of '%s' is invalid, see '%s'"
+
+// Reasons of rejected rows, without the layout of console messages
+#define REJECT_NAME_EMPTY "Parsed name is empty"
+#define REJECT_SCORE_RANGE "Parsed score '%d' is not within score range of '%d' to '%d'"
+#define REJECT_SCORE_COUNT "Student %.*s has %d scores, %d scores are required to calculate the grade"
+
+// Daemon replies, one line per request
+#define MESSAGE_TAG_END "! " // Ends the 'ERROR!' tag left out of replies
+#define DAEMON_REPLY_OK "OK\n"
+#define DAEMON_REPLY_COUNT "OK %d\n"
+#define DAEMON_REPLY_GRADE "OK %c %.*f\n"
+#define DAEMON_REPLY_ERROR "ERR %s\n"
+#define DAEMON_REPLY_UNKNOWN_REQUEST "ERR Unknown request '%s'\n"
+#define DAEMON_REPLY_UNKNOWN_ROSTER "ERR Unknown roster '%s'\n"
+#define DAEMON_REPLY_UNKNOWN_STUDENT "ERR Unknown student '%s'\n"
+#define DAEMON_REPLY_MISSING_ARGUMENT "ERR Request '%s' needs more arguments\n"
+#define DAEMON_REPLY_ROSTER_NAME "ERR Roster name '%s' is too long\n"
+#define DAEMON_REPLY_TOO_LONG "ERR Request is longer than %d bytes\n"
+#define ERR_BUFFER_SIZE "\n\nERROR! Buffer holds %d entries, %d entries are required"
 
 #endif // MESSAGES_H
\ No newline at end of file
@@ -0,0 +1,238 @@
+/**
+ * @file parallel.c
+ * @brief Parallel parsing of one large roster.
+ *
+ * A roster file of at least 'BATCH_SPLIT_BYTES' is split into byte ranges the way batch
+ * mode splits its large sections. Each range is read with 'read_file_range', which moves
+ * its start forward to the next line boundary, and parsed on a pool worker into a grading
+ * context of its own, so the workers share nothing while parsing. The ranges are then
+ * spliced onto the caller's table in file order, which gives the same table as a serial
+ * parse: records keep the roster order, so the stable sort by name breaks ties the same way.
+ *
+ * The roster ends at its first empty line, and a range past that line is dropped. When a
+ * range fails, the failure of the first failing range in file order is reported, which is
+ * the failure a serial parse stops at. Rejected rows are numbered from the start of their
+ * range and moved past the lines of the earlier ranges when the ranges are merged. When the
+ * run is profiled, every range times its own read, tokenize and parse phases, and the times
+ * and byte counts move to the caller's profiler with the records.
+ */
+
+// Library includes
+#include <stdio.h>
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "memory.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "reject.h"
+#include "threadpool.h"
+#include "trace.h"
+
+// Define byte range of a roster parsed by one pool task
+typedef struct
+{
+    GradingContext context; // Records, allocations and rejected rows of the range
+    const char *pFileName;  // Roster file
+    int index;              // Index of the range in file order
+    long nStart;            // First byte of the range
+    long nEnd;              // Byte after the range
+    long nLines;            // Lines parsed, up to the first empty line
+    Boolean isStopped;      // TRUE if an empty line inside the range ends the roster
+    ReturnStatus status;    // Result of the range
+} ParseRange;
+
+// Function declaration
+void parse_range_task(void *);
+ReturnStatus merge_parse_ranges(GradingContext *, ParseRange *, int);
+
+/**
+ * @brief Returns the number of byte ranges a roster is parsed in.
+ *
+ * Rosters are split as batch mode splits its sections: only from 'BATCH_SPLIT_BYTES' on,
+ * and into ranges of at least half that size.
+ *
+ * @param nBytes Size of the roster file, or a negative number if it is not a regular file.
+ * @param nThreads Number of worker threads, or zero for one per processor.
+ * @return The number of ranges, 1 to parse the roster serially.
+ */
+int get_parse_range_count(long nBytes, int nThreads)
+{
+    nThreads = (nThreads > 0) ? nThreads : get_processor_count();
+    if (nThreads < 2 || nBytes < BATCH_SPLIT_BYTES)
+    {
+        return 1;
+    }
+
+    long nRanges = nBytes / (BATCH_SPLIT_BYTES / 2);
+
+    return (nRanges < nThreads) ? (int)nRanges : nThreads;
+}
+
+/**
+ * @brief Parses a roster file in byte ranges on several workers.
+ *
+ * The records are appended to the student table of the context in file order. When the
+ * context has a reject log, rejected rows of every range are appended to it in file order.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param pFileName Name of the roster file.
+ * @param nBytes Size of the roster file.
+ * @param nRanges Number of ranges from 'get_parse_range_count'.
+ * @return SUCCESS if the roster is parsed, otherwise FAILURE.
+ */
+ReturnStatus process_student_file(GradingContext *pContext, const char *pFileName, long nBytes, int nRanges)
+{
+    ParseRange *ranges = NULL;
+    ThreadPool *pool = NULL;
+    ReturnStatus status = SUCCESS;
+    int nReady = 0; // Ranges with an initialized context
+
+    do
+    {
+        if (allocate_buffer_memory(pContext, (void **)&ranges, nRanges * sizeof(ParseRange)) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        // Give every range its own context so workers share nothing while parsing
+        long nRangeSize = nBytes / nRanges;
+        for (; nReady < nRanges; nReady++)
+        {
+            ParseRange *range = &ranges[nReady];
+            *range = (ParseRange){0};
+            init_grading_context(&range->context, pContext->schema);
+            set_message_stream(&range->context, NULL);
+            set_tracer(&range->context, pContext->pTracer);
+            if (pContext->profiler.isEnabled == TRUE)
+            {
+                start_profiler(&range->context.profiler);
+            }
+            range->pFileName = pFileName;
+            range->index = nReady;
+            range->nStart = nRangeSize * nReady;
+            range->nEnd = (nReady == nRanges - 1) ? nBytes : range->nStart + nRangeSize;
+
+            if (pContext->pRejectLog != NULL &&
+                open_reject_part(pContext, &range->context.pRejectLog, pContext->pRejectLog->pFileName) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+        }
+        if (status != SUCCESS)
+        {
+            break;
+        }
+
+        if (create_thread_pool(&pool, nRanges) != SUCCESS)
+        {
+            report_error(pContext, ERROR_CLASS_MEMORY, ERR_THREAD_CREATE);
+            status = FAILURE;
+            break;
+        }
+        for (int n = 0; n < nRanges; n++)
+        {
+            if (submit_task(pool, parse_range_task, &ranges[n]) != SUCCESS)
+            {
+                // Ranges already submitted still run before the pool is released
+                report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+                status = FAILURE;
+                break;
+            }
+        }
+        destroy_thread_pool(&pool);
+        if (status != SUCCESS)
+        {
+            break;
+        }
+
+        TRACE_START(pContext, mergeStart);
+        status = merge_parse_ranges(pContext, ranges, nRanges);
+        TRACE_STOP(pContext, TRACE_STAGE_MERGE, pFileName, TRACE_WHOLE_FILE, mergeStart);
+    } while (FALSE);
+
+    // Release the ranges that were not merged
+    for (int n = 0; n < nReady; n++)
+    {
+        close_reject_log(&ranges[n].context, &ranges[n].context.pRejectLog);
+        clear_grading_context(&ranges[n].context);
+    }
+    clear_buffer_memory(pContext, ranges);
+
+    return status;
+}
+
+/**
+ * @brief Pool task that reads and parses one byte range of a roster.
+ *
+ * @param pArgument The 'ParseRange'.
+ */
+void parse_range_task(void *pArgument)
+{
+    ParseRange *range = (ParseRange *)pArgument;
+    GradingContext *pContext = &range->context;
+    char *pBuffer = NULL;
+    long nSize = 0;
+
+    TRACE_START(pContext, loadStart);
+    PROFILE_START(pContext, readStart);
+    range->status = read_file_range(pContext, range->pFileName, range->nStart, range->nEnd, &pBuffer, &nSize);
+    PROFILE_STOP(pContext, PHASE_READ, readStart);
+    PROFILE_ADD(pContext, nBytesRead, nSize);
+    TRACE_STOP(pContext, TRACE_STAGE_LOAD, range->pFileName, range->index, loadStart);
+    if (range->status != SUCCESS)
+    {
+        return;
+    }
+
+    TRACE_START(pContext, parseStart);
+    range->status = process_student_range(pContext, pBuffer, nSize, &range->nLines, &range->isStopped);
+    TRACE_STOP(pContext, TRACE_STAGE_PARSE, range->pFileName, range->index, parseStart);
+    clear_buffer_memory(pContext, pBuffer);
+}
+
+/**
+ * @brief Splices the parsed ranges onto the student table in file order.
+ *
+ * Ranges are merged up to the one that holds the first empty line. The first failing
+ * range among them fails the roster with its own message and error class.
+ *
+ * @param pContext The grading context that receives the student records.
+ * @param ranges The parsed ranges in file order.
+ * @param nRanges Number of ranges.
+ * @return SUCCESS if every range up to the end of the roster is merged, otherwise FAILURE.
+ */
+ReturnStatus merge_parse_ranges(GradingContext *pContext, ParseRange *ranges, int nRanges)
+{
+    long nLinesBefore = 0; // Lines of the roster before the range being merged
+
+    for (int n = 0; n < nRanges; n++)
+    {
+        ParseRange *range = &ranges[n];
+
+        if (range->status != SUCCESS)
+        {
+            // Keep the layout the message had when the range reported it
+            report_error(pContext, range->context.errorClass, "\n\n%s", range->context.lastMessage);
+            return FAILURE;
+        }
+
+        if (range->context.pRejectLog != NULL &&
+            merge_reject_log(pContext, pContext->pRejectLog, &range->context.pRejectLog, nLinesBefore) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        merge_grading_context(pContext, &range->context);
+        nLinesBefore += range->nLines;
+
+        if (range->isStopped == TRUE)
+        {
+            break;
+        }
+    }
+
+    return SUCCESS;
+}
@@ -0,0 +1,11 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+int get_parse_range_count(long, int);
+ReturnStatus process_student_file(GradingContext *, const char *, long, int);
+
+#endif // PARALLEL_H
@@ -0,0 +1,179 @@
+/**
+ * @file profiler.c
+ * @brief Phase timing and throughput instrumentation of a grading run.
+ *
+ * The profiler adds up monotonic clock intervals per phase of a run (read, tokenize,
+ * parse, grade, sort, format, write and free) and prints a report with the wall time,
+ * the share of each phase, rows and bytes per second, and the allocation counters of
+ * 'memory.c'. Timing points are the 'PROFILE_START' and 'PROFILE_STOP' macros, which only
+ * read the clock when the profiler of the grading context is enabled.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <time.h> // for clock_gettime
+
+// Code includes
+#include "profiler.h"
+
+// Phase names for the report, in 'Phase' order
+const char *const PHASE_NAMES[] = {"Read", "Tokenize", "Parse", "Grade", "Sort", "Format", "Write", "Free"};
+
+// Function declaration
+double get_rate(double, long long);
+
+/**
+ * @brief Returns the time of the monotonic clock.
+ *
+ * @return The time in nanoseconds since an arbitrary fixed point.
+ */
+long long get_monotonic_time(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (long long)now.tv_sec * NANOSECONDS_PER_SECOND + now.tv_nsec;
+}
+
+/**
+ * @brief Clears a profiler, enables it and starts the wall clock of the run.
+ *
+ * @param pProfiler The profiler to start.
+ *
+ * @return SUCCESS after the profiler is started.
+ */
+ReturnStatus start_profiler(Profiler *pProfiler)
+{
+    *pProfiler = (Profiler){0};
+    pProfiler->isEnabled = TRUE;
+    pProfiler->startTime = get_monotonic_time();
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Adds the time since 'start' to a phase.
+ *
+ * @param pProfiler The profiler.
+ * @param phase The phase that just ended.
+ * @param start The monotonic time the phase started.
+ *
+ * @return SUCCESS after the time is added.
+ */
+ReturnStatus add_phase_time(Profiler *pProfiler, Phase phase, long long start)
+{
+    pProfiler->phaseTime[phase] += get_monotonic_time() - start;
+    pProfiler->phaseIntervals[phase]++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Adds the phase times and counters of a part of a job to the profiler of the job.
+ *
+ * Parts that ran at the same time on different workers add up their times, so the phases
+ * of a parallel parse report the time of all workers rather than the elapsed time.
+ *
+ * @param pTarget The profiler of the job.
+ * @param pSource The profiler of the part.
+ *
+ * @return SUCCESS after the counters are added.
+ */
+ReturnStatus merge_profiler(Profiler *pTarget, const Profiler *pSource)
+{
+    for (int n = 0; n < NUMBER_OF_PHASES; n++)
+    {
+        pTarget->phaseTime[n] += pSource->phaseTime[n];
+        pTarget->phaseIntervals[n] += pSource->phaseIntervals[n];
+    }
+    pTarget->nBytesRead += pSource->nBytesRead;
+    pTarget->nBytesWritten += pSource->nBytesWritten;
+    pTarget->nRows += pSource->nRows;
+    pTarget->nRecordSteps += pSource->nRecordSteps;
+    pTarget->nNameComparisons += pSource->nNameComparisons;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the timing report of a run.
+ *
+ * Tokenizing happens while records are parsed, so the parse time is reported without
+ * the tokenize time. Time outside every phase, such as argument handling and statistics,
+ * only counts towards the wall time.
+ *
+ * @param pProfiler The profiler of the finished run.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS after the report is written.
+ */
+ReturnStatus write_profile_report(const Profiler *pProfiler, FILE *pStream)
+{
+    long long wallTime = get_monotonic_time() - pProfiler->startTime;
+    double wallMilliseconds = (double)wallTime / NANOSECONDS_PER_MILLISECOND;
+
+    fprintf(pStream, MSG_SHOW_TIMING_HEADER);
+    fprintf(pStream, "\n%-*s%*s%*s%*s", PROFILE_NAME_WIDTH, "Phase", PROFILE_COLUMN_WIDTH, "ms", PROFILE_COLUMN_WIDTH,
+            "Share", PROFILE_COLUMN_WIDTH, "Count");
+
+    for (int n = 0; n < NUMBER_OF_PHASES; n++)
+    {
+        long long phaseTime = pProfiler->phaseTime[n];
+        if (n == PHASE_PARSE)
+        {
+            phaseTime -= pProfiler->phaseTime[PHASE_TOKENIZE];
+        }
+
+        double share = (wallTime > 0) ? PERCENT_SCALE * phaseTime / wallTime : 0;
+        fprintf(pStream, "\n%-*s%*.*f%*.*f%%%*ld", PROFILE_NAME_WIDTH, PHASE_NAMES[n], PROFILE_COLUMN_WIDTH, PROFILE_PRECISION,
+                (double)phaseTime / NANOSECONDS_PER_MILLISECOND, PROFILE_COLUMN_WIDTH - 1, STATS_PRECISION, share,
+                PROFILE_COLUMN_WIDTH, pProfiler->phaseIntervals[n]);
+    }
+    fprintf(pStream, "\n%-*s%*.*f", PROFILE_NAME_WIDTH, "Wall", PROFILE_COLUMN_WIDTH, PROFILE_PRECISION, wallMilliseconds);
+
+    // Throughput over the whole run
+    fprintf(pStream, "\n\n%-*s%d rows, %.0f rows/s", PROFILE_NAME_WIDTH, "Rows", pProfiler->nRows,
+            get_rate(pProfiler->nRows, wallTime));
+    fprintf(pStream, "\n%-*s%lld bytes, %.*f MB/s", PROFILE_NAME_WIDTH, "Read", pProfiler->nBytesRead, STATS_PRECISION,
+            get_rate(pProfiler->nBytesRead / BYTES_PER_MEGABYTE, wallTime));
+    fprintf(pStream, "\n%-*s%lld bytes, %.*f MB/s", PROFILE_NAME_WIDTH, "Written", pProfiler->nBytesWritten,
+            STATS_PRECISION, get_rate(pProfiler->nBytesWritten / BYTES_PER_MEGABYTE, wallTime));
+    fprintf(pStream, "\n%-*s%lld records walked, %lld name comparisons", PROFILE_NAME_WIDTH, "Steps",
+            pProfiler->nRecordSteps, pProfiler->nNameComparisons);
+
+    // Live allocations from the allocator counters
+    const Allocator *pParsed = &pProfiler->parsedAllocations;
+    const Allocator *pFreed = &pProfiler->freedAllocations;
+    fprintf(pStream, "\n\n%-*s%*s%*s%*s%*s", PROFILE_NAME_WIDTH, "Live", PROFILE_COLUMN_WIDTH, "Strings", PROFILE_COLUMN_WIDTH,
+            "Arrays", PROFILE_COLUMN_WIDTH, "Records", PROFILE_COLUMN_WIDTH, "Buffers");
+    fprintf(pStream, "\n%-*s%*d%*d%*d%*d", PROFILE_NAME_WIDTH, "Parsed", PROFILE_COLUMN_WIDTH, pParsed->nStringAllocationCount,
+            PROFILE_COLUMN_WIDTH, pParsed->nArrayAllocationCount, PROFILE_COLUMN_WIDTH, pParsed->nRecordAllocationCount,
+            PROFILE_COLUMN_WIDTH, pParsed->nBufferAllocationCount);
+    fprintf(pStream, "\n%-*s%*d%*d%*d%*d", PROFILE_NAME_WIDTH, "Freed", PROFILE_COLUMN_WIDTH, pFreed->nStringAllocationCount,
+            PROFILE_COLUMN_WIDTH, pFreed->nArrayAllocationCount, PROFILE_COLUMN_WIDTH, pFreed->nRecordAllocationCount,
+            PROFILE_COLUMN_WIDTH, pFreed->nBufferAllocationCount);
+
+    // Peaks only grow, so the last snapshot holds the peak of the whole run
+    fprintf(pStream, "\n%-*s", PROFILE_NAME_WIDTH, "Peak KB");
+    for (int n = 0; n < NUMBER_OF_ALLOCATION_CATEGORIES; n++)
+    {
+        fprintf(pStream, "%*.*f", PROFILE_COLUMN_WIDTH, STATS_PRECISION, pFreed->profile[n].nPeakBytes / BYTES_PER_KILOBYTE);
+    }
+    fprintf(pStream, "\n%-*s%.*f KB", PROFILE_NAME_WIDTH, "Peak", STATS_PRECISION, pFreed->nPeakBytes / BYTES_PER_KILOBYTE);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns an amount per second.
+ *
+ * @param amount The amount counted over the interval.
+ * @param interval The interval in nanoseconds.
+ *
+ * @return The amount per second, or zero for an empty interval.
+ */
+double get_rate(double amount, long long interval)
+{
+    return (interval > 0) ? amount * NANOSECONDS_PER_SECOND / interval : 0;
+}
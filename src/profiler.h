@@ -0,0 +1,44 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+// Phase timing points. With profiling off at run time a point costs one predictable
+// branch; building with -DPROFILING_DISABLED removes the points completely.
+#ifndef PROFILING_DISABLED
+#define PROFILE_START(pContext, start) \
+    long long start = ((pContext)->profiler.isEnabled == TRUE) ? get_monotonic_time() : 0
+#define PROFILE_STOP(pContext, phase, start)                        \
+    do                                                              \
+    {                                                               \
+        if ((pContext)->profiler.isEnabled == TRUE)                 \
+        {                                                           \
+            add_phase_time(&(pContext)->profiler, (phase), (start)); \
+        }                                                           \
+    } while (FALSE)
+#define PROFILE_ADD(pContext, counter, amount)       \
+    do                                               \
+    {                                                \
+        if ((pContext)->profiler.isEnabled == TRUE)  \
+        {                                            \
+            (pContext)->profiler.counter += (amount); \
+        }                                            \
+    } while (FALSE)
+#else
+#define PROFILE_START(pContext, start)
+#define PROFILE_STOP(pContext, phase, start)
+#define PROFILE_ADD(pContext, counter, amount)
+#endif
+
+extern const char *const PHASE_NAMES[];
+
+long long get_monotonic_time(void);
+
+ReturnStatus start_profiler(Profiler *);
+ReturnStatus add_phase_time(Profiler *, Phase, long long);
+ReturnStatus merge_profiler(Profiler *, const Profiler *);
+ReturnStatus write_profile_report(const Profiler *, FILE *);
+
+#endif // PROFILER_H
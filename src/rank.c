@@ -0,0 +1,450 @@
+/**
+ * @file rank.c
+ * @brief Top and bottom students by weighted score without sorting the class.
+ *
+ * A report of the best 100 students, or of the 5 percent at risk, needs only those
+ * students in order, not the whole class. Each list is selected in one pass over the
+ * student table with a bounded binary heap of 'k' records whose root is the record ranked
+ * last among those kept: a record that ranks before the root replaces it and sinks to its
+ * place, any other record is passed over after one comparison. This takes O(n log k) time
+ * and O(k) memory, and the heap is then sorted in place into rank order.
+ *
+ * Students are ranked by weighted score in hundredths, as the score is written, highest
+ * first for the top list and lowest first for the bottom list. Equal scores are ordered by
+ * name, so the lists do not depend on the order of the roster or of the student table.
+ */
+
+// Library includes
+#include <limits.h> // for INT_MAX
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h> // for strtol and strtod
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "memory.h"
+#include "rank.h"
+#include "writer.h"
+
+// Function declaration
+ReturnStatus select_ranked_students(GradingContext *, Boolean, int, Record ***, int *);
+Boolean is_ranked_before(const Record *, const Record *, Boolean);
+void sift_up(Record **, int, Boolean);
+void sift_down(Record **, int, int, Boolean);
+void write_json_name(FILE *, const char *);
+
+/**
+ * @brief Reads the size of a top or bottom list from an option value.
+ *
+ * @param pValue A count such as '100', or a percent of the class such as '5%'.
+ * @param pSize Pointer that receives the size.
+ * @return SUCCESS if the value is a positive count or a percent above 0 and up to 100,
+ *         otherwise FAILURE.
+ */
+ReturnStatus parse_rank_size(const char *pValue, RankSize *pSize)
+{
+    char *pEnd = NULL;
+
+    *pSize = (RankSize){0};
+
+    if (strchr(pValue, RANK_PERCENT_CHAR) != NULL)
+    {
+        double percent = strtod(pValue, &pEnd);
+        if (pEnd == pValue || *pEnd != RANK_PERCENT_CHAR || pEnd[1] != STRING_TERMINATION || !(percent > 0) ||
+            percent > PERCENT_SCALE)
+        {
+            return FAILURE;
+        }
+        pSize->percent = percent;
+        return SUCCESS;
+    }
+
+    long nCount = strtol(pValue, &pEnd, 10);
+    if (pEnd == pValue || *pEnd != STRING_TERMINATION || nCount <= 0 || nCount > INT_MAX)
+    {
+        return FAILURE;
+    }
+    pSize->nCount = (int)nCount;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the number of students of a top or bottom list for a class.
+ *
+ * A percent is rounded up, so any class of at least one student lists at least one.
+ *
+ * @param pSize The size of the list.
+ * @param nStudents Number of students in the class.
+ * @return Number of students to list, at most the size of the class.
+ */
+int get_rank_count(const RankSize *pSize, int nStudents)
+{
+    int nCount = pSize->nCount;
+
+    if (pSize->percent > 0)
+    {
+        nCount = (int)ceil(nStudents * pSize->percent / PERCENT_SCALE);
+    }
+
+    return (nCount < nStudents) ? nCount : nStudents;
+}
+
+/**
+ * @brief Selects the top and bottom students of the graded student table.
+ *
+ * Replaces the ranking of the context. The lists point at the records of the table and
+ * are valid until the table changes.
+ *
+ * @param pContext The grading context that owns the graded student table.
+ * @param nTop Number of students with the highest weighted scores, zero for none.
+ * @param nBottom Number of students with the lowest weighted scores, zero for none.
+ * @return SUCCESS if the students are ranked, otherwise FAILURE.
+ */
+ReturnStatus rank_students(GradingContext *pContext, int nTop, int nBottom)
+{
+    StudentRanking *pRanking = &pContext->ranking;
+
+    clear_student_ranking(pContext);
+
+    if (select_ranked_students(pContext, TRUE, nTop, &pRanking->top, &pRanking->nTop) != SUCCESS ||
+        select_ranked_students(pContext, FALSE, nBottom, &pRanking->bottom, &pRanking->nBottom) != SUCCESS)
+    {
+        clear_student_ranking(pContext);
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Releases the top and bottom lists of a context.
+ *
+ * @param pContext The grading context that owns the lists.
+ * @return SUCCESS after the lists are released.
+ */
+ReturnStatus clear_student_ranking(GradingContext *pContext)
+{
+    StudentRanking *pRanking = &pContext->ranking;
+
+    clear_buffer_memory(pContext, pRanking->top);
+    clear_buffer_memory(pContext, pRanking->bottom);
+    *pRanking = (StudentRanking){0};
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Displays the top and bottom lists as a section of the class statistics.
+ *
+ * @param pContext The grading context that owns the ranking.
+ * @param pStream The stream that receives the report.
+ * @return SUCCESS after the lists are displayed, nothing is shown for empty lists.
+ */
+ReturnStatus show_student_ranking(GradingContext *pContext, FILE *pStream)
+{
+    const StudentRanking *pRanking = &pContext->ranking;
+
+    if (pRanking->nTop > 0)
+    {
+        fprintf(pStream, MSG_SHOW_TOP_HEADER, pRanking->nTop);
+        for (int n = 0; n < pRanking->nTop; n++)
+        {
+            const Record *record = pRanking->top[n];
+            fprintf(pStream, RANK_STUDENT_FORMAT, RANK_WIDTH, n + 1, NAME_WIDTH, record->name, STATS_COLUMN_WIDTH,
+                    STATS_PRECISION, record->weightedScore, GRADE_WIDTH, record->grade);
+        }
+    }
+
+    if (pRanking->nBottom > 0)
+    {
+        fprintf(pStream, MSG_SHOW_BOTTOM_HEADER, pRanking->nBottom);
+        for (int n = 0; n < pRanking->nBottom; n++)
+        {
+            const Record *record = pRanking->bottom[n];
+            fprintf(pStream, RANK_STUDENT_FORMAT, RANK_WIDTH, n + 1, NAME_WIDTH, record->name, STATS_COLUMN_WIDTH,
+                    STATS_PRECISION, record->weightedScore, GRADE_WIDTH, record->grade);
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the top and bottom lists as rows of the CSV class statistics.
+ *
+ * Each student is one 'Top,name,score' or 'Bottom,name,score' row, in rank order.
+ *
+ * @param pContext The grading context that owns the ranking.
+ * @param pStream The stream that receives the rows.
+ * @return SUCCESS after the rows are written.
+ */
+ReturnStatus write_ranking_csv(GradingContext *pContext, FILE *pStream)
+{
+    const StudentRanking *pRanking = &pContext->ranking;
+
+    for (int n = 0; n < pRanking->nTop; n++)
+    {
+        fprintf(pStream, "%s,%s,%.*f\n", STAT_NAME_TOP, pRanking->top[n]->name, STATS_PRECISION,
+                pRanking->top[n]->weightedScore);
+    }
+    for (int n = 0; n < pRanking->nBottom; n++)
+    {
+        fprintf(pStream, "%s,%s,%.*f\n", STAT_NAME_BOTTOM, pRanking->bottom[n]->name, STATS_PRECISION,
+                pRanking->bottom[n]->weightedScore);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the top and bottom lists as members of the JSON class statistics.
+ *
+ * Writes ',"top":[...]' and ',"bottom":[...]' for the lists that are not empty, to be
+ * placed before the closing brace of the statistics object.
+ *
+ * @param pContext The grading context that owns the ranking.
+ * @param pStream The stream that receives the members.
+ * @return SUCCESS after the members are written.
+ */
+ReturnStatus write_ranking_json(GradingContext *pContext, FILE *pStream)
+{
+    const StudentRanking *pRanking = &pContext->ranking;
+    const char *const ppKeys[] = {RANK_LIST_NAME_TOP, RANK_LIST_NAME_BOTTOM};
+    Record *const *lists[] = {pRanking->top, pRanking->bottom};
+    const int counts[] = {pRanking->nTop, pRanking->nBottom};
+
+    for (int list = 0; list < 2; list++)
+    {
+        if (counts[list] == 0)
+        {
+            continue;
+        }
+
+        fprintf(pStream, ",\"%s\":[", ppKeys[list]);
+        for (int n = 0; n < counts[list]; n++)
+        {
+            const Record *record = lists[list][n];
+            fprintf(pStream, "%s{\"name\":", (n > 0) ? "," : "");
+            write_json_name(pStream, record->name);
+            fprintf(pStream, ",\"score\":%.*f,\"grade\":\"%c\"}", STATS_PRECISION, record->weightedScore, record->grade);
+        }
+        fputc(']', pStream);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the top and bottom lists to a CSV file.
+ *
+ * Each student is one 'list,rank,name,score,grade' row, the top list first.
+ *
+ * @param pContext The grading context that owns the ranking and reports errors.
+ * @param pFileName Name of the file to write.
+ * @return SUCCESS if the file is written, otherwise FAILURE.
+ */
+ReturnStatus write_ranking_file(GradingContext *pContext, const char *pFileName)
+{
+    const StudentRanking *pRanking = &pContext->ranking;
+    FILE *pFile = NULL;
+
+    if (open_file_in_write_mode(pContext, &pFile, pFileName) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    fprintf(pFile, RANK_CSV_HEADER);
+    for (int n = 0; n < pRanking->nTop; n++)
+    {
+        const Record *record = pRanking->top[n];
+        fprintf(pFile, "%s,%d,%s,%.*f,%c\n", RANK_LIST_NAME_TOP, n + 1, record->name, STATS_PRECISION,
+                record->weightedScore, record->grade);
+    }
+    for (int n = 0; n < pRanking->nBottom; n++)
+    {
+        const Record *record = pRanking->bottom[n];
+        fprintf(pFile, "%s,%d,%s,%.*f,%c\n", RANK_LIST_NAME_BOTTOM, n + 1, record->name, STATS_PRECISION,
+                record->weightedScore, record->grade);
+    }
+
+    if (ferror(pFile))
+    {
+        fclose(pFile);
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, pFileName);
+        return FAILURE;
+    }
+
+    return close_file(pContext, &pFile);
+}
+
+/**
+ * @brief Selects the students ranked first with a bounded heap.
+ *
+ * @param pContext The grading context that owns the student table and the list.
+ * @param isTop TRUE to rank the highest weighted scores first, FALSE for the lowest.
+ * @param nCount Number of students to select, zero for none.
+ * @param pppSelected Pointer that receives the selected students in rank order, or NULL.
+ * @param pnSelected Pointer that receives the number of selected students.
+ * @return SUCCESS if the students are selected, FAILURE if memory is exhausted.
+ */
+ReturnStatus select_ranked_students(GradingContext *pContext, Boolean isTop, int nCount, Record ***pppSelected,
+                                    int *pnSelected)
+{
+    Record **heap = NULL;
+    int nHeap = 0;
+
+    *pppSelected = NULL;
+    *pnSelected = 0;
+    nCount = (nCount < pContext->table.nStudents) ? nCount : pContext->table.nStudents;
+    if (nCount <= 0)
+    {
+        return SUCCESS;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&heap, nCount * sizeof(Record *)) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    // Keep the 'nCount' students ranked first, the one ranked last among them at the root
+    for (Record *current = pContext->table.head; current != NULL; current = current->next)
+    {
+        if (nHeap < nCount)
+        {
+            heap[nHeap] = current;
+            sift_up(heap, nHeap, isTop);
+            nHeap++;
+        }
+        else if (is_ranked_before(current, heap[0], isTop) == TRUE)
+        {
+            heap[0] = current;
+            sift_down(heap, 0, nHeap, isTop);
+        }
+    }
+
+    // Move the root to the end of the shrinking heap, which leaves the list in rank order
+    for (int n = nHeap - 1; n > 0; n--)
+    {
+        Record *last = heap[0];
+        heap[0] = heap[n];
+        heap[n] = last;
+        sift_down(heap, 0, n, isTop);
+    }
+
+    *pppSelected = heap;
+    *pnSelected = nHeap;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Tells whether one student ranks before another.
+ *
+ * Scores are compared in hundredths, so scores written the same are ordered by name.
+ *
+ * @param a The first student.
+ * @param b The second student.
+ * @param isTop TRUE if higher weighted scores rank first, FALSE if lower ones do.
+ * @return TRUE if 'a' ranks before 'b', FALSE if it ranks after or they are equal.
+ */
+Boolean is_ranked_before(const Record *a, const Record *b, Boolean isTop)
+{
+    long scoreA = get_score_hundredths(a->weightedScore);
+    long scoreB = get_score_hundredths(b->weightedScore);
+
+    if (scoreA != scoreB)
+    {
+        return ((scoreA > scoreB) == (isTop == TRUE)) ? TRUE : FALSE;
+    }
+
+    return (strcmp(a->name, b->name) < 0) ? TRUE : FALSE;
+}
+
+/**
+ * @brief Moves a new heap entry up until its parent ranks after it.
+ *
+ * @param heap The heap, the entry ranked last at the root.
+ * @param n Position of the new entry.
+ * @param isTop TRUE if higher weighted scores rank first.
+ */
+void sift_up(Record **heap, int n, Boolean isTop)
+{
+    while (n > 0)
+    {
+        int parent = (n - 1) / 2;
+        if (is_ranked_before(heap[parent], heap[n], isTop) == FALSE)
+        {
+            break;
+        }
+        Record *entry = heap[parent];
+        heap[parent] = heap[n];
+        heap[n] = entry;
+        n = parent;
+    }
+}
+
+/**
+ * @brief Moves a heap entry down until both children rank before it.
+ *
+ * @param heap The heap, the entry ranked last at the root.
+ * @param n Position of the entry.
+ * @param nHeap Number of entries in the heap.
+ * @param isTop TRUE if higher weighted scores rank first.
+ */
+void sift_down(Record **heap, int n, int nHeap, Boolean isTop)
+{
+    for (;;)
+    {
+        int child = 2 * n + 1;
+        if (child >= nHeap)
+        {
+            break;
+        }
+        // Follow the child ranked last
+        if (child + 1 < nHeap && is_ranked_before(heap[child], heap[child + 1], isTop) == TRUE)
+        {
+            child++;
+        }
+        if (is_ranked_before(heap[n], heap[child], isTop) == FALSE)
+        {
+            break;
+        }
+        Record *entry = heap[child];
+        heap[child] = heap[n];
+        heap[n] = entry;
+        n = child;
+    }
+}
+
+/**
+ * @brief Writes a student name as a JSON string.
+ *
+ * Quotes, backslashes and control characters are escaped.
+ *
+ * @param pStream The stream that receives the string.
+ * @param pName The name.
+ */
+void write_json_name(FILE *pStream, const char *pName)
+{
+    fputc('"', pStream);
+    for (const unsigned char *p = (const unsigned char *)pName; *p != STRING_TERMINATION; p++)
+    {
+        if (*p == '"' || *p == '\\')
+        {
+            fputc('\\', pStream);
+            fputc(*p, pStream);
+        }
+        else if (*p < 0x20)
+        {
+            fprintf(pStream, "\\u%04x", *p);
+        }
+        else
+        {
+            fputc(*p, pStream);
+        }
+    }
+    fputc('"', pStream);
+}
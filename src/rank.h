@@ -0,0 +1,17 @@
+#ifndef RANK_H
+#define RANK_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus parse_rank_size(const char *, RankSize *);
+int get_rank_count(const RankSize *, int);
+ReturnStatus rank_students(GradingContext *, int, int);
+ReturnStatus clear_student_ranking(GradingContext *);
+ReturnStatus show_student_ranking(GradingContext *, FILE *);
+ReturnStatus write_ranking_csv(GradingContext *, FILE *);
+ReturnStatus write_ranking_json(GradingContext *, FILE *);
+ReturnStatus write_ranking_file(GradingContext *, const char *);
+
+#endif // RANK_H
@@ -0,0 +1,637 @@
+/**
+ * @file readahead.c
+ * @brief Asynchronous read-ahead of input files for the line reader.
+ *
+ * A blocking 'read' stalls the parser for the whole latency of the storage, which is long
+ * on network file systems and cold disks. The read-ahead keeps 'READ_AHEAD_BLOCK_COUNT'
+ * reads of 'READ_AHEAD_BLOCK_SIZE' bytes in flight at increasing offsets of the file, so
+ * the storage works on the next blocks while the parser works on the current one. Each
+ * block is a ring slot: once the parser has taken all of its bytes, the read of the block
+ * 'READ_AHEAD_BLOCK_COUNT' further on is issued into it.
+ *
+ * On Linux the reads are submitted to an io_uring, which runs them all at once without a
+ * thread of ours. Where io_uring is missing or not allowed, as in many containers, a
+ * read-ahead thread reads the blocks one after the other with 'pread' and the parser waits
+ * only when it has caught up with it. Only regular files are read ahead: their reads never
+ * block for good and can be issued at any offset. Pipes and terminals are read directly.
+ */
+
+// Feature macros, for 'syscall' and 'MAP_POPULATE' next to the POSIX interfaces
+#define _DEFAULT_SOURCE
+
+// Library includes
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h> // for malloc and free
+#include <stdint.h> // for uintptr_t
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h> // for pread and lseek
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define READ_AHEAD_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+// Code includes
+#include "context.h"
+#include "memory.h"
+#include "readahead.h"
+
+#ifdef READ_AHEAD_IO_URING
+// Define the rings shared with the kernel
+typedef struct
+{
+    int descriptor;               // Ring file descriptor, -1 without a ring
+    void *pSubmitRing;            // Mapped submission ring
+    size_t nSubmitRingSize;       // Bytes of the submission ring mapping
+    void *pCompleteRing;          // Mapped completion ring, the submission ring if mapped once
+    size_t nCompleteRingSize;     // Bytes of the completion ring mapping
+    struct io_uring_sqe *entries; // Mapped submission queue entries
+    unsigned *pSubmitTail;        // Tail of the submission ring
+    unsigned *pSubmitArray;       // Entry index of each submission ring slot
+    unsigned submitMask;          // Mask of submission ring positions
+    unsigned *pCompleteHead;      // Head of the completion ring
+    unsigned *pCompleteTail;      // Tail of the completion ring
+    unsigned completeMask;        // Mask of completion ring positions
+    struct io_uring_cqe *events;  // Completion queue events
+} SubmissionRing;
+#endif
+
+// Define read-ahead state
+struct read_ahead
+{
+    int descriptor;                               // File being read
+    long long nStart;                             // File offset of the first block
+    char *blocks[READ_AHEAD_BLOCK_COUNT];         // Ring of block buffers
+    long nBlockBytes[READ_AHEAD_BLOCK_COUNT];     // Bytes read into each slot, -1 while its read is in flight
+    int blockError[READ_AHEAD_BLOCK_COUNT];       // Error number of a failed read of each slot
+    long long nCurrent;                           // Block the parser takes bytes from
+    long nTaken;                                  // Bytes of the current block already taken
+    Boolean isEndSeen;                            // TRUE once a block ended before its full size
+    Boolean isThread;                             // TRUE when the read-ahead thread reads the blocks
+    pthread_t thread;                             // Read-ahead thread
+    pthread_mutex_t lock;                         // Protects the slots and 'nCurrent' in thread mode
+    pthread_cond_t blockReady;                    // Signaled when a block has been read
+    pthread_cond_t blockFree;                     // Signaled when the parser releases a block
+    Boolean isStopping;                           // TRUE to stop the read-ahead thread
+#ifdef READ_AHEAD_IO_URING
+    SubmissionRing ring;                          // io_uring of the reads in flight
+    struct iovec vectors[READ_AHEAD_BLOCK_COUNT]; // Buffer of the read of each slot
+    int nInFlight;                                // Reads submitted and not completed
+#endif
+};
+
+// Function declaration
+long fill_block(int, char *, long long, long, int *);
+void *read_ahead_thread(void *);
+ReturnStatus wait_for_block(ReadAhead *, int);
+void release_block(ReadAhead *, int);
+#ifdef READ_AHEAD_IO_URING
+ReturnStatus open_submission_ring(ReadAhead *);
+void close_submission_ring(ReadAhead *);
+ReturnStatus submit_block_read(ReadAhead *, long long);
+ReturnStatus reap_block_reads(ReadAhead *, Boolean);
+#endif
+
+/**
+ * @brief Starts reading a file ahead of the parser.
+ *
+ * Nothing is read ahead when the mode is 'READ_AHEAD_OFF' or the descriptor is not a
+ * regular file; the reader then reads the descriptor directly. Reading starts at the
+ * current offset of the descriptor.
+ *
+ * @param pContext The grading context that owns the block buffers.
+ * @param ppReadAhead Pointer that receives the read-ahead, or NULL when nothing is read ahead.
+ * @param descriptor The file descriptor to read.
+ * @param mode How to read ahead.
+ * @return SUCCESS if the read-ahead is running or not needed, FAILURE if memory is exhausted.
+ */
+ReturnStatus open_read_ahead(GradingContext *pContext, ReadAhead **ppReadAhead, int descriptor, ReadAheadMode mode)
+{
+    struct stat status;
+    long long nStart = lseek(descriptor, 0, SEEK_CUR);
+
+    *ppReadAhead = NULL;
+    if (mode == READ_AHEAD_OFF || fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode) || nStart < 0)
+    {
+        return SUCCESS;
+    }
+
+    ReadAhead *pReadAhead = malloc(sizeof(ReadAhead));
+    if (pReadAhead == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *pReadAhead = (ReadAhead){0};
+    pReadAhead->descriptor = descriptor;
+    pReadAhead->nStart = nStart;
+#ifdef READ_AHEAD_IO_URING
+    pReadAhead->ring.descriptor = -1;
+#endif
+
+    for (int n = 0; n < READ_AHEAD_BLOCK_COUNT; n++)
+    {
+        pReadAhead->nBlockBytes[n] = -1;
+        if (allocate_buffer_memory(pContext, (void **)&pReadAhead->blocks[n], READ_AHEAD_BLOCK_SIZE) != SUCCESS)
+        {
+            close_read_ahead(pContext, &pReadAhead);
+            return FAILURE;
+        }
+    }
+
+#ifdef READ_AHEAD_IO_URING
+    if (mode == READ_AHEAD_AUTO && open_submission_ring(pReadAhead) == SUCCESS)
+    {
+        *ppReadAhead = pReadAhead;
+        return SUCCESS;
+    }
+#endif
+
+    // Read the blocks on a thread of their own
+    pthread_mutex_init(&pReadAhead->lock, NULL);
+    pthread_cond_init(&pReadAhead->blockReady, NULL);
+    pthread_cond_init(&pReadAhead->blockFree, NULL);
+    pReadAhead->isThread = TRUE;
+    if (pthread_create(&pReadAhead->thread, NULL, read_ahead_thread, pReadAhead) != 0)
+    {
+        // Without a thread the file is simply read directly
+        pthread_cond_destroy(&pReadAhead->blockFree);
+        pthread_cond_destroy(&pReadAhead->blockReady);
+        pthread_mutex_destroy(&pReadAhead->lock);
+        pReadAhead->isThread = FALSE;
+        close_read_ahead(pContext, &pReadAhead);
+        return SUCCESS;
+    }
+
+    *ppReadAhead = pReadAhead;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes the next bytes of the file, like 'read'.
+ *
+ * Copies bytes of the current block and waits only when its read is still in flight.
+ *
+ * @param pReadAhead The read-ahead.
+ * @param pBuffer Buffer that receives the bytes.
+ * @param nCapacity Most bytes to take.
+ * @param pnRead Pointer that receives the number of bytes taken, zero at the end of the file.
+ * @return SUCCESS if bytes or the end of the file are returned, FAILURE with 'errno' set if
+ *         a read failed.
+ */
+ReturnStatus read_ahead(ReadAhead *pReadAhead, char *pBuffer, long nCapacity, long *pnRead)
+{
+    int slot = (int)(pReadAhead->nCurrent % READ_AHEAD_BLOCK_COUNT);
+
+    *pnRead = 0;
+    if (wait_for_block(pReadAhead, slot) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    if (pReadAhead->blockError[slot] != 0)
+    {
+        errno = pReadAhead->blockError[slot];
+        return FAILURE;
+    }
+
+    // A block that is taken completely and ended early is the end of the file
+    long nAvailable = pReadAhead->nBlockBytes[slot] - pReadAhead->nTaken;
+    long nCopy = (nAvailable < nCapacity) ? nAvailable : nCapacity;
+    memcpy(pBuffer, pReadAhead->blocks[slot] + pReadAhead->nTaken, nCopy);
+    pReadAhead->nTaken += nCopy;
+    *pnRead = nCopy;
+
+    if (pReadAhead->nTaken == READ_AHEAD_BLOCK_SIZE)
+    {
+        release_block(pReadAhead, slot);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Stops reading ahead and releases the read-ahead.
+ *
+ * Waits for the reads in flight, so no block is written after it is released.
+ *
+ * @param pContext The grading context that owns the block buffers.
+ * @param ppReadAhead Pointer to the read-ahead, set to NULL.
+ * @return SUCCESS after the read-ahead is released.
+ */
+ReturnStatus close_read_ahead(GradingContext *pContext, ReadAhead **ppReadAhead)
+{
+    ReadAhead *pReadAhead = *ppReadAhead;
+
+    if (pReadAhead == NULL)
+    {
+        return SUCCESS;
+    }
+
+    if (pReadAhead->isThread == TRUE)
+    {
+        pthread_mutex_lock(&pReadAhead->lock);
+        pReadAhead->isStopping = TRUE;
+        pthread_cond_signal(&pReadAhead->blockFree);
+        pthread_mutex_unlock(&pReadAhead->lock);
+        pthread_join(pReadAhead->thread, NULL);
+
+        pthread_cond_destroy(&pReadAhead->blockFree);
+        pthread_cond_destroy(&pReadAhead->blockReady);
+        pthread_mutex_destroy(&pReadAhead->lock);
+    }
+#ifdef READ_AHEAD_IO_URING
+    close_submission_ring(pReadAhead);
+#endif
+
+    for (int n = 0; n < READ_AHEAD_BLOCK_COUNT; n++)
+    {
+        clear_buffer_memory(pContext, pReadAhead->blocks[n]);
+    }
+    free(pReadAhead);
+    *ppReadAhead = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reads one block of a file, up to its full size or the end of the file.
+ *
+ * @param descriptor The file.
+ * @param pBlock Buffer of the block.
+ * @param nOffset File offset of the block.
+ * @param nBytes Bytes already in the block.
+ * @param pError Receives the error number of a failed read, zero otherwise.
+ * @return Bytes in the block, short of 'READ_AHEAD_BLOCK_SIZE' only at the end of the file.
+ */
+long fill_block(int descriptor, char *pBlock, long long nOffset, long nBytes, int *pError)
+{
+    *pError = 0;
+    while (nBytes < READ_AHEAD_BLOCK_SIZE)
+    {
+        ssize_t nRead = pread(descriptor, pBlock + nBytes, READ_AHEAD_BLOCK_SIZE - nBytes, nOffset + nBytes);
+        if (nRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (nRead < 0)
+        {
+            *pError = errno;
+            break;
+        }
+        if (nRead == 0)
+        {
+            break;
+        }
+        nBytes += nRead;
+    }
+
+    return nBytes;
+}
+
+/**
+ * @brief Thread that reads the blocks of the file into free ring slots.
+ *
+ * @param pArgument The 'ReadAhead'.
+ * @return NULL once the file is read or the read-ahead stops.
+ */
+void *read_ahead_thread(void *pArgument)
+{
+    ReadAhead *pReadAhead = (ReadAhead *)pArgument;
+
+    for (long long nBlock = 0;; nBlock++)
+    {
+        int slot = (int)(nBlock % READ_AHEAD_BLOCK_COUNT);
+
+        // Wait until the parser has released the slot
+        pthread_mutex_lock(&pReadAhead->lock);
+        while (pReadAhead->isStopping == FALSE && nBlock - pReadAhead->nCurrent >= READ_AHEAD_BLOCK_COUNT)
+        {
+            pthread_cond_wait(&pReadAhead->blockFree, &pReadAhead->lock);
+        }
+        Boolean isStopping = pReadAhead->isStopping;
+        pthread_mutex_unlock(&pReadAhead->lock);
+        if (isStopping == TRUE)
+        {
+            break;
+        }
+
+        int error = 0;
+        long nBytes = fill_block(pReadAhead->descriptor, pReadAhead->blocks[slot],
+                                 pReadAhead->nStart + nBlock * READ_AHEAD_BLOCK_SIZE, 0, &error);
+
+        pthread_mutex_lock(&pReadAhead->lock);
+        pReadAhead->nBlockBytes[slot] = nBytes;
+        pReadAhead->blockError[slot] = error;
+        pthread_cond_signal(&pReadAhead->blockReady);
+        pthread_mutex_unlock(&pReadAhead->lock);
+
+        // The last block ends early or fails
+        if (nBytes < READ_AHEAD_BLOCK_SIZE)
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Waits until the read of a ring slot has completed.
+ *
+ * @param pReadAhead The read-ahead.
+ * @param slot The ring slot of the current block.
+ * @return SUCCESS once the slot holds its block, FAILURE with 'errno' set if the io_uring fails.
+ */
+ReturnStatus wait_for_block(ReadAhead *pReadAhead, int slot)
+{
+    if (pReadAhead->isThread == TRUE)
+    {
+        pthread_mutex_lock(&pReadAhead->lock);
+        while (pReadAhead->nBlockBytes[slot] < 0)
+        {
+            pthread_cond_wait(&pReadAhead->blockReady, &pReadAhead->lock);
+        }
+        pthread_mutex_unlock(&pReadAhead->lock);
+
+        return SUCCESS;
+    }
+
+#ifdef READ_AHEAD_IO_URING
+    while (pReadAhead->nBlockBytes[slot] < 0)
+    {
+        if (reap_block_reads(pReadAhead, TRUE) != SUCCESS)
+        {
+            return FAILURE;
+        }
+    }
+#endif
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Hands the slot of a block that was taken completely back to the read-ahead.
+ *
+ * The slot receives the block 'READ_AHEAD_BLOCK_COUNT' further on, unless the end of the
+ * file was already seen.
+ *
+ * @param pReadAhead The read-ahead.
+ * @param slot The ring slot of the current block.
+ */
+void release_block(ReadAhead *pReadAhead, int slot)
+{
+    if (pReadAhead->isThread == TRUE)
+    {
+        pthread_mutex_lock(&pReadAhead->lock);
+        pReadAhead->nBlockBytes[slot] = -1;
+        pReadAhead->nCurrent++;
+        pReadAhead->nTaken = 0;
+        pthread_cond_signal(&pReadAhead->blockFree);
+        pthread_mutex_unlock(&pReadAhead->lock);
+        return;
+    }
+
+#ifdef READ_AHEAD_IO_URING
+    pReadAhead->nBlockBytes[slot] = -1;
+    pReadAhead->nCurrent++;
+    pReadAhead->nTaken = 0;
+    if (pReadAhead->isEndSeen == FALSE)
+    {
+        // A failed submission is reported when the parser reaches the block
+        if (submit_block_read(pReadAhead, pReadAhead->nCurrent + READ_AHEAD_BLOCK_COUNT - 1) != SUCCESS)
+        {
+            pReadAhead->nBlockBytes[slot] = 0;
+            pReadAhead->blockError[slot] = errno;
+        }
+    }
+    else
+    {
+        // Past the end of the file every block is empty
+        pReadAhead->nBlockBytes[slot] = 0;
+    }
+#endif
+}
+
+#ifdef READ_AHEAD_IO_URING
+/**
+ * @brief Creates an io_uring and submits the reads of the first blocks.
+ *
+ * @param pReadAhead The read-ahead.
+ * @return SUCCESS if the reads are in flight, FAILURE if io_uring is not available.
+ */
+ReturnStatus open_submission_ring(ReadAhead *pReadAhead)
+{
+    SubmissionRing *pRing = &pReadAhead->ring;
+    struct io_uring_params parameters;
+
+    memset(&parameters, 0, sizeof(parameters));
+    pRing->descriptor = (int)syscall(__NR_io_uring_setup, READ_AHEAD_BLOCK_COUNT, &parameters);
+    if (pRing->descriptor < 0)
+    {
+        pRing->descriptor = -1;
+        return FAILURE;
+    }
+
+    // Map the rings, once for both when the kernel allows it
+    pRing->nSubmitRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+    pRing->nCompleteRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+    Boolean isSingleMap = (parameters.features & IORING_FEAT_SINGLE_MMAP) ? TRUE : FALSE;
+    if (isSingleMap == TRUE && pRing->nCompleteRingSize > pRing->nSubmitRingSize)
+    {
+        pRing->nSubmitRingSize = pRing->nCompleteRingSize;
+    }
+
+    pRing->pSubmitRing = mmap(NULL, pRing->nSubmitRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              pRing->descriptor, IORING_OFF_SQ_RING);
+    pRing->pCompleteRing = (isSingleMap == TRUE)
+                               ? pRing->pSubmitRing
+                               : mmap(NULL, pRing->nCompleteRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                      pRing->descriptor, IORING_OFF_CQ_RING);
+    pRing->entries = mmap(NULL, parameters.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, pRing->descriptor, IORING_OFF_SQES);
+    if (pRing->pSubmitRing == MAP_FAILED || pRing->pCompleteRing == MAP_FAILED || pRing->entries == MAP_FAILED)
+    {
+        close_submission_ring(pReadAhead);
+        return FAILURE;
+    }
+
+    char *pSubmitRing = (char *)pRing->pSubmitRing;
+    char *pCompleteRing = (char *)pRing->pCompleteRing;
+    pRing->pSubmitTail = (unsigned *)(pSubmitRing + parameters.sq_off.tail);
+    pRing->pSubmitArray = (unsigned *)(pSubmitRing + parameters.sq_off.array);
+    pRing->submitMask = *(unsigned *)(pSubmitRing + parameters.sq_off.ring_mask);
+    pRing->pCompleteHead = (unsigned *)(pCompleteRing + parameters.cq_off.head);
+    pRing->pCompleteTail = (unsigned *)(pCompleteRing + parameters.cq_off.tail);
+    pRing->completeMask = *(unsigned *)(pCompleteRing + parameters.cq_off.ring_mask);
+    pRing->events = (struct io_uring_cqe *)(pCompleteRing + parameters.cq_off.cqes);
+
+    for (int n = 0; n < READ_AHEAD_BLOCK_COUNT; n++)
+    {
+        pReadAhead->vectors[n].iov_base = pReadAhead->blocks[n];
+        pReadAhead->vectors[n].iov_len = READ_AHEAD_BLOCK_SIZE;
+        if (submit_block_read(pReadAhead, n) != SUCCESS)
+        {
+            // A ring that refuses reads is not used; wait for the reads it took
+            close_submission_ring(pReadAhead);
+            for (int slot = 0; slot < READ_AHEAD_BLOCK_COUNT; slot++)
+            {
+                pReadAhead->nBlockBytes[slot] = -1;
+                pReadAhead->blockError[slot] = 0;
+            }
+            return FAILURE;
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Waits for the reads in flight and releases the io_uring.
+ *
+ * @param pReadAhead The read-ahead.
+ */
+void close_submission_ring(ReadAhead *pReadAhead)
+{
+    SubmissionRing *pRing = &pReadAhead->ring;
+
+    if (pRing->descriptor < 0)
+    {
+        return;
+    }
+
+    // The kernel may still write into the blocks until their reads complete
+    while (pReadAhead->nInFlight > 0 && pRing->events != NULL)
+    {
+        if (reap_block_reads(pReadAhead, TRUE) != SUCCESS && errno != EINTR)
+        {
+            break;
+        }
+    }
+
+    if (pRing->entries != NULL && pRing->entries != MAP_FAILED)
+    {
+        munmap(pRing->entries, READ_AHEAD_BLOCK_COUNT * sizeof(struct io_uring_sqe));
+    }
+    if (pRing->pCompleteRing != NULL && pRing->pCompleteRing != MAP_FAILED && pRing->pCompleteRing != pRing->pSubmitRing)
+    {
+        munmap(pRing->pCompleteRing, pRing->nCompleteRingSize);
+    }
+    if (pRing->pSubmitRing != NULL && pRing->pSubmitRing != MAP_FAILED)
+    {
+        munmap(pRing->pSubmitRing, pRing->nSubmitRingSize);
+    }
+    close(pRing->descriptor);
+    *pRing = (SubmissionRing){0};
+    pRing->descriptor = -1;
+}
+
+/**
+ * @brief Submits the read of one block into its ring slot.
+ *
+ * @param pReadAhead The read-ahead.
+ * @param nBlock Index of the block in the file.
+ * @return SUCCESS if the read is in flight, otherwise FAILURE with 'errno' set.
+ */
+ReturnStatus submit_block_read(ReadAhead *pReadAhead, long long nBlock)
+{
+    SubmissionRing *pRing = &pReadAhead->ring;
+    int slot = (int)(nBlock % READ_AHEAD_BLOCK_COUNT);
+    unsigned tail = *pRing->pSubmitTail;
+    unsigned index = tail & pRing->submitMask;
+    struct io_uring_sqe *pEntry = &pRing->entries[index];
+
+    memset(pEntry, 0, sizeof(*pEntry));
+    pEntry->opcode = IORING_OP_READV;
+    pEntry->fd = pReadAhead->descriptor;
+    pEntry->addr = (unsigned long long)(uintptr_t)&pReadAhead->vectors[slot];
+    pEntry->len = 1;
+    pEntry->off = (unsigned long long)(pReadAhead->nStart + nBlock * READ_AHEAD_BLOCK_SIZE);
+    pEntry->user_data = (unsigned long long)nBlock;
+    pRing->pSubmitArray[index] = index;
+    __atomic_store_n(pRing->pSubmitTail, tail + 1, __ATOMIC_RELEASE);
+
+    long nSubmitted;
+    do
+    {
+        nSubmitted = syscall(__NR_io_uring_enter, pRing->descriptor, 1, 0, 0, NULL, 0);
+    } while (nSubmitted < 0 && errno == EINTR);
+    if (nSubmitted != 1)
+    {
+        if (nSubmitted >= 0)
+        {
+            errno = EIO;
+        }
+        return FAILURE;
+    }
+    pReadAhead->nInFlight++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Records the reads that have completed.
+ *
+ * A read that returns less than a block before the end of the file is completed with
+ * 'pread', so every block is full except the last one.
+ *
+ * @param pReadAhead The read-ahead.
+ * @param isWaiting TRUE to wait for at least one completion when none is ready.
+ * @return SUCCESS after the completions are recorded, otherwise FAILURE with 'errno' set.
+ */
+ReturnStatus reap_block_reads(ReadAhead *pReadAhead, Boolean isWaiting)
+{
+    SubmissionRing *pRing = &pReadAhead->ring;
+    unsigned head = *pRing->pCompleteHead;
+
+    if (head == __atomic_load_n(pRing->pCompleteTail, __ATOMIC_ACQUIRE) && isWaiting == TRUE)
+    {
+        if (syscall(__NR_io_uring_enter, pRing->descriptor, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+        {
+            return FAILURE;
+        }
+    }
+
+    while (head != __atomic_load_n(pRing->pCompleteTail, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe *pEvent = &pRing->events[head & pRing->completeMask];
+        long long nBlock = (long long)pEvent->user_data;
+        int slot = (int)(nBlock % READ_AHEAD_BLOCK_COUNT);
+        int error = 0;
+        long nBytes = 0;
+
+        if (pEvent->res < 0)
+        {
+            error = -pEvent->res;
+        }
+        else
+        {
+            nBytes = pEvent->res;
+            if (nBytes > 0 && nBytes < READ_AHEAD_BLOCK_SIZE)
+            {
+                nBytes = fill_block(pReadAhead->descriptor, pReadAhead->blocks[slot],
+                                    pReadAhead->nStart + nBlock * READ_AHEAD_BLOCK_SIZE, nBytes, &error);
+            }
+        }
+        if (nBytes < READ_AHEAD_BLOCK_SIZE)
+        {
+            pReadAhead->isEndSeen = TRUE;
+        }
+
+        pReadAhead->nBlockBytes[slot] = nBytes;
+        pReadAhead->blockError[slot] = error;
+        pReadAhead->nInFlight--;
+        head++;
+        __atomic_store_n(pRing->pCompleteHead, head, __ATOMIC_RELEASE);
+    }
+
+    return SUCCESS;
+}
+#endif // READ_AHEAD_IO_URING
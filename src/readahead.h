@@ -0,0 +1,12 @@
+#ifndef READAHEAD_H
+#define READAHEAD_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus open_read_ahead(GradingContext *, ReadAhead **, int, ReadAheadMode);
+ReturnStatus read_ahead(ReadAhead *, char *, long, long *);
+ReturnStatus close_read_ahead(GradingContext *, ReadAhead **);
+
+#endif // READAHEAD_H
@@ -0,0 +1,271 @@
+/**
+ * @file reject.c
+ * @brief Rejects file and bounded diagnostics of error tolerant parsing.
+ *
+ * With '--skip-invalid' a row that a strict run would fail on is set aside instead: it is
+ * appended to a CSV rejects file with its line number, a reason code, a readable detail and
+ * the row itself, and parsing goes on with the next line. The rejects file is written
+ * through the buffered stream, so a run with many invalid rows still writes in large blocks.
+ * Nothing is printed per row; the log keeps the first 'REJECT_DIAGNOSTIC_COUNT' diagnostics
+ * and counts the rest by reason, and the summary is reported once parsing is done.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "reject.h"
+
+// Function declaration
+ReturnStatus write_reject_field(FILE *, const char *);
+
+// Reason codes written to the rejects file, in the order of 'RejectReason'
+const char *const REJECT_REASON_CODES[] = {"name_empty", "score_range", "score_count"};
+
+/**
+ * @brief Creates a reject log and opens its rejects file.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param ppLog Pointer that receives the log.
+ * @param pFileName Name of the rejects file.
+ * @return SUCCESS if the rejects file is open and has its header row, otherwise FAILURE.
+ */
+ReturnStatus open_reject_log(GradingContext *pContext, RejectLog **ppLog, const char *pFileName)
+{
+    RejectLog *pLog = malloc(sizeof(RejectLog));
+    if (pLog == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *pLog = (RejectLog){0};
+    pLog->pFileName = pFileName;
+
+    if (open_file_in_write_mode(pContext, &pLog->pFile, pFileName) != SUCCESS)
+    {
+        free(pLog);
+        return FAILURE;
+    }
+
+    fputs(REJECT_FILE_HEADER, pLog->pFile);
+    *ppLog = pLog;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Creates a reject log for one part of a roster parsed in parallel.
+ *
+ * The part writes its rows to an anonymous temporary file, with line numbers counted from
+ * the start of the part, until 'merge_reject_log' appends them to the rejects file.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param ppLog Pointer that receives the log.
+ * @param pFileName Name of the rejects file the part is merged into.
+ * @return SUCCESS if the temporary file is open, otherwise FAILURE.
+ */
+ReturnStatus open_reject_part(GradingContext *pContext, RejectLog **ppLog, const char *pFileName)
+{
+    RejectLog *pLog = malloc(sizeof(RejectLog));
+    if (pLog == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *pLog = (RejectLog){0};
+    pLog->pFileName = pFileName;
+
+    pLog->pFile = tmpfile();
+    if (pLog->pFile == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_OPEN_WRITE, pFileName);
+        free(pLog);
+        return FAILURE;
+    }
+    *ppLog = pLog;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends a part of a roster parsed in parallel to the reject log of the roster.
+ *
+ * The rows of the part are copied to the rejects file with their line numbers moved past
+ * the lines of the earlier parts, and its counts and diagnostics are added while the
+ * bounded diagnostic buffer has room. The part is released.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param pLog The reject log of the roster.
+ * @param ppPart Pointer to the log of the part, set to NULL.
+ * @param nLineOffset Lines of the roster before the part.
+ * @return SUCCESS if the rows of the part are appended, otherwise FAILURE.
+ */
+ReturnStatus merge_reject_log(GradingContext *pContext, RejectLog *pLog, RejectLog **ppPart, long nLineOffset)
+{
+    RejectLog *pPart = *ppPart;
+    char block[REJECT_COPY_BUFFER_SIZE];
+    Boolean isLineStart = TRUE;
+
+    // Every row is one line that starts with its line number
+    rewind(pPart->pFile);
+    while (fgets(block, sizeof(block), pPart->pFile) != NULL)
+    {
+        const char *pRest = block;
+        if (isLineStart == TRUE)
+        {
+            char *pNumberEnd = NULL;
+            long lineNumber = strtol(block, &pNumberEnd, 10);
+            fprintf(pLog->pFile, "%ld", lineNumber + nLineOffset);
+            pRest = pNumberEnd;
+        }
+        fputs(pRest, pLog->pFile);
+        isLineStart = (strchr(block, END_OF_LINE_CHAR) != NULL) ? TRUE : FALSE;
+    }
+
+    pLog->nRejected += pPart->nRejected;
+    for (int n = 0; n < NUMBER_OF_REJECT_REASONS; n++)
+    {
+        pLog->reasonCount[n] += pPart->reasonCount[n];
+    }
+    for (int n = 0; n < pPart->nDiagnostics && pLog->nDiagnostics < REJECT_DIAGNOSTIC_COUNT; n++)
+    {
+        pLog->diagnostics[pLog->nDiagnostics] = pPart->diagnostics[n];
+        pLog->diagnostics[pLog->nDiagnostics].lineNumber += nLineOffset;
+        pLog->nDiagnostics++;
+    }
+
+    return close_reject_log(pContext, ppPart);
+}
+
+/**
+ * @brief Closes the rejects file and releases the log.
+ *
+ * A read or write error on the file of the log is reported as a failure to write the
+ * rejects file.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param ppLog Pointer to the log, set to NULL.
+ * @return SUCCESS if every rejected row reached the file, otherwise FAILURE.
+ */
+ReturnStatus close_reject_log(GradingContext *pContext, RejectLog **ppLog)
+{
+    RejectLog *pLog = *ppLog;
+    ReturnStatus status = SUCCESS;
+
+    if (pLog == NULL)
+    {
+        return SUCCESS;
+    }
+
+    Boolean isWriteFailed = (ferror(pLog->pFile) != 0) ? TRUE : FALSE;
+    if (close_file(pContext, &pLog->pFile) != SUCCESS)
+    {
+        status = FAILURE;
+    }
+    else if (isWriteFailed == TRUE)
+    {
+        report_error(pContext, ERROR_CLASS_OUTPUT, ERR_FILE_WRITE, pLog->pFileName);
+        status = FAILURE;
+    }
+
+    free(pLog);
+    *ppLog = NULL;
+
+    return status;
+}
+
+/**
+ * @brief Sets an invalid row aside.
+ *
+ * The row is appended to the rejects file and counted. Its diagnostic is kept while the
+ * bounded diagnostic buffer has room.
+ *
+ * @param pLog The reject log.
+ * @param pDiagnostic Line number, reason and detail of the row.
+ * @param pRow The row as read from the input.
+ * @return SUCCESS after the row is logged.
+ */
+ReturnStatus add_rejected_row(RejectLog *pLog, const RejectDiagnostic *pDiagnostic, const char *pRow)
+{
+    fprintf(pLog->pFile, "%ld,%s,", pDiagnostic->lineNumber, REJECT_REASON_CODES[pDiagnostic->reason]);
+    write_reject_field(pLog->pFile, pDiagnostic->message);
+    fputc(COMMA_CHAR, pLog->pFile);
+    write_reject_field(pLog->pFile, pRow);
+    fputc(END_OF_LINE_CHAR, pLog->pFile);
+
+    pLog->nRejected++;
+    pLog->reasonCount[pDiagnostic->reason]++;
+    if (pLog->nDiagnostics < REJECT_DIAGNOSTIC_COUNT)
+    {
+        pLog->diagnostics[pLog->nDiagnostics++] = *pDiagnostic;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Reports how many rows were skipped and why.
+ *
+ * One warning gives the counts by reason and the rejects file, followed by the kept
+ * diagnostics and the number of rows not shown. Nothing is reported when no row was skipped.
+ *
+ * @param pContext The grading context that reports the warning.
+ * @param pLog The reject log.
+ * @return SUCCESS after the summary is reported.
+ */
+ReturnStatus report_rejected_rows(GradingContext *pContext, const RejectLog *pLog)
+{
+    if (pLog->nRejected == 0)
+    {
+        return SUCCESS;
+    }
+
+    report_message(pContext, WARNING_ROWS_REJECTED, pLog->nRejected, pLog->reasonCount[REJECT_REASON_NAME_EMPTY],
+                   pLog->reasonCount[REJECT_REASON_SCORE_RANGE], pLog->reasonCount[REJECT_REASON_SCORE_COUNT],
+                   pLog->pFileName);
+    for (int n = 0; n < pLog->nDiagnostics; n++)
+    {
+        report_message(pContext, WARNING_ROW_REJECTED, pLog->diagnostics[n].lineNumber, pLog->diagnostics[n].message);
+    }
+    if (pLog->nRejected > pLog->nDiagnostics)
+    {
+        report_message(pContext, WARNING_MORE_ROWS_REJECTED, pLog->nRejected - pLog->nDiagnostics);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes one field of the rejects file.
+ *
+ * A field with a comma, a quote or a line break is quoted and its quotes are doubled.
+ *
+ * @param pFile The rejects file.
+ * @param pField The field text.
+ * @return SUCCESS after the field is written.
+ */
+ReturnStatus write_reject_field(FILE *pFile, const char *pField)
+{
+    if (pField[strcspn(pField, ",\"\r\n")] == STRING_TERMINATION)
+    {
+        fputs(pField, pFile);
+        return SUCCESS;
+    }
+
+    fputc('"', pFile);
+    for (const char *pChar = pField; *pChar != STRING_TERMINATION; pChar++)
+    {
+        if (*pChar == '"')
+        {
+            fputc('"', pFile);
+        }
+        fputc(*pChar, pFile);
+    }
+    fputc('"', pFile);
+
+    return SUCCESS;
+}
@@ -0,0 +1,15 @@
+#ifndef REJECT_H
+#define REJECT_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus open_reject_log(GradingContext *, RejectLog **, const char *);
+ReturnStatus open_reject_part(GradingContext *, RejectLog **, const char *);
+ReturnStatus merge_reject_log(GradingContext *, RejectLog *, RejectLog **, long);
+ReturnStatus close_reject_log(GradingContext *, RejectLog **);
+ReturnStatus add_rejected_row(RejectLog *, const RejectDiagnostic *, const char *);
+ReturnStatus report_rejected_rows(GradingContext *, const RejectLog *);
+
+#endif // REJECT_H
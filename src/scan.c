@@ -0,0 +1,254 @@
+/**
+ * @file scan.c
+ * @brief Structural scanner that classifies 64 bytes of CSV at a time.
+ *
+ * The line reader and the tokenizer look for the same few characters: the comma between
+ * fields, the newline and carriage return between lines and the terminator of a string.
+ * Instead of testing one byte at a time, the scanner compares a block of 'SCAN_BLOCK_SIZE'
+ * bytes against a character in a few vector instructions and returns a 64 bit mask with bit
+ * n set when byte n matches. Callers then walk the set bits, so a line of fields costs one
+ * mask and one bit search per field instead of a comparison per byte.
+ *
+ * The vector width is chosen when compiling: AVX2 compares 32 bytes per instruction when the
+ * compiler targets it (for example 'make CPPFLAGS=-mavx2'), SSE2 compares 16 bytes and is
+ * always available on x86-64, and other processors use a portable loop that gives the same
+ * masks. Blocks are read with unaligned loads and must be fully readable; the helpers that
+ * take a length copy a short last block into a zero filled buffer first.
+ */
+
+// Library includes
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Code includes
+#include "scan.h"
+
+// Function declaration
+const char *get_readable_block(const char *, long, char *);
+
+/**
+ * @brief Finds the bytes of a block that equal a character.
+ *
+ * @param pBlock Start of 'SCAN_BLOCK_SIZE' readable bytes.
+ * @param character The character to find.
+ * @return Mask with bit n set when byte n of the block equals the character.
+ */
+uint64_t get_character_mask(const char *pBlock, char character)
+{
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(character);
+    uint64_t low = (uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)pBlock), needle));
+    uint64_t high = (uint32_t)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(pBlock + 32)), needle));
+
+    return low | (high << 32);
+#elif defined(__SSE2__)
+    const __m128i needle = _mm_set1_epi8(character);
+    uint64_t mask = 0;
+
+    for (int n = 0; n < SCAN_BLOCK_SIZE; n += 16)
+    {
+        uint64_t part = (uint16_t)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(pBlock + n)), needle));
+        mask |= part << n;
+    }
+
+    return mask;
+#else
+    uint64_t mask = 0;
+
+    for (int n = 0; n < SCAN_BLOCK_SIZE; n++)
+    {
+        mask |= (uint64_t)(pBlock[n] == character) << n;
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * @brief Finds the bytes of a block that end a field: commas and the string terminator.
+ *
+ * @param pBlock Start of 'SCAN_BLOCK_SIZE' readable bytes.
+ * @return Mask with bit n set when byte n of the block is a comma or a terminator.
+ */
+uint64_t get_field_end_mask(const char *pBlock)
+{
+#if defined(__AVX2__)
+    const __m256i comma = _mm256_set1_epi8(COMMA_CHAR);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i low = _mm256_loadu_si256((const __m256i *)pBlock);
+    __m256i high = _mm256_loadu_si256((const __m256i *)(pBlock + 32));
+    uint64_t lowMask = (uint32_t)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(low, comma), _mm256_cmpeq_epi8(low, zero)));
+    uint64_t highMask = (uint32_t)_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_cmpeq_epi8(high, comma), _mm256_cmpeq_epi8(high, zero)));
+
+    return lowMask | (highMask << 32);
+#elif defined(__SSE2__)
+    const __m128i comma = _mm_set1_epi8(COMMA_CHAR);
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t mask = 0;
+
+    for (int n = 0; n < SCAN_BLOCK_SIZE; n += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *)(pBlock + n));
+        uint64_t part = (uint16_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, comma), _mm_cmpeq_epi8(bytes, zero)));
+        mask |= part << n;
+    }
+
+    return mask;
+#else
+    uint64_t mask = 0;
+
+    for (int n = 0; n < SCAN_BLOCK_SIZE; n++)
+    {
+        mask |= (uint64_t)(pBlock[n] == COMMA_CHAR || pBlock[n] == STRING_TERMINATION) << n;
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * @brief Returns the position of the lowest set bit of a mask.
+ *
+ * @param mask A mask with at least one bit set.
+ * @return Position of the lowest set bit, from 0 to 63.
+ */
+int get_lowest_bit(uint64_t mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(mask);
+#else
+    int position = 0;
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        position++;
+    }
+    return position;
+#endif
+}
+
+/**
+ * @brief Starts a scan for the occurrences of a character in a buffer.
+ *
+ * @param pScan The scan.
+ * @param pData The buffer.
+ * @param nSize Number of bytes in the buffer.
+ * @param character The character to find.
+ */
+void start_character_scan(CharacterScan *pScan, const char *pData, long nSize, char character)
+{
+    pScan->pData = pData;
+    pScan->nSize = nSize;
+    pScan->nBlock = 0;
+    pScan->character = character;
+    pScan->mask = (nSize > 0) ? get_character_mask(get_readable_block(pData, nSize, pScan->spare), character) : 0;
+}
+
+/**
+ * @brief Returns the next occurrence of the character of a scan.
+ *
+ * Works like repeated calls of 'memchr', but every block of the buffer is compared once:
+ * the occurrences of a block are kept as a mask and returned one set bit at a time, so
+ * finding the end of each short line of a roster costs a bit search, not a new scan.
+ *
+ * @param pScan The scan.
+ * @return Pointer to the occurrence after the previous one, or NULL if there are no more.
+ */
+const char *find_next_character(CharacterScan *pScan)
+{
+    while (pScan->mask == 0)
+    {
+        pScan->nBlock += SCAN_BLOCK_SIZE;
+        if (pScan->nBlock >= pScan->nSize)
+        {
+            pScan->nBlock = pScan->nSize;
+            return NULL;
+        }
+        const char *pBlock = get_readable_block(pScan->pData + pScan->nBlock, pScan->nSize - pScan->nBlock, pScan->spare);
+        pScan->mask = get_character_mask(pBlock, pScan->character);
+    }
+
+    int nBit = get_lowest_bit(pScan->mask);
+    pScan->mask &= pScan->mask - 1; // Clear the bit just returned
+
+    return pScan->pData + pScan->nBlock + nBit;
+}
+
+/**
+ * @brief Counts the comma separated fields of a buffer.
+ *
+ * A field is a run of characters other than commas and newlines, so leading, trailing and
+ * repeated commas add no empty fields, as with 'get_next_token'. A field starts at every
+ * byte that is not a separator and follows a separator or the start of the buffer, which is
+ * found for a whole block with one shift of its separator mask. Newlines separate fields
+ * too, so a buffer of many lines gives the fields of all its lines in one pass.
+ *
+ * @param pData The buffer.
+ * @param nSize Number of bytes in the buffer.
+ * @return Number of fields.
+ */
+long count_fields(const char *pData, long nSize)
+{
+    char spare[SCAN_BLOCK_SIZE]; // Zero filled copy of a short last block
+    uint64_t carry = 1;          // The byte before the block ends a field
+    long nFields = 0;
+
+    for (long nOffset = 0; nOffset < nSize; nOffset += SCAN_BLOCK_SIZE)
+    {
+        long nBytes = nSize - nOffset;
+        const char *pBlock = get_readable_block(pData + nOffset, nBytes, spare);
+        uint64_t separator = get_character_mask(pBlock, COMMA_CHAR) | get_character_mask(pBlock, END_OF_LINE_CHAR);
+        uint64_t starts = ~separator & ((separator << 1) | carry);
+        if (nBytes < SCAN_BLOCK_SIZE)
+        {
+            starts &= (1ULL << nBytes) - 1;
+        }
+
+#if defined(__GNUC__)
+        nFields += __builtin_popcountll(starts);
+#else
+        for (; starts != 0; starts &= starts - 1)
+        {
+            nFields++;
+        }
+#endif
+        carry = separator >> (SCAN_BLOCK_SIZE - 1);
+    }
+
+    return nFields;
+}
+
+/**
+ * @brief Returns a block of a buffer that can be read whole.
+ *
+ * A block shorter than 'SCAN_BLOCK_SIZE' is copied into a zero filled buffer first, so no
+ * byte after the buffer is read and the bytes after its end match no character but the
+ * terminator.
+ *
+ * @param pBlock Start of the block.
+ * @param nBytes Bytes of the buffer from the start of the block on.
+ * @param pSpare Buffer of 'SCAN_BLOCK_SIZE' bytes for a short block.
+ * @return The block itself, or the spare buffer holding its copy.
+ */
+const char *get_readable_block(const char *pBlock, long nBytes, char *pSpare)
+{
+    if (nBytes >= SCAN_BLOCK_SIZE)
+    {
+        return pBlock;
+    }
+
+    memset(pSpare, 0, SCAN_BLOCK_SIZE);
+    memcpy(pSpare, pBlock, nBytes);
+
+    return pSpare;
+}
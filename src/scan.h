@@ -0,0 +1,15 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+uint64_t get_character_mask(const char *, char);
+uint64_t get_field_end_mask(const char *);
+int get_lowest_bit(uint64_t);
+void start_character_scan(CharacterScan *, const char *, long, char);
+const char *find_next_character(CharacterScan *);
+long count_fields(const char *, long);
+
+#endif // SCAN_H
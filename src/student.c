@@ -6,7 +6,8 @@
  * It reads data, processes student records, computes grades based on predefined weights,
  * and calculates class statistics such as averages, minimum, and maximum scores. The program
  * also writes the student records and calculated results to a file and handles dynamic memory
- * allocation and deallocation.
+ * allocation and deallocation. All records and results are kept in the grading context passed
+ * to each function.
  */
 
 // Library includes
@@ -15,27 +16,35 @@
 #include <stdlib.h>
 
 // Code includes
+#include "collate.h"
+#include "context.h"
 #include "helper.h"
 #include "memory.h"
+#include "profiler.h"
+#include "rank.h"
+#include "trace.h"
 #include "student.h"
 
 // Grading constants
 const double TEST_WEIGHTS[] = {0.1, 0.1, 0.1, 0.1, 0.2, 0.15, 0.25}; // Weights for each test
 const double GRADE_THRESHOLD[] = {90, 80, 70, 60, 0}; // Thresholds for grade calculation
 const char GRADE_LETTER[] = {'A', 'B', 'C', 'D', 'F'}; // Corresponding grade letters
-const char *TEST_NAMES[] = {"Quiz 1", "Quiz 2", "Quiz 3", "Quiz 4", "Mid 1", "Mid 2", "Final"}; // Test names
-const char *STAT_NAMES[] = {"Average", "Minimum", "Maximum"}; // Statistical names for report
+const char *const TEST_NAMES[] = {"Quiz 1", "Quiz 2", "Quiz 3", "Quiz 4", "Mid 1", "Mid 2", "Final"}; // Test names
+const char *const STAT_NAMES[] = {"Average", "Minimum", "Maximum"}; // Statistical names for report
 
-// File scope global variable
-static Record *head = NULL; // Start of student record link list
+// Default grading schema built from the grading constants
+const GradingSchema DEFAULT_GRADING_SCHEMA = {
+    .testWeights = TEST_WEIGHTS,
+    .testNames = TEST_NAMES,
+    .nTests = sizeof(TEST_WEIGHTS) / sizeof(TEST_WEIGHTS[0]),
+    .gradeThreshold = GRADE_THRESHOLD,
+    .gradeLetter = GRADE_LETTER,
+};
 
 // Function declaration
-ReturnStatus set_name(const char *, char **, char **);
-ReturnStatus set_scores(const char *, char **, int, int **);
-ReturnStatus calculate_grade(Record *);
-ReturnStatus calculate_average(int, double *);
-ReturnStatus calculate_minimum(int, double *);
-ReturnStatus calculate_maximum(int, double *);
+ReturnStatus set_name(GradingContext *, const char *, char **, char **);
+ReturnStatus set_scores(GradingContext *, const char *, char **, int, int **);
+int get_histogram_bucket(double);
 
 /**
  * @brief Creates a new student record from raw data string.
@@ -43,18 +52,22 @@ ReturnStatus calculate_maximum(int, double *);
  * This function parses a raw data string to extract the student's name and scores,
  * and dynamically allocates memory to store the student's information.
  *
+ * @param pContext The grading context that receives the student record.
  * @param rawDataString The raw data string containing student information (name and scores).
  *
  * @return SUCCESS if the student record is created successfully.
  *         FAILURE if there is an error in creating the student record.
  */
-ReturnStatus create_student(const char *rawDataString)
+ReturnStatus create_student(GradingContext *pContext, const char *rawDataString)
 {
     Record *record = NULL;
 
     // Get the number of comma seperated fields in the string
     int nField = 0; // Track number of comma seperated fields
-    if (get_token_count(rawDataString, &nField) != SUCCESS)
+    PROFILE_START(pContext, tokenizeStart);
+    ReturnStatus countStatus = get_token_count(rawDataString, &nField);
+    PROFILE_STOP(pContext, PHASE_TOKENIZE, tokenizeStart);
+    if (countStatus != SUCCESS)
     {
         return FAILURE;
     }
@@ -62,7 +75,7 @@ ReturnStatus create_student(const char *rawDataString)
     // Get student name from data string
     char *tempDataString = NULL; // Temporaty storage for string token
     char *studentName = NULL;
-    if (set_name(rawDataString, &tempDataString, &studentName) != SUCCESS)
+    if (set_name(pContext, rawDataString, &tempDataString, &studentName) != SUCCESS)
     {
         return FAILURE;
     }
@@ -70,19 +83,19 @@ ReturnStatus create_student(const char *rawDataString)
     // Get student scores from data string
     int nScores = nField - 1; // One field for name the rest are scores
     int *studentScores = NULL;
-    if (set_scores(rawDataString, &tempDataString, nScores, &studentScores) != SUCCESS)
+    if (set_scores(pContext, rawDataString, &tempDataString, nScores, &studentScores) != SUCCESS)
     {
         return FAILURE;
     }
     
     // Get next token to release token memory
-    if (get_next_token(rawDataString, &tempDataString) != SUCCESS)
+    if (get_next_token(pContext, rawDataString, &tempDataString) != SUCCESS)
     {
         return FAILURE;
     }
 
     // Dynamically allocate memory for record
-    if (allocate_record_memory(&record) != SUCCESS)
+    if (allocate_record_memory(pContext, &record) != SUCCESS)
     {
         return FAILURE;
     }
@@ -91,11 +104,12 @@ ReturnStatus create_student(const char *rawDataString)
     record->name = studentName;
     record->scores = studentScores;
     record->numberOfScores = nScores;
+    record->weightedScore = 0;
     record->grade = 0;
     record->next = NULL;
     
     // add student record to link list
-    if (add_record_to_list(&head, record) != SUCCESS)
+    if (add_record_to_list(pContext, record) != SUCCESS)
     {
         return FAILURE;
     }
@@ -103,12 +117,92 @@ ReturnStatus create_student(const char *rawDataString)
     return SUCCESS;
 }
 
+/**
+ * @brief Checks a raw data string against the rules 'create_student' and 'calculate_grade' apply.
+ *
+ * The string is scanned in place without tokenizing or allocating, so error tolerant
+ * parsing can set invalid rows aside before any memory is spent on them. Fields are split
+ * as 'get_next_token' splits them and scores are converted as 'set_scores' converts them.
+ * The first problem found is described in the same order in which a strict run reports it:
+ * a missing name, then a score out of range, then a wrong number of scores.
+ *
+ * @param pContext The grading context with the grading schema.
+ * @param rawDataString The raw data string containing student information (name and scores).
+ * @param pIsValid Pointer that receives TRUE if a record can be created and graded from the string.
+ * @param pDiagnostic Diagnostic that receives the reason when the string is not valid.
+ *
+ * @return SUCCESS after the string is checked.
+ */
+ReturnStatus check_student_data(GradingContext *pContext, const char *rawDataString, Boolean *pIsValid,
+                                RejectDiagnostic *pDiagnostic)
+{
+    const char *pName = NULL;
+    int nNameLength = 0;
+    int nScores = 0;
+    int nScoresRequired = pContext->schema->nTests;
+
+    *pIsValid = FALSE;
+
+    for (const char *pChar = rawDataString; *pChar != STRING_TERMINATION;)
+    {
+        // Skip the commas before the next field
+        if (*pChar == COMMA_CHAR)
+        {
+            pChar++;
+            continue;
+        }
+
+        const char *pField = pChar;
+        while (*pChar != COMMA_CHAR && *pChar != STRING_TERMINATION)
+        {
+            pChar++;
+        }
+
+        if (pName == NULL)
+        {
+            pName = pField;
+            nNameLength = (int)(pChar - pField);
+            continue;
+        }
+
+        // The field ends at a comma, which stops the conversion like the terminator of a token
+        int score = atoi(pField);
+        if (score > MAXIMUM_SCORE || score < MINIMUM_SCORE)
+        {
+            pDiagnostic->reason = REJECT_REASON_SCORE_RANGE;
+            snprintf(pDiagnostic->message, REJECT_MESSAGE_SIZE, REJECT_SCORE_RANGE, score, MINIMUM_SCORE, MAXIMUM_SCORE);
+            return SUCCESS;
+        }
+        nScores++;
+    }
+
+    if (pName == NULL)
+    {
+        pDiagnostic->reason = REJECT_REASON_NAME_EMPTY;
+        snprintf(pDiagnostic->message, REJECT_MESSAGE_SIZE, REJECT_NAME_EMPTY);
+        return SUCCESS;
+    }
+
+    if (nScores != nScoresRequired)
+    {
+        pDiagnostic->reason = REJECT_REASON_SCORE_COUNT;
+        snprintf(pDiagnostic->message, REJECT_MESSAGE_SIZE, REJECT_SCORE_COUNT, nNameLength, pName, nScores,
+                 nScoresRequired);
+        return SUCCESS;
+    }
+
+    *pIsValid = TRUE;
+
+    return SUCCESS;
+}
+
 /**
  * @brief Sets the name for a student from the raw data string.
  *
  * This function extracts the student's name from the raw data string and dynamically
  * allocates memory to store it.
  *
+ * @param pContext The grading context that owns the tokenizer and allocator.
  * @param rawDataString The raw data string containing the student's name.
  * @param tempDataString Temporary storage for tokenized data.
  * @param studentName Pointer to store the dynamically allocated memory for the student's name.
@@ -116,23 +210,23 @@ ReturnStatus create_student(const char *rawDataString)
  * @return SUCCESS if the name is set successfully.
  *         FAILURE if there is an error setting the name.
  */
-ReturnStatus set_name(const char *rawDataString, char **tempDataString, char **studentName)
+ReturnStatus set_name(GradingContext *pContext, const char *rawDataString, char **tempDataString, char **studentName)
 {
     // Get name which is the first token
-    if (get_next_token(rawDataString, tempDataString) != SUCCESS)
+    if (get_next_token(pContext, rawDataString, tempDataString) != SUCCESS)
     {
         return FAILURE;
     }
     
     // Check name is valid
-    if (tempDataString == NULL)
+    if (*tempDataString == NULL)
     {
-        printf(ERR_PARSED_NAME_EMPTY);
+        report_error(pContext, ERROR_CLASS_DATA, ERR_PARSED_NAME_EMPTY);
         return FAILURE;
     }
     
     // Dynamically allocate memory for the student's name
-    if (allocate_string_memory(studentName, strlen(*tempDataString)) != SUCCESS)
+    if (allocate_string_memory(pContext, studentName, strlen(*tempDataString)) != SUCCESS)
     {
         return FAILURE;
     }
@@ -149,6 +243,7 @@ ReturnStatus set_name(const char *rawDataString, char **tempDataString, char **s
  * This function extracts and validates the scores from the raw data string and
  * stores them in dynamically allocated memory.
  *
+ * @param pContext The grading context that owns the tokenizer and allocator.
  * @param rawDataString The raw data string containing the student's scores.
  * @param tempDataString Temporary storage for tokenized data.
  * @param nScores The number of scores to extract.
@@ -157,10 +252,10 @@ ReturnStatus set_name(const char *rawDataString, char **tempDataString, char **s
  * @return SUCCESS if the scores are set successfully.
  *         FAILURE if there is an error setting the scores.
  */
-ReturnStatus set_scores(const char *rawDataString, char **tempDataString, int nScores, int **scores)
+ReturnStatus set_scores(GradingContext *pContext, const char *rawDataString, char **tempDataString, int nScores, int **scores)
 {
     // Dynamically allocate memory for the student's scores
-    if (allocate_int_array_memory(scores, nScores) != SUCCESS)
+    if (allocate_int_array_memory(pContext, scores, nScores) != SUCCESS)
     {
         return FAILURE;
     }
@@ -169,7 +264,7 @@ ReturnStatus set_scores(const char *rawDataString, char **tempDataString, int nS
     for (int i = 0; i < nScores; i++)
     {
         // Get next score
-        if (get_next_token(rawDataString, tempDataString) != SUCCESS)
+        if (get_next_token(pContext, rawDataString, tempDataString) != SUCCESS)
         {
             return FAILURE;
         }
@@ -178,7 +273,7 @@ ReturnStatus set_scores(const char *rawDataString, char **tempDataString, int nS
         // Check score is valid
         if (*(*scores + i) > MAXIMUM_SCORE || *(*scores + i) < MINIMUM_SCORE)
         {
-            printf(ERR_PARSED_SCORE_INVALID, *(*scores + i), MINIMUM_SCORE, MAXIMUM_SCORE);
+            report_error(pContext, ERROR_CLASS_DATA, ERR_PARSED_SCORE_INVALID, *(*scores + i), MINIMUM_SCORE, MAXIMUM_SCORE);
             return FAILURE;
         }
     }
@@ -189,25 +284,73 @@ ReturnStatus set_scores(const char *rawDataString, char **tempDataString, int nS
  * @brief Calculates the grades for all students.
  *
  * This function iterates through all student records and calculates their grades
- * based on the weighted scores.
+ * based on the weighted scores. The grade distribution is accumulated into a local
+ * counter set while grading and merged into the class distribution once the pass is done,
+ * so no extra pass over the data is needed for the distribution report.
+ *
+ * @param pContext The grading context whose students are graded.
  *
  * @return SUCCESS if the grades are calculated successfully for all students.
  *         FAILURE if there is an error in calculating any student's grade.
  */
-ReturnStatus calculate_student_grade()
+ReturnStatus calculate_student_grade(GradingContext *pContext)
 {
+    GradeDistribution local = {0}; // Counters for this grading pass
 
-    Record *current = head;
+    Record *current = pContext->table.head;
 
     while (current != NULL)
     {
 
-        if (calculate_grade(current) != SUCCESS)
+        if (calculate_grade(pContext, current, &local) != SUCCESS)
         {
             return FAILURE;
         }
         current = current->next;
     }
+
+    // Replace the class distribution with the one from this pass
+    pContext->distribution = (GradeDistribution){0};
+    if (merge_grade_distribution(&pContext->distribution, &local) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Merges one grade distribution into another.
+ *
+ * Adds the letter counts, histogram buckets and graded count of 'pSource' to 'pTarget'.
+ * When grading runs on several threads each thread fills its own distribution and
+ * the results are merged with this function.
+ *
+ * @param pTarget Distribution that receives the counts.
+ * @param pSource Distribution whose counts are added.
+ *
+ * @return SUCCESS if the distributions are merged.
+ *         FAILURE if either distribution is NULL.
+ */
+ReturnStatus merge_grade_distribution(GradeDistribution *pTarget, const GradeDistribution *pSource)
+{
+    if (pTarget == NULL || pSource == NULL)
+    {
+        return FAILURE;
+    }
+
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        pTarget->letterCount[n] += pSource->letterCount[n];
+    }
+
+    for (int n = 0; n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        pTarget->scoreHistogram[n] += pSource->scoreHistogram[n];
+    }
+
+    pTarget->nGraded += pSource->nGraded;
+
     return SUCCESS;
 }
 
@@ -216,46 +359,104 @@ ReturnStatus calculate_student_grade()
  *
  * This function calculates the grade for a student based on weighted scores
  * and compares it with predefined grade thresholds to determine the final grade.
+ * The weighted score is kept in the record and counted in the grade distribution.
  *
+ * @param pContext The grading context with the grading schema.
  * @param record The student record whose grade will be calculated.
+ * @param pDistribution The distribution that counts the grade and weighted score.
  *
  * @return SUCCESS if the grade is calculated successfully.
  *         FAILURE if there is an error in calculating the grade.
  */
-ReturnStatus calculate_grade(Record *record)
+ReturnStatus calculate_grade(GradingContext *pContext, Record *record, GradeDistribution *pDistribution)
 {
+    const GradingSchema *pSchema = pContext->schema;
     double sum = 0;
-    int nScoresRequired = sizeof(TEST_WEIGHTS)/sizeof(double);  
+    int nScoresRequired = pSchema->nTests;
 
     if (record->numberOfScores != nScoresRequired)
     {
-        printf(ERR_INCORRECT_SCORE_COUNT, record->name, record->numberOfScores, nScoresRequired);
+        report_error(pContext, ERROR_CLASS_DATA, ERR_INCORRECT_SCORE_COUNT, record->name, record->numberOfScores, nScoresRequired);
         return FAILURE;
     }
     
     for (int n = 0; n < record->numberOfScores; n++)
     {
-        sum += (*((record->scores) + n)) * TEST_WEIGHTS[n];
+        sum += (*((record->scores) + n)) * pSchema->testWeights[n];
     }
 
-    for (int n = 0; n < nScoresRequired; n++)
+    record->weightedScore = sum;
+
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        if (sum >= pSchema->gradeThreshold[n])
+        {
+            record->grade = pSchema->gradeLetter[n];
+            pDistribution->letterCount[n]++;
+            break;
+        }
+    }
+
+    pDistribution->scoreHistogram[get_histogram_bucket(sum)]++;
+    pDistribution->nGraded++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Removes a graded student from a grade distribution.
+ *
+ * Undoes what 'calculate_grade' counted for the record, so a distribution can follow a
+ * table whose records come and go without grading every record again.
+ *
+ * @param pContext The grading context with the grading schema.
+ * @param record The graded student record to remove.
+ * @param pDistribution The distribution that counted the record.
+ *
+ * @return SUCCESS if the record is removed from the distribution.
+ */
+ReturnStatus remove_student_grade(GradingContext *pContext, const Record *record, GradeDistribution *pDistribution)
+{
+    const GradingSchema *pSchema = pContext->schema;
+
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
     {
-        if (sum >= GRADE_THRESHOLD[n])
+        if (record->grade == pSchema->gradeLetter[n])
         {
-            record->grade = GRADE_LETTER[n];
+            pDistribution->letterCount[n]--;
             break;
         }
     }
 
+    pDistribution->scoreHistogram[get_histogram_bucket(record->weightedScore)]--;
+    pDistribution->nGraded--;
+
     return SUCCESS;
 }
 
+/**
+ * @brief Finds the histogram bucket of a weighted score.
+ *
+ * @param weightedScore The weighted score of a student.
+ *
+ * @return The bucket index, a perfect score is counted in the last bucket.
+ */
+int get_histogram_bucket(double weightedScore)
+{
+    int bucket = (int)(weightedScore / HISTOGRAM_BUCKET_WIDTH);
+    bucket = bucket >= HISTOGRAM_BUCKET_COUNT ? HISTOGRAM_BUCKET_COUNT - 1 : bucket;
+    bucket = bucket < 0 ? 0 : bucket;
+
+    return bucket;
+}
+
 /**
  * @brief Sets the total number of students in the record list.
  *
- * This function traverses the student record linked list, counting the number of student records,
- * and then stores the total count in the variable pointed to by 'nStudents'.
+ * This function reads the number of student records kept by the student table
+ * and stores the total count in the variable pointed to by 'nStudents'.
  *
+ * @param pContext The grading context that owns the student table.
  * @param nStudents A pointer to an integer where the total number of student records will be stored.
  *
  * @return ReturnStatus
@@ -264,30 +465,48 @@ ReturnStatus calculate_grade(Record *record)
  *
  */
 
-ReturnStatus set_number_of_students(int *nStudents)
+ReturnStatus set_number_of_students(GradingContext *pContext, int *nStudents)
 {
-    Record *current = head;
-    int nCount = 0;
+    *nStudents = pContext->table.nStudents;
 
-    while (current != NULL)
-    {
+    return SUCCESS;
+}
 
-        nCount++;
-        current = current->next;
+/**
+ * @brief Sorts the student table in the output order of the context for writing.
+ *
+ * The table is sorted by name first, in the collation of the context; an order by score or
+ * letter grade is then taken from packed keys, with the name order breaking ties.
+ *
+ * @param pContext The grading context that owns the student table and selects the order.
+ *
+ * @return SUCCESS if the table is sorted, otherwise FAILURE.
+ */
+ReturnStatus sort_students(GradingContext *pContext)
+{
+    PROFILE_START(pContext, sortStart);
+    TRACE_START(pContext, traceStart);
+    ReturnStatus status = (pContext->collation == NAME_COLLATION_BYTE)
+                              ? sort_list_by_name(pContext)
+                              : sort_list_by_collation(pContext, pContext->collation);
+    if (status == SUCCESS)
+    {
+        status = sort_list_by_key(pContext, pContext->sortOrder);
     }
+    TRACE_STOP(pContext, TRACE_STAGE_SORT, NULL, TRACE_WHOLE_FILE, traceStart);
+    PROFILE_STOP(pContext, PHASE_SORT, sortStart);
 
-    *nStudents = nCount;
-
-    return SUCCESS;
+    return status;
 }
 
 /**
  * @brief Writes student names and grades to a specified file.
  *
- * This function sorts the student records by name and then iterates through each student record,
+ * This function sorts the student records in the output order and then iterates through each student record,
  * writing the student's name and grade to the specified file. The data is formatted according to the
  * specified width and format defined by 'FILE_STUDENT_DATA_STRING_FORMAT'.
  *
+ * @param pContext The grading context that owns the student table.
  * @param pFile A pointer to the file where the student names and grades will be written.
  *
  * @return ReturnStatus
@@ -295,20 +514,31 @@ ReturnStatus set_number_of_students(int *nStudents)
  *         - FAILURE (-1) if there is an error during the sorting or file writing process.
  *
  */
-ReturnStatus write_names_and_grades_to_file(FILE *pFile)
+ReturnStatus write_names_and_grades_to_file(GradingContext *pContext, FILE *pFile)
 {
-    if (sort_list_by_name(&head) != SUCCESS)
+    // An empty table has nothing to sort or write
+    if (pContext->table.head == NULL)
     {
         return SUCCESS;
     }
 
-    Record *current = head;
+    if (sort_students(pContext) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    Record *current = pContext->table.head;
+    long long nBytesWritten = 0;
 
+    PROFILE_START(pContext, formatStart);
     while (current != NULL)
     {
-        fprintf(pFile, FILE_STUDENT_DATA_STRING_FORMAT, NAME_WIDTH, current->name, GRADE_WIDTH, current->grade);
+        nBytesWritten += fprintf(pFile, FILE_STUDENT_DATA_STRING_FORMAT, NAME_WIDTH, current->name, GRADE_WIDTH, current->grade);
         current = current->next;
     }
+    PROFILE_STOP(pContext, PHASE_FORMAT, formatStart);
+    PROFILE_ADD(pContext, nBytesWritten, nBytesWritten);
+
     return SUCCESS;
 }
 
@@ -317,20 +547,23 @@ ReturnStatus write_names_and_grades_to_file(FILE *pFile)
  *
  * This function prints the header for the statistical display, including the test names.
  *
+ * @param pContext The grading context whose schema names the tests.
+ * @param pStream The stream that receives the report.
+ *
  * @return SUCCESS if the header is displayed successfully.
  */
-ReturnStatus show_header(void)
+ReturnStatus show_header(GradingContext *pContext, FILE *pStream)
 {
-    printf(MSG_SHOW_AVERAGE_HEADER);
+    fprintf(pStream, MSG_SHOW_AVERAGE_HEADER);
 
-    printf("\n%*s", STATS_COLUMN_WIDTH, "");
+    fprintf(pStream, "\n%*s", STATS_COLUMN_WIDTH, "");
 
-    // Calculate the number of elements in the array
-    int nColumns = sizeof(TEST_NAMES) / sizeof(TEST_NAMES[0]);
+    // Number of tests in the grading schema
+    int nColumns = pContext->schema->nTests;
 
     for (int n = 0; n < nColumns; n++)
     {
-        printf("%-*s", STATS_COLUMN_WIDTH, TEST_NAMES[n]);
+        fprintf(pStream, "%-*s", STATS_COLUMN_WIDTH, pContext->schema->testNames[n]);
     }
 
     return SUCCESS;
@@ -341,24 +574,27 @@ ReturnStatus show_header(void)
  *
  * This function calculates and displays the average score for each test.
  *
+ * @param pContext The grading context that owns the student table.
+ * @param pStream The stream that receives the report.
+ *
  * @return SUCCESS if the averages are displayed successfully.
  *         FAILURE if there is an error calculating or displaying the averages.
  */
-ReturnStatus show_average(void)
+ReturnStatus show_average(GradingContext *pContext, FILE *pStream)
 {
-    printf("\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_AVERAGE]);
-    // Calculate the number of elements in the array
-    int nColumns = sizeof(TEST_NAMES) / sizeof(TEST_NAMES[0]);
+    fprintf(pStream, "\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_AVERAGE]);
+    // Number of tests in the grading schema
+    int nColumns = pContext->schema->nTests;
 
     for (int n = 0; n < nColumns; n++)
     {
         double average;
 
-        if (calculate_average(n, &average) != SUCCESS)
+        if (calculate_average(pContext, n, &average) != SUCCESS)
         {
             return FAILURE;
         }
-        printf("%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, average);
+        fprintf(pStream, "%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, average);
     }
     return SUCCESS;
 }
@@ -368,25 +604,28 @@ ReturnStatus show_average(void)
  *
  * This function calculates and displays the minimum score for each test.
  *
+ * @param pContext The grading context that owns the student table.
+ * @param pStream The stream that receives the report.
+ *
  * @return SUCCESS if the minimum scores are displayed successfully.
  *         FAILURE if there is an error calculating or displaying the minimums.
  */
-ReturnStatus show_minimum(void)
+ReturnStatus show_minimum(GradingContext *pContext, FILE *pStream)
 {
-    printf("\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_MINIMUM]);
+    fprintf(pStream, "\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_MINIMUM]);
     
-    // Calculate the number of elements in the array
-    int nColumns = sizeof(TEST_NAMES) / sizeof(TEST_NAMES[0]);
+    // Number of tests in the grading schema
+    int nColumns = pContext->schema->nTests;
 
     for (int n = 0; n < nColumns; n++)
     {
         double minimum;
 
-        if (calculate_minimum(n, &minimum) != SUCCESS)
+        if (calculate_minimum(pContext, n, &minimum) != SUCCESS)
         {
             return FAILURE;
         }
-        printf("%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, minimum);
+        fprintf(pStream, "%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, minimum);
     }
 
     return SUCCESS;
@@ -397,54 +636,275 @@ ReturnStatus show_minimum(void)
  *
  * This function calculates and displays the maximum score for each test.
  *
+ * @param pContext The grading context that owns the student table.
+ * @param pStream The stream that receives the report.
+ *
  * @return SUCCESS if the maximum scores are displayed successfully.
  *         FAILURE if there is an error calculating or displaying the maximums.
  */
-ReturnStatus show_maximum(void)
+ReturnStatus show_maximum(GradingContext *pContext, FILE *pStream)
 {
-    printf("\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_MAXIMUM]);
-    // Calculate the number of elements in the array
-    int nColumns = sizeof(TEST_NAMES) / sizeof(TEST_NAMES[0]);
+    fprintf(pStream, "\n%-*s", STATS_COLUMN_WIDTH, STAT_NAMES[ROW_MAXIMUM]);
+    // Number of tests in the grading schema
+    int nColumns = pContext->schema->nTests;
 
     for (int n = 0; n < nColumns; n++)
     {
         double maximum;
 
-        if (calculate_maximum(n, &maximum) != SUCCESS)
+        if (calculate_maximum(pContext, n, &maximum) != SUCCESS)
         {
             return FAILURE;
         }
-        printf("%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, maximum);
+        fprintf(pStream, "%-*.*f", STATS_COLUMN_WIDTH, STATS_PRECISION, maximum);
     }
     return SUCCESS;
 }
 
+/**
+ * @brief Displays the letter grade distribution.
+ *
+ * This function displays the number and percentage of students for each letter grade
+ * using the distribution accumulated during grading.
+ *
+ * @param pContext The grading context that owns the grade distribution.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS if the distribution is displayed successfully.
+ *         FAILURE if no student has been graded.
+ */
+ReturnStatus show_grade_distribution(GradingContext *pContext, FILE *pStream)
+{
+    const GradeDistribution *pDistribution = &pContext->distribution;
+
+    if (pDistribution->nGraded <= 0)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_DIVIDE_BY_ZERO);
+        return FAILURE;
+    }
+
+    fprintf(pStream, MSG_SHOW_DISTRIBUTION_HEADER);
+
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        double percent = PERCENT_SCALE * pDistribution->letterCount[n] / pDistribution->nGraded;
+        fprintf(pStream, "\n%-*c%-*d%*.*f%%", STATS_COLUMN_WIDTH, pContext->schema->gradeLetter[n], STATS_COLUMN_WIDTH,
+                pDistribution->letterCount[n], STATS_COLUMN_WIDTH, STATS_PRECISION, percent);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Displays a histogram of the weighted scores.
+ *
+ * Each bucket covers 'HISTOGRAM_BUCKET_WIDTH' points and shows the student count
+ * with a bar scaled to the largest bucket.
+ *
+ * @param pContext The grading context that owns the grade distribution.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS if the histogram is displayed successfully.
+ *         FAILURE if no student has been graded.
+ */
+ReturnStatus show_score_histogram(GradingContext *pContext, FILE *pStream)
+{
+    const GradeDistribution *pDistribution = &pContext->distribution;
+
+    if (pDistribution->nGraded <= 0)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_DIVIDE_BY_ZERO);
+        return FAILURE;
+    }
+
+    fprintf(pStream, MSG_SHOW_HISTOGRAM_HEADER);
+
+    // Find the largest bucket to scale the bars
+    int nLargest = 0;
+    for (int n = 0; n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        nLargest = pDistribution->scoreHistogram[n] > nLargest ? pDistribution->scoreHistogram[n] : nLargest;
+    }
+
+    for (int n = 0; n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        int lower = n * HISTOGRAM_BUCKET_WIDTH;
+        int upper = (n == HISTOGRAM_BUCKET_COUNT - 1) ? MAXIMUM_SCORE : lower + HISTOGRAM_BUCKET_WIDTH - 1;
+        int nBar = (nLargest > 0) ? (pDistribution->scoreHistogram[n] * HISTOGRAM_BAR_WIDTH) / nLargest : 0;
+
+        fprintf(pStream, "\n%3d-%-*d%-*d", lower, STATS_COLUMN_WIDTH - 4, upper, STATS_COLUMN_WIDTH, pDistribution->scoreHistogram[n]);
+        for (int i = 0; i < nBar; i++)
+        {
+            fputc(HISTOGRAM_BAR_CHAR, pStream);
+        }
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the class statistics as comma separated values.
+ *
+ * Every value is one 'statistic,name,value' row, so the per-test statistics, the letter
+ * grade distribution and the histogram fit one table that spreadsheets and scripts can read.
+ * The top and bottom students of the ranking follow as 'Top' and 'Bottom' rows.
+ *
+ * @param pContext The grading context that owns the student table and distribution.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS if the statistics are written.
+ *         FAILURE if no student has been graded.
+ */
+ReturnStatus write_statistics_csv(GradingContext *pContext, FILE *pStream)
+{
+    const GradingSchema *pSchema = pContext->schema;
+    const GradeDistribution *pDistribution = &pContext->distribution;
+
+    if (pDistribution->nGraded <= 0)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_DIVIDE_BY_ZERO);
+        return FAILURE;
+    }
+
+    fprintf(pStream, STATS_CSV_HEADER);
+    fprintf(pStream, "%s,,%d\n", STAT_NAME_STUDENTS, pDistribution->nGraded);
+
+    for (int row = ROW_AVERAGE; row <= ROW_MAXIMUM; row++)
+    {
+        for (int n = 0; n < pSchema->nTests; n++)
+        {
+            double value;
+            ReturnStatus status = (row == ROW_AVERAGE) ? calculate_average(pContext, n, &value)
+                                : (row == ROW_MINIMUM) ? calculate_minimum(pContext, n, &value)
+                                                       : calculate_maximum(pContext, n, &value);
+            if (status != SUCCESS)
+            {
+                return FAILURE;
+            }
+            fprintf(pStream, "%s,%s,%.*f\n", STAT_NAMES[row], pSchema->testNames[n], STATS_PRECISION, value);
+        }
+    }
+
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        double percent = PERCENT_SCALE * pDistribution->letterCount[n] / pDistribution->nGraded;
+        fprintf(pStream, "%s,%c,%d\n", STAT_NAME_COUNT, pSchema->gradeLetter[n], pDistribution->letterCount[n]);
+        fprintf(pStream, "%s,%c,%.*f\n", STAT_NAME_PERCENT, pSchema->gradeLetter[n], STATS_PRECISION, percent);
+    }
+
+    for (int n = 0; n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        int lower = n * HISTOGRAM_BUCKET_WIDTH;
+        int upper = (n == HISTOGRAM_BUCKET_COUNT - 1) ? MAXIMUM_SCORE : lower + HISTOGRAM_BUCKET_WIDTH - 1;
+        fprintf(pStream, "%s,%d-%d,%d\n", STAT_NAME_HISTOGRAM, lower, upper, pDistribution->scoreHistogram[n]);
+    }
+
+    return write_ranking_csv(pContext, pStream);
+}
+
+/**
+ * @brief Writes the class statistics as one JSON object.
+ *
+ * Test names come from the grading schema and are written without escaping. The top and
+ * bottom students of the ranking are added as 'top' and 'bottom' arrays.
+ *
+ * @param pContext The grading context that owns the student table and distribution.
+ * @param pStream The stream that receives the report.
+ *
+ * @return SUCCESS if the statistics are written.
+ *         FAILURE if no student has been graded.
+ */
+ReturnStatus write_statistics_json(GradingContext *pContext, FILE *pStream)
+{
+    const GradingSchema *pSchema = pContext->schema;
+    const GradeDistribution *pDistribution = &pContext->distribution;
+
+    if (pDistribution->nGraded <= 0)
+    {
+        report_error(pContext, ERROR_CLASS_DATA, ERR_DIVIDE_BY_ZERO);
+        return FAILURE;
+    }
+
+    fprintf(pStream, "{\"students\":%d,\"tests\":[", pDistribution->nGraded);
+
+    for (int n = 0; n < pSchema->nTests; n++)
+    {
+        double average, minimum, maximum;
+
+        if (calculate_average(pContext, n, &average) != SUCCESS ||
+            calculate_minimum(pContext, n, &minimum) != SUCCESS ||
+            calculate_maximum(pContext, n, &maximum) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        fprintf(pStream, "%s{\"name\":\"%s\",\"average\":%.*f,\"minimum\":%.*f,\"maximum\":%.*f}", (n > 0) ? "," : "",
+                pSchema->testNames[n], STATS_PRECISION, average, STATS_PRECISION, minimum, STATS_PRECISION, maximum);
+    }
+
+    fprintf(pStream, "],\"grades\":[");
+    for (int n = 0; n < NUMBER_OF_GRADES; n++)
+    {
+        double percent = PERCENT_SCALE * pDistribution->letterCount[n] / pDistribution->nGraded;
+        fprintf(pStream, "%s{\"letter\":\"%c\",\"count\":%d,\"percent\":%.*f}", (n > 0) ? "," : "",
+                pSchema->gradeLetter[n], pDistribution->letterCount[n], STATS_PRECISION, percent);
+    }
+
+    fprintf(pStream, "],\"histogram\":[");
+    for (int n = 0; n < HISTOGRAM_BUCKET_COUNT; n++)
+    {
+        int lower = n * HISTOGRAM_BUCKET_WIDTH;
+        int upper = (n == HISTOGRAM_BUCKET_COUNT - 1) ? MAXIMUM_SCORE : lower + HISTOGRAM_BUCKET_WIDTH - 1;
+        fprintf(pStream, "%s{\"lower\":%d,\"upper\":%d,\"count\":%d}", (n > 0) ? "," : "", lower, upper,
+                pDistribution->scoreHistogram[n]);
+    }
+
+    fprintf(pStream, "]");
+    write_ranking_json(pContext, pStream);
+    fprintf(pStream, "}\n");
+
+    return SUCCESS;
+}
+
 /**
  * @brief Calculates the average score for a specific test across all students.
  *
+ * The score summary of the context is used instead of the table when there is one.
+ *
+ * @param pContext The grading context that owns the student table.
  * @param testNumber The test number for which the average will be calculated.
  * @param average Pointer to store the calculated average score.
  *
  * @return SUCCESS if the average is calculated successfully.
  *         FAILURE if there is an error calculating the average.
  */
-ReturnStatus calculate_average(int testNumber, double *average)
+ReturnStatus calculate_average(GradingContext *pContext, int testNumber, double *average)
 {
-    Record *current = head;
+    Record *current = pContext->table.head;
+    const ScoreSummary *pSummary = pContext->pScoreSummary;
+    long nSteps = 0; // Records visited
 
     double sum = 0;
     int nStudents = 0;
 
+    if (pSummary != NULL)
+    {
+        sum = (double)pSummary->sums[testNumber];
+        nStudents = pSummary->nStudents;
+        current = NULL;
+    }
+
     while (current != NULL)
     {
         sum += *(current->scores + testNumber);
         nStudents++;
         current = current->next;
+        nSteps++;
     }
+    PROFILE_ADD(pContext, nRecordSteps, nSteps);
 
     if (nStudents <= 0)
     {
-        printf(ERR_DIVIDE_BY_ZERO);
+        report_error(pContext, ERROR_CLASS_DATA, ERR_DIVIDE_BY_ZERO);
         return FAILURE;
     }
     else
@@ -457,22 +917,44 @@ ReturnStatus calculate_average(int testNumber, double *average)
 /**
  * @brief Calculates the minimum score for a specific test across all students.
  *
+ * The score summary of the context is used instead of the table when there is one.
+ *
+ * @param pContext The grading context that owns the student table.
  * @param testNumber The test number for which the minimum will be calculated.
  * @param minimum Pointer to store the calculated minimum score.
  *
  * @return SUCCESS if the minimum is calculated successfully.
  */
-ReturnStatus calculate_minimum(int testNumber, double *minimum)
+ReturnStatus calculate_minimum(GradingContext *pContext, int testNumber, double *minimum)
 {
-    Record *current = head;
+    Record *current = pContext->table.head;
+    const ScoreSummary *pSummary = pContext->pScoreSummary;
+    long nSteps = 0; // Records visited
 
     *minimum = MAXIMUM_SCORE;
 
+    // The lowest score value any student has
+    if (pSummary != NULL)
+    {
+        const int *counts = pSummary->counts + testNumber * SCORE_VALUE_COUNT;
+        for (int n = 0; n < SCORE_VALUE_COUNT; n++)
+        {
+            if (counts[n] > 0)
+            {
+                *minimum = MINIMUM_SCORE + n;
+                break;
+            }
+        }
+        current = NULL;
+    }
+
     while (current != NULL)
     {
         *minimum = *minimum > *(current->scores + testNumber) ? *(current->scores + testNumber) : *minimum;
         current = current->next;
+        nSteps++;
     }
+    PROFILE_ADD(pContext, nRecordSteps, nSteps);
 
     return SUCCESS;
 }
@@ -480,22 +962,72 @@ ReturnStatus calculate_minimum(int testNumber, double *minimum)
 /**
  * @brief Calculates the maximum score for a specific test across all students.
  *
+ * The score summary of the context is used instead of the table when there is one.
+ *
+ * @param pContext The grading context that owns the student table.
  * @param testNumber The test number for which the maximum will be calculated.
  * @param maximum Pointer to store the calculated maximum score.
  *
  * @return SUCCESS if the maximum is calculated successfully.
  */
-ReturnStatus calculate_maximum(int testNumber, double *maximum)
+ReturnStatus calculate_maximum(GradingContext *pContext, int testNumber, double *maximum)
 {
-    Record *current = head;
+    Record *current = pContext->table.head;
+    const ScoreSummary *pSummary = pContext->pScoreSummary;
+    long nSteps = 0; // Records visited
 
     *maximum = MINIMUM_SCORE;
 
+    // The highest score value any student has
+    if (pSummary != NULL)
+    {
+        const int *counts = pSummary->counts + testNumber * SCORE_VALUE_COUNT;
+        for (int n = SCORE_VALUE_COUNT - 1; n >= 0; n--)
+        {
+            if (counts[n] > 0)
+            {
+                *maximum = MINIMUM_SCORE + n;
+                break;
+            }
+        }
+        current = NULL;
+    }
+
     while (current != NULL)
     {
         *maximum = *maximum < *(current->scores + testNumber) ? *(current->scores + testNumber) : *maximum;
         current = current->next;
+        nSteps++;
+    }
+    PROFILE_ADD(pContext, nRecordSteps, nSteps);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Adds a student's scores to a score summary, or removes them.
+ *
+ * @param pSummary The score summary kept for the student table.
+ * @param record The student record whose scores are counted.
+ * @param direction 1 to add the scores, -1 to remove them.
+ *
+ * @return SUCCESS if the scores are counted.
+ *         FAILURE if the record has a different number of scores than the summary.
+ */
+ReturnStatus update_score_summary(ScoreSummary *pSummary, const Record *record, int direction)
+{
+    if (record->numberOfScores != pSummary->nTests)
+    {
+        return FAILURE;
+    }
+
+    for (int n = 0; n < pSummary->nTests; n++)
+    {
+        int score = record->scores[n];
+        pSummary->sums[n] += direction * score;
+        pSummary->counts[n * SCORE_VALUE_COUNT + score - MINIMUM_SCORE] += direction;
     }
+    pSummary->nStudents += direction;
 
     return SUCCESS;
 }
@@ -504,38 +1036,46 @@ ReturnStatus calculate_maximum(int testNumber, double *maximum)
  * @brief Deletes all student records and frees the allocated memory.
  *
  * This function clears the memory for all student records, including their names, scores, 
- * and the student record structures.
+ * and the student record structures, and leaves the student table empty.
+ *
+ * @param pContext The grading context that owns the student table.
  *
  * @return SUCCESS if the records are deleted successfully.
  *         FAILURE if there is an error clearing any of the records.
  */
-ReturnStatus delete_students(void)
+ReturnStatus delete_students(GradingContext *pContext)
 {
-    Record *current = head;
+    Record *current = pContext->table.head;
     Record *next = NULL;
 
     while (current != NULL)
     {
         next = current->next;
 
-        if (clear_string_memory(current->name) != SUCCESS)
+        if (clear_string_memory(pContext, current->name) != SUCCESS)
         {
             return FAILURE;
         }
 
-        if (clear_int_array_memory(current->scores) != SUCCESS)
+        if (clear_int_array_memory(pContext, current->scores) != SUCCESS)
         {
             return FAILURE;
         }
 
-        if (clear_record_memory(current) != SUCCESS)
+        if (clear_record_memory(pContext, current) != SUCCESS)
         {
             return FAILURE;
         };
 
         current = next;
-        head = current;
+        pContext->table.head = current;
+        pContext->table.nStudents--;
     }
 
+    pContext->table.tail = NULL;
+
+    // Every record, score array and name should be gone with the table
+    report_allocation_leaks(pContext);
+
     return SUCCESS;
 }
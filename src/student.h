@@ -5,16 +5,34 @@
 #include "messages.h"
 #include "types.h"
 
-ReturnStatus create_student(const char *);
-ReturnStatus delete_students();
+extern const GradingSchema DEFAULT_GRADING_SCHEMA;
+extern const char *const STAT_NAMES[];
 
-ReturnStatus calculate_student_grade(void);
-ReturnStatus set_number_of_students(int *);
-ReturnStatus write_names_and_grades_to_file(FILE *pFILE);
+ReturnStatus create_student(GradingContext *, const char *);
+ReturnStatus check_student_data(GradingContext *, const char *, Boolean *, RejectDiagnostic *);
+ReturnStatus delete_students(GradingContext *);
 
-ReturnStatus show_header(void);
-ReturnStatus show_average(void);
-ReturnStatus show_minimum(void);
-ReturnStatus show_maximum(void);
+ReturnStatus calculate_student_grade(GradingContext *);
+ReturnStatus calculate_grade(GradingContext *, Record *, GradeDistribution *);
+ReturnStatus remove_student_grade(GradingContext *, const Record *, GradeDistribution *);
+ReturnStatus merge_grade_distribution(GradeDistribution *, const GradeDistribution *);
+ReturnStatus set_number_of_students(GradingContext *, int *);
+ReturnStatus sort_students(GradingContext *);
+ReturnStatus write_names_and_grades_to_file(GradingContext *, FILE *pFILE);
+
+ReturnStatus calculate_average(GradingContext *, int, double *);
+ReturnStatus calculate_minimum(GradingContext *, int, double *);
+ReturnStatus calculate_maximum(GradingContext *, int, double *);
+ReturnStatus update_score_summary(ScoreSummary *, const Record *, int);
+
+ReturnStatus show_header(GradingContext *, FILE *);
+ReturnStatus show_average(GradingContext *, FILE *);
+ReturnStatus show_minimum(GradingContext *, FILE *);
+ReturnStatus show_maximum(GradingContext *, FILE *);
+ReturnStatus show_grade_distribution(GradingContext *, FILE *);
+ReturnStatus show_score_histogram(GradingContext *, FILE *);
+
+ReturnStatus write_statistics_csv(GradingContext *, FILE *);
+ReturnStatus write_statistics_json(GradingContext *, FILE *);
 
 #endif // STUDENT_H
\ No newline at end of file
@@ -0,0 +1,423 @@
+/**
+ * @file threadpool.c
+ * @brief Work-stealing thread pool for running grading jobs in parallel.
+ *
+ * Every worker owns a task queue. Submitted tasks are spread over the queues round robin,
+ * and every queue is run oldest first, so a worker runs its tasks in the order they were
+ * submitted: a caller that submits its largest jobs first has them started first. A worker
+ * whose queue is empty steals the oldest task of another worker. Taking a task only locks
+ * the queue it is taken from; the shared state lock is used only by idle workers going to
+ * sleep, and by the last task to finish when it wakes the caller waiting for the pool.
+ */
+
+// Library includes
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <unistd.h> // for sysconf
+
+// Code includes
+#include "threadpool.h"
+
+// Define a queued task
+typedef struct
+{
+    TaskFunction function; // Function to run
+    void *argument;        // Argument passed to the function
+} Task;
+
+// Define the task queue of one worker
+typedef struct
+{
+    pthread_mutex_t lock; // Protects the queue
+    Task *tasks;          // Circular buffer of tasks
+    int capacity;         // Number of slots in 'tasks'
+    int first;            // Index of the oldest task
+    int nTasks;           // Number of tasks in the queue
+} TaskQueue;
+
+// Define the argument handed to each worker thread
+typedef struct
+{
+    ThreadPool *pool; // Pool the worker belongs to
+    int index;        // Index of the worker's own queue
+} Worker;
+
+// Define thread pool
+struct thread_pool
+{
+    pthread_t *threads;        // Worker threads
+    TaskQueue *queues;         // One task queue per worker
+    Worker *workers;           // Worker thread arguments
+    int nWorkers;              // Number of workers and queues
+    int nStarted;              // Number of worker threads running
+    int nextQueue;             // Queue that receives the next submitted task
+    pthread_mutex_t stateLock; // Serializes submitting with idle workers going to sleep
+    pthread_cond_t workReady;  // Signaled when a task is queued or the pool stops
+    pthread_cond_t workDone;   // Signaled when the last pending task finishes
+    atomic_int nPending;       // Tasks submitted and not yet finished
+    Boolean isStopping;        // TRUE once the pool is being destroyed
+};
+
+// Function declaration
+void *run_worker(void *);
+ReturnStatus push_task(TaskQueue *, Task);
+Boolean pop_oldest_task(TaskQueue *, Task *);
+Boolean find_queued_task(ThreadPool *, int, Task *);
+Boolean has_queued_task(ThreadPool *);
+
+/**
+ * @brief Creates a thread pool and starts its workers.
+ *
+ * @param pPool Pointer that receives the new pool.
+ * @param nWorkers Number of worker threads, or zero to use one per processor.
+ *
+ * @return SUCCESS if the pool is created and all workers are running.
+ *         FAILURE if memory allocation or thread creation fails.
+ */
+ReturnStatus create_thread_pool(ThreadPool **pPool, int nWorkers)
+{
+    nWorkers = (nWorkers > 0) ? nWorkers : get_processor_count();
+
+    ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+    if (pool == NULL)
+    {
+        fprintf(stderr, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+
+    pool->threads = (pthread_t *)calloc(nWorkers, sizeof(pthread_t));
+    pool->queues = (TaskQueue *)calloc(nWorkers, sizeof(TaskQueue));
+    pool->workers = (Worker *)calloc(nWorkers, sizeof(Worker));
+    if (pool->threads == NULL || pool->queues == NULL || pool->workers == NULL)
+    {
+        fprintf(stderr, ERR_MEMORY_ALLOCATION_BUFFER);
+        free(pool->threads);
+        free(pool->queues);
+        free(pool->workers);
+        free(pool);
+        return FAILURE;
+    }
+
+    pthread_mutex_init(&pool->stateLock, NULL);
+    pthread_cond_init(&pool->workReady, NULL);
+    pthread_cond_init(&pool->workDone, NULL);
+    atomic_init(&pool->nPending, 0);
+
+    pool->nWorkers = nWorkers;
+    for (int n = 0; n < nWorkers; n++)
+    {
+        pthread_mutex_init(&pool->queues[n].lock, NULL);
+        pool->workers[n].pool = pool;
+        pool->workers[n].index = n;
+    }
+
+    // Start the workers, stopping the ones already running if one fails to start
+    for (int n = 0; n < nWorkers; n++)
+    {
+        if (pthread_create(&pool->threads[n], NULL, run_worker, &pool->workers[n]) != 0)
+        {
+            fprintf(stderr, ERR_THREAD_CREATE);
+            destroy_thread_pool(&pool);
+            return FAILURE;
+        }
+        pool->nStarted++;
+    }
+
+    *pPool = pool;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Submits a task to the pool.
+ *
+ * Tasks are spread over the worker queues round robin and each queue runs oldest first,
+ * so tasks start roughly in the order they are submitted. Idle workers steal tasks from
+ * busy ones, so the placement only decides which worker tries a task first.
+ *
+ * @param pool The thread pool.
+ * @param function The function to run on a worker.
+ * @param argument The argument passed to the function.
+ *
+ * @return SUCCESS if the task is queued.
+ *         FAILURE if the queue cannot grow.
+ */
+ReturnStatus submit_task(ThreadPool *pool, TaskFunction function, void *argument)
+{
+    Task task = {function, argument};
+
+    pthread_mutex_lock(&pool->stateLock);
+
+    int index = pool->nextQueue;
+    pool->nextQueue = (pool->nextQueue + 1) % pool->nWorkers;
+
+    // Count the task before it is queued, a worker may take and finish it right away
+    atomic_fetch_add(&pool->nPending, 1);
+    if (push_task(&pool->queues[index], task) != SUCCESS)
+    {
+        if (atomic_fetch_sub(&pool->nPending, 1) == 1)
+        {
+            pthread_cond_broadcast(&pool->workDone);
+        }
+        pthread_mutex_unlock(&pool->stateLock);
+        return FAILURE;
+    }
+
+    pthread_cond_signal(&pool->workReady);
+
+    pthread_mutex_unlock(&pool->stateLock);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Waits until every submitted task has finished.
+ *
+ * @param pool The thread pool.
+ *
+ * @return SUCCESS once the pool is idle.
+ */
+ReturnStatus wait_thread_pool(ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->stateLock);
+
+    while (atomic_load(&pool->nPending) > 0)
+    {
+        pthread_cond_wait(&pool->workDone, &pool->stateLock);
+    }
+
+    pthread_mutex_unlock(&pool->stateLock);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Stops the workers and releases the pool.
+ *
+ * Tasks still queued are run before the workers exit.
+ *
+ * @param pPool Pointer to the pool, set to NULL afterwards.
+ *
+ * @return SUCCESS after the pool is released.
+ */
+ReturnStatus destroy_thread_pool(ThreadPool **pPool)
+{
+    ThreadPool *pool = *pPool;
+
+    if (pool == NULL)
+    {
+        return SUCCESS;
+    }
+
+    // Wake every worker so it can see the stop flag
+    pthread_mutex_lock(&pool->stateLock);
+    pool->isStopping = TRUE;
+    pthread_cond_broadcast(&pool->workReady);
+    pthread_mutex_unlock(&pool->stateLock);
+
+    for (int n = 0; n < pool->nStarted; n++)
+    {
+        pthread_join(pool->threads[n], NULL);
+    }
+
+    for (int n = 0; n < pool->nWorkers; n++)
+    {
+        pthread_mutex_destroy(&pool->queues[n].lock);
+        free(pool->queues[n].tasks);
+    }
+
+    pthread_cond_destroy(&pool->workDone);
+    pthread_cond_destroy(&pool->workReady);
+    pthread_mutex_destroy(&pool->stateLock);
+
+    free(pool->threads);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool);
+
+    *pPool = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the number of online processors.
+ *
+ * @return The number of processors, or one if it cannot be determined.
+ */
+int get_processor_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    return (nProcessors > 0) ? (int)nProcessors : 1;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * The worker takes the oldest task of its own queue, or steals the oldest task of another
+ * worker. Only when every queue is empty does it take the state lock, and it sleeps there
+ * until a task is submitted. Tasks are pushed under the state lock, so a task submitted
+ * while the worker checks the queues under that lock is always seen or signaled.
+ *
+ * @param pArgument The worker's 'Worker' argument.
+ *
+ * @return NULL when the pool stops.
+ */
+void *run_worker(void *pArgument)
+{
+    Worker *worker = (Worker *)pArgument;
+    ThreadPool *pool = worker->pool;
+
+    while (TRUE)
+    {
+        Task task;
+        if (find_queued_task(pool, worker->index, &task) == FALSE)
+        {
+            // Sleep until a task is queued or the pool stops
+            pthread_mutex_lock(&pool->stateLock);
+            Boolean hasTask = has_queued_task(pool);
+            while (hasTask == FALSE && pool->isStopping == FALSE)
+            {
+                pthread_cond_wait(&pool->workReady, &pool->stateLock);
+                hasTask = has_queued_task(pool);
+            }
+            pthread_mutex_unlock(&pool->stateLock);
+
+            // Tasks still queued when the pool stops are run first
+            if (hasTask == FALSE)
+            {
+                break;
+            }
+            continue;
+        }
+
+        task.function(task.argument);
+
+        if (atomic_fetch_sub(&pool->nPending, 1) == 1)
+        {
+            // The caller checks the counter under the state lock before waiting
+            pthread_mutex_lock(&pool->stateLock);
+            pthread_cond_broadcast(&pool->workDone);
+            pthread_mutex_unlock(&pool->stateLock);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Takes the oldest task of a worker's own queue, or steals one from another queue.
+ *
+ * @param pool The thread pool.
+ * @param index Index of the worker's own queue.
+ * @param pTask Receives the task.
+ *
+ * @return TRUE if a task was taken, FALSE if every queue is empty.
+ */
+Boolean find_queued_task(ThreadPool *pool, int index, Task *pTask)
+{
+    for (int n = 0; n < pool->nWorkers; n++)
+    {
+        if (pop_oldest_task(&pool->queues[(index + n) % pool->nWorkers], pTask) == TRUE)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * @brief Checks whether any queue holds a task.
+ *
+ * @param pool The thread pool.
+ *
+ * @return TRUE if a task is queued, otherwise FALSE.
+ */
+Boolean has_queued_task(ThreadPool *pool)
+{
+    Boolean hasTask = FALSE;
+
+    for (int n = 0; n < pool->nWorkers && hasTask == FALSE; n++)
+    {
+        pthread_mutex_lock(&pool->queues[n].lock);
+        hasTask = (pool->queues[n].nTasks > 0) ? TRUE : FALSE;
+        pthread_mutex_unlock(&pool->queues[n].lock);
+    }
+
+    return hasTask;
+}
+
+/**
+ * @brief Adds a task to the newest end of a queue, growing the queue when it is full.
+ *
+ * @param queue The task queue.
+ * @param task The task to add.
+ *
+ * @return SUCCESS if the task is added.
+ *         FAILURE if the queue cannot grow.
+ */
+ReturnStatus push_task(TaskQueue *queue, Task task)
+{
+    pthread_mutex_lock(&queue->lock);
+
+    if (queue->nTasks == queue->capacity)
+    {
+        int capacity = (queue->capacity > 0) ? queue->capacity * 2 : THREAD_POOL_QUEUE_SIZE;
+        Task *tasks = (Task *)malloc(capacity * sizeof(Task));
+        if (tasks == NULL)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            fprintf(stderr, ERR_MEMORY_ALLOCATION_BUFFER);
+            return FAILURE;
+        }
+
+        // Unwrap the circular buffer into the new one
+        for (int n = 0; n < queue->nTasks; n++)
+        {
+            tasks[n] = queue->tasks[(queue->first + n) % queue->capacity];
+        }
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->capacity = capacity;
+        queue->first = 0;
+    }
+
+    queue->tasks[(queue->first + queue->nTasks) % queue->capacity] = task;
+    queue->nTasks++;
+
+    pthread_mutex_unlock(&queue->lock);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Takes the oldest task of a queue, for its own worker or for a thief.
+ *
+ * @param queue The task queue.
+ * @param pTask Receives the task.
+ *
+ * @return TRUE if a task was taken, FALSE if the queue is empty.
+ */
+Boolean pop_oldest_task(TaskQueue *queue, Task *pTask)
+{
+    Boolean isFound = FALSE;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->nTasks > 0)
+    {
+        *pTask = queue->tasks[queue->first];
+        queue->first = (queue->first + 1) % queue->capacity;
+        queue->nTasks--;
+        isFound = TRUE;
+    }
+    pthread_mutex_unlock(&queue->lock);
+
+    return isFound;
+}
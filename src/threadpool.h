@@ -0,0 +1,21 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+// Opaque thread pool handle
+typedef struct thread_pool ThreadPool;
+
+// Task run by a pool worker
+typedef void (*TaskFunction)(void *);
+
+ReturnStatus create_thread_pool(ThreadPool **, int);
+ReturnStatus submit_task(ThreadPool *, TaskFunction, void *);
+ReturnStatus wait_thread_pool(ThreadPool *);
+ReturnStatus destroy_thread_pool(ThreadPool **);
+
+int get_processor_count(void);
+
+#endif // THREADPOOL_H
@@ -0,0 +1,297 @@
+/**
+ * @file trace.c
+ * @brief Trace event recording of pipeline stages in Chrome trace format.
+ *
+ * Every thread that records an event gets a ring buffer of its own the first time it
+ * records, so recording takes no lock: a thread only ever writes its own buffer. New
+ * buffers are pushed onto the tracer's list with a compare and swap. When a buffer is full
+ * the oldest events are overwritten and counted as dropped. Each event is a complete event
+ * (begin time and duration) of one stage of one roster or byte range.
+ *
+ * 'write_trace' writes the events as Chrome trace JSON, which chrome://tracing and
+ * ui.perfetto.dev show as one timeline row per thread. It must only be called once every
+ * recording thread has finished, for example after the thread pool is destroyed.
+ */
+
+// Library includes
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h> // for calloc and free
+#include <string.h>
+
+// Code includes
+#include "profiler.h"
+#include "trace.h"
+
+// Define one recorded stage
+typedef struct
+{
+    const char *stage;           // Stage name, a string constant
+    char file[TRACE_LABEL_SIZE]; // Base name of the roster, cut to fit
+    int chunk;                   // Index of the byte range, TRACE_WHOLE_FILE for a whole roster
+    long long start;             // Monotonic time the stage began, in nanoseconds
+    long long duration;          // Duration of the stage in nanoseconds
+} TraceEvent;
+
+// Define the ring buffer of one recording thread
+typedef struct trace_buffer
+{
+    TraceEvent events[TRACE_RING_SIZE]; // Ring of the newest events
+    long nEvents;                       // Events recorded, including overwritten ones
+    int threadId;                       // Timeline row of the thread
+    struct trace_buffer *next;          // Next buffer of the tracer
+} TraceBuffer;
+
+// Define tracer
+struct tracer
+{
+    long long startTime;            // Time of the first timeline tick
+    pthread_key_t bufferKey;        // Buffer of the calling thread
+    _Atomic(TraceBuffer *) buffers; // Buffers of all recording threads
+    atomic_int nThreads;            // Number of buffers handed out
+};
+
+// Function declaration
+TraceBuffer *get_thread_buffer(Tracer *);
+ReturnStatus write_trace_string(FILE *, const char *);
+
+/**
+ * @brief Creates a tracer and starts its timeline.
+ *
+ * @param pTracer Pointer that receives the new tracer.
+ *
+ * @return SUCCESS if the tracer is created.
+ *         FAILURE if memory or the thread key cannot be allocated.
+ */
+ReturnStatus create_tracer(Tracer **pTracer)
+{
+    Tracer *tracer = (Tracer *)calloc(1, sizeof(Tracer));
+    if (tracer == NULL)
+    {
+        fprintf(stderr, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+
+    if (pthread_key_create(&tracer->bufferKey, NULL) != 0)
+    {
+        fprintf(stderr, ERR_MEMORY_ALLOCATION_BUFFER);
+        free(tracer);
+        return FAILURE;
+    }
+    atomic_init(&tracer->buffers, NULL);
+    atomic_init(&tracer->nThreads, 0);
+    tracer->startTime = get_trace_time();
+
+    *pTracer = tracer;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Releases a tracer and every thread buffer.
+ *
+ * @param pTracer Pointer to the tracer, set to NULL afterwards.
+ *
+ * @return SUCCESS after the tracer is released.
+ */
+ReturnStatus destroy_tracer(Tracer **pTracer)
+{
+    Tracer *tracer = *pTracer;
+
+    if (tracer == NULL)
+    {
+        return SUCCESS;
+    }
+
+    TraceBuffer *buffer = atomic_load(&tracer->buffers);
+    while (buffer != NULL)
+    {
+        TraceBuffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+
+    pthread_key_delete(tracer->bufferKey);
+    free(tracer);
+
+    *pTracer = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the time used for trace events.
+ *
+ * @return The monotonic time in nanoseconds.
+ */
+long long get_trace_time(void)
+{
+    return get_monotonic_time();
+}
+
+/**
+ * @brief Records a stage that began at 'start' and ends now.
+ *
+ * Only the calling thread's buffer is written, so threads never wait for each other.
+ * An event is lost only if the thread's buffer cannot be allocated.
+ *
+ * @param tracer The tracer.
+ * @param pStage The stage name, a string constant that outlives the tracer.
+ * @param pFileName The roster the stage worked on, or NULL if the stage does not know it.
+ * @param chunk The index of the byte range, or TRACE_WHOLE_FILE.
+ * @param start The time the stage began, from 'get_trace_time'.
+ *
+ * @return SUCCESS if the event is recorded, otherwise FAILURE.
+ */
+ReturnStatus add_trace_event(Tracer *tracer, const char *pStage, const char *pFileName, int chunk, long long start)
+{
+    long long end = get_trace_time();
+
+    TraceBuffer *buffer = get_thread_buffer(tracer);
+    if (buffer == NULL)
+    {
+        return FAILURE;
+    }
+
+    // Keep the base name, the directory is the same for every roster of a run
+    const char *pBaseName = (pFileName != NULL) ? pFileName : "";
+    for (const char *pChar = pBaseName; *pChar != STRING_TERMINATION; pChar++)
+    {
+        if (*pChar == PATH_SEPARATOR_CHAR || *pChar == PATH_SEPARATOR_WINDOWS_CHAR)
+        {
+            pBaseName = pChar + 1;
+        }
+    }
+
+    TraceEvent *event = &buffer->events[buffer->nEvents % TRACE_RING_SIZE];
+    event->stage = pStage;
+    snprintf(event->file, TRACE_LABEL_SIZE, "%s", pBaseName);
+    event->chunk = chunk;
+    event->start = start;
+    event->duration = end - start;
+    buffer->nEvents++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the recorded events as a Chrome trace JSON object.
+ *
+ * Timestamps are microseconds since the tracer was created. Each thread gets a name
+ * metadata event so the viewer labels its row, and the number of events overwritten in
+ * full ring buffers is reported in 'otherData'.
+ *
+ * @param tracer The tracer.
+ * @param pStream The stream that receives the trace.
+ *
+ * @return SUCCESS after the trace is written.
+ */
+ReturnStatus write_trace(const Tracer *tracer, FILE *pStream)
+{
+    long nDropped = 0;
+    Boolean isFirst = TRUE;
+
+    fprintf(pStream, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (TraceBuffer *buffer = atomic_load(&tracer->buffers); buffer != NULL; buffer = buffer->next)
+    {
+        fprintf(pStream, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+                (isFirst == TRUE) ? "" : ",", TRACE_PROCESS_ID, buffer->threadId, TRACE_THREAD_NAME, buffer->threadId);
+        isFirst = FALSE;
+
+        // Oldest event still in the ring first
+        long nFirst = (buffer->nEvents > TRACE_RING_SIZE) ? buffer->nEvents - TRACE_RING_SIZE : 0;
+        nDropped += nFirst;
+
+        for (long n = nFirst; n < buffer->nEvents; n++)
+        {
+            const TraceEvent *event = &buffer->events[n % TRACE_RING_SIZE];
+
+            fprintf(pStream, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,",
+                    event->stage, TRACE_CATEGORY, TRACE_PROCESS_ID, buffer->threadId,
+                    (event->start - tracer->startTime) / NANOSECONDS_PER_MICROSECOND,
+                    event->duration / NANOSECONDS_PER_MICROSECOND);
+            // Stages that do not know their roster, such as a sort, show up nested in one that does
+            fprintf(pStream, "\"args\":{");
+            if (event->file[0] != STRING_TERMINATION)
+            {
+                fprintf(pStream, "\"file\":");
+                write_trace_string(pStream, event->file);
+            }
+            if (event->chunk != TRACE_WHOLE_FILE)
+            {
+                fprintf(pStream, "%s\"chunk\":%d", (event->file[0] != STRING_TERMINATION) ? "," : "", event->chunk);
+            }
+            fprintf(pStream, "}}");
+        }
+    }
+
+    fprintf(pStream, "\n],\"otherData\":{\"droppedEvents\":%ld}}\n", nDropped);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Returns the ring buffer of the calling thread, creating it on first use.
+ *
+ * @param tracer The tracer.
+ *
+ * @return The buffer, or NULL if it cannot be allocated.
+ */
+TraceBuffer *get_thread_buffer(Tracer *tracer)
+{
+    TraceBuffer *buffer = (TraceBuffer *)pthread_getspecific(tracer->bufferKey);
+    if (buffer != NULL)
+    {
+        return buffer;
+    }
+
+    buffer = (TraceBuffer *)calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL)
+    {
+        return NULL;
+    }
+    buffer->threadId = atomic_fetch_add(&tracer->nThreads, 1);
+
+    // Push the buffer onto the list without a lock
+    buffer->next = atomic_load(&tracer->buffers);
+    while (atomic_compare_exchange_weak(&tracer->buffers, &buffer->next, buffer) == FALSE)
+    {
+    }
+
+    pthread_setspecific(tracer->bufferKey, buffer);
+
+    return buffer;
+}
+
+/**
+ * @brief Writes a string as a JSON string literal.
+ *
+ * @param pStream The stream.
+ * @param pString The string.
+ *
+ * @return SUCCESS after the string is written.
+ */
+ReturnStatus write_trace_string(FILE *pStream, const char *pString)
+{
+    fputc('"', pStream);
+    for (const unsigned char *pChar = (const unsigned char *)pString; *pChar != STRING_TERMINATION; pChar++)
+    {
+        if (*pChar == '"' || *pChar == '\\')
+        {
+            fprintf(pStream, "\\%c", *pChar);
+        }
+        else if (*pChar < ' ')
+        {
+            fprintf(pStream, "\\u%04x", *pChar);
+        }
+        else
+        {
+            fputc(*pChar, pStream);
+        }
+    }
+    fputc('"', pStream);
+
+    return SUCCESS;
+}
@@ -0,0 +1,32 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+// Trace points. Without a tracer on the context a point costs one predictable branch;
+// building with -DPROFILING_DISABLED removes the points completely.
+#ifndef PROFILING_DISABLED
+#define TRACE_START(pContext, start) \
+    long long start = ((pContext)->pTracer != NULL) ? get_trace_time() : 0
+#define TRACE_STOP(pContext, stage, pFileName, chunk, start)                                  \
+    do                                                                                        \
+    {                                                                                         \
+        if ((pContext)->pTracer != NULL)                                                      \
+        {                                                                                     \
+            add_trace_event((pContext)->pTracer, (stage), (pFileName), (chunk), (start));     \
+        }                                                                                     \
+    } while (FALSE)
+#else
+#define TRACE_START(pContext, start)
+#define TRACE_STOP(pContext, stage, pFileName, chunk, start)
+#endif
+
+ReturnStatus create_tracer(Tracer **);
+ReturnStatus destroy_tracer(Tracer **);
+long long get_trace_time(void);
+ReturnStatus add_trace_event(Tracer *, const char *, const char *, int, long long);
+ReturnStatus write_trace(const Tracer *, FILE *);
+
+#endif // TRACE_H
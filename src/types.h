@@ -10,6 +10,11 @@
 #ifndef TYPES_H
 #define TYPES_H
 
+#include <stdint.h>
+#include <stdio.h>
+
+#include "constants.h"
+
 // Define status codes using enum for function return
 typedef enum
 {
@@ -24,17 +29,376 @@ typedef enum
     FALSE = 0, // 0 for false (standard convention)
 } Boolean;
 
+// Define classes of failure, each reported with its own exit code
+typedef enum
+{
+    ERROR_CLASS_NONE = 0, // Nothing failed
+    ERROR_CLASS_USAGE,    // Invalid command-line options or API call order
+    ERROR_CLASS_INPUT,    // Input cannot be opened or read
+    ERROR_CLASS_DATA,     // Input holds invalid student data
+    ERROR_CLASS_OUTPUT,   // Output cannot be written
+    ERROR_CLASS_MEMORY,   // Memory allocation failed
+    ERROR_CLASS_SECTION,  // One or more batch sections failed
+} ErrorClass;
+
+// Define formats of the class statistics report
+typedef enum
+{
+    STATS_FORMAT_TEXT = 0, // Console tables and histogram
+    STATS_FORMAT_CSV,      // One 'statistic,name,value' row per value
+    STATS_FORMAT_JSON,     // One JSON object
+    STATS_FORMAT_NONE,     // No statistics
+} StatsFormat;
+
+// Define formats of the letter grade output
+typedef enum
+{
+    OUTPUT_FORMAT_TEXT = 0, // Padded names and letters under a header line
+    OUTPUT_FORMAT_CSV,      // 'name,weighted_score,grade' rows under a header row
+    OUTPUT_FORMAT_JSONL,    // One JSON object per student and line
+    OUTPUT_FORMAT_BINARY,   // Packed little endian records after a small header
+    NUMBER_OF_OUTPUT_FORMATS,
+} OutputFormat;
+
+// Define reasons a row is skipped by error tolerant parsing
+typedef enum
+{
+    REJECT_REASON_NAME_EMPTY = 0, // Row holds no name
+    REJECT_REASON_SCORE_RANGE,    // A score is outside the score range
+    REJECT_REASON_SCORE_COUNT,    // Row holds more or fewer scores than the schema has tests
+    NUMBER_OF_REJECT_REASONS,
+} RejectReason;
+
+// Define how input files are read ahead of the parser
+typedef enum
+{
+    READ_AHEAD_AUTO = 0, // io_uring where the kernel allows it, otherwise a read-ahead thread
+    READ_AHEAD_THREAD,   // A read-ahead thread with a ring of blocks
+    READ_AHEAD_OFF,      // Blocking reads on the parsing thread
+} ReadAheadMode;
+
+// Define orders of the letter grade output
+typedef enum
+{
+    SORT_ORDER_NAME = 0, // By name
+    SORT_ORDER_SCORE,    // By weighted score, highest first, then by name
+    SORT_ORDER_GRADE,    // By letter grade, then by name
+} SortOrder;
+
+// Define how names are compared when students are sorted by name
+typedef enum
+{
+    NAME_COLLATION_BYTE = 0, // Bytes of the names, as 'strcmp' compares them
+    NAME_COLLATION_FOLD,     // Case and accents folded, so 'de la Cruz' and 'Émile' sort as 'de la cruz' and 'emile'
+    NAME_COLLATION_LOCALE,   // The collation of the 'LC_COLLATE' locale, as 'strcoll' compares names
+} NameCollation;
+
+// Define what is done with students listed more than once in a roster
+typedef enum
+{
+    DUPLICATE_POLICY_NONE = 0, // Duplicates are not looked for, every row is graded
+    DUPLICATE_POLICY_FIRST,    // The first row of a student is graded, later rows are dropped
+    DUPLICATE_POLICY_LAST,     // The last row of a student is graded, earlier rows are dropped
+    DUPLICATE_POLICY_ERROR,    // A second row of a student fails the run
+    DUPLICATE_POLICY_MERGE,    // The rows of a student are merged by the highest score of every test
+} DuplicatePolicy;
+
+// Define how many students a top or bottom list holds
+typedef struct
+{
+    int nCount;     // Number of students, zero when a percent is given or no list is requested
+    double percent; // Percent of the class, zero when a count is given or no list is requested
+} RankSize;
+
+// Define options selected on the command line
+typedef struct
+{
+    const char *pReadFileName;         // Input file, '-' for standard input
+    const char *pWriteFileName;        // Output file, '-' for standard output, or the batch output directory
+    const char *pBatchSource;          // Directory or manifest of rosters, NULL outside batch mode
+    int nThreads;                      // Number of worker threads, zero for one per processor
+    Boolean isQuiet;                   // TRUE to print no progress messages
+    Boolean isNoWait;                  // TRUE to exit without waiting for Enter
+    Boolean isTiming;                  // TRUE to report the time spent in each phase
+    const char *pTraceFileName;        // Chrome trace output, NULL to record no trace
+    const char *pMemoryReportFileName; // Allocation report output, NULL to write none
+    const char *pDaemonSocketName;     // Unix domain socket of daemon mode, NULL outside daemon mode
+    Boolean isWatch;                   // TRUE to re-grade the input whenever it changes
+    const char *pIndexFileName;        // Grade index to write, or to query, NULL for none
+    const char *pLookupName;           // Student to look up in the grade index, NULL for none
+    const char *pQueryPrefix;          // Name prefix to list from the grade index, NULL for none
+    const char *pQueryFrom;            // Lowest name to list from the grade index, NULL for the first
+    const char *pQueryTo;              // Highest name or prefix to list from the grade index, NULL for the last
+    const char *pRejectsFileName;      // Rejects file of error tolerant parsing, NULL to fail on an invalid row
+    Boolean isHelp;                    // TRUE to print the usage and exit
+    Boolean isDefaultFileName;         // TRUE if a default input or output file name is used
+    Boolean isStatsFormatSet;          // TRUE if the statistics format was given explicitly
+    StatsFormat statsFormat;           // Format of the class statistics report
+    OutputFormat outputFormat;         // Format of the letter grade output
+    ReadAheadMode readAheadMode;       // How input files are read ahead of the parser
+    SortOrder sortOrder;               // Order of the students in the letter grade output
+    NameCollation collation;           // How names are compared when students are sorted by name
+    DuplicatePolicy duplicatePolicy;   // What is done with students listed more than once
+    RankSize topSize;                  // Students with the highest weighted scores to report
+    RankSize bottomSize;               // Students with the lowest weighted scores to report
+    const char *pRankFileName;         // Top and bottom students output, NULL to write none
+    FILE *pReportStream;               // Stream for progress messages and statistics
+} CommandLineOptions;
+
 // Define student record structure
 struct node
 {
-    char *name;         // Pointer to student's name
-    int *scores;        // Pointer to an array of student scores
-    int numberOfScores; // Number of scores in the 'scores' array
-    char grade;         // Letter grade for the student
-    struct node *next;  // Pointer to the next record in the list
+    char *name;           // Pointer to student's name
+    int *scores;          // Pointer to an array of student scores
+    int numberOfScores;   // Number of scores in the 'scores' array
+    double weightedScore; // Weighted score used to pick the letter grade
+    char grade;           // Letter grade for the student
+    struct node *next;    // Pointer to the next record in the list
 };
 
 // Define Record as a typedef for convenience
 typedef struct node Record;
 
+// Define grade distribution accumulated while grading
+typedef struct
+{
+    int letterCount[NUMBER_OF_GRADES];          // Number of students per letter grade
+    int scoreHistogram[HISTOGRAM_BUCKET_COUNT]; // Number of students per weighted score bucket
+    int nGraded;                                // Number of students graded
+} GradeDistribution;
+
+// Define categories of allocations made through 'memory.c'
+typedef enum
+{
+    ALLOCATION_STRING = 0, // Student names and tokenizer lines
+    ALLOCATION_ARRAY,      // Score arrays
+    ALLOCATION_RECORD,     // Student records
+    ALLOCATION_BUFFER,     // General purpose buffers
+    NUMBER_OF_ALLOCATION_CATEGORIES,
+} AllocationCategory;
+
+// Define byte counters and size histogram of one allocation category
+typedef struct
+{
+    long long nLiveBytes;                                  // Bytes of the live allocations as reported by the C library
+    long long nPeakBytes;                                  // Most live bytes at any time
+    long long nRequestedBytes;                             // Bytes requested by every allocation so far
+    long nAllocations;                                     // Allocations made so far
+    long sizeHistogram[ALLOCATION_HISTOGRAM_BUCKET_COUNT]; // Allocations per power of two of the requested size
+} AllocationProfile;
+
+// Define allocation counters owned by a grading context
+typedef struct
+{
+    int nStringAllocationCount;                                 // Number of live string allocations
+    int nArrayAllocationCount;                                  // Number of live integer array allocations
+    int nRecordAllocationCount;                                 // Number of live record allocations
+    int nBufferAllocationCount;                                 // Number of live general purpose buffer allocations
+    AllocationProfile profile[NUMBER_OF_ALLOCATION_CATEGORIES]; // Bytes and sizes per category
+    long long nLiveBytes;                                       // Bytes of all live allocations
+    long long nPeakBytes;                                       // Most live bytes of all categories together at any time
+} Allocator;
+
+// Define tokenizer state for one comma separated line
+typedef struct
+{
+    char *buffer;          // Copy of the line being tokenized, followed by 'SCAN_BLOCK_SIZE' zero bytes
+    char *cursor;          // Position where the next token starts
+    char *block;           // Start of the scanned block that holds the cursor
+    uint64_t fieldEndMask; // Commas and terminators of the block, from 'get_field_end_mask'
+} Tokenizer;
+
+// Opaque asynchronous reader that keeps reads of a file in flight ahead of the parser
+typedef struct read_ahead ReadAhead;
+
+// Define compression of an input stream, found from its magic number
+typedef enum
+{
+    COMPRESSION_NONE = 0, // Plain text
+    COMPRESSION_GZIP,     // gzip, read through zlib
+    COMPRESSION_ZSTD,     // Zstandard, read through libzstd
+} CompressionFormat;
+
+// Opaque decompressing thread that feeds the parser from a ring of decompressed bytes
+typedef struct decompressor Decompressor;
+
+// Define scan for the occurrences of one character in a buffer, a block at a time
+typedef struct
+{
+    const char *pData;           // Buffer being scanned
+    long nSize;                  // Number of bytes in the buffer
+    long nBlock;                 // Offset of the block the mask belongs to
+    uint64_t mask;               // Occurrences in the block not returned yet
+    char character;              // Character being found
+    char spare[SCAN_BLOCK_SIZE]; // Zero filled copy of a short last block
+} CharacterScan;
+
+// Define forward-only line reader for streams that may not support seeking
+typedef struct
+{
+    int descriptor;              // Descriptor of the stream being read
+    char *buffer;                // Buffered input, with one spare byte for a terminator
+    long capacity;               // Number of input bytes 'buffer' can hold
+    long start;                  // First buffered byte not yet returned in a line
+    long end;                    // Byte after the last buffered byte
+    long nBytesRead;             // Total bytes read from the stream
+    Boolean isEndOfStream;       // TRUE once the stream reported its end
+    CharacterScan newLines;      // Newlines of the buffered bytes after 'start'
+    ReadAhead *pReadAhead;       // Reads in flight ahead of the parser, NULL to read the descriptor directly
+    Decompressor *pDecompressor; // Decompressing thread of a compressed stream, NULL for plain text
+} LineReader;
+
+// Define grading schema (test weights, names and letter thresholds)
+typedef struct
+{
+    const double *testWeights;    // Weight of each test in the weighted score
+    const char *const *testNames; // Name of each test for reports
+    int nTests;                   // Number of tests (scores required per student)
+    const double *gradeThreshold; // Lowest weighted score for each letter grade
+    const char *gradeLetter;      // Letter for each grade threshold
+} GradingSchema;
+
+// Define student table as a linked list with a tail for constant time append
+typedef struct
+{
+    Record *head;  // First record in the list
+    Record *tail;  // Last record in the list
+    int nStudents; // Number of records in the list
+} StudentTable;
+
+// Define students with the highest and lowest weighted scores, ties broken by name
+typedef struct
+{
+    Record **top;    // Highest weighted scores, highest first
+    int nTop;        // Students in 'top'
+    Record **bottom; // Lowest weighted scores, lowest first
+    int nBottom;     // Students in 'bottom'
+} StudentRanking;
+
+// Define phases of a grading run measured by the profiler
+typedef enum
+{
+    PHASE_READ = 0, // Reading input blocks from the stream
+    PHASE_TOKENIZE, // Splitting lines into comma separated tokens
+    PHASE_PARSE,    // Building student records from tokens, excluding tokenizing
+    PHASE_GRADE,    // Calculating weighted scores and letter grades
+    PHASE_SORT,     // Sorting the student table by name
+    PHASE_FORMAT,   // Formatting the letter grades into the output stream
+    PHASE_WRITE,    // Flushing and closing the output
+    PHASE_FREE,     // Releasing the student records
+    NUMBER_OF_PHASES,
+} Phase;
+
+// Define phase timing and throughput counters of one grading job
+typedef struct
+{
+    Boolean isEnabled;                          // TRUE to measure, FALSE leaves every counter untouched
+    long long startTime;                        // Monotonic time the run started, in nanoseconds
+    long long phaseTime[NUMBER_OF_PHASES];      // Nanoseconds spent in each phase
+    long phaseIntervals[NUMBER_OF_PHASES];      // Number of measured intervals of each phase
+    long long nBytesRead;                       // Bytes read from the input
+    long long nBytesWritten;                    // Bytes of letter grades written
+    int nRows;                                  // Student records graded
+    long long nRecordSteps;                     // Records visited by appends and walks over the table
+    long long nNameComparisons;                 // Name comparisons of the merge sort by name
+    Allocator parsedAllocations;                // Live allocations once the input is parsed
+    Allocator freedAllocations;                 // Live allocations left after the records are released
+} Profiler;
+
+// Opaque trace event recorder shared by the threads of a run
+typedef struct tracer Tracer;
+
+// Define per-test score counts kept up to date while records are added and removed
+typedef struct
+{
+    int nTests;      // Number of tests counted
+    int nStudents;   // Number of students counted
+    long long *sums; // Sum of the scores of each test
+    int *counts;     // Students per score value, one row of 'SCORE_VALUE_COUNT' per test
+} ScoreSummary;
+
+// Opaque watch of an input file and the lines of its last version
+typedef struct file_watch FileWatch;
+
+// Define header of a grade index file, followed by the entries and the name block
+typedef struct
+{
+    char magic[INDEX_MAGIC_SIZE]; // 'INDEX_MAGIC'
+    uint32_t version;             // 'INDEX_VERSION'
+    uint32_t entrySize;           // Bytes of one entry, files of another layout are rejected
+    uint64_t nStudents;           // Number of entries
+    uint64_t namesOffset;         // Byte offset of the name block in the file
+    uint64_t namesSize;           // Bytes in the name block
+} GradeIndexHeader;
+
+// Define one student of a grade index file, the entries are sorted by name
+typedef struct
+{
+    uint64_t nameOffset;  // Offset of the null terminated name in the name block
+    double weightedScore; // Weighted score of the student
+    uint32_t nameLength;  // Characters in the name, without the terminator
+    char grade;           // Letter grade of the student
+    char reserved[3];     // Zero
+} GradeIndexEntry;
+
+// Define one student read from a grade index
+typedef struct
+{
+    const char *name;     // Name inside the index, valid until the index is closed
+    char grade;           // Letter grade
+    double weightedScore; // Weighted score
+} IndexedStudent;
+
+// Opaque grade index mapped for queries
+typedef struct grade_index GradeIndex;
+
+// Define what one reload of a watched file changed
+typedef struct
+{
+    int nParsed;       // Lines parsed and graded because they are new or changed
+    int nReused;       // Lines whose record was kept from the previous version
+    int nRemoved;      // Records of the previous version no longer in the file
+    Boolean isChanged; // FALSE if the file holds the same lines in the same order
+} ReloadSummary;
+
+// Define diagnostic of one rejected row
+typedef struct
+{
+    long lineNumber;                    // Line of the row in the input, counted from one
+    RejectReason reason;                // Why the row was rejected
+    char message[REJECT_MESSAGE_SIZE];  // Reason with the offending value
+} RejectDiagnostic;
+
+// Define log of the rows skipped by error tolerant parsing
+typedef struct
+{
+    FILE *pFile;                                           // Rejects file that receives every skipped row
+    const char *pFileName;                                 // Name of the rejects file for messages
+    long nRejected;                                        // Rows skipped
+    long reasonCount[NUMBER_OF_REJECT_REASONS];            // Rows skipped for each reason
+    RejectDiagnostic diagnostics[REJECT_DIAGNOSTIC_COUNT]; // First rejects, later ones are only counted
+    int nDiagnostics;                                      // Diagnostics kept in 'diagnostics'
+} RejectLog;
+
+// Define grading context that owns all state of one grading job
+typedef struct
+{
+    StudentTable table;             // Student records of this job
+    const GradingSchema *schema;    // Schema used to grade the records
+    Allocator allocator;            // Allocation counters of this job
+    Tokenizer tokenizer;            // Tokenizer state of the line being parsed
+    GradeDistribution distribution; // Grade distribution of the last grading pass
+    FILE *pMessageStream;           // Stream for error and warning messages, NULL to stay silent
+    char lastMessage[MESSAGE_BUFFER_SIZE]; // Last error or warning message reported
+    ErrorClass errorClass;          // Class of the last error reported
+    Profiler profiler;              // Phase timing of this job, disabled by default
+    Tracer *pTracer;                // Trace event recorder, NULL to record nothing
+    ScoreSummary *pScoreSummary;    // Score counts of the table, NULL to scan the table for statistics
+    RejectLog *pRejectLog;          // Rows skipped while parsing, NULL to fail on the first invalid row
+    ReadAheadMode readAheadMode;    // How input files are read ahead of the parser
+    SortOrder sortOrder;            // Order of the students in the letter grade output
+    NameCollation collation;        // How names are compared when students are sorted by name
+    StudentRanking ranking;         // Top and bottom students of the last ranking, empty unless ranked
+} GradingContext;
+
 #endif // TYPES_H
\ No newline at end of file
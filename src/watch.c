@@ -0,0 +1,745 @@
+/**
+ * @file watch.c
+ * @brief Watches an input file and reloads it incrementally after every change.
+ *
+ * Watch mode keeps the graded students of the last version of the input in memory. When
+ * the file changes, every line is hashed and looked up in an index of the lines of the
+ * previous version, which keeps a copy of each line so a hash collision is never taken for
+ * the same line: a line that was already there keeps its graded record, so only new
+ * or edited lines are parsed and graded. Records whose line is gone are released. The
+ * grade distribution and a per-test score summary are updated record by record, so the
+ * class statistics never scan the table again.
+ *
+ * Changes are reported by inotify on the directory of the input, so editors that save by
+ * writing a new file and renaming it over the input are seen as well. A burst of events
+ * is merged into one change once the file has been quiet for 'WATCH_DEBOUNCE_MS'.
+ *
+ * SIGINT and SIGTERM stop the watch. They are blocked everywhere except while waiting for
+ * a change, so a reload or the output it writes is never interrupted half way.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <stdlib.h> // for malloc and free
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "watch.h"
+
+#ifdef __linux__
+
+// Library includes
+#include <errno.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Code includes
+#include "file.h"
+#include "helper.h"
+#include "memory.h"
+#include "profiler.h"
+#include "student.h"
+
+// Define one line of the last version of the watched file
+typedef struct
+{
+    unsigned long long hash; // Hash of the line, 0 for an empty slot
+    char *line;              // Copy of the line, NULL once it is claimed
+    int nSize;               // Number of characters in the line
+    Record *record;          // Graded record of the line, NULL once it is claimed
+} LineSlot;
+
+// Define lines of one version of the watched file, an open addressing hash table
+typedef struct
+{
+    LineSlot *slots; // Slots, 'capacity' of them
+    int capacity;    // Number of slots, a power of two
+    int nLines;      // Number of slots in use
+} LineIndex;
+
+// Define watch state
+struct file_watch
+{
+    int inotify;                     // Change notification descriptor
+    int epoll;                       // Descriptor the watch waits on
+    char directory[FILE_NAME_SIZE];  // Directory of the watched file
+    const char *pBaseName;           // Name of the watched file in its directory
+    LineIndex index;                 // Lines of the last version loaded
+    unsigned long long fileHash;     // Hash of every line of the last version, in order
+    Boolean isLoaded;                // TRUE once a version is loaded, FALSE again if its output failed
+    ScoreSummary summary;            // Score counts of the loaded students
+    sigset_t originalSignals;        // Signal mask before the watch started
+};
+
+// Set by the signal handler, the only state of the watch outside 'FileWatch'
+static volatile sig_atomic_t isStopRequested = 0;
+
+// Function declaration
+void request_watch_stop(int);
+Boolean read_file_changes(FileWatch *);
+unsigned long long hash_line(const char *, int);
+Record *claim_line(LineIndex *, LineSlot *);
+ReturnStatus insert_line(GradingContext *, LineIndex *, const LineSlot *);
+ReturnStatus release_unclaimed_lines(GradingContext *, LineIndex *, Boolean, int *);
+ReturnStatus clear_line_index(GradingContext *, LineIndex *);
+ReturnStatus delete_student(GradingContext *, Record *);
+ReturnStatus reset_file_watch(GradingContext *, FileWatch *);
+
+/**
+ * @brief Starts watching a file for changes.
+ *
+ * The grading context gets the score summary of the watch, so its statistics follow the
+ * reloaded students without scanning them.
+ *
+ * @param pContext The grading context that receives the students of the watched file.
+ * @param ppWatch Pointer that receives the watch.
+ * @param pFileName Name of the file to watch.
+ *
+ * @return SUCCESS if the file is watched.
+ *         FAILURE if the directory of the file cannot be watched or memory runs out.
+ */
+ReturnStatus open_file_watch(GradingContext *pContext, FileWatch **ppWatch, const char *pFileName)
+{
+    FileWatch *watch = malloc(sizeof(FileWatch));
+    if (watch == NULL)
+    {
+        report_error(pContext, ERROR_CLASS_MEMORY, ERR_MEMORY_ALLOCATION_BUFFER);
+        return FAILURE;
+    }
+    *watch = (FileWatch){0};
+    watch->inotify = watch->epoll = -1;
+
+    // Split the name into its directory and the name within it
+    snprintf(watch->directory, FILE_NAME_SIZE, "%s", pFileName);
+    char *pSeparator = strrchr(watch->directory, PATH_SEPARATOR_CHAR);
+    if (pSeparator == NULL)
+    {
+        watch->pBaseName = pFileName;
+        snprintf(watch->directory, FILE_NAME_SIZE, ".");
+    }
+    else
+    {
+        watch->pBaseName = pFileName + (pSeparator - watch->directory) + 1;
+        *(pSeparator + (pSeparator == watch->directory ? 1 : 0)) = STRING_TERMINATION;
+    }
+
+    // The directory is watched, the file itself may be replaced by a rename
+    struct epoll_event event = {.events = EPOLLIN};
+    watch->inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    watch->epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (watch->inotify < 0 || watch->epoll < 0 ||
+        inotify_add_watch(watch->inotify, watch->directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY) < 0 ||
+        epoll_ctl(watch->epoll, EPOLL_CTL_ADD, watch->inotify, &event) != 0)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_WATCH_OPEN, pFileName);
+        close_file_watch(pContext, &watch);
+        return FAILURE;
+    }
+
+    // Per-test score counts, kept up to date by every reload
+    ScoreSummary *pSummary = &watch->summary;
+    pSummary->nTests = pContext->schema->nTests;
+    if (allocate_buffer_memory(pContext, (void **)&pSummary->sums, pSummary->nTests * sizeof(long long)) != SUCCESS ||
+        allocate_buffer_memory(pContext, (void **)&pSummary->counts,
+                               pSummary->nTests * SCORE_VALUE_COUNT * sizeof(int)) != SUCCESS)
+    {
+        close_file_watch(pContext, &watch);
+        return FAILURE;
+    }
+    memset(pSummary->sums, 0, pSummary->nTests * sizeof(long long));
+    memset(pSummary->counts, 0, pSummary->nTests * SCORE_VALUE_COUNT * sizeof(int));
+    pContext->pScoreSummary = pSummary;
+
+    // Only the wait for a change lets the stop signals through
+    sigset_t stopSignals;
+    struct sigaction action = {0};
+    action.sa_handler = request_watch_stop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &stopSignals, &watch->originalSignals);
+
+    *ppWatch = watch;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Stops watching a file and releases the watch.
+ *
+ * The students of the last version stay in the grading context, which now computes its
+ * statistics from the table again.
+ *
+ * @param pContext The grading context the watch was opened with.
+ * @param ppWatch Pointer to the watch, set to NULL.
+ *
+ * @return SUCCESS once the watch is released.
+ */
+ReturnStatus close_file_watch(GradingContext *pContext, FileWatch **ppWatch)
+{
+    FileWatch *watch = *ppWatch;
+    if (watch == NULL)
+    {
+        return SUCCESS;
+    }
+
+    // The stop signals are blocked once the score summary is attached
+    if (pContext->pScoreSummary == &watch->summary)
+    {
+        pContext->pScoreSummary = NULL;
+        sigprocmask(SIG_SETMASK, &watch->originalSignals, NULL);
+    }
+    clear_buffer_memory(pContext, watch->summary.sums);
+    clear_buffer_memory(pContext, watch->summary.counts);
+    clear_line_index(pContext, &watch->index);
+
+    if (watch->inotify >= 0)
+    {
+        close(watch->inotify);
+    }
+    if (watch->epoll >= 0)
+    {
+        close(watch->epoll);
+    }
+
+    free(watch);
+    *ppWatch = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Waits until the watched file has changed and stayed unchanged for a while.
+ *
+ * Returns as soon as a stop signal arrives, even while a change is pending.
+ *
+ * @param pContext The grading context that reports errors.
+ * @param watch The watch.
+ * @param pIsStopped Pointer that receives TRUE if the watch was asked to stop.
+ *
+ * @return SUCCESS on a change or a stop signal.
+ *         FAILURE if waiting for events fails.
+ */
+ReturnStatus wait_for_file_change(GradingContext *pContext, FileWatch *watch, Boolean *pIsStopped)
+{
+    struct epoll_event event;
+    int timeout = -1; // Wait without limit until the first change
+
+    *pIsStopped = FALSE;
+
+    while (isStopRequested == 0)
+    {
+        int nEvents = epoll_pwait(watch->epoll, &event, 1, timeout, &watch->originalSignals);
+        if (nEvents < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            report_error(pContext, ERROR_CLASS_INPUT, ERR_WATCH_OPEN, watch->pBaseName);
+            return FAILURE;
+        }
+
+        // Quiet for the debounce time after a change
+        if (nEvents == 0)
+        {
+            return SUCCESS;
+        }
+
+        // Every further change starts the quiet time again
+        if (read_file_changes(watch) == TRUE)
+        {
+            timeout = WATCH_DEBOUNCE_MS;
+        }
+    }
+
+    *pIsStopped = TRUE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Signal handler that asks the watch to stop.
+ *
+ * @param signalNumber The signal received.
+ */
+void request_watch_stop(int signalNumber)
+{
+    (void)signalNumber;
+    isStopRequested = 1;
+}
+
+/**
+ * @brief Reads the pending change events of the watched directory.
+ *
+ * @param watch The watch.
+ *
+ * @return TRUE if any event is about the watched file.
+ */
+Boolean read_file_changes(FileWatch *watch)
+{
+    _Alignas(struct inotify_event) char buffer[WATCH_EVENT_BUFFER_SIZE];
+    Boolean isChanged = FALSE;
+    ssize_t nBytes = 0;
+
+    while ((nBytes = read(watch->inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *pEvent = buffer; pEvent < buffer + nBytes;)
+        {
+            const struct inotify_event *event = (const struct inotify_event *)pEvent;
+            if (event->len > 0 && strcmp(event->name, watch->pBaseName) == 0)
+            {
+                isChanged = TRUE;
+            }
+            pEvent += sizeof(struct inotify_event) + event->len;
+        }
+    }
+
+    return isChanged;
+}
+
+/**
+ * @brief Reloads the students of a watched file after a change.
+ *
+ * The student table of the context is rebuilt in file order. Lines that were already in
+ * the previous version keep their graded record; new lines are parsed and graded, and
+ * records whose line is gone are deleted. The grade distribution and score summary are
+ * updated for the added and removed records only. If the file cannot be loaded, every
+ * student is deleted and the next reload parses the whole file.
+ *
+ * @param pContext The grading context that owns the students.
+ * @param watch The watch of the file.
+ * @param pFile The watched file, open in read mode.
+ * @param pFileName Name of the file for error messages.
+ * @param pReload Pointer that receives what the reload changed.
+ *
+ * @return SUCCESS if the file is loaded and graded.
+ *         FAILURE if the file is empty, holds invalid student data or memory runs out.
+ */
+ReturnStatus reload_watched_file(GradingContext *pContext, FileWatch *watch, FILE *pFile, const char *pFileName,
+                                 ReloadSummary *pReload)
+{
+    LineIndex previous = watch->index;
+    LineIndex current = {0};
+    LineReader reader;
+    ReturnStatus status = SUCCESS;
+    unsigned long long fileHash = LINE_HASH_OFFSET;
+    char *DataString = NULL; // Line returned by the reader
+    int DataSize = 0;        // Number of characters in the line
+
+    *pReload = (ReloadSummary){0};
+
+    // The records of the previous version stay reachable through its index
+    pContext->table = (StudentTable){0};
+    watch->index = (LineIndex){0};
+
+    if (open_line_reader(pContext, &reader, pFile) != SUCCESS)
+    {
+        status = FAILURE;
+    }
+
+    while (status == SUCCESS)
+    {
+        if (read_next_line(pContext, &reader, pFileName, &DataString, &DataSize) != SUCCESS)
+        {
+            status = FAILURE;
+            break;
+        }
+
+        // Stop at the end of the stream or the first empty line
+        if (DataString == NULL || DataSize == 0)
+        {
+            break;
+        }
+
+        LineSlot line = {hash_line(DataString, DataSize), DataString, DataSize, NULL};
+        fileHash = (fileHash ^ line.hash) * LINE_HASH_PRIME;
+
+        // A line of the previous version keeps its graded record and its copy
+        Record *record = claim_line(&previous, &line);
+        if (record != NULL)
+        {
+            status = add_record_to_list(pContext, record);
+            pReload->nReused++;
+        }
+        else
+        {
+            if (allocate_string_memory(pContext, &line.line, DataSize) != SUCCESS)
+            {
+                status = FAILURE;
+                break;
+            }
+            memcpy(line.line, DataString, DataSize);
+            line.line[DataSize] = '\0';
+
+            PROFILE_START(pContext, parseStart);
+            status = create_student(pContext, DataString);
+            PROFILE_STOP(pContext, PHASE_PARSE, parseStart);
+            if (status == SUCCESS)
+            {
+                record = pContext->table.tail;
+                PROFILE_START(pContext, gradeStart);
+                status = calculate_grade(pContext, record, &pContext->distribution);
+                PROFILE_STOP(pContext, PHASE_GRADE, gradeStart);
+            }
+            if (status == SUCCESS)
+            {
+                status = update_score_summary(&watch->summary, record, 1);
+            }
+            pReload->nParsed++;
+        }
+
+        line.record = record;
+        if (status != SUCCESS || insert_line(pContext, &current, &line) != SUCCESS)
+        {
+            clear_string_memory(pContext, line.line);
+            status = FAILURE;
+        }
+    }
+
+    // Emptiness is only known once the end of the stream is reached
+    if (status == SUCCESS && reader.nBytesRead == 0)
+    {
+        report_error(pContext, ERROR_CLASS_INPUT, ERR_FILE_EMPTY, pFileName);
+        status = FAILURE;
+    }
+
+    close_line_reader(pContext, &reader);
+
+    if (status != SUCCESS)
+    {
+        // Start over from an empty table, the records left in the old index are not in it
+        release_unclaimed_lines(pContext, &previous, FALSE, NULL);
+        clear_line_index(pContext, &previous);
+        clear_line_index(pContext, &current);
+        reset_file_watch(pContext, watch);
+        return FAILURE;
+    }
+
+    // Lines that are gone take their records with them
+    release_unclaimed_lines(pContext, &previous, TRUE, &pReload->nRemoved);
+    clear_line_index(pContext, &previous);
+
+    pReload->isChanged = (watch->isLoaded == FALSE || fileHash != watch->fileHash || pReload->nParsed > 0 ||
+                          pReload->nRemoved > 0) ? TRUE : FALSE;
+    watch->index = current;
+    watch->fileHash = fileHash;
+    watch->isLoaded = TRUE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Makes the next reload count as a change after the loaded version failed to be written.
+ *
+ * The students and lines of the loaded version are kept, so unchanged lines are still
+ * reused, but the next reload is reported as changed even if the file is the same.
+ *
+ * @param watch The watch.
+ *
+ * @return SUCCESS after the watch is invalidated.
+ */
+ReturnStatus invalidate_file_watch(FileWatch *watch)
+{
+    watch->isLoaded = FALSE;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Hashes a line with 64 bit FNV-1a.
+ *
+ * @param pLine The line.
+ * @param nSize Number of characters in the line.
+ *
+ * @return The hash, never 0 so it can mark an empty slot.
+ */
+unsigned long long hash_line(const char *pLine, int nSize)
+{
+    unsigned long long hash = LINE_HASH_OFFSET;
+
+    for (int n = 0; n < nSize; n++)
+    {
+        hash = (hash ^ (unsigned char)pLine[n]) * LINE_HASH_PRIME;
+    }
+
+    return (hash != 0) ? hash : 1;
+}
+
+/**
+ * @brief Takes the record of a line out of the index of the previous version.
+ *
+ * A slot only matches if its copy of the line is the same text, equal hashes are not
+ * enough. A claimed slot keeps its hash, so lines that were stored after it are still
+ * found. Repeated lines are claimed one at a time.
+ *
+ * @param pIndex The index of the previous version.
+ * @param pLine The line with its hash. If it is found, its text is replaced with the copy
+ *              held by the index, which the caller then owns.
+ *
+ * @return The record of the line, or NULL if the line is not in the index.
+ */
+Record *claim_line(LineIndex *pIndex, LineSlot *pLine)
+{
+    if (pIndex->capacity == 0)
+    {
+        return NULL;
+    }
+
+    unsigned long long mask = (unsigned long long)pIndex->capacity - 1;
+    for (unsigned long long n = pLine->hash & mask; pIndex->slots[n].hash != 0; n = (n + 1) & mask)
+    {
+        LineSlot *pSlot = &pIndex->slots[n];
+        if (pSlot->hash == pLine->hash && pSlot->record != NULL && pSlot->nSize == pLine->nSize &&
+            memcmp(pSlot->line, pLine->line, pLine->nSize) == 0)
+        {
+            Record *record = pSlot->record;
+            pLine->line = pSlot->line;
+            pSlot->line = NULL;
+            pSlot->record = NULL;
+            return record;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Adds a line of the version being loaded to its index.
+ *
+ * The index is doubled whenever it would become more than half full.
+ *
+ * @param pContext The grading context that owns the index memory.
+ * @param pIndex The index of the version being loaded.
+ * @param pLine The line, its hash, its copy that the index takes over and its graded record.
+ *
+ * @return SUCCESS if the line is added.
+ *         FAILURE if the index cannot grow.
+ */
+ReturnStatus insert_line(GradingContext *pContext, LineIndex *pIndex, const LineSlot *pLine)
+{
+    if ((pIndex->nLines + 1) * 2 > pIndex->capacity)
+    {
+        LineIndex grown = {0};
+        grown.capacity = (pIndex->capacity > 0) ? pIndex->capacity * 2 : WATCH_INDEX_INITIAL_CAPACITY;
+        if (allocate_buffer_memory(pContext, (void **)&grown.slots, grown.capacity * sizeof(LineSlot)) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        memset(grown.slots, 0, grown.capacity * sizeof(LineSlot));
+
+        for (int n = 0; n < pIndex->capacity; n++)
+        {
+            if (pIndex->slots[n].hash != 0)
+            {
+                insert_line(pContext, &grown, &pIndex->slots[n]);
+            }
+        }
+        clear_buffer_memory(pContext, pIndex->slots);
+        *pIndex = grown;
+    }
+
+    unsigned long long mask = (unsigned long long)pIndex->capacity - 1;
+    unsigned long long n = pLine->hash & mask;
+    while (pIndex->slots[n].hash != 0)
+    {
+        n = (n + 1) & mask;
+    }
+    pIndex->slots[n] = *pLine;
+    pIndex->nLines++;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Deletes the records of the previous version whose line was not seen again.
+ *
+ * @param pContext The grading context that owns the records.
+ * @param pIndex The index of the previous version.
+ * @param isCounted TRUE to take the records out of the distribution and score summary.
+ * @param pnRemoved Pointer that receives the number of records deleted, or NULL.
+ *
+ * @return SUCCESS once the records are deleted.
+ *         FAILURE if a record could not be deleted.
+ */
+ReturnStatus release_unclaimed_lines(GradingContext *pContext, LineIndex *pIndex, Boolean isCounted, int *pnRemoved)
+{
+    int nRemoved = 0;
+
+    for (int n = 0; n < pIndex->capacity; n++)
+    {
+        Record *record = pIndex->slots[n].record;
+        if (record == NULL)
+        {
+            continue;
+        }
+
+        if (isCounted == TRUE)
+        {
+            remove_student_grade(pContext, record, &pContext->distribution);
+            update_score_summary(pContext->pScoreSummary, record, -1);
+        }
+        pIndex->slots[n].record = NULL;
+        if (delete_student(pContext, record) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        nRemoved++;
+    }
+
+    if (pnRemoved != NULL)
+    {
+        *pnRemoved = nRemoved;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Frees the line copies and the slots of an index.
+ *
+ * @param pContext The grading context that owns the index memory.
+ * @param pIndex The index, empty afterwards.
+ *
+ * @return SUCCESS once the index is freed.
+ */
+ReturnStatus clear_line_index(GradingContext *pContext, LineIndex *pIndex)
+{
+    for (int n = 0; n < pIndex->capacity; n++)
+    {
+        clear_string_memory(pContext, pIndex->slots[n].line);
+    }
+    clear_buffer_memory(pContext, pIndex->slots);
+    *pIndex = (LineIndex){0};
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Deletes one student record that is not in the student table.
+ *
+ * @param pContext The grading context that owns the record.
+ * @param record The record to delete.
+ *
+ * @return SUCCESS if the record is deleted, otherwise FAILURE.
+ */
+ReturnStatus delete_student(GradingContext *pContext, Record *record)
+{
+    if (clear_string_memory(pContext, record->name) != SUCCESS ||
+        clear_int_array_memory(pContext, record->scores) != SUCCESS ||
+        clear_record_memory(pContext, record) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Deletes every student and forgets the loaded version after a failed reload.
+ *
+ * @param pContext The grading context that owns the students.
+ * @param watch The watch.
+ *
+ * @return SUCCESS once the watch holds no version.
+ */
+ReturnStatus reset_file_watch(GradingContext *pContext, FileWatch *watch)
+{
+    ScoreSummary *pSummary = &watch->summary;
+
+    delete_students(pContext);
+    pContext->distribution = (GradeDistribution){0};
+
+    memset(pSummary->sums, 0, pSummary->nTests * sizeof(long long));
+    memset(pSummary->counts, 0, pSummary->nTests * SCORE_VALUE_COUNT * sizeof(int));
+    pSummary->nStudents = 0;
+
+    watch->index = (LineIndex){0};
+    watch->fileHash = 0;
+    watch->isLoaded = FALSE;
+
+    return SUCCESS;
+}
+
+#else
+
+/**
+ * @brief Reports that watch mode is not available without inotify.
+ *
+ * @return FAILURE.
+ */
+ReturnStatus open_file_watch(GradingContext *pContext, FileWatch **ppWatch, const char *pFileName)
+{
+    (void)pFileName;
+
+    *ppWatch = NULL;
+    report_error(pContext, ERROR_CLASS_USAGE, ERR_WATCH_UNSUPPORTED);
+
+    return FAILURE;
+}
+
+/**
+ * @brief Nothing to release without inotify.
+ *
+ * @return SUCCESS.
+ */
+ReturnStatus close_file_watch(GradingContext *pContext, FileWatch **ppWatch)
+{
+    (void)pContext;
+
+    *ppWatch = NULL;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Never called, a watch cannot be opened without inotify.
+ *
+ * @return FAILURE.
+ */
+ReturnStatus wait_for_file_change(GradingContext *pContext, FileWatch *watch, Boolean *pIsStopped)
+{
+    (void)watch;
+
+    *pIsStopped = TRUE;
+    report_error(pContext, ERROR_CLASS_USAGE, ERR_WATCH_UNSUPPORTED);
+
+    return FAILURE;
+}
+
+/**
+ * @brief Never called, a watch cannot be opened without inotify.
+ *
+ * @return FAILURE.
+ */
+ReturnStatus reload_watched_file(GradingContext *pContext, FileWatch *watch, FILE *pFile, const char *pFileName,
+                                 ReloadSummary *pReload)
+{
+    (void)watch;
+    (void)pFile;
+    (void)pFileName;
+
+    *pReload = (ReloadSummary){0};
+    report_error(pContext, ERROR_CLASS_USAGE, ERR_WATCH_UNSUPPORTED);
+
+    return FAILURE;
+}
+
+/**
+ * @brief Never called, a watch cannot be opened without inotify.
+ *
+ * @return SUCCESS.
+ */
+ReturnStatus invalidate_file_watch(FileWatch *watch)
+{
+    (void)watch;
+
+    return SUCCESS;
+}
+
+#endif // __linux__
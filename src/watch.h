@@ -0,0 +1,14 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus open_file_watch(GradingContext *, FileWatch **, const char *);
+ReturnStatus close_file_watch(GradingContext *, FileWatch **);
+ReturnStatus wait_for_file_change(GradingContext *, FileWatch *, Boolean *);
+ReturnStatus reload_watched_file(GradingContext *, FileWatch *, FILE *, const char *, ReloadSummary *);
+ReturnStatus invalidate_file_watch(FileWatch *);
+
+#endif // WATCH_H
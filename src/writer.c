@@ -0,0 +1,469 @@
+/**
+ * @file writer.c
+ * @brief Letter grade output in text and in machine readable formats.
+ *
+ * The text output pads names for people to read. Programs get one of three formats
+ * instead, each written by a small writer that formats a header and one record at a time:
+ *
+ *     csv       'name,weighted_score,grade' rows under a header row
+ *     jsonl     {"name":"...","score":84.40,"grade":"B"} on each line
+ *     binary    a header and packed little endian records, see 'write_binary_header'
+ *
+ * The writers do not use 'fprintf'. Fields are formatted by hand into one buffer of
+ * 'OUTPUT_BUFFER_SIZE' bytes that is handed to the stream whenever it fills up, so a large
+ * export is limited by the stream rather than by formatting. Names are escaped as each
+ * format requires and weighted scores are written with two decimals.
+ */
+
+// Library includes
+#include <stdio.h>
+#include <string.h>
+
+// Code includes
+#include "context.h"
+#include "file.h"
+#include "memory.h"
+#include "profiler.h"
+#include "student.h"
+#include "writer.h"
+
+// Define buffer the records are formatted into
+typedef struct
+{
+    char *data;              // Formatted bytes not yet handed to the stream
+    long nUsed;              // Bytes in 'data'
+    long capacity;           // Size of 'data'
+    FILE *pFile;             // Stream that receives the bytes
+    long long nBytesWritten; // Bytes handed to the stream so far
+    Boolean isFailed;        // TRUE once the stream refused bytes
+} OutputBuffer;
+
+// Define writer of one output format
+typedef struct
+{
+    ReturnStatus (*writeHeader)(OutputBuffer *, int, const char *); // Before the first record, or NULL
+    ReturnStatus (*writeRecord)(OutputBuffer *, const Record *);    // One student
+} OutputWriter;
+
+// Function declaration
+ReturnStatus flush_output(OutputBuffer *);
+ReturnStatus reserve_output(OutputBuffer *, long);
+ReturnStatus append_bytes(OutputBuffer *, const char *, long);
+ReturnStatus append_unsigned(OutputBuffer *, unsigned long);
+ReturnStatus append_score(OutputBuffer *, double);
+ReturnStatus append_little_endian(OutputBuffer *, unsigned long, int);
+ReturnStatus write_csv_header(OutputBuffer *, int, const char *);
+ReturnStatus write_csv_record(OutputBuffer *, const Record *);
+ReturnStatus write_jsonl_record(OutputBuffer *, const Record *);
+ReturnStatus write_binary_header(OutputBuffer *, int, const char *);
+ReturnStatus write_binary_record(OutputBuffer *, const Record *);
+
+// Writers of the machine readable formats, in the order of 'OutputFormat'
+const OutputWriter OUTPUT_WRITERS[] = {
+    {NULL, NULL},
+    {write_csv_header, write_csv_record},
+    {NULL, write_jsonl_record},
+    {write_binary_header, write_binary_record},
+};
+
+/**
+ * @brief Writes the letter grades of the student table in an output format.
+ *
+ * The table is sorted in the output order of the context first, as for the text output.
+ *
+ * @param pContext The grading context that owns the student table.
+ * @param pFile The output stream.
+ * @param pReadFileName Name of the input, written in the text header.
+ * @param format The output format.
+ *
+ * @return SUCCESS if the letter grades are written, otherwise FAILURE.
+ */
+ReturnStatus write_student_output(GradingContext *pContext, FILE *pFile, const char *pReadFileName,
+                                  OutputFormat format)
+{
+    if (format == OUTPUT_FORMAT_TEXT)
+    {
+        if (write_file_header(pContext, pFile, pReadFileName) != SUCCESS || write_file_data(pContext, pFile) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        return SUCCESS;
+    }
+
+    const OutputWriter *pWriter = &OUTPUT_WRITERS[format];
+    OutputBuffer buffer = {0};
+
+    if (sort_students(pContext) != SUCCESS)
+    {
+        return FAILURE;
+    }
+
+    if (allocate_buffer_memory(pContext, (void **)&buffer.data, OUTPUT_BUFFER_SIZE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    buffer.capacity = OUTPUT_BUFFER_SIZE;
+    buffer.pFile = pFile;
+
+    PROFILE_START(pContext, formatStart);
+    if (pWriter->writeHeader != NULL)
+    {
+        pWriter->writeHeader(&buffer, pContext->table.nStudents, pReadFileName);
+    }
+    for (const Record *current = pContext->table.head; current != NULL && buffer.isFailed == FALSE;
+         current = current->next)
+    {
+        pWriter->writeRecord(&buffer, current);
+    }
+    flush_output(&buffer);
+    PROFILE_STOP(pContext, PHASE_FORMAT, formatStart);
+    PROFILE_ADD(pContext, nBytesWritten, buffer.nBytesWritten);
+
+    clear_buffer_memory(pContext, buffer.data);
+
+    // Write errors are reported by the caller when the stream is closed
+    return SUCCESS;
+}
+
+/**
+ * @brief Hands the formatted bytes to the stream.
+ *
+ * @param pBuffer The output buffer.
+ *
+ * @return SUCCESS if the stream took every byte, otherwise FAILURE.
+ */
+ReturnStatus flush_output(OutputBuffer *pBuffer)
+{
+    if (pBuffer->nUsed > 0 && pBuffer->isFailed == FALSE &&
+        fwrite(pBuffer->data, 1, pBuffer->nUsed, pBuffer->pFile) != (size_t)pBuffer->nUsed)
+    {
+        pBuffer->isFailed = TRUE;
+    }
+    pBuffer->nBytesWritten += pBuffer->nUsed;
+    pBuffer->nUsed = 0;
+
+    return (pBuffer->isFailed == TRUE) ? FAILURE : SUCCESS;
+}
+
+/**
+ * @brief Makes room for a number of bytes in the buffer.
+ *
+ * @param pBuffer The output buffer.
+ * @param nBytes Bytes needed, at most the capacity of the buffer.
+ *
+ * @return SUCCESS if the bytes fit, otherwise FAILURE.
+ */
+ReturnStatus reserve_output(OutputBuffer *pBuffer, long nBytes)
+{
+    if (pBuffer->nUsed + nBytes > pBuffer->capacity)
+    {
+        return flush_output(pBuffer);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends bytes of any length to the buffer.
+ *
+ * @param pBuffer The output buffer.
+ * @param pBytes The bytes.
+ * @param nBytes Number of bytes.
+ *
+ * @return SUCCESS if the bytes are appended, otherwise FAILURE.
+ */
+ReturnStatus append_bytes(OutputBuffer *pBuffer, const char *pBytes, long nBytes)
+{
+    while (nBytes > 0)
+    {
+        if (pBuffer->nUsed == pBuffer->capacity && flush_output(pBuffer) != SUCCESS)
+        {
+            return FAILURE;
+        }
+
+        long nCopy = pBuffer->capacity - pBuffer->nUsed;
+        nCopy = (nCopy < nBytes) ? nCopy : nBytes;
+        memcpy(pBuffer->data + pBuffer->nUsed, pBytes, nCopy);
+        pBuffer->nUsed += nCopy;
+        pBytes += nCopy;
+        nBytes -= nCopy;
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends the decimal digits of a number, room must be reserved.
+ *
+ * @param pBuffer The output buffer.
+ * @param value The number.
+ *
+ * @return SUCCESS after the digits are appended.
+ */
+ReturnStatus append_unsigned(OutputBuffer *pBuffer, unsigned long value)
+{
+    char digits[24];
+    int nDigits = 0;
+
+    do
+    {
+        digits[nDigits++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (nDigits > 0)
+    {
+        pBuffer->data[pBuffer->nUsed++] = digits[--nDigits];
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends a weighted score with two decimals, room must be reserved.
+ *
+ * @param pBuffer The output buffer.
+ * @param score The weighted score.
+ *
+ * @return SUCCESS after the score is appended.
+ */
+ReturnStatus append_score(OutputBuffer *pBuffer, double score)
+{
+    long hundredths = get_score_hundredths(score);
+
+    if (hundredths < 0)
+    {
+        pBuffer->data[pBuffer->nUsed++] = '-';
+        hundredths = -hundredths;
+    }
+
+    append_unsigned(pBuffer, (unsigned long)(hundredths / SCORE_HUNDREDTHS));
+    pBuffer->data[pBuffer->nUsed++] = '.';
+    pBuffer->data[pBuffer->nUsed++] = (char)('0' + hundredths % SCORE_HUNDREDTHS / 10);
+    pBuffer->data[pBuffer->nUsed++] = (char)('0' + hundredths % 10);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Appends an unsigned number in little endian byte order, room must be reserved.
+ *
+ * @param pBuffer The output buffer.
+ * @param value The number.
+ * @param nBytes Number of bytes to write.
+ *
+ * @return SUCCESS after the bytes are appended.
+ */
+ReturnStatus append_little_endian(OutputBuffer *pBuffer, unsigned long value, int nBytes)
+{
+    for (int n = 0; n < nBytes; n++)
+    {
+        pBuffer->data[pBuffer->nUsed++] = (char)((value >> (8 * n)) & 0xFF);
+    }
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Rounds a weighted score to hundredths.
+ *
+ * @param score The weighted score.
+ *
+ * @return The score in hundredths, rounded half away from zero.
+ */
+long get_score_hundredths(double score)
+{
+    double scaled = score * SCORE_HUNDREDTHS;
+
+    return (long)(scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+/**
+ * @brief Writes the header row of the CSV output.
+ *
+ * @param pBuffer The output buffer.
+ * @param nStudents Number of students that follow.
+ * @param pReadFileName Name of the input.
+ *
+ * @return SUCCESS if the header is written, otherwise FAILURE.
+ */
+ReturnStatus write_csv_header(OutputBuffer *pBuffer, int nStudents, const char *pReadFileName)
+{
+    (void)nStudents;
+    (void)pReadFileName;
+
+    return append_bytes(pBuffer, OUTPUT_CSV_HEADER, strlen(OUTPUT_CSV_HEADER));
+}
+
+/**
+ * @brief Writes one student as a CSV row.
+ *
+ * A name with a comma, a quote or a line break is quoted and its quotes are doubled.
+ *
+ * @param pBuffer The output buffer.
+ * @param record The student.
+ *
+ * @return SUCCESS if the row is written, otherwise FAILURE.
+ */
+ReturnStatus write_csv_record(OutputBuffer *pBuffer, const Record *record)
+{
+    const char *pName = record->name;
+    long nLength = (long)strcspn(pName, ",\"\r\n");
+
+    if (pName[nLength] == STRING_TERMINATION)
+    {
+        append_bytes(pBuffer, pName, nLength);
+    }
+    else
+    {
+        append_bytes(pBuffer, "\"", 1);
+        for (const char *pQuote = pName; *pQuote != STRING_TERMINATION; pName = pQuote)
+        {
+            pQuote = strchr(pName, '"');
+            pQuote = (pQuote != NULL) ? pQuote + 1 : pName + strlen(pName);
+            append_bytes(pBuffer, pName, pQuote - pName);
+            if (pQuote[-1] == '"')
+            {
+                append_bytes(pBuffer, "\"", 1);
+            }
+        }
+        append_bytes(pBuffer, "\"", 1);
+    }
+
+    if (reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    pBuffer->data[pBuffer->nUsed++] = COMMA_CHAR;
+    append_score(pBuffer, record->weightedScore);
+    pBuffer->data[pBuffer->nUsed++] = COMMA_CHAR;
+    pBuffer->data[pBuffer->nUsed++] = record->grade;
+    pBuffer->data[pBuffer->nUsed++] = END_OF_LINE_CHAR;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes one student as a JSON object on its own line.
+ *
+ * Quotes, backslashes and control characters in the name are escaped.
+ *
+ * @param pBuffer The output buffer.
+ * @param record The student.
+ *
+ * @return SUCCESS if the line is written, otherwise FAILURE.
+ */
+ReturnStatus write_jsonl_record(OutputBuffer *pBuffer, const Record *record)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    const char *pName = record->name;
+
+    append_bytes(pBuffer, "{\"name\":\"", 9);
+    while (*pName != STRING_TERMINATION)
+    {
+        // Copy the run of characters that need no escape in one go
+        const char *pEscape = pName;
+        while (*pEscape != STRING_TERMINATION && *pEscape != '"' && *pEscape != '\\' &&
+               (unsigned char)*pEscape >= 0x20)
+        {
+            pEscape++;
+        }
+        append_bytes(pBuffer, pName, pEscape - pName);
+        if (*pEscape == STRING_TERMINATION)
+        {
+            break;
+        }
+
+        if (reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+        {
+            return FAILURE;
+        }
+        unsigned char character = (unsigned char)*pEscape;
+        pBuffer->data[pBuffer->nUsed++] = '\\';
+        if (character == '"' || character == '\\')
+        {
+            pBuffer->data[pBuffer->nUsed++] = (char)character;
+        }
+        else
+        {
+            memcpy(pBuffer->data + pBuffer->nUsed, "u00", 3);
+            pBuffer->nUsed += 3;
+            pBuffer->data[pBuffer->nUsed++] = HEX_DIGITS[character >> 4];
+            pBuffer->data[pBuffer->nUsed++] = HEX_DIGITS[character & 0x0F];
+        }
+        pName = pEscape + 1;
+    }
+
+    if (reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    memcpy(pBuffer->data + pBuffer->nUsed, "\",\"score\":", 10);
+    pBuffer->nUsed += 10;
+    append_score(pBuffer, record->weightedScore);
+    memcpy(pBuffer->data + pBuffer->nUsed, ",\"grade\":\"", 10);
+    pBuffer->nUsed += 10;
+    pBuffer->data[pBuffer->nUsed++] = record->grade;
+    memcpy(pBuffer->data + pBuffer->nUsed, "\"}\n", 3);
+    pBuffer->nUsed += 3;
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes the header of the packed binary output.
+ *
+ * The header is the magic 'OUTPUT_BINARY_MAGIC' with its terminator, then the version and
+ * the number of students as 32 bit little endian numbers. Each student follows as the
+ * name length as a 32 bit number, the name without terminator, the weighted score in
+ * hundredths as a 32 bit number and the letter grade as one byte.
+ *
+ * @param pBuffer The output buffer.
+ * @param nStudents Number of students that follow.
+ * @param pReadFileName Name of the input.
+ *
+ * @return SUCCESS if the header is written, otherwise FAILURE.
+ */
+ReturnStatus write_binary_header(OutputBuffer *pBuffer, int nStudents, const char *pReadFileName)
+{
+    (void)pReadFileName;
+
+    if (append_bytes(pBuffer, OUTPUT_BINARY_MAGIC, OUTPUT_BINARY_MAGIC_SIZE) != SUCCESS ||
+        reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    append_little_endian(pBuffer, OUTPUT_BINARY_VERSION, 4);
+    append_little_endian(pBuffer, (unsigned long)nStudents, 4);
+
+    return SUCCESS;
+}
+
+/**
+ * @brief Writes one student as a packed binary record.
+ *
+ * @param pBuffer The output buffer.
+ * @param record The student.
+ *
+ * @return SUCCESS if the record is written, otherwise FAILURE.
+ */
+ReturnStatus write_binary_record(OutputBuffer *pBuffer, const Record *record)
+{
+    long nLength = (long)strlen(record->name);
+
+    if (reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    append_little_endian(pBuffer, (unsigned long)nLength, 4);
+    append_bytes(pBuffer, record->name, nLength);
+
+    if (reserve_output(pBuffer, OUTPUT_RECORD_RESERVE) != SUCCESS)
+    {
+        return FAILURE;
+    }
+    append_little_endian(pBuffer, (unsigned long)get_score_hundredths(record->weightedScore), 4);
+    pBuffer->data[pBuffer->nUsed++] = record->grade;
+
+    return SUCCESS;
+}
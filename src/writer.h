@@ -0,0 +1,11 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include "constants.h"
+#include "messages.h"
+#include "types.h"
+
+ReturnStatus write_student_output(GradingContext *, FILE *, const char *, OutputFormat);
+long get_score_hundredths(double);
+
+#endif // WRITER_H
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> // for lseek
+
+#include "unity.h"
+#include "context.h"
+#include "file.h"
+#include "helper.h"
+#include "profiler.h"
+#include "student.h"
+
+// Complexity tests count the operations of each hot path on n and on 4n records: the
+// records visited by appending and by the statistics, and the name comparisons of the sort. Counts do not depend on how busy the machine is, so they are checked exactly
+// or against the n log n bound. The line reader does no counted work and is timed instead:
+// linear code takes about 4 to 5 times longer on 4n, quadratic code 16 times longer, and
+// the best of several runs is compared so a busy machine does not fail the test.
+#define COMPLEXITY_SCALE 4         // Size factor between the small and the large run
+#define COMPLEXITY_RATIO_LIMIT 10.0 // Largest time ratio accepted for the large run
+#define COMPLEXITY_RUNS 5          // Runs per size, the fastest one is compared
+#define LIST_SIZE 16000            // Records of the small list run
+#define SORT_SIZE 4000             // Records of the small sort run
+#define LINE_COUNT 16000           // Lines of the small line reader run
+#define TEST_NAME_SIZE 16          // Size of a generated student name
+
+typedef long long (*TimedRun)(int);
+typedef void (*CountedRun)(int);
+
+// Records and names of the list being counted, owned by the test instead of memory.c
+static Record *records;
+static char (*names)[TEST_NAME_SIZE];
+static int scores[1];
+
+/**
+ * @brief Fills a context with n records, named in a shuffled order, and starts its profiler.
+ */
+static void build_records(GradingContext *pContext, int n) {
+    unsigned int state = 12345u;
+
+    init_grading_context(pContext, NULL);
+    set_message_stream(pContext, NULL);
+    start_profiler(&pContext->profiler);
+    for (int i = 0; i < n; i++) {
+        state = state * 1103515245u + 12345u;
+        snprintf(names[i], TEST_NAME_SIZE, "S%08u", state % 100000000u);
+        records[i] = (Record){.name = names[i], .scores = scores, .numberOfScores = 1, .grade = 'F'};
+        add_record_to_list(pContext, &records[i]);
+    }
+}
+
+/**
+ * @brief Runs a counted function on n and on 4n records.
+ */
+static void count_operations(CountedRun run, int n) {
+#ifdef PROFILING_DISABLED
+    (void)run;
+    (void)n;
+    TEST_IGNORE_MESSAGE("operations are counted by the profiler");
+#else
+    records = (Record *)calloc((size_t)n * COMPLEXITY_SCALE, sizeof(Record));
+    names = calloc((size_t)n * COMPLEXITY_SCALE, TEST_NAME_SIZE);
+    TEST_ASSERT_NOT_NULL(records);
+    TEST_ASSERT_NOT_NULL(names);
+
+    run(n);
+    run(n * COMPLEXITY_SCALE);
+
+    free(records);
+    free(names);
+#endif
+}
+
+/**
+ * @brief Returns the fastest of several runs of a timed function.
+ */
+static long long best_time(TimedRun run, int n) {
+    long long best = 0;
+
+    for (int i = 0; i < COMPLEXITY_RUNS; i++) {
+        long long time = run(n);
+        if (i == 0 || time < best) {
+            best = time;
+        }
+    }
+    return (best > 0) ? best : 1;
+}
+
+/**
+ * @brief Asserts that a function on 4n takes less than the ratio limit times it takes on n.
+ */
+static void assert_not_quadratic(TimedRun run, int n) {
+    double ratio = (double)best_time(run, n * COMPLEXITY_SCALE) / best_time(run, n);
+
+    char message[64];
+    snprintf(message, sizeof(message), "time ratio %.1f for %dx the input", ratio, COMPLEXITY_SCALE);
+    TEST_ASSERT_TRUE_MESSAGE(ratio < COMPLEXITY_RATIO_LIMIT, message);
+}
+
+static void count_add_record_to_list(int n) {
+    GradingContext context;
+    build_records(&context, n);
+
+    TEST_ASSERT_EQUAL_INT(n, context.table.nStudents);
+    TEST_ASSERT_EQUAL_PTR(&records[n - 1], context.table.tail);
+
+    // Appending finds the end from the tail pointer, one record per append after the first
+    char message[64];
+    snprintf(message, sizeof(message), "%lld records visited for %d appends", context.profiler.nRecordSteps, n);
+    TEST_ASSERT_TRUE_MESSAGE(context.profiler.nRecordSteps <= n, message);
+}
+
+static void count_sort_list_by_name(int n) {
+    GradingContext context;
+    build_records(&context, n);
+
+    TEST_ASSERT_EQUAL_INT(SUCCESS, sort_list_by_name(&context));
+
+    // The list must be sorted and the tail must be its last record
+    int count = 1;
+    for (Record *current = context.table.head; current->next != NULL; current = current->next, count++) {
+        TEST_ASSERT_TRUE(strcmp(current->name, current->next->name) <= 0);
+    }
+    TEST_ASSERT_EQUAL_INT(n, count);
+    TEST_ASSERT_NULL(context.table.tail->next);
+
+    // A merge sort makes at most n comparisons on each of its ceil(log2 n) passes
+    long long nPasses = 0;
+    while ((1LL << nPasses) < n) {
+        nPasses++;
+    }
+    char message[64];
+    snprintf(message, sizeof(message), "%lld comparisons for %d records", context.profiler.nNameComparisons, n);
+    TEST_ASSERT_TRUE_MESSAGE(context.profiler.nNameComparisons <= (long long)n * nPasses, message);
+}
+
+static void count_class_statistics(int n) {
+    GradingContext context;
+    double average, minimum, maximum;
+    build_records(&context, n);
+    context.profiler.nRecordSteps = 0;
+
+    // Each statistic walks the list once
+    TEST_ASSERT_EQUAL_INT(SUCCESS, calculate_average(&context, 0, &average));
+    TEST_ASSERT_EQUAL_INT(SUCCESS, calculate_minimum(&context, 0, &minimum));
+    TEST_ASSERT_EQUAL_INT(SUCCESS, calculate_maximum(&context, 0, &maximum));
+    TEST_ASSERT_EQUAL_INT64(3LL * n, context.profiler.nRecordSteps);
+}
+
+static long long time_line_reader(int n) {
+    GradingContext context;
+    LineReader reader;
+    char *line = NULL;
+    int length = 0;
+    int count = 0;
+    FILE *pFile = tmpfile();
+
+    TEST_ASSERT_NOT_NULL(pFile);
+    for (int i = 0; i < n; i++) {
+        fprintf(pFile, "Student %08d,70,80,90,60,75,85,95\n", i);
+    }
+    fflush(pFile);
+    lseek(fileno(pFile), 0, SEEK_SET);
+
+    init_grading_context(&context, NULL);
+    set_message_stream(&context, NULL);
+
+    long long start = get_monotonic_time();
+    TEST_ASSERT_EQUAL_INT(SUCCESS, open_line_reader(&context, &reader, pFile));
+    while (read_next_line(&context, &reader, "test", &line, &length) == SUCCESS && line != NULL) {
+        count++;
+    }
+    close_line_reader(&context, &reader);
+    long long time = get_monotonic_time() - start;
+
+    fclose(pFile);
+    TEST_ASSERT_EQUAL_INT(n, count);
+    return time;
+}
+
+void test_add_record_to_list_is_not_quadratic(void) {
+    count_operations(count_add_record_to_list, LIST_SIZE);
+}
+
+void test_sort_list_by_name_is_not_quadratic(void) {
+    count_operations(count_sort_list_by_name, SORT_SIZE);
+}
+
+void test_class_statistics_are_not_quadratic(void) {
+    count_operations(count_class_statistics, LIST_SIZE);
+}
+
+void test_line_reader_is_not_quadratic(void) {
+    assert_not_quadratic(time_line_reader, LINE_COUNT);
+}
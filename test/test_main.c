@@ -2,11 +2,19 @@
 
 // Forward declarations
 void test_always_pass(void);
+void test_add_record_to_list_is_not_quadratic(void);
+void test_sort_list_by_name_is_not_quadratic(void);
+void test_class_statistics_are_not_quadratic(void);
+void test_line_reader_is_not_quadratic(void);
 
 int main(void) {
     UNITY_BEGIN();
     
     RUN_TEST(test_always_pass);
+    RUN_TEST(test_add_record_to_list_is_not_quadratic);
+    RUN_TEST(test_sort_list_by_name_is_not_quadratic);
+    RUN_TEST(test_class_statistics_are_not_quadratic);
+    RUN_TEST(test_line_reader_is_not_quadratic);
     
     return UNITY_END();
 }